@@ -16,11 +16,10 @@
 #include <QMutex>
 #include <QPainter>
 #include <QFile>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
 #include "defaults.h"
 
-const qint64 MaxSeekOvershoot(1000); // One second error in the forward direction for seeking
-const qint64 MaxSeekUndershoot(500); // Half second error in the backward direction for seeking
-
 QTime StartStopTimer;
 
 /*
@@ -37,6 +36,7 @@ videoDecoderItem::videoDecoderItem(QGraphicsItem *parent) :
     playbackState = IdleState;
     setTransformationMode(Qt::SmoothTransformation);
     av_register_all();
+    connect( &seekIndexWatcher, SIGNAL( finished() ), this, SLOT( seekIndexReady() ) );
 }
 
 /*
@@ -82,9 +82,18 @@ void videoDecoderItem::play( void )
 {
     if( frameTimer && videoState )
     {
+        // A paused seek that was answered from the cache has not moved the stream yet
+        if( videoState->pendingSeekPts >= 0 )
+        {
+            decodeToFrame( videoState->pendingSeekPts );
+            videoState->pendingSeekPts = -1;
+            decoder->resetRing();
+        }
+
         qDebug() << "Starting frame timer at: " << (int)videoState->millisecondsPerFrame << "ms per update.";
         decoder->go();
-        frameTimer->singleShot(0, decoder, SLOT(decodeFrame()));
+        emit decodeRequested();
+        frameTimer->start( (int)videoState->millisecondsPerFrame );
         playbackState = PlayingState;
         emit stateChanged(PlayingState);
     }
@@ -229,13 +238,23 @@ bool videoDecoderItem::load( QString filename )
     }
 
     // Set up frame buffers
-    videoState->frame    = avcodec_alloc_frame();
-    videoState->RGBFrame = avcodec_alloc_frame();
-
-    videoState->rawFrameBuffer = (uint8_t *)av_malloc( avpicture_get_size(PIX_FMT_RGB24, videoState->codecContext->width,
-                                                                          videoState->codecContext->height) * sizeof(uint8_t) );
-    avpicture_fill( (AVPicture *)videoState->RGBFrame, videoState->rawFrameBuffer, PIX_FMT_RGB24,
-                    videoState->codecContext->width, videoState->codecContext->height );
+    videoState->frame = avcodec_alloc_frame();
+
+    // One scaler for the life of the clip; frames are converted straight into the worker's ring
+    videoState->scaleContext = sws_getContext( videoState->codecContext->width,
+                                               videoState->codecContext->height,
+                                               videoState->codecContext->pix_fmt,
+                                               videoState->codecContext->width,
+                                               videoState->codecContext->height,
+                                               PIX_FMT_RGB24,
+                                               SWS_BICUBIC, NULL, NULL, NULL );
+    if( videoState->scaleContext == NULL )
+    {
+        delete videoState;
+        videoState = NULL;
+        qDebug() << "videoDecoderItem::load failed to create scaler.";
+        return false;
+    }
 
     AVStream *stream = videoState->formatContext->streams[videoState->videoStream];
 
@@ -246,13 +265,18 @@ bool videoDecoderItem::load( QString filename )
     decoder = new decodeWorker(videoState);
 
     frameTimer = new QTimer(this);
+    frameTimer->setTimerType( Qt::PreciseTimer );
 
-    connect( frameTimer, SIGNAL( timeout() ), decoder, SLOT( decodeFrame() ) );
-    connect( decoder, SIGNAL(newFrameAvailable(QImage *,qint64)), this, SLOT(updateFrame(QImage *,qint64)));
-    connect( decoder, SIGNAL( complete() ), this, SLOT( videoEnd() ) );
+    // The timer presents frames on this thread; every consumed frame queues a refill on the decoder thread
+    connect( frameTimer, SIGNAL( timeout() ), this, SLOT( presentFrame() ) );
+    connect( this, SIGNAL( decodeRequested() ), decoder, SLOT( decodeFrame() ) );
     decoder->moveToThread(decoderThread);
     decoderThread->start();
 
+    // Reading every packet takes a while on long clips; seeks use the container's own index until it is done.
+    // A newer future replaces the watcher's, so an index still being built for the previous clip is ignored.
+    seekIndexWatcher.setFuture( QtConcurrent::run( &videoDecoderItem::buildSeekIndex, filename, videoState->videoStream ) );
+
     emit hasVideoChanged( true );
     emit totalTimeChanged( totalTime() );
     emit tick( currentTime() );
@@ -297,16 +321,17 @@ void videoDecoderItem::tickTime( void )
 
 /*
  * seek
+ *
+ * Show the frame at (or just before) target. The stream is moved to the
+ * nearest preceding keyframe and only the frames from there to the target
+ * are decoded; recently shown frames come straight from the cache.
  */
 void videoDecoderItem::seek( qint64 target )
 {
-    qint64 newTarget = target;
-    int flags = 0;
-
     qDebug() << "Seeking to " << target;
     static bool noReEntry = false;
 
-    if(noReEntry)
+    if( noReEntry || !videoState )
     {
         return; // Prevent multiple simultaneous calls by Qt event handler (like in the below wait loop).
     }
@@ -321,96 +346,197 @@ void videoDecoderItem::seek( qint64 target )
         }
     }
 
-    if( target == 0 )
-    {
-        flags = AVSEEK_FLAG_ANY;
-    }
-    else
+    const qint64 framePts = nearestFramePts( target );
+    QImage *cachedFrame = videoState->frameCache.object( framePts );
+
+    if( cachedFrame && ( playbackState != PlayingState ) )
     {
-        flags = AVSEEK_FLAG_FRAME;
+        // Scrubbing while paused; the stream only needs to move when playback resumes
+        updateFrame( cachedFrame, framePts );
+        videoState->currentTime    = framePts;
+        videoState->pendingSeekPts = framePts;
     }
-
-    if( target < videoState->currentTime )
+    else if( decodeToFrame( framePts ) )
     {
-        flags |= AVSEEK_FLAG_BACKWARD;
+        if( !cachedFrame )
+        {
+            cachedFrame = new QImage( videoState->codecContext->width, videoState->codecContext->height, QImage::Format_RGB888 );
+            convertDecodedFrame( *cachedFrame );
+            videoState->frameCache.insert( framePts, cachedFrame );
+        }
+        updateFrame( cachedFrame, framePts );
+        videoState->pendingSeekPts = -1;
     }
-    if( avformat_seek_file(videoState->formatContext, videoState->videoStream, 0, target,
-                           totalTime(), flags ) < 0)
+    else
     {
         qDebug() << "Error while seeking.";
     }
-    else
+
+    qDebug() << "Sought to " << currentTime();
+    emit tick( currentTime() ); // Update the client, even if we aren't playing
+
+    // Frames decoded ahead of the old position are stale
+    decoder->resetRing();
+    if(playbackState == PlayingState)
     {
-        avcodec_flush_buffers(videoState->codecContext);
+        decoder->go();
+        emit decodeRequested();
     }
+    noReEntry = false;
+}
 
-    bool done = false;
+/*
+ * buildSeekIndex
+ *
+ * Runs on a worker with its own demuxer: walk the packets of the clip once
+ * (no decoding) and record the pts of every video frame and keyframe.
+ */
+seekIndex videoDecoderItem::buildSeekIndex( QString filename, int videoStream )
+{
+    seekIndex index;
+    AVFormatContext *formatContext = NULL;
     AVPacket packet;
 
-    // Seek through to desired frame
-    while ( !done )
+    if( avformat_open_input( &formatContext, filename.toLatin1(), NULL, NULL ) != 0 )
     {
-        if( av_read_frame(videoState->formatContext, &packet) < 0 )
-        {
-            qDebug() << "Error reading frame while seeking.";
-            done = true;
-            break;
-        }
+        qDebug() << "videoDecoderItem::buildSeekIndex failed to open movie file " << filename;
+        return index;
+    }
 
-        if( packet.stream_index == videoState->videoStream )
+    while( av_read_frame( formatContext, &packet ) >= 0 )
+    {
+        if( packet.stream_index == videoStream )
         {
-            int frameFinished;
-            avcodec_decode_video2( videoState->codecContext,
-                                   videoState->frame, &frameFinished, &packet );
+            const qint64 pts = ( packet.pts != (int64_t)AV_NOPTS_VALUE ) ? packet.pts : packet.dts;
 
-            if( frameFinished )
+            index.framePts.append( pts );
+            if( packet.flags & AV_PKT_FLAG_KEY )
             {
-                int f = packet.pts;
-
-                // Zero in on the correct target if we missed. This may take few iterations
-                int error = f - target;
-                if( error > MaxSeekOvershoot )
-                { // Back up
-                    newTarget -= error;
-                    if(newTarget < 0)
-                    {
-                        newTarget = 0;
-                    }
-                    if( avformat_seek_file( videoState->formatContext, videoState->videoStream, 0, newTarget,
-                                            totalTime(), AVSEEK_FLAG_FRAME ) < 0 )
-                    {
-                        qDebug() << "Error while seeking.";
-                    }
-                    else
-                    {
-                        avcodec_flush_buffers(videoState->codecContext);
-                    }
-                    continue;
-                }
-                else if( error < MaxSeekUndershoot )
-                { // Stream forward
-                    continue;
-                }
-                else
-                { // In the goal zone.
-                    done = true;
-                    qDebug() << "Packet matches at f = " << f;
-                    videoState->currentTime = f;
-                    break;
-                }
+                index.keyframePts.append( pts );
             }
         }
         av_free_packet( &packet );
     }
+    avformat_close_input( &formatContext );
 
-    qDebug() << "Sought to " << currentTime();
-    emit tick( currentTime() ); // Update the client, even if we aren't playing
-    if(playbackState == PlayingState)
+    // Packets are in decode order; the lookups need presentation order
+    std::sort( index.framePts.begin(), index.framePts.end() );
+    std::sort( index.keyframePts.begin(), index.keyframePts.end() );
+
+    return index;
+}
+
+/*
+ * seekIndexReady
+ */
+void videoDecoderItem::seekIndexReady( void )
+{
+    if( !videoState )
     {
-        decoder->go();
-        frameTimer->singleShot(0, decoder, SLOT(decodeFrame()));
+        return;
     }
-    noReEntry = false;
+
+    const seekIndex index = seekIndexWatcher.result();
+    videoState->framePts    = index.framePts;
+    videoState->keyframePts = index.keyframePts;
+
+    qDebug() << "Seek index:" << videoState->framePts.count() << "frames," << videoState->keyframePts.count() << "keyframes";
+}
+
+/*
+ * nearestFramePts
+ *
+ * pts of the last frame at or before target.
+ */
+qint64 videoDecoderItem::nearestFramePts( qint64 target )
+{
+    const QVector<qint64> &index = videoState->framePts;
+
+    if( index.isEmpty() )
+    {
+        return target;
+    }
+
+    QVector<qint64>::const_iterator it = std::upper_bound( index.constBegin(), index.constEnd(), target );
+    return ( it == index.constBegin() ) ? *it : *( it - 1 );
+}
+
+/*
+ * nearestKeyframePts
+ *
+ * pts of the last keyframe at or before target. Without an index yet, the
+ * target itself; the backward seek then finds the keyframe.
+ */
+qint64 videoDecoderItem::nearestKeyframePts( qint64 target )
+{
+    const QVector<qint64> &index = videoState->keyframePts;
+
+    if( index.isEmpty() )
+    {
+        return target;
+    }
+
+    QVector<qint64>::const_iterator it = std::upper_bound( index.constBegin(), index.constEnd(), target );
+    return ( it == index.constBegin() ) ? *it : *( it - 1 );
+}
+
+/*
+ * decodeToFrame
+ *
+ * Position the stream at the keyframe preceding framePts and decode up to
+ * that frame. On success the frame is in videoState->frame and the stream
+ * continues from the following packet.
+ */
+bool videoDecoderItem::decodeToFrame( qint64 framePts )
+{
+    AVPacket packet;
+
+    if( av_seek_frame( videoState->formatContext, videoState->videoStream,
+                       nearestKeyframePts( framePts ), AVSEEK_FLAG_BACKWARD ) < 0 )
+    {
+        return false;
+    }
+    avcodec_flush_buffers( videoState->codecContext );
+
+    while( av_read_frame( videoState->formatContext, &packet ) >= 0 )
+    {
+        bool found = false;
+
+        if( packet.stream_index == videoState->videoStream )
+        {
+            int frameFinished = 0;
+            avcodec_decode_video2( videoState->codecContext, videoState->frame, &frameFinished, &packet );
+
+            // With B-frames the packet just fed in is not the frame that came out
+            found = ( frameFinished &&
+                      ( videoState->frame->best_effort_timestamp != (int64_t)AV_NOPTS_VALUE ) &&
+                      ( videoState->frame->best_effort_timestamp >= framePts ) );
+        }
+        av_free_packet( &packet );
+
+        if( found )
+        {
+            videoState->currentTime = framePts;
+            return true;
+        }
+    }
+
+    qDebug() << "Error reading frame while seeking.";
+    return false;
+}
+
+/*
+ * convertDecodedFrame
+ *
+ * Convert the last decoded frame to RGB into image.
+ */
+void videoDecoderItem::convertDecodedFrame( QImage &image )
+{
+    uint8_t *dst[4]    = { image.bits(), NULL, NULL, NULL };
+    int      stride[4] = { image.bytesPerLine(), 0, 0, 0 };
+
+    sws_scale( videoState->scaleContext, videoState->frame->data, videoState->frame->linesize, 0, videoState->codecContext->height,
+               dst, stride );
 }
 
 /*
@@ -450,7 +576,7 @@ qint64 videoDecoderItem::currentTime()
 /*
  * updateFrame
  */
-void videoDecoderItem::updateFrame( QImage *frame, qint64 /*timestamp*/ )
+void videoDecoderItem::updateFrame( const QImage *frame, qint64 /*timestamp*/ )
 {
     static QTime elapsedFrameTime;
 
@@ -462,12 +588,38 @@ void videoDecoderItem::updateFrame( QImage *frame, qint64 /*timestamp*/ )
 }
 
 
+/*
+ * presentFrame
+ *
+ * Called by the frame timer. Shows the oldest decoded frame and hands its
+ * ring slot back to the decoder. If the decoder has fallen behind, the
+ * current frame stays up until the next tick.
+ */
+void videoDecoderItem::presentFrame( void )
+{
+    qint64 pts = 0;
+    const QImage *frame = decoder->peekFrame( &pts );
+
+    if( !frame )
+    {
+        if( decoder->atEndOfStream() )
+        {
+            videoEnd();
+        }
+        return;
+    }
+
+    videoState->currentTime = pts;
+    updateFrame( frame, pts );
+    decoder->releaseFrame();
+    emit decodeRequested();
+}
+
 /*
  * decodeAndDisplayFirstFrame
  */
 void videoDecoderItem::decodeAndDisplayFirstFrame( void )
 {
-    struct SwsContext *img_convert_ctx;
     AVPacket packet;
     int frameFinished = 0;
     bool repeat = true;
@@ -485,29 +637,12 @@ void videoDecoderItem::decodeAndDisplayFirstFrame( void )
                 // Did we get a video frame?
                 if( frameFinished )
                 {
-                    img_convert_ctx = sws_getContext( videoState->codecContext->width,
-                                                      videoState->codecContext->height,
-                                                      videoState->codecContext->pix_fmt,
-                                                      videoState->codecContext->width,
-                                                      videoState->codecContext->height,
-                                                      PIX_FMT_RGB24,
-                                                      SWS_BICUBIC, NULL, NULL, NULL );
-
-                    // Convert the image from its native format to RGB
-                    sws_scale( img_convert_ctx, videoState->frame->data, videoState->frame->linesize, 0, videoState->codecContext->height,
-                               videoState->RGBFrame->data, ((AVPicture *)videoState->RGBFrame)->linesize );
-
-                    /*
-                     * Must release sws context after sws_getContext(). This is less significant here, because this is called only
-                     * at the first frame.
-                     */
-                    sws_freeContext( img_convert_ctx );
+                    // Convert the image from its native format to RGB, directly into the display image
+                    QImage frameImage( videoState->codecContext->width, videoState->codecContext->height, QImage::Format_RGB888 );
+                    convertDecodedFrame( frameImage );
 
                     // Send frame to display item
-                    QImage *frameImage = new QImage( videoState->codecContext->width, videoState->codecContext->height, QImage::Format_RGB888 );
-                    memcpy( frameImage->bits(), videoState->RGBFrame->data[0], videoState->codecContext->width * videoState->codecContext->height * 3 );
-                    updateFrame( frameImage, 0 );
-                    delete frameImage;
+                    updateFrame( &frameImage, 0 );
                     repeat = false;
                 }
             }
@@ -536,25 +671,26 @@ void videoDecoderItem::videoEnd(void)
 
 /*
  * decodeFrame
+ *
+ * Decode until the frame ring is full (or the stream ends) and return.
+ * Pacing is left to the display item's frame timer.
  */
 void decodeWorker::decodeFrame(void)
 {
-    struct SwsContext *img_convert_ctx;
     AVPacket packet;
     int frameFinished = 0;
-    static QTime lastCalled;
-    QTime frameTime;
-    int   nextFrameTime = state->millisecondsPerFrame;
+
+    loopActive = true;
 
     while ( running )
     {
-        loopActive = true;
+        ringLock.lock();
+        const bool ringFull = ( framesReady == FrameRingSize );
+        ringLock.unlock();
 
-        frameTime.start();
-        if( lastCalled.elapsed() < nextFrameTime )
+        if( ringFull )
         {
-            QApplication::processEvents();
-            continue;
+            break;
         }
 
         // Is this a packet from the video stream?
@@ -568,29 +704,20 @@ void decodeWorker::decodeFrame(void)
                 // Did we get a video frame?
                 if( frameFinished )
                 {
-                    img_convert_ctx = sws_getContext( state->codecContext->width,
-                                                      state->codecContext->height,
-                                                      state->codecContext->pix_fmt,
-                                                      state->codecContext->width,
-                                                      state->codecContext->height,
-                                                      PIX_FMT_RGB24,
-                                                      SWS_BICUBIC, NULL, NULL, NULL );
+                    // The write slot is not visible to the display item until it is committed below
+                    QImage  &slot      = frameRing[writeIndex];
+                    uint8_t *dst[4]    = { slot.bits(), NULL, NULL, NULL };
+                    int      stride[4] = { slot.bytesPerLine(), 0, 0, 0 };
 
                     // Convert the image from its native format to RGB
-                    sws_scale( img_convert_ctx, state->frame->data, state->frame->linesize, 0, state->codecContext->height,
-                               state->RGBFrame->data, ((AVPicture *)state->RGBFrame)->linesize );
-
-                    /*
-                     * Must release sws context after sws_getContext(). This fixes a significant memory leak, since this is called to
-                     * decode every video frame.
-                     */
-                    sws_freeContext( img_convert_ctx );
-
-                    // Send frame to display item
-                    memcpy( frameImage->bits(), state->RGBFrame->data[0], state->codecContext->width * state->codecContext->height * 3 );
-                    state->currentTime = packet.pts;
-
-                    emit newFrameAvailable( frameImage,  state->currentTime );
+                    sws_scale( state->scaleContext, state->frame->data, state->frame->linesize, 0, state->codecContext->height,
+                               dst, stride );
+
+                    ringLock.lock();
+                    frameRingPts[writeIndex] = state->frame->best_effort_timestamp;
+                    writeIndex = ( writeIndex + 1 ) % FrameRingSize;
+                    framesReady++;
+                    ringLock.unlock();
                 }
             }
             // Free the packet that was allocated by av_read_frame
@@ -598,14 +725,58 @@ void decodeWorker::decodeFrame(void)
         }
         else
         {
-            emit complete();
-
-            // We're done.
+            // We're done. The display item drains the ring and then ends playback.
+            endOfStream = true;
             running = false;
         }
-        lastCalled.start();
-        nextFrameTime = state->millisecondsPerFrame - frameTime.elapsed(); // Adjust for frame decoding time
     }
     loopActive = false;
 }
 
+/*
+ * peekFrame
+ *
+ * Oldest decoded frame in the ring, or NULL if none is ready. The frame
+ * stays valid until releaseFrame() is called.
+ */
+const QImage *decodeWorker::peekFrame( qint64 *pts )
+{
+    QMutexLocker locker( &ringLock );
+
+    if( framesReady == 0 )
+    {
+        return NULL;
+    }
+    *pts = frameRingPts[readIndex];
+    return &frameRing[readIndex];
+}
+
+/*
+ * releaseFrame
+ *
+ * Return the oldest ring slot to the decoder.
+ */
+void decodeWorker::releaseFrame( void )
+{
+    QMutexLocker locker( &ringLock );
+
+    if( framesReady > 0 )
+    {
+        readIndex = ( readIndex + 1 ) % FrameRingSize;
+        framesReady--;
+    }
+}
+
+/*
+ * resetRing
+ *
+ * Drop all decoded frames. Only called while the worker is stopped.
+ */
+void decodeWorker::resetRing( void )
+{
+    QMutexLocker locker( &ringLock );
+
+    readIndex   = 0;
+    writeIndex  = 0;
+    framesReady = 0;
+}
@@ -11,9 +11,13 @@
 #ifndef VIDEODECODERITEM_H
 #define VIDEODECODERITEM_H
 
+#include <QCache>
+#include <QFutureWatcher>
 #include <QGraphicsPixmapItem>
+#include <QMutex>
 #include <QPixmap>
 #include <qtimer>
+#include <QVector>
 extern "C" {
 #include <avcodec.h>
 #include <avformat.h>
@@ -25,12 +29,16 @@ class decoderState {
 public:
     decoderState() : formatContext(NULL),
         codecContext(NULL), codec(NULL),
-        frame(NULL), RGBFrame(NULL), rawFrameBuffer(NULL),
+        frame(NULL), scaleContext(NULL),
         videoStream(-1), millisecondsPerFrame(0),
-        currentTime(0) {
+        currentTime(0), pendingSeekPts(-1) {
+        frameCache.setMaxCost( SeekCacheFrames );
     }
     ~decoderState() {
 
+        if( scaleContext ) {
+            sws_freeContext( scaleContext );
+        }
         // Close the codec
         if( codecContext ) {
            avcodec_close( codecContext );
@@ -41,63 +49,101 @@ public:
         if ( frame ) {
             av_free( frame );
         }
-        if ( RGBFrame ) {
-            av_free( RGBFrame );
-        }
-        if ( rawFrameBuffer ) {
-            av_free( rawFrameBuffer );
-        }
      }
 
     AVFormatContext *formatContext;
     AVCodecContext  *codecContext;
     AVCodec         *codec;
-    AVFrame         *frame, *RGBFrame;
-    uint8_t         *rawFrameBuffer;
+    AVFrame         *frame;
+    SwsContext      *scaleContext; // created once per clip, converts decoded frames to RGB24
     double           millisecondsPerFrame;
     int              videoStream;
     qint64            currentTime;
+
+    // Seek index, built in the background after the clip is loaded: pts of
+    // every video frame and of every keyframe, both in ascending order
+    // (stream time base). Empty until the index is ready.
+    QVector<qint64>   framePts;
+    QVector<qint64>   keyframePts;
+
+    // Frames shown by recent seeks, keyed by pts, for back-and-forth scrubbing
+    static const int  SeekCacheFrames = 16;
+    QCache<qint64, QImage> frameCache;
+
+    // A seek served from the cache while paused; the stream is moved here on play()
+    qint64            pendingSeekPts;
 };
 
+/*
+ * decodeWorker
+ *
+ * Runs on the decoder thread and keeps a small ring of pre-allocated RGB
+ * frames filled. The display item takes frames out of the ring on its
+ * frame timer and asks for a refill; the worker never waits on the clock.
+ */
 class decodeWorker : public QObject
 {
     Q_OBJECT
 public:
+    static const int FrameRingSize = 4;
+
     explicit decodeWorker(decoderState *s) {
-        frameImage = new QImage( s->codecContext->width, s->codecContext->height, QImage::Format_RGB888 );
+        for( int i = 0; i < FrameRingSize; i++ ) {
+            frameRing[i] = QImage( s->codecContext->width, s->codecContext->height, QImage::Format_RGB888 );
+            frameRingPts[i] = 0;
+        }
         loopActive = false;
         running = false;
+        endOfStream = false;
         state = s;
-    }
-    ~decodeWorker() {
-        if (frameImage) {
-            delete frameImage;
-        }
+        resetRing();
     }
 
     bool isWorking() {
         return loopActive;
     }
 
+    bool atEndOfStream() {
+        return endOfStream;
+    }
+
+    const QImage *peekFrame(qint64 *pts);
+    void releaseFrame();
+    void resetRing();
+
 public slots:
     void decodeFrame();
     void go() {
         running = true;
+        endOfStream = false;
     }
     void stop() {
         running = false;
     }
 
-signals:
-    void newFrameAvailable(QImage *, qint64);
-    void complete(void);
 private:
     bool             running;
     bool             loopActive;
-    QImage          *frameImage;
+    bool             endOfStream;
+    QImage           frameRing[FrameRingSize];
+    qint64           frameRingPts[FrameRingSize];
+    int              readIndex;
+    int              writeIndex;
+    int              framesReady;
+    QMutex           ringLock;
     decoderState     *state;
 };
 
+/*
+ * seekIndex
+ *
+ * What buildSeekIndex() finds; moved into decoderState on the GUI thread.
+ */
+struct seekIndex {
+    QVector<qint64> framePts;
+    QVector<qint64> keyframePts;
+};
+
 class videoDecoderItem : public QObject, public QGraphicsPixmapItem
 {
     Q_OBJECT
@@ -123,6 +169,7 @@ public:
     }
 
 signals:
+    void decodeRequested();
     void hasVideoChanged(bool);
     void stateChanged(videoDecoderItem::State);
     void totalTimeChanged(qint64);
@@ -130,17 +177,25 @@ signals:
     void finished();
 
 public slots:
-    void updateFrame(QImage *, qint64);
+    void updateFrame(const QImage *, qint64);
+    void presentFrame(void);
     void tickTime(void);
     void videoEnd();
+    void seekIndexReady(void);
 private:
     void decodeAndDisplayFirstFrame(void);
+    static seekIndex buildSeekIndex(QString, int);
+    qint64 nearestFramePts(qint64);
+    qint64 nearestKeyframePts(qint64);
+    bool decodeToFrame(qint64);
+    void convertDecodedFrame(QImage &);
     decoderState    *videoState;
     enum State       playbackState;
     QTimer          *tickTimer;
     QTimer          *frameTimer;
     QThread         *decoderThread;
     decodeWorker    *decoder;
+    QFutureWatcher<seekIndex> seekIndexWatcher;
 };
 
 #endif // VIDEODECODERITEM_H
@@ -9,19 +9,30 @@
 #define _WINDOWS
 #define SECTOR_HEIGHT_PX 1024
 #define FFT_DATA_SIZE    1024
+#define RAW_ALINE_LENGTH ( 2 * FFT_DATA_SIZE ) // raw fringe samples per A-line (host spectral processing)
 #define MAX_LINES_PER_FRAME 12000   // normalized to 1000rpm that is 6000 lines/frame
                                     // memory is allocated for twice the lines/frame
 
 #define SECTOR_SIZE_B (SECTOR_HEIGHT_PX * SECTOR_HEIGHT_PX)
 
+// Scene units of the sector. The warp renders it at SignalModel::getSectorWidth_px(), which is
+// picked at runtime (control/sectorSize_px) and defaults to the control screen's pixels.
 const int SectorWidth_px  = SECTOR_HEIGHT_PX;
 const int SectorHeight_px = SECTOR_HEIGHT_PX;
 
+// Bounds of the rendered sector; sizes are rounded up to whole warp work-groups
+const int MinSectorSize_px   = SECTOR_HEIGHT_PX / 2;
+const int MaxSectorSize_px   = 4 * SECTOR_HEIGHT_PX;
+const int SectorAlignment_px = 64;
+
+// Frames for the loop recorder (OctFrameRecorder), written by the warp alongside the display
+const int VideoWidth_px  = SECTOR_HEIGHT_PX;
+const int VideoHeight_px = SECTOR_HEIGHT_PX;
+
 #define MAX_ACQ_IMAGE_SIZE ( FFT_DATA_SIZE * MAX_LINES_PER_FRAME) // max acquired frame size
 
 #define SURFACE_BOOK 0
 #define SIMULATION_MODE 0
-#define LINE_AVERAGING 0
 #define RECORDING_ON 1
 #define USE_SLED_SUPPORT_BOARD 1
 #define USE_NEW_SLED_SUPPORT_BOARD 1
@@ -31,6 +42,9 @@ const int ControlScreenWidth = 3240;
 const int ControlScreenHeight = 2160;
 const double IMAGE_SCALE_FACTOR{2.2};
 
+// Live zoom; the warp renders the zoomed region of the sector at the full display size
+const double MaxZoomFactor{8.0};
+
 
 // file defines
 const int B_per_KB = 1024;
@@ -81,6 +95,8 @@ const QString SystemDir            = "/opt/Avinger_System";
 const QString TrainingDir          = "/opt/Avinger_Training";
 #endif
 const QString DevicesPath          = SystemDir + "/devices";
+const QString DeviceCatalogueCacheFile = SystemDir + "/deviceCatalogue.cache";
+const QString OpenClTuningFile     = SystemDir + "/openclTuning.ini";
 const QString ExportCacheDir       = "exportcache";
 const QString ExportCachePath      = DataDir + "/" + ExportCacheDir;
 const QString ExportArchivePath    = "Avinger_Exports";
@@ -0,0 +1,38 @@
+/*
+ * deviceCatalogueCache.h
+ *
+ * Binary cache of the devices parsed from the device XML files, so start-up
+ * only parses the XML when a device file or one of its icons was added,
+ * removed or changed.
+ *
+ * Copyright (c) 2018 Avinger, Inc.
+ *
+ */
+#ifndef DEVICECATALOGUECACHE_H_
+#define DEVICECATALOGUECACHE_H_
+
+#include <QByteArray>
+#include <QFileInfoList>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class device;
+
+class DeviceCatalogueCache
+{
+public:
+    // No-highlight and highlight icons published next to a device XML file
+    static QStringList iconFiles( const QString &deviceFile );
+
+    static QByteArray key( const QFileInfoList &deviceFiles );
+
+    /*
+     * Appends the cached devices. Returns false, leaving the list untouched, if the cache is
+     * missing, unreadable or was written for other device files.
+     */
+    static bool load( const QString &cacheFileName, const QByteArray &key, QList<device *> &devices );
+    static bool save( const QString &cacheFileName, const QByteArray &key, const QList<device *> &devices );
+};
+
+#endif // DEVICECATALOGUECACHE_H_
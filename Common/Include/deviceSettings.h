@@ -16,6 +16,10 @@
 #include <QSettings>
 #include <QDomDocument>
 #include <QDebug>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QMutex>
+#include <QStringList>
 #include "defaults.h"
 
 #include <vector>
@@ -61,7 +65,7 @@ public:
           QString     inDisclaimerText           = InvestigationalDeviceWarning,
           QByteArray  inDeviceCRC                = "",
 
-          DeviceIconType      inIcon = std::vector<QImage*>())
+          QStringList inIconFiles                = QStringList())
     {
         deviceName               = inDeviceName;
         splitDeviceName          = formatDeviceName(inDeviceName);
@@ -91,7 +95,7 @@ public:
         measurementVersion       = inMeasurementVersion;
         disclaimerText           = inDisclaimerText;
         deviceCRC                = inDeviceCRC;
-        icon                     = inIcon;
+        iconFiles                = inIconFiles;
         pixelsPerMm              = (float)aLineLength_px / (float)imagingDepth_mm;
         pixelsPerUm              = pixelsPerMm / (float)1000;
         m_isAth = inCatheterType[0] == 'A';
@@ -128,12 +132,20 @@ public:
 
 
     float getImagingDepth_mm(void) const;
-    DeviceIconType getIcon(void)              { return icon; }
+    DeviceIconType getIcon(void);
     bool isBiDirectional(void)            { return biDirectional; }
     QString getDisclaimerText(void)       { return disclaimerText; }
     void setInternalImagingMask_px(int mask)  { internalImagingMask_px = mask; }
     float getPixelsPerUm() const {return pixelsPerUm;}
-    DeviceIconType    icon;
+
+    /*
+     * Icons are decoded on first use (or by the background prefetch after init), not at load
+     */
+    void loadIcons(void);
+
+    // Catalogue cache serialization
+    void write( QDataStream &out ) const;
+    static device *read( QDataStream &in );
 
 public:
     static QString formatDeviceName(const QString& name);
@@ -194,6 +206,12 @@ private:
     QString    disclaimerText;
     QByteArray deviceCRC;
     bool       m_isAth;
+
+    // No-highlight and highlight icon files, decoded lazily into icon
+    QStringList    iconFiles;
+    DeviceIconType icon;
+    bool           iconsLoaded{false};
+    QMutex         iconMutex;
 };
 
 /*
@@ -226,6 +244,9 @@ public:
     QList<device *>list( void ) { return deviceList; }
 
     bool loadDevice( QString deviceFile );
+
+    // Starts decoding the device icons on a worker thread
+    void prefetchIcons( void );
     bool checkVersion( QDomDocument *doc );
 
     void setBrightness (int value ) { brightness = value; }
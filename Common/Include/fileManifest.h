@@ -0,0 +1,47 @@
+/*
+ * fileManifest.h
+ *
+ * Remembers the SHA-1 of files together with their size and modification
+ * time. Writers record the hash of data as they write it, and the key checks
+ * only re-read files whose size or modification time no longer match. The
+ * manifest is saved next to each key file, covering the files under it.
+ *
+ * Copyright (c) 2018 Avinger, Inc.
+ *
+ */
+#ifndef FILEMANIFEST_H_
+#define FILEMANIFEST_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+class FileManifest
+{
+public:
+    static FileManifest & Instance();
+
+    void record( const QString &fileName, const QByteArray &hash );
+    QByteArray lookup( const QString &fileName );
+
+    bool load( const QString &manifestFileName );
+    bool save( const QString &manifestFileName );
+
+private:
+    struct Entry_t
+    {
+        qint64 size;
+        qint64 lastModified_ms;
+        QByteArray hash;
+    };
+
+    FileManifest() {}
+    FileManifest( const FileManifest & );
+    FileManifest & operator=( const FileManifest & );
+
+    QHash< QString, Entry_t > entries;
+    QMutex mutex;
+};
+
+#endif // FILEMANIFEST_H_
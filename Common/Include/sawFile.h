@@ -27,6 +27,8 @@ class SawFile
 public:
     static bool checkHash( QTextStream &in );
     static QByteArray computeHash( QString inputFile );
+    static QByteArray hashData( const QByteArray &data );
+    static bool writeHashed( const QString &outputFile, const QByteArray &data );
 
 #ifdef WIN32
     static int getDiskFreeSpaceInGB( LPCWSTR drive );
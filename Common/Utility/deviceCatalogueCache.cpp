@@ -0,0 +1,180 @@
+/*
+ * deviceCatalogueCache.cpp
+ *
+ * Binary cache of the parsed device XML files.
+ *
+ * Copyright (c) 2018 Avinger, Inc.
+ *
+ */
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include "deviceCatalogueCache.h"
+#include "deviceSettings.h"
+#include "logger.h"
+
+namespace{
+// Bump when the device fields written to the catalogue cache change
+const quint32 CatalogueCacheMagic   = 0x44434154; // "DCAT"
+const quint32 CatalogueCacheVersion = 1;
+
+void addFileToKey( QCryptographicHash &hash, const QFileInfo &fileInfo )
+{
+    hash.addData( fileInfo.fileName().toUtf8() );
+    if( fileInfo.exists() )
+    {
+        hash.addData( QByteArray::number( fileInfo.size() ) );
+        hash.addData( QByteArray::number( fileInfo.lastModified().toMSecsSinceEpoch() ) );
+    }
+    else
+    {
+        hash.addData( "missing" );
+    }
+}
+}
+
+/*
+ * iconFiles
+ */
+QStringList DeviceCatalogueCache::iconFiles( const QString &deviceFile )
+{
+    QStringList fn = deviceFile.split( "." );
+    QString fn1 = fn[ 0 ] + "_Highlight.png";
+    QString fn2 = fn[ 0 ] + "_Nohighlight.png";
+
+    return QStringList{ fn2, fn1 };
+}
+
+/*
+ * key
+ *
+ * Identifies the contents of the devices directory by the name, size and modification
+ * time of every device file and of its icons.
+ */
+QByteArray DeviceCatalogueCache::key( const QFileInfoList &deviceFiles )
+{
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+    for( const auto &fileInfo : deviceFiles )
+    {
+        addFileToKey( hash, fileInfo );
+        for( const auto &iconFile : iconFiles( fileInfo.filePath() ) )
+        {
+            addFileToKey( hash, QFileInfo( iconFile ) );
+        }
+    }
+    return hash.result();
+}
+
+/*
+ * load
+ */
+bool DeviceCatalogueCache::load( const QString &cacheFileName, const QByteArray &key, QList<device *> &devices )
+{
+    QFile file( cacheFileName );
+    if( !file.open( QFile::ReadOnly ) )
+    {
+        return false;
+    }
+
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_5_6 );
+
+    quint32 magic{0};
+    quint32 version{0};
+    QByteArray cachedKey;
+    quint32 count{0};
+    in >> magic >> version >> cachedKey >> count;
+    if( ( magic != CatalogueCacheMagic ) || ( version != CatalogueCacheVersion ) || ( cachedKey != key ) )
+    {
+        return false;
+    }
+
+    QList<device *> cachedList;
+    for( quint32 i = 0; ( i < count ) && ( in.status() == QDataStream::Ok ); i++ )
+    {
+        cachedList.append( device::read( in ) );
+    }
+
+    if( in.status() != QDataStream::Ok )
+    {
+        LOG( WARNING, QString( "Device catalogue cache %1 is corrupt" ).arg( cacheFileName ) );
+        qDeleteAll( cachedList );
+        return false;
+    }
+
+    devices.append( cachedList );
+    return true;
+}
+
+/*
+ * save
+ *
+ * Writes the device list for the next start-up. A failure only costs the XML parse next time.
+ */
+bool DeviceCatalogueCache::save( const QString &cacheFileName, const QByteArray &key, const QList<device *> &devices )
+{
+    QSaveFile file( cacheFileName );
+    if( !file.open( QFile::WriteOnly ) )
+    {
+        LOG( WARNING, QString( "Failed to write device catalogue cache %1" ).arg( cacheFileName ) );
+        return false;
+    }
+
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_5_6 );
+    out << CatalogueCacheMagic << CatalogueCacheVersion << key << quint32( devices.size() );
+    for( const auto dev : devices )
+    {
+        dev->write( out );
+    }
+
+    if( !file.commit() )
+    {
+        LOG( WARNING, QString( "Failed to write device catalogue cache %1" ).arg( cacheFileName ) );
+        return false;
+    }
+    return true;
+}
+
+void device::write(QDataStream &out) const
+{
+    out << deviceName << catheterType << devicePropVersion << sledFwMinVersion
+        << ifFwMinVersion << qint32(catheterLength) << qint32(internalImagingMask_px) << qint32(catheterRadius_um)
+        << qint32(biDirectional) << qint32(numberOfSpeeds) << qint32(revolutionsPerMin1) << qint32(revolutionsPerMin2)
+        << qint32(revolutionsPerMin3) << qint32(defaultSpeedIndex) << qint32(clockingEnabled) << clockingGain
+        << clockingOffset << torqueLimit << torqueTime << stallBlinking
+        << buttonMode << qint32(measurementVersion) << disclaimerText << deviceCRC
+        << iconFiles;
+}
+
+device *device::read(QDataStream &in)
+{
+    QString    name;
+    QByteArray type, propVersion, sledFwMin, ifFwMin;
+    qint32     length{0}, mask{0}, radius{0}, biDir{0}, speeds{0}, rpm1{0}, rpm2{0}, rpm3{0}, speedIndex{0}, clocking{0};
+    QByteArray gain, offset, torque, time, stall, button;
+    qint32     measurement{0};
+    QString    disclaimer;
+    QByteArray crc;
+    QStringList files;
+
+    in >> name >> type >> propVersion >> sledFwMin
+       >> ifFwMin >> length >> mask >> radius
+       >> biDir >> speeds >> rpm1 >> rpm2
+       >> rpm3 >> speedIndex >> clocking >> gain
+       >> offset >> torque >> time >> stall
+       >> button >> measurement >> disclaimer >> crc
+       >> files;
+
+    return new device(name, type, propVersion, sledFwMin,
+                      ifFwMin, length, mask, radius,
+                      biDir, speeds, rpm1, rpm2,
+                      rpm3, speedIndex, clocking, gain,
+                      offset, torque, time, stall,
+                      button, measurement, disclaimer, crc,
+                      files);
+}
@@ -11,6 +11,7 @@
  */
 #include <QDebug>
 #include "deviceSettings.h"
+#include "deviceCatalogueCache.h"
 #include "defaults.h"
 #include "logger.h"
 #include <QDir>
@@ -21,6 +22,7 @@
 #include <QSettings>
 #include <QMessageBox>
 #include <QTextStream>
+#include <QtConcurrent/QtConcurrent>
 #include <logger.h>
 #include "Utility/userSettings.h"
 #include "signalmodel.h"
@@ -78,14 +80,25 @@ int deviceSettings::init( void )
     int  numDevicesLoaded = 0;
     QDir deviceDir( DevicesPath );
     qDebug() << "Device directory: " << DevicesPath;
-    QFileInfoList list = deviceDir.entryInfoList( QStringList( "*.xml" ) );
+    QFileInfoList list = deviceDir.entryInfoList( QStringList( "*.xml" ), QDir::Files, QDir::Name );
 
-    for( int i = 0; i < list.size(); i++ )
+    // Parsing the XML is only needed when a device file or icon was added, removed or changed
+    const QByteArray key = DeviceCatalogueCache::key( list );
+    if( DeviceCatalogueCache::load( DeviceCatalogueCacheFile, key, deviceList ) )
     {
-        if( loadDevice( DevicesPath + "/" + list.at( i ).fileName() ) )
+        numDevicesLoaded = deviceList.size();
+        LOG( INFO, QString( "Loaded %1 devices from %2" ).arg( numDevicesLoaded ).arg( DeviceCatalogueCacheFile ) )
+    }
+    else
+    {
+        for( int i = 0; i < list.size(); i++ )
         {
-            numDevicesLoaded++;
+            if( loadDevice( DevicesPath + "/" + list.at( i ).fileName() ) )
+            {
+                numDevicesLoaded++;
+            }
         }
+        DeviceCatalogueCache::save( DeviceCatalogueCacheFile, key, deviceList );
     }
     auto& settings = userSettings::Instance();
     const float depth = settings.getImagingDepth_mm() / 2.0f;
@@ -95,10 +108,28 @@ int deviceSettings::init( void )
         device->setImagingDepth_mm(depth);
         device->setALineLength_px(aLineLength);
     }
+    prefetchIcons();
 
     return numDevicesLoaded;
 }
 
+/*
+ * prefetchIcons
+ *
+ * Decodes the icons off the GUI thread so they are usually ready by the time the device
+ * selector is shown. A device that is drawn first simply decodes its own icons.
+ */
+void deviceSettings::prefetchIcons( void )
+{
+    const QList<device *> devices = deviceList;
+    QtConcurrent::run( [devices]() {
+        for( auto dev : devices )
+        {
+            dev->loadIcons();
+        }
+    } );
+}
+
 void deviceSettings::setCurrentDevice( int devIndex )
 {
     qDebug() << "* DeviceSettings - Current device changed";
@@ -221,27 +252,11 @@ bool deviceSettings::loadDevice( QString deviceFile )
         if( e.tagName() == "device" )
         {
             /*
-             * Load the device icon file; these are published along side the
-             * device XML files.  If it cannot be loaded use the built-in
-             * unknown device. This ensures that the device will be on the
-             * selection list.
+             * The device icon files are published along side the device XML
+             * files; they are decoded when first needed. If one cannot be
+             * loaded the device is still on the selection list.
              */
-            QStringList fn = deviceFile.split(".");
-            QString fn1 = fn[0] + "_Highlight.png";
-            QString fn2 = fn[0] + "_Nohighlight.png";
-            QImage *d1Img = new QImage;
-            if( !d1Img->load( deviceFile.replace( DeviceDescriptionExtension, DeviceIconExtension, Qt::CaseInsensitive ) ) )
-            {
-                QString msg("Failed loading icon");
-                LOG1(msg)
-            }
-
-            QImage *d2Img = new QImage;
-            QImage *d3Img = new QImage;
-            d2Img->load(fn1);
-            d3Img->load(fn2);
-
-            DeviceIconType deviceIcon{d3Img,d2Img};
+            const QStringList deviceIconFiles = DeviceCatalogueCache::iconFiles( deviceFile );
             device *d1 = new device( e.attribute( "deviceName", "" ),
                                      e.attribute( "type", "" ).toLatin1(),
                                      e.attribute( "devicePropVersion","").toLatin1(),
@@ -272,7 +287,7 @@ bool deviceSettings::loadDevice( QString deviceFile )
                                      e.attribute( "disclaimerText", InvestigationalDeviceWarning ),
                                      e.attribute( "deviceCRC","").toLatin1(),
 
-                                     deviceIcon );    // d1Img
+                                     deviceIconFiles );
             deviceList.append( d1 );
         }
         // close the XML file
@@ -355,6 +370,29 @@ QString device::formatDeviceName(const QString &name)
     return retVal;
 }
 
+DeviceIconType device::getIcon()
+{
+    loadIcons();
+    return icon;
+}
+
+void device::loadIcons()
+{
+    QMutexLocker lock(&iconMutex);
+
+    if(iconsLoaded){
+        return;
+    }
+    for(const auto& iconFile : iconFiles){
+        QImage* image = new QImage;
+        if(!image->load(iconFile)){
+            LOG2(deviceName, iconFile)
+        }
+        icon.push_back(image);
+    }
+    iconsLoaded = true;
+}
+
 void device::setImagingDepth_mm(float value)
 {
     imagingDepth_mm = value;
@@ -0,0 +1,157 @@
+/*
+ * fileManifest.cpp
+ *
+ * Size, modification time and SHA-1 of files written or checked by the
+ * software, so unchanged files are not re-read for every key check.
+ *
+ * Copyright (c) 2018 Avinger, Inc.
+ *
+ */
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QTextStream>
+#include "fileManifest.h"
+#include "logger.h"
+
+/*
+ * Instance
+ */
+FileManifest & FileManifest::Instance()
+{
+    static FileManifest theManifest;
+    return theManifest;
+}
+
+/*
+ * record
+ *
+ * Store the hash of a file that has just been written or hashed. The size
+ * and modification time are taken from the file as it is now.
+ */
+void FileManifest::record( const QString &fileName, const QByteArray &hash )
+{
+    QFileInfo info( fileName );
+
+    if( !info.exists() || hash.isEmpty() )
+    {
+        return;
+    }
+
+    QMutexLocker lock( &mutex );
+    entries.insert( info.absoluteFilePath(), Entry_t{ info.size(), info.lastModified().toMSecsSinceEpoch(), hash } );
+}
+
+/*
+ * lookup
+ *
+ * Return the recorded hash if the file has not changed since, or an empty
+ * array if it must be hashed again.
+ */
+QByteArray FileManifest::lookup( const QString &fileName )
+{
+    QFileInfo info( fileName );
+
+    QMutexLocker lock( &mutex );
+    auto entry = entries.constFind( info.absoluteFilePath() );
+
+    if( ( entry == entries.constEnd() ) ||
+        ( entry->size != info.size() ) ||
+        ( entry->lastModified_ms != info.lastModified().toMSecsSinceEpoch() ) )
+    {
+        return QByteArray();
+    }
+    return entry->hash;
+}
+
+/*
+ * load
+ *
+ * Merge a saved manifest. Each line holds the hash, size, modification time
+ * and the file name relative to the manifest. Lines that do not parse are
+ * skipped; those files are simply hashed again.
+ */
+bool FileManifest::load( const QString &manifestFileName )
+{
+    QFile manifestFile( manifestFileName );
+
+    if( !manifestFile.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        // Not an error; the manifest is created by the first save
+        return false;
+    }
+
+    static const QRegularExpression EntryLine( "^([0-9a-fA-F]+) (\\d+) (-?\\d+)  (.+)$" );
+    const QDir baseDir = QFileInfo( manifestFileName ).absoluteDir();
+    QTextStream in( &manifestFile );
+    int numCorrupt = 0;
+
+    QMutexLocker lock( &mutex );
+    while( !in.atEnd() )
+    {
+        const QString line = in.readLine();
+        const QRegularExpressionMatch match = EntryLine.match( line );
+
+        if( !match.hasMatch() )
+        {
+            if( !line.trimmed().isEmpty() )
+            {
+                numCorrupt++;
+            }
+            continue;
+        }
+        entries.insert( baseDir.absoluteFilePath( match.captured( 4 ) ),
+                        Entry_t{ match.captured( 2 ).toLongLong(), match.captured( 3 ).toLongLong(), match.captured( 1 ).toLatin1() } );
+    }
+
+    if( numCorrupt > 0 )
+    {
+        LOG( WARNING, QString( "Skipped %1 unreadable lines in %2" ).arg( numCorrupt ).arg( manifestFileName ) )
+    }
+    return true;
+}
+
+/*
+ * save
+ *
+ * Write out the entries for files under the manifest's directory. Entries
+ * for files that no longer exist are dropped.
+ */
+bool FileManifest::save( const QString &manifestFileName )
+{
+    QFile manifestFile( manifestFileName );
+
+    if( !manifestFile.open( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        LOG( WARNING, QString( "Could not open %1 for writing" ).arg( manifestFileName ) )
+        return false;
+    }
+
+    const QDir baseDir = QFileInfo( manifestFileName ).absoluteDir();
+    const QString basePath = baseDir.absolutePath() + "/";
+    QTextStream out( &manifestFile );
+
+    QMutexLocker lock( &mutex );
+    auto entry = entries.begin();
+    while( entry != entries.end() )
+    {
+        if( !entry.key().startsWith( basePath ) )
+        {
+            ++entry;
+        }
+        else if( !QFileInfo::exists( entry.key() ) )
+        {
+            entry = entries.erase( entry );
+        }
+        else
+        {
+            out << entry->hash << " " << entry->size << " " << entry->lastModified_ms << "  "
+                << baseDir.relativeFilePath( entry.key() ) << Qt::endl;
+            ++entry;
+        }
+    }
+    return true;
+}
@@ -13,6 +13,7 @@
  */
 #include <QDebug>
 #include "keys.h"
+#include "fileManifest.h"
 #include "sawFile.h"
 #include "logger.h"
 #include <QCryptographicHash>
@@ -21,10 +22,20 @@
 #include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QSemaphore>
 #include "logger.h"
 #include "util.h"
 
-QMutex fileCheckMutex;
+namespace{
+/*
+ * Files that must be re-read are hashed by at most this many threads at once;
+ * more than that only adds seek contention on the disk.
+ */
+const int MaxConcurrentHashReads = 2;
+const QString ManifestSuffix = ".manifest";
+}
+
+QSemaphore fileCheckReaders( MaxConcurrentHashReads );
 
 /*
  * Constructor
@@ -83,6 +94,9 @@ bool Keys::init( QString inputDirPath )
 
     getFileHandles( keyFilename );
 
+    // Hashes of files that have not changed since the last check or write
+    FileManifest::Instance().load( keyFilename + ManifestSuffix );
+
     if (inputDirPath.length() > 0 && inputDirPath[inputDirPath.length() - 1] != '/') {
         // Append a slash character
         inputDirPath += '/';
@@ -215,12 +229,16 @@ bool Keys::readKeys( void )
 KeyBundle_t *checkSingleKey( KeyBundle_t *key )
 {
     /*
-     * Use the QtConcurrent Framework for backgrounding only.
-     * Since this is an I/O operation, multiple instances
-     * causes contention.
+     * Unchanged files are answered from the manifest; the rest are I/O
+     * bound, so only a few are read at once.
      */
-    QMutexLocker lock(&fileCheckMutex);
-    QByteArray testValue = SawFile::computeHash( key->file );
+    QByteArray testValue = FileManifest::Instance().lookup( key->file );
+    if( testValue.isEmpty() )
+    {
+        fileCheckReaders.acquire();
+        testValue = SawFile::computeHash( key->file );
+        fileCheckReaders.release();
+    }
 
     if( key->key != testValue )
     {
@@ -257,6 +275,7 @@ void Keys::handleFileCheckDone( void )
         }
     }
     emit fileCheckDone( allValid );
+    FileManifest::Instance().save( keyFilename + ManifestSuffix );
 
     delete fileCheckWatcher;
     fileCheckWatcher = NULL;
@@ -303,6 +322,7 @@ bool Keys::checkKeysBlocking(QString inputDirPath)
             status = false;
         }
     }
+    FileManifest::Instance().save( keyFilename + ManifestSuffix );
 
     return status;
 }
@@ -408,10 +428,12 @@ void Keys::run( void )
         FileItem_t f = fileQ.dequeue();
         mutex.unlock();
 
+        // Files written through SawFile::writeHashed() are not read back
         QByteArray newValue  = SawFile::computeHash( f.fileFullPath );
 
         textStream << newValue << "  " << f.fileNameOnly << Qt::endl;
     }
+    FileManifest::Instance().save( keyFilename + ManifestSuffix );
 }
 
 /*
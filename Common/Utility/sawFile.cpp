@@ -12,6 +12,7 @@
 #include <QDataStream>
 #include <QByteArray>
 #include <QDebug>
+#include "fileManifest.h"
 #include "logger.h"
 #include "sawFile.h"
 #include "util.h"
@@ -27,18 +28,29 @@
 
 namespace{
 const char* NoncritialFileTypes[] = { "png", "mkv", "mp4" };
+
+// Large reads keep the disk streaming when hashing multi-GB recordings
+const qint64 HashReadSize_bytes = 1024 * 1024;
 }
 
 /*
  * computeHash
  *
  * Computes and returns the SHA1 hash of a file. This may
- * return 0 for non-critical files.
+ * return 0 for non-critical files. Files whose hash was recorded in the
+ * manifest (when written, or by an earlier check) are not re-read unless
+ * their size or modification time changed.
  */
 QByteArray SawFile::computeHash( QString inputFile )
 {
     errorHandler & err = errorHandler::Instance();
-    QByteArray calcKey;
+    QByteArray calcKey = FileManifest::Instance().lookup( inputFile );
+
+    if( !calcKey.isEmpty() )
+    {
+        return calcKey;
+    }
+
     QFile *input       = new QFile( inputFile );
     QFileInfo filename( input->fileName() );
 
@@ -79,23 +91,20 @@ QByteArray SawFile::computeHash( QString inputFile )
     else
     {
         // Everything looks valid. Read the file and compute the hash
-        const int BufferSize = 1024;
-        char data[ BufferSize ];
         QCryptographicHash hash( QCryptographicHash::Sha1 );
-        QDataStream in( input );
-
-        int bytesRead = 0;
+        QByteArray data( int( HashReadSize_bytes ), Qt::Uninitialized );
+        qint64 bytesRead = 0;
 
-        // Read in the contents of the file and compute the hash
-        while( !in.atEnd() )
+        // Request HashReadSize_bytes from the file, hash the amount we get back
+        while( ( bytesRead = input->read( data.data(), HashReadSize_bytes ) ) > 0 )
         {
-            // Request BufferSize bytes from the file, hash the amount we get back
-            bytesRead = in.readRawData( data, BufferSize );
-            hash.addData( data, bytesRead );
+            hash.addData( data.constData(), int( bytesRead ) );
         }
 
         // Get the result in hex
         calcKey = hash.result().toHex();
+        input->close();
+        FileManifest::Instance().record( inputFile, calcKey );
     }
 
     // free the memory. nullptr checked above
@@ -104,6 +113,37 @@ QByteArray SawFile::computeHash( QString inputFile )
     return calcKey;
 }
 
+/*
+ * hashData
+ *
+ * SHA1 hash (in hex) of data that is about to be written.
+ */
+QByteArray SawFile::hashData( const QByteArray &data )
+{
+    return QCryptographicHash::hash( data, QCryptographicHash::Sha1 ).toHex();
+}
+
+/*
+ * writeHashed
+ *
+ * Write data to a file and record its hash in the manifest so the key
+ * checks do not need to read the file back.
+ */
+bool SawFile::writeHashed( const QString &outputFile, const QByteArray &data )
+{
+    QFile output( outputFile );
+
+    if( !output.open( QIODevice::WriteOnly ) || ( output.write( data ) != data.size() ) )
+    {
+        LOG( WARNING, QString( "Could not write %1: %2" ).arg( outputFile ).arg( output.errorString() ) )
+        return false;
+    }
+    output.close();
+
+    FileManifest::Instance().record( outputFile, hashData( data ) );
+    return true;
+}
+
 #ifdef WIN32
 /*
  * getDiskFreeSpaceInGB
@@ -0,0 +1,162 @@
+#include <QtTest/QtTest>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+#include "deviceCatalogueCache.h"
+#include "deviceSettings.h"
+
+// The rest of deviceSettings.cpp is not needed to read and write devices
+QString device::formatDeviceName( const QString &name )
+{
+    return name;
+}
+
+class TestDeviceCatalogueCache: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void cacheHit();
+    void deviceFileChanged();
+    void iconChanged();
+    void corruptCache();
+
+private:
+    static void writeFile( const QString &fileName, const QByteArray &data );
+    static QByteArray serialized( const QList<device *> &devices );
+    QFileInfoList deviceFiles() const;
+
+    QTemporaryDir *dir;
+    QString cacheFileName;
+    QList<device *> devices;
+};
+
+void TestDeviceCatalogueCache::writeFile( const QString &fileName, const QByteArray &data )
+{
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QCOMPARE( file.write( data ), qint64( data.size() ) );
+}
+
+QByteArray TestDeviceCatalogueCache::serialized( const QList<device *> &devices )
+{
+    QByteArray data;
+    QDataStream out( &data, QIODevice::WriteOnly );
+    for( const auto dev : devices )
+    {
+        dev->write( out );
+    }
+    return data;
+}
+
+QFileInfoList TestDeviceCatalogueCache::deviceFiles() const
+{
+    return QDir( dir->path() ).entryInfoList( QStringList( "*.xml" ), QDir::Files, QDir::Name );
+}
+
+void TestDeviceCatalogueCache::init()
+{
+    dir = new QTemporaryDir();
+    QVERIFY( dir->isValid() );
+    cacheFileName = dir->filePath( "deviceCatalogue.cache" );
+
+    // Two devices, each with both icons
+    for( const QString name : { "Pantheris", "Ocelot" } )
+    {
+        const QString deviceFile = dir->filePath( name + ".xml" );
+        writeFile( deviceFile, "<device deviceName=\"" + name.toLatin1() + "\"/>" );
+        for( const auto &iconFile : DeviceCatalogueCache::iconFiles( deviceFile ) )
+        {
+            writeFile( iconFile, "png" );
+        }
+        devices.append( new device( name, "ATH", "3.0", "3.0", "3.0", 140, 135, 406, 0, 1, 600, 800, 1000, 1, 1,
+                                    "25", "400", "45", "8", "1", "0", 1, "disclaimer", "crc",
+                                    DeviceCatalogueCache::iconFiles( deviceFile ) ) );
+    }
+}
+
+void TestDeviceCatalogueCache::cleanup()
+{
+    qDeleteAll( devices );
+    devices.clear();
+    delete dir;
+    dir = nullptr;
+}
+
+void TestDeviceCatalogueCache::cacheHit()
+{
+    const QByteArray key = DeviceCatalogueCache::key( deviceFiles() );
+    QVERIFY( DeviceCatalogueCache::save( cacheFileName, key, devices ) );
+
+    // Same files, same key, same devices
+    QCOMPARE( DeviceCatalogueCache::key( deviceFiles() ), key );
+    QList<device *> loaded;
+    QVERIFY( DeviceCatalogueCache::load( cacheFileName, key, loaded ) );
+    QCOMPARE( loaded.size(), devices.size() );
+    QCOMPARE( serialized( loaded ), serialized( devices ) );
+    QCOMPARE( loaded.first()->getDeviceName(), QString( "Pantheris" ) );
+    qDeleteAll( loaded );
+}
+
+void TestDeviceCatalogueCache::deviceFileChanged()
+{
+    const QByteArray key = DeviceCatalogueCache::key( deviceFiles() );
+    QVERIFY( DeviceCatalogueCache::save( cacheFileName, key, devices ) );
+
+    writeFile( dir->filePath( "Ocelot.xml" ), "<device deviceName=\"Ocelot\" catheterLength=\"150\"/>" );
+    const QByteArray changedKey = DeviceCatalogueCache::key( deviceFiles() );
+    QVERIFY( changedKey != key );
+
+    // A miss leaves the list alone so the XML can be parsed into it
+    QList<device *> loaded;
+    QVERIFY( !DeviceCatalogueCache::load( cacheFileName, changedKey, loaded ) );
+    QVERIFY( loaded.isEmpty() );
+
+    // A new device file is a miss too
+    writeFile( dir->filePath( "Wildcat.xml" ), "<device deviceName=\"Wildcat\"/>" );
+    QVERIFY( DeviceCatalogueCache::key( deviceFiles() ) != changedKey );
+}
+
+void TestDeviceCatalogueCache::iconChanged()
+{
+    const QByteArray key = DeviceCatalogueCache::key( deviceFiles() );
+    const QStringList icons = DeviceCatalogueCache::iconFiles( dir->filePath( "Pantheris.xml" ) );
+
+    // Replaced with an image of the same size
+    QFile icon( icons.last() );
+    QVERIFY( icon.open( QIODevice::ReadWrite ) );
+    QVERIFY( icon.setFileTime( QFileInfo( icon ).lastModified().addSecs( 10 ), QFileDevice::FileModificationTime ) );
+    icon.close();
+    const QByteArray touchedKey = DeviceCatalogueCache::key( deviceFiles() );
+    QVERIFY( touchedKey != key );
+
+    // Removed
+    QVERIFY( QFile::remove( icons.first() ) );
+    QVERIFY( DeviceCatalogueCache::key( deviceFiles() ) != touchedKey );
+}
+
+void TestDeviceCatalogueCache::corruptCache()
+{
+    const QByteArray key = DeviceCatalogueCache::key( deviceFiles() );
+    QList<device *> loaded;
+
+    // No cache yet
+    QVERIFY( !DeviceCatalogueCache::load( cacheFileName, key, loaded ) );
+
+    // Not a cache at all
+    writeFile( cacheFileName, "not a device catalogue" );
+    QVERIFY( !DeviceCatalogueCache::load( cacheFileName, key, loaded ) );
+
+    // Cut off in the middle of the second device
+    QVERIFY( DeviceCatalogueCache::save( cacheFileName, key, devices ) );
+    QFile cacheFile( cacheFileName );
+    QVERIFY( cacheFile.resize( cacheFile.size() - 16 ) );
+    QVERIFY( !DeviceCatalogueCache::load( cacheFileName, key, loaded ) );
+    QVERIFY( loaded.isEmpty() );
+}
+
+QTEST_MAIN(TestDeviceCatalogueCache)
+#include "test.moc"
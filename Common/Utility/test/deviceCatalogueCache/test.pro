@@ -0,0 +1,4 @@
+INCLUDEPATH += ../../../Include
+SOURCES = test.cpp ../../deviceCatalogueCache.cpp ../../../../Console/consoleApp/Backend/Tests/stubs/logger.cpp
+CONFIG  += qtestlib
+QT      += xml
@@ -0,0 +1,193 @@
+#include <QtTest/QtTest>
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QTemporaryDir>
+
+// A fresh manifest for every test rather than the shared instance
+#define private public
+#include "fileManifest.h"
+#undef private
+
+class TestFileManifest: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void changeForcesRehash();
+    void corruptLine();
+    void relativePaths();
+    void deletedFilesDropped();
+
+private:
+    static void writeFile( const QString &fileName, const QByteArray &data );
+    static QStringList readLines( const QString &fileName );
+};
+
+void TestFileManifest::writeFile( const QString &fileName, const QByteArray &data )
+{
+    QDir().mkpath( QFileInfo( fileName ).absolutePath() );
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QCOMPARE( file.write( data ), qint64( data.size() ) );
+}
+
+QStringList TestFileManifest::readLines( const QString &fileName )
+{
+    QFile file( fileName );
+    if( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return QStringList();
+    }
+    return QString( file.readAll() ).split( '\n', Qt::SkipEmptyParts );
+}
+
+void TestFileManifest::roundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString first  = dir.filePath( "first.saw" );
+    const QString second = dir.filePath( "captures/second.saw" );
+    const QString manifestName = dir.filePath( "keys.manifest" );
+    writeFile( first, "first" );
+    writeFile( second, "second" );
+
+    FileManifest saved;
+    saved.record( first, "0a1b2c" );
+    saved.record( second, "3d4e5f" );
+    QVERIFY( saved.save( manifestName ) );
+
+    FileManifest loaded;
+    QVERIFY( loaded.load( manifestName ) );
+    QCOMPARE( loaded.lookup( first ), QByteArray( "0a1b2c" ) );
+    QCOMPARE( loaded.lookup( second ), QByteArray( "3d4e5f" ) );
+
+    // No manifest yet is not an error, just nothing known
+    FileManifest empty;
+    QVERIFY( !empty.load( dir.filePath( "missing.manifest" ) ) );
+    QVERIFY( empty.lookup( first ).isEmpty() );
+}
+
+void TestFileManifest::changeForcesRehash()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString grown   = dir.filePath( "grown.saw" );
+    const QString touched = dir.filePath( "touched.saw" );
+    writeFile( grown, "data" );
+    writeFile( touched, "data" );
+
+    FileManifest manifest;
+    manifest.record( grown, "aa" );
+    manifest.record( touched, "bb" );
+    QCOMPARE( manifest.lookup( grown ), QByteArray( "aa" ) );
+    QCOMPARE( manifest.lookup( touched ), QByteArray( "bb" ) );
+
+    // Size changed
+    writeFile( grown, "more data" );
+    QVERIFY( manifest.lookup( grown ).isEmpty() );
+
+    // Same size, new modification time
+    QFile file( touched );
+    QVERIFY( file.open( QIODevice::ReadWrite ) );
+    const QDateTime later = QFileInfo( touched ).lastModified().addSecs( 10 );
+    QVERIFY( file.setFileTime( later, QFileDevice::FileModificationTime ) );
+    file.close();
+    QVERIFY( manifest.lookup( touched ).isEmpty() );
+}
+
+void TestFileManifest::corruptLine()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString before = dir.filePath( "before.saw" );
+    const QString after  = dir.filePath( "after.saw" );
+    writeFile( before, "before" );
+    writeFile( after, "after" );
+    const QFileInfo beforeInfo( before );
+    const QFileInfo afterInfo( after );
+
+    const QString manifestName = dir.filePath( "keys.manifest" );
+    QFile manifestFile( manifestName );
+    QVERIFY( manifestFile.open( QIODevice::WriteOnly | QIODevice::Text ) );
+    QTextStream out( &manifestFile );
+    out << "0a0a " << beforeInfo.size() << " " << beforeInfo.lastModified().toMSecsSinceEpoch() << "  before.saw\n"
+        << "not a manifest line\n"
+        << "0b0b twelve 5  bad.saw\n"
+        << "0c0c 12\n"
+        << "\n"
+        << "0d0d " << afterInfo.size() << " " << afterInfo.lastModified().toMSecsSinceEpoch() << "  after.saw\n";
+    out.flush();
+    manifestFile.close();
+
+    // Good lines on either side of the bad ones still load
+    FileManifest manifest;
+    QVERIFY( manifest.load( manifestName ) );
+    QCOMPARE( manifest.entries.size(), 2 );
+    QCOMPARE( manifest.lookup( before ), QByteArray( "0a0a" ) );
+    QCOMPARE( manifest.lookup( after ), QByteArray( "0d0d" ) );
+}
+
+void TestFileManifest::relativePaths()
+{
+    QTemporaryDir dir;
+    QTemporaryDir elsewhere;
+    QVERIFY( dir.isValid() );
+    QVERIFY( elsewhere.isValid() );
+    const QString inside  = dir.filePath( "case 1/inside.saw" );
+    const QString outside = elsewhere.filePath( "outside.saw" );
+    writeFile( inside, "inside" );
+    writeFile( outside, "outside" );
+
+    // Recorded by a relative name, looked up by the absolute one
+    FileManifest manifest;
+    const QString current = QDir::currentPath();
+    QVERIFY( QDir::setCurrent( dir.path() ) );
+    manifest.record( "case 1/inside.saw", "1111" );
+    QVERIFY( QDir::setCurrent( current ) );
+    manifest.record( outside, "2222" );
+    QCOMPARE( manifest.lookup( inside ), QByteArray( "1111" ) );
+
+    // Names are stored relative to the manifest; files outside its directory are left out
+    const QString manifestName = dir.filePath( "keys.manifest" );
+    QVERIFY( manifest.save( manifestName ) );
+    const QStringList lines = readLines( manifestName );
+    QCOMPARE( lines.size(), 1 );
+    QVERIFY( lines.first().endsWith( "  case 1/inside.saw" ) );
+
+    FileManifest loaded;
+    QVERIFY( loaded.load( manifestName ) );
+    QCOMPARE( loaded.lookup( inside ), QByteArray( "1111" ) );
+    QVERIFY( loaded.lookup( outside ).isEmpty() );
+}
+
+void TestFileManifest::deletedFilesDropped()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString kept    = dir.filePath( "kept.saw" );
+    const QString deleted = dir.filePath( "deleted.saw" );
+    writeFile( kept, "kept" );
+    writeFile( deleted, "deleted" );
+
+    FileManifest manifest;
+    manifest.record( kept, "aaaa" );
+    manifest.record( deleted, "bbbb" );
+    QVERIFY( QFile::remove( deleted ) );
+
+    const QString manifestName = dir.filePath( "keys.manifest" );
+    QVERIFY( manifest.save( manifestName ) );
+    QCOMPARE( manifest.entries.size(), 1 );
+
+    const QStringList lines = readLines( manifestName );
+    QCOMPARE( lines.size(), 1 );
+    QVERIFY( lines.first().endsWith( "  kept.saw" ) );
+}
+
+QTEST_MAIN(TestFileManifest)
+#include "test.moc"
@@ -0,0 +1,3 @@
+INCLUDEPATH += ../../../Include
+SOURCES = test.cpp ../../fileManifest.cpp ../../../../Console/consoleApp/Backend/Tests/stubs/logger.cpp
+CONFIG  += qtestlib
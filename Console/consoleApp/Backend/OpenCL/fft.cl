@@ -0,0 +1,71 @@
+/*
+ * Batched real FFT of resampled A-lines, one work-group per A-line.
+ *
+ * The 2N real samples are read as N complex points z[n] = x[2n] + i x[2n+1], transformed
+ * in local memory with a radix-2 FFT and split into the first N bins of the spectrum of x:
+ *     X[k] = (Z[k] + Z*[N-k]) / 2 - i e^(-i pi k / N) (Z[k] - Z*[N-k]) / 2
+ * The output is split into real and imaginary planes for postfft_kernel.
+ */
+#define FFT_POINTS      1024    // complex points; FFT_DATA_SIZE
+#define FFT_LOG2_POINTS 10
+#define FFT_GROUP_SIZE  256
+
+inline int bit_reverse( int n )
+{
+    int reversed = 0;
+    for( int bit = 0; bit < FFT_LOG2_POINTS; bit++ )
+    {
+        reversed = ( reversed << 1 ) | ( ( n >> bit ) & 1 );
+    }
+    return reversed;
+}
+
+__kernel __attribute__((reqd_work_group_size(FFT_GROUP_SIZE, 1, 1)))
+void fft_kernel(__global const float2 *input,
+                __global float *output_re,
+                __global float *output_imag )
+{
+    __local float2 z[ FFT_POINTS ];
+
+    const int tid = get_local_id( 0 );
+    const int line = get_group_id( 1 );
+    __global const float2 *in = input + line * FFT_POINTS;
+
+    for( int n = tid; n < FFT_POINTS; n += FFT_GROUP_SIZE )
+    {
+        z[ bit_reverse( n ) ] = in[ n ];
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    for( int half = 1; half < FFT_POINTS; half <<= 1 )
+    {
+        for( int b = tid; b < FFT_POINTS / 2; b += FFT_GROUP_SIZE )
+        {
+            const int k = b & ( half - 1 );
+            const int i = ( ( b - k ) << 1 ) + k;
+            float s;
+            const float c = sincos( -M_PI_F * k / half, &s );
+
+            const float2 u = z[ i ];
+            const float2 v = z[ i + half ];
+            const float2 t = (float2)( c * v.x - s * v.y, c * v.y + s * v.x );
+            z[ i ] = u + t;
+            z[ i + half ] = u - t;
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+    }
+
+    const int offset = line * FFT_POINTS;
+    for( int k = tid; k < FFT_POINTS; k += FFT_GROUP_SIZE )
+    {
+        const float2 zk = z[ k ];
+        const float2 zm = z[ ( FFT_POINTS - k ) & ( FFT_POINTS - 1 ) ];
+        const float2 even = 0.5f * (float2)( zk.x + zm.x, zk.y - zm.y );
+        const float2 odd  = 0.5f * (float2)( zk.y + zm.y, zm.x - zk.x );
+
+        float s;
+        const float c = sincos( -M_PI_F * k / FFT_POINTS, &s );
+        output_re[ offset + k ]   = even.x + c * odd.x - s * odd.y;
+        output_imag[ offset + k ] = even.y + c * odd.y + s * odd.x;
+    }
+}
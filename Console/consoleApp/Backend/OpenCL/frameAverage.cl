@@ -0,0 +1,31 @@
+constant sampler_t PIXEL_SMPLR = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+/*
+ * Recursive temporal average of polar frames: avg = curr * w + prev * (1 - w).
+ *
+ * The running average stays on the device between frames as 8.7 fixed point (sample * 128),
+ * so only the new frame is uploaded.
+ */
+__kernel void frame_average_kernel(__read_only image2d_t currentFrame,
+                                   __write_only image2d_t averagedFrame,
+                                   __global ushort* previousFrame,
+                                   const float currFrameWeight,
+                                   const float prevFrameWeight,
+                                   const int doReset )
+{
+    const int2 coord = (int2)( get_global_id( 0 ), get_global_id( 1 ) );
+    const int offset = coord.y * get_global_size( 0 ) + coord.x;
+
+    const float current = (float)read_imageui( currentFrame, PIXEL_SMPLR, coord ).s0 * 128.0f;
+    float averaged = current;
+
+    if( !doReset )
+    {
+        averaged = currFrameWeight * current + prevFrameWeight * (float)previousFrame[ offset ];
+    }
+
+    const uint fixedPoint = min( (uint)( averaged + 0.5f ), (uint)( 255 * 128 ) );
+    previousFrame[ offset ] = (ushort)fixedPoint;
+
+    write_imageui( averagedFrame, coord, (uint4)( ( fixedPoint + 64 ) >> 7, 0, 0, 1 ) );
+}
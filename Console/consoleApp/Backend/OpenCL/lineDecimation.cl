@@ -0,0 +1,44 @@
+constant sampler_t PIXEL_SMPLR = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+/*
+ * Combines groups of factor A-lines into one (see LineDecimation).
+ *
+ * Weighted modes sum the taps with 8-bit fixed point weights that add up to 256; max mode
+ * keeps the brightest sample of the group. Lines wrap around, a frame is one revolution.
+ * The taps index the revolution padded to a whole number of groups; taps on the padding
+ * lines are left out and the other weights rescaled, so a short last group is still used.
+ */
+__kernel void line_decimation_kernel( __read_only image2d_t srcImg,
+                                      __write_only image2d_t dstImg,
+                                      __constant ushort *weights,
+                                      const int factor,
+                                      const int firstOffset,
+                                      const int numberOfTaps,
+                                      const int doMax )
+{
+    const int x = get_global_id( 0 );
+    const int y = get_global_id( 1 );
+    const int numberOfLines = get_image_height( srcImg );
+    const int paddedLines = get_image_height( dstImg ) * factor;
+    const int first = y * factor + firstOffset;
+
+    uint value = 0;
+    uint weightSum = 0;
+    for( int tap = 0; tap < numberOfTaps; tap++ )
+    {
+        const int line = ( ( first + tap ) % paddedLines + paddedLines ) % paddedLines;
+        if( line >= numberOfLines )
+        {
+            continue;
+        }
+        const uint sample = read_imageui( srcImg, PIXEL_SMPLR, (int2)( x, line ) ).s0;
+        value = doMax ? max( value, sample ) : value + weights[ tap ] * sample;
+        weightSum += weights[ tap ];
+    }
+    if( !doMax )
+    {
+        value = ( weightSum == 256 ) ? ( value + 128 ) >> 8 : ( value + weightSum / 2 ) / weightSum;
+    }
+
+    write_imageui( dstImg, (int2)( x, y ), (uint4)( value, 0, 0, 1 ) );
+}
@@ -29,6 +29,9 @@ __kernel void postfft_kernel(__global const float *input_re,
     }
     prev_frame[ i + offset ] = tmp; // Store for later
 
+    // Out of range values (log10(0) included) are undefined when converted to uint
+    magnitude = clamp( magnitude, 0.0f, 255.0f );
+
     uint4 clr = 0;
 
     if( doInvert )
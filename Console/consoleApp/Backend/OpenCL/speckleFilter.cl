@@ -0,0 +1,72 @@
+constant sampler_t PIXEL_SMPLR = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+#define GROUP_WIDTH  64
+#define GROUP_HEIGHT 4
+#define MAX_RADIUS   2
+
+uint median3( uint a, uint b, uint c )
+{
+    return max( min( a, b ), min( max( a, b ), c ) );
+}
+
+uint median5( uint a, uint b, uint c, uint d, uint e )
+{
+    return median3( e, max( min( a, b ), min( c, d ) ), min( max( a, b ), max( c, d ) ) );
+}
+
+/*
+ * Median across the lines either side of (x, line); lines wrap, a frame is one revolution.
+ * Past the ends of a line the sampler repeats the end sample.
+ */
+uint median_across( __read_only image2d_t srcImg, int x, int line, int numberOfLines, int radius )
+{
+    uint value[ 2 * MAX_RADIUS + 1 ];
+    for( int tap = 0; tap <= 2 * radius; tap++ )
+    {
+        const int y = ( ( line + tap - radius ) % numberOfLines + numberOfLines ) % numberOfLines;
+        value[ tap ] = read_imageui( srcImg, PIXEL_SMPLR, (int2)( x, y ) ).s0;
+    }
+    return ( radius == 1 ) ? median3( value[ 0 ], value[ 1 ], value[ 2 ] ) :
+                             median5( value[ 0 ], value[ 1 ], value[ 2 ], value[ 3 ], value[ 4 ] );
+}
+
+/*
+ * Separable median speckle filter (see SpeckleFilter): the median along the A-line of the
+ * medians across lines. Each work-group keeps the medians across lines of its samples, plus
+ * radius either side, in local memory so every one is worked out once.
+ *
+ * The global size is padded to whole work-groups; padded lines only help fill the tile.
+ */
+__kernel __attribute__((reqd_work_group_size(GROUP_WIDTH, GROUP_HEIGHT, 1)))
+void speckle_filter_kernel( __read_only image2d_t srcImg,
+                            __write_only image2d_t dstImg,
+                            const int radius )
+{
+    __local uint across[ GROUP_HEIGHT ][ GROUP_WIDTH + 2 * MAX_RADIUS ];
+
+    const int x  = get_global_id( 0 );
+    const int y  = get_global_id( 1 );
+    const int lx = get_local_id( 0 );
+    const int ly = get_local_id( 1 );
+    const int numberOfLines = get_image_height( srcImg );
+    const int line = min( y, numberOfLines - 1 );
+
+    across[ ly ][ lx + radius ] = median_across( srcImg, x, line, numberOfLines, radius );
+    if( lx < 2 * radius )
+    {
+        // The first radius work-items fetch the left margin, the next radius the right one
+        const int tile = ( lx < radius ) ? lx : GROUP_WIDTH + lx;
+        across[ ly ][ tile ] = median_across( srcImg, get_group_id( 0 ) * GROUP_WIDTH + tile - radius, line, numberOfLines, radius );
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    if( y >= numberOfLines )
+    {
+        return;
+    }
+    __local const uint *window = &across[ ly ][ lx ];
+    const uint value = ( radius == 1 ) ? median3( window[ 0 ], window[ 1 ], window[ 2 ] ) :
+                                         median5( window[ 0 ], window[ 1 ], window[ 2 ], window[ 3 ], window[ 4 ] );
+
+    write_imageui( dstImg, (int2)( x, y ), (uint4)( value, 0, 0, 1 ) );
+}
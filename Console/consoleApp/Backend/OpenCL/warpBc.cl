@@ -1,21 +1,27 @@
 constant sampler_t NORM_SMPLR = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
 
-__kernel void warpBc_kernel(__read_only image2d_t srcImg,
-                          __write_only image2d_t dstImg,
-                          __write_only image2d_t videoImg,
-                          float catheterRadius_um,
-                          float fInternalImagingMask_S,
-                          float standardDepth_mm,
-                          int standardDepth_S,
-                          float rotationAngle_deg,
-                          const int reverseDirection,
-                          int width_px,
-                          int height_px,
-                          float fFractionOfCanvas,
-                          int maxDepth_S,
-                          int brightness,
-                          int contrast,
-                          int doInvert              )
+/*
+ * Looks up the sector pixel at a normalized store coordinate (origin at the corner, [0..1]
+ * across the output) and applies brightness, contrast and inversion.
+ *
+ * Every output of the warp goes through here, so the display, the video frame and the
+ * thumbnail agree whatever their sizes. *sample is the raw source sample for the histogram,
+ * or -1 outside the imaged area.
+ */
+uint4 sector_pixel( __read_only image2d_t srcImg,
+                    float2 storeCoord_norm,
+                    float catheterRadius_um,
+                    float fInternalImagingMask_S,
+                    float standardDepth_mm,
+                    int standardDepth_S,
+                    float rotation_norm,
+                    const int reverseDirection,
+                    float fFractionOfCanvas,
+                    int maxDepth_S,
+                    int brightness,
+                    int contrast,
+                    int doInvert,
+                    int *sample )
 {
     /*
      * Max depth in samples from FFT Output. Samples are not the same as Pixels since we don't display
@@ -26,13 +32,6 @@ __kernel void warpBc_kernel(__read_only image2d_t srcImg,
     const float fStandard_S      = standardDepth_S;
     const float fStandard_SPerMm = fStandard_S / fStandard_mm;
 
-    /*
-     * We work through the image at each *storage* location, choosing
-     * the warped pixels to load based on the transform.
-     */
-    int2 storeCoord = (int2)( get_global_id( 0 ), get_global_id( 1 ) );
-    float2 storeCoord_norm = convert_float2( storeCoord ) * (float2)( 1.0f / width_px, 1.0f / height_px );
-
     float2 loadCoord_norm;
     float2 videoLoadCoord_norm;
 
@@ -48,7 +47,6 @@ __kernel void warpBc_kernel(__read_only image2d_t srcImg,
      * TBD: Use lookup table for speed? This call is worth about 5%-10% performance hit.
      */
     float theta = 0.0f;
-    float directionMultiplier = 1.0f;
 
     if( reverseDirection )
     {
@@ -58,7 +56,6 @@ __kernel void warpBc_kernel(__read_only image2d_t srcImg,
     else
     {
         theta = atan2pi( storeCoord_norm.y, storeCoord_norm.x ); // draw CW
-        directionMultiplier = -1.0f;
     }
 
     /*
@@ -78,8 +75,6 @@ __kernel void warpBc_kernel(__read_only image2d_t srcImg,
     float r_max = fFractionOfCanvas;
     float r_cath_px;
 
-    float scaleFactor = ( 1024.0f - y_val_loadNorm ) / max_len_S;
-
     c3_px = max_len_S;
     // pass in image depth 3.23
     r_cath_px = catheterRadius_um * fStandard_SPerMm / 1000.0f; // 1000.0f um per mm
@@ -102,16 +97,12 @@ __kernel void warpBc_kernel(__read_only image2d_t srcImg,
     loadCoord_norm.y = ( theta + 1.0f ) / 2.0f;
 
     /*
-     * Find the rotated point relative to the computer loadCoord_norm location.
-     * Since the coordinates are normalized, we just have to normalize the
-     * rotation to the range to [0..1].  We clamp videoLoadCoord_norm to [0..1].
+     * Rotation is a row offset into the polar frame: rotation_norm is the display angle as
+     * a fraction of a revolution, signed for the drawing direction on the host. Rows wrap
+     * around the revolution.
      */
-    videoLoadCoord_norm.y = fmod( ( loadCoord_norm.y + directionMultiplier * ( rotationAngle_deg / (float)360.0f ) ), 1.0f );
-
-    if( videoLoadCoord_norm.y < 0.0f )
-    {
-        videoLoadCoord_norm.y = videoLoadCoord_norm.y + 1.0f;
-    }
+    videoLoadCoord_norm.y = loadCoord_norm.y + rotation_norm;
+    videoLoadCoord_norm.y = videoLoadCoord_norm.y - floor( videoLoadCoord_norm.y );
 
     uint4 pixel;
     int   ipixel;
@@ -119,7 +110,8 @@ __kernel void warpBc_kernel(__read_only image2d_t srcImg,
     float fcontrast;
     float contrastCorrection;
 
-    uint4 clr = 0;
+    *sample = -1;
+
     /*
      * Draw black if:
      *   corners of the canvas,
@@ -129,38 +121,141 @@ __kernel void warpBc_kernel(__read_only image2d_t srcImg,
     const bool outsideofthecircle = ( r > r_max ) || ( loadCoord_norm.x > 1.0f ) || ( loadCoord_norm.x < y_val_loadNorm );
     if( outsideofthecircle )
     {
-        pixel = (uint4){ 0, 0, 0, 1 }; // give a black center circle to the sector
-        clr = pixel;
+        return (uint4){ 0, 0, 0, 1 }; // give a black center circle to the sector
     }
-    else // everything else inside should be the pixel from the load image
+
+    // everything else inside should be the pixel from the load image
+    pixel = read_imageui( srcImg, NORM_SMPLR, videoLoadCoord_norm );
+    ipixel = pixel.s0;
+    *sample = ipixel;
+    ipixel = ipixel + brightness;
+    if(ipixel < 0) ipixel = 0;
+    if(ipixel > 255) ipixel = 255;
+    pixel.s0 = ipixel;
+
+    fcontrast = contrast;
+    contrastCorrection = (259.0f*(fcontrast+255.0f))/(255.0f*(259.0f-fcontrast));
+    fpixel = pixel.s0;
+    fpixel = contrastCorrection*(fpixel-128.0f) + 128.0f;
+    ipixel = fpixel;
+    if( ipixel < 0 ) ipixel = 0;
+    if( ipixel > 255 ) ipixel = 255;
+    pixel.s0 = ipixel;
+
+    if( doInvert )
     {
-        pixel = read_imageui( srcImg, NORM_SMPLR, videoLoadCoord_norm );
-        ipixel = pixel.s0;
-        ipixel = ipixel + brightness;
-        if(ipixel < 0) ipixel = 0;
-        if(ipixel > 255) ipixel = 255;
-        pixel.s0 = ipixel;
-
-        fcontrast = contrast;
-        contrastCorrection = (259.0f*(fcontrast+255.0f))/(255.0f*(259.0f-fcontrast));
-        fpixel = pixel.s0;
-        fpixel = contrastCorrection*(fpixel-128.0f) + 128.0f;
-        ipixel = fpixel;
-        if( ipixel < 0 ) ipixel = 0;
-        if( ipixel > 255 ) ipixel = 255;
-        pixel.s0 = ipixel;
+        return (uint4) 255 - pixel;
     }
-    uint4 maxVal = (uint4) 255;
-    if( doInvert )
+    return pixel;
+}
+
+/*
+ * One launch writes every requested output. The work size covers the largest of the
+ * display and the video frame; each work-item writes the pixel it stands on in every
+ * output that is at least that big. An output of the display's size reuses its pixel.
+ *
+ * The display covers only roi (x, y, width, height as fractions of the sector), drawn at
+ * the full display size; the video frame and the thumbnail always show the whole sector.
+ * All three sample at their pixel centres, so they line up whatever their sizes.
+ */
+__kernel void warpBc_kernel(__read_only image2d_t srcImg,
+                          __write_only image2d_t dstImg,
+                          __write_only image2d_t videoImg,
+                          float catheterRadius_um,
+                          float fInternalImagingMask_S,
+                          float standardDepth_mm,
+                          int standardDepth_S,
+                          float rotation_norm,
+                          const int reverseDirection,
+                          int width_px,
+                          int height_px,
+                          float fFractionOfCanvas,
+                          int maxDepth_S,
+                          int brightness,
+                          int contrast,
+                          int doInvert,
+                          __global uint* histogram,
+                          int doHistogram,
+                          __write_only image2d_t thumbnailImg,
+                          int doVideo,
+                          int videoWidth_px,
+                          int videoHeight_px,
+                          int doThumbnail,
+                          int thumbnailWidth_px,
+                          int thumbnailHeight_px,
+                          float4 roi )
+{
+    /*
+     * Auto contrast: each work-group bins the source samples it draws into local memory and
+     * adds its bins to the frame histogram once, so the histogram costs no extra pass.
+     */
+    __local uint localHistogram[ 256 ];
+    const int localId   = get_local_id( 1 ) * get_local_size( 0 ) + get_local_id( 0 );
+    const int localSize = get_local_size( 0 ) * get_local_size( 1 );
+
+    if( doHistogram )
     {
-        if(!outsideofthecircle)
-            clr = maxVal - pixel;
+        for( int bin = localId; bin < 256; bin += localSize )
+        {
+            localHistogram[ bin ] = 0;
+        }
     }
-    else
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    /*
+     * We work through the image at each *storage* location, choosing
+     * the warped pixels to load based on the transform.
+     */
+    const int2 storeCoord = (int2)( get_global_id( 0 ), get_global_id( 1 ) );
+    int sample;
+    uint4 clr = 0;
+
+    const bool isDisplayPixel = ( storeCoord.x < width_px ) && ( storeCoord.y < height_px );
+    if( isDisplayPixel )
+    {
+        const float2 storeCoord_norm = roi.xy + ( convert_float2( storeCoord ) + 0.5f ) * roi.zw / (float2)( width_px, height_px );
+        clr = sector_pixel( srcImg, storeCoord_norm, catheterRadius_um, fInternalImagingMask_S, standardDepth_mm, standardDepth_S,
+                            rotation_norm, reverseDirection, fFractionOfCanvas, maxDepth_S, brightness, contrast, doInvert, &sample );
+        if( doHistogram && ( sample >= 0 ) )
+        {
+            atomic_inc( &localHistogram[ min( sample, 255 ) ] );
+        }
+
+        // Write to the image for display
+        write_imageui( dstImg, storeCoord, clr );
+    }
+
+    if( doVideo && ( storeCoord.x < videoWidth_px ) && ( storeCoord.y < videoHeight_px ) )
+    {
+        uint4 videoClr = clr;
+        const bool isWholeSector = ( roi.z == 1.0f ) && ( roi.w == 1.0f );
+        if( !isWholeSector || ( videoWidth_px != width_px ) || ( videoHeight_px != height_px ) )
+        {
+            const float2 videoCoord_norm = ( convert_float2( storeCoord ) + 0.5f ) * (float2)( 1.0f / videoWidth_px, 1.0f / videoHeight_px );
+            videoClr = sector_pixel( srcImg, videoCoord_norm, catheterRadius_um, fInternalImagingMask_S, standardDepth_mm, standardDepth_S,
+                                     rotation_norm, reverseDirection, fFractionOfCanvas, maxDepth_S, brightness, contrast, doInvert, &sample );
+        }
+        write_imageui( videoImg, storeCoord, videoClr );
+    }
+
+    if( doThumbnail && ( storeCoord.x < thumbnailWidth_px ) && ( storeCoord.y < thumbnailHeight_px ) )
     {
-        clr = pixel;
+        // The linear sampler does the filtering
+        const float2 thumbnailCoord_norm = ( convert_float2( storeCoord ) + 0.5f ) * (float2)( 1.0f / thumbnailWidth_px, 1.0f / thumbnailHeight_px );
+        const uint4 thumbnailClr = sector_pixel( srcImg, thumbnailCoord_norm, catheterRadius_um, fInternalImagingMask_S, standardDepth_mm, standardDepth_S,
+                                                 rotation_norm, reverseDirection, fFractionOfCanvas, maxDepth_S, brightness, contrast, doInvert, &sample );
+        write_imageui( thumbnailImg, storeCoord, thumbnailClr );
     }
 
-    // Write to the image for display and for the video
-     write_imageui(   dstImg, storeCoord, clr );
+    barrier( CLK_LOCAL_MEM_FENCE );
+    if( doHistogram )
+    {
+        for( int bin = localId; bin < 256; bin += localSize )
+        {
+            if( localHistogram[ bin ] )
+            {
+                atomic_add( &histogram[ bin ], localHistogram[ bin ] );
+            }
+        }
+    }
 }
@@ -0,0 +1,13 @@
+QT += testlib
+QT -= gui
+TARGET = autocontrasttest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+SOURCES += main.cpp \
+    ../../autocontrast.cpp
+
+INCLUDEPATH += . \
+    ../..
+
+HEADERS += ../../autocontrast.h
@@ -0,0 +1,159 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "autocontrast.h"
+
+/*
+ * AutoContrast: the CPU histogram, the 30th / 99.5th percentile black and white points, their
+ * smoothing over frames, and the brightness and contrast that map them to 0 and 255 in the warp.
+ */
+class TestAutoContrast : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+void testAccumulateHistogram();
+void testPercentiles();
+void testMinimumSpan();
+void testSmoothing();
+void testKernelMapping();
+void testEmptyHistogramIgnored();
+
+private:
+    // The warp kernel's brightness and contrast, as in warpBc.cl
+    static int warpPixel( int value, int brightness, int contrast );
+};
+
+int TestAutoContrast::warpPixel( int value, int brightness, int contrast )
+{
+    int pixel = std::max( 0, std::min( 255, value + brightness ) );
+    const float correction = ( 259.0f * ( contrast + 255.0f ) ) / ( 255.0f * ( 259.0f - contrast ) );
+    pixel = int( correction * ( pixel - 128.0f ) + 128.0f );
+    return std::max( 0, std::min( 255, pixel ) );
+}
+
+void TestAutoContrast::testAccumulateHistogram()
+{
+    // Lines of 21 samples: eight at a time twice, then a tail of five
+    const int numberOfLines = 6;
+    const int lineLength = 21;
+    std::vector<uint8_t> frame( numberOfLines * lineLength );
+    for( int line = 0; line < numberOfLines; line++ )
+    {
+        for( int sample = 0; sample < lineLength; sample++ )
+        {
+            frame[ line * lineLength + sample ] = uint8_t( sample < 4 ? 255 : line );
+        }
+    }
+
+    AutoContrast::Histogram_t histogram;
+    histogram.fill( 0 );
+    AutoContrast::accumulateHistogram( frame.data(), numberOfLines, lineLength, 4, 2, histogram.data() );
+
+    // Lines 0, 2 and 4, without the first four samples of each
+    QCOMPARE( histogram[ 0 ], uint32_t( lineLength - 4 ) );
+    QCOMPARE( histogram[ 1 ], uint32_t( 0 ) );
+    QCOMPARE( histogram[ 2 ], uint32_t( lineLength - 4 ) );
+    QCOMPARE( histogram[ 4 ], uint32_t( lineLength - 4 ) );
+    QCOMPARE( histogram[ 255 ], uint32_t( 0 ) );
+}
+
+void TestAutoContrast::testPercentiles()
+{
+    // 1000 samples, ten at each level from 0 to 99
+    AutoContrast::Histogram_t histogram;
+    histogram.fill( 0 );
+    for( int bin = 0; bin < 100; bin++ )
+    {
+        histogram[ bin ] = 10;
+    }
+
+    AutoContrast autoContrast;
+    autoContrast.update( histogram.data() );
+
+    // 300 samples reach bin 29, 995 reach bin 99
+    QCOMPARE( autoContrast.blackPoint(), 29.0f );
+    QCOMPARE( autoContrast.whitePoint(), 99.0f );
+}
+
+void TestAutoContrast::testMinimumSpan()
+{
+    // A frame of one level must not be stretched into noise
+    AutoContrast::Histogram_t histogram;
+    histogram.fill( 0 );
+    histogram[ 250 ] = 500;
+
+    AutoContrast autoContrast;
+    autoContrast.update( histogram.data() );
+
+    QCOMPARE( autoContrast.whitePoint(), 255.0f );
+    QCOMPARE( autoContrast.blackPoint(), 223.0f );
+}
+
+void TestAutoContrast::testSmoothing()
+{
+    AutoContrast::Histogram_t dark;
+    dark.fill( 0 );
+    for( int bin = 0; bin < 100; bin++ )
+    {
+        dark[ bin ] = 10;
+    }
+    AutoContrast::Histogram_t bright;
+    bright.fill( 0 );
+    for( int bin = 100; bin < 200; bin++ )
+    {
+        bright[ bin ] = 10;
+    }
+
+    AutoContrast autoContrast;
+    autoContrast.update( dark.data() );
+    autoContrast.update( bright.data() );
+
+    // One bright frame moves the points a tenth of the way
+    QVERIFY( std::fabs( autoContrast.blackPoint() - ( 29.0f + 0.1f * 100.0f ) ) < 0.01f );
+    QVERIFY( std::fabs( autoContrast.whitePoint() - ( 99.0f + 0.1f * 100.0f ) ) < 0.01f );
+
+    autoContrast.reset();
+    autoContrast.update( bright.data() );
+    QCOMPARE( autoContrast.blackPoint(), 129.0f );
+}
+
+void TestAutoContrast::testKernelMapping()
+{
+    AutoContrast::Histogram_t histogram;
+    histogram.fill( 0 );
+    for( int bin = 40; bin < 200; bin++ )
+    {
+        histogram[ bin ] = 10;
+    }
+
+    AutoContrast autoContrast;
+    autoContrast.update( histogram.data() );
+
+    const int black = int( autoContrast.blackPoint() );
+    const int white = int( autoContrast.whitePoint() );
+    QVERIFY( warpPixel( black, *autoContrast.brightness(), *autoContrast.contrast() ) <= 3 );
+    QVERIFY( warpPixel( white, *autoContrast.brightness(), *autoContrast.contrast() ) >= 252 );
+
+    autoContrast.reset();
+    QCOMPARE( *autoContrast.brightness(), 0 );
+    QCOMPARE( *autoContrast.contrast(), 0 );
+}
+
+void TestAutoContrast::testEmptyHistogramIgnored()
+{
+    AutoContrast::Histogram_t histogram;
+    histogram.fill( 0 );
+
+    AutoContrast autoContrast;
+    autoContrast.update( histogram.data() );
+
+    QCOMPARE( autoContrast.blackPoint(), 0.0f );
+    QCOMPARE( autoContrast.whitePoint(), 255.0f );
+}
+
+QTEST_MAIN(TestAutoContrast)
+#include "main.moc"
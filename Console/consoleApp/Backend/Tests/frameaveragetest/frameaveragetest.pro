@@ -0,0 +1,13 @@
+QT += testlib
+QT -= gui
+TARGET = frameaveragetest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+SOURCES += main.cpp \
+    ../../frameaverage.cpp
+
+INCLUDEPATH += . \
+    ../..
+
+HEADERS += ../../frameaverage.h
@@ -0,0 +1,112 @@
+#include <QtTest/QtTest>
+#include <cmath>
+#include <vector>
+
+#include "frameaverage.h"
+
+/*
+ * The running average is 8.7 fixed point; the SIMD and scalar parts of blend() must both
+ * follow avg = curr * w + prev * (1 - w) in that format, the same as frameAverage.cl.
+ */
+class TestFrameAverage : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+void testResetTakesCurrentFrame();
+void testBlendMatchesFixedPoint();
+void testConvergesToConstant();
+void testNoOverflowAtFullScale();
+void testDelay();
+};
+
+void TestFrameAverage::testResetTakesCurrentFrame()
+{
+    // 8 + 8 + 3 samples: two vector steps and a scalar tail
+    const size_t length = 19;
+    std::vector<uint8_t> current( length );
+    for( size_t i = 0; i < length; i++ )
+    {
+        current[ i ] = uint8_t( i * 13 );
+    }
+    std::vector<uint16_t> average( length, 12345 );
+    std::vector<uint8_t> averaged( length );
+
+    FrameAverage::blend( current.data(), average.data(), averaged.data(), length, 0.25f, true );
+
+    for( size_t i = 0; i < length; i++ )
+    {
+        QCOMPARE( int( average[ i ] ), current[ i ] * FrameAverage::FixedPointScale );
+        QCOMPARE( averaged[ i ], current[ i ] );
+    }
+}
+
+void TestFrameAverage::testBlendMatchesFixedPoint()
+{
+    const size_t length = 35;
+    const float weight = 0.3f;
+    std::vector<uint8_t> current( length );
+    std::vector<uint16_t> average( length );
+    for( size_t i = 0; i < length; i++ )
+    {
+        current[ i ] = uint8_t( ( i * 37 ) % 256 );
+        average[ i ] = uint16_t( ( ( i * 91 ) % 256 ) * FrameAverage::FixedPointScale + i % 128 );
+    }
+    const std::vector<uint16_t> previous = average;
+    std::vector<uint8_t> averaged( length );
+
+    FrameAverage::blend( current.data(), average.data(), averaged.data(), length, weight, false );
+
+    for( size_t i = 0; i < length; i++ )
+    {
+        const double exact = weight * current[ i ] * FrameAverage::FixedPointScale + ( 1.0 - weight ) * previous[ i ];
+        QVERIFY( std::fabs( average[ i ] - exact ) <= 1.0 );
+        QCOMPARE( int( averaged[ i ] ), ( average[ i ] + FrameAverage::FixedPointScale / 2 ) >> 7 );
+    }
+}
+
+void TestFrameAverage::testConvergesToConstant()
+{
+    // The fraction bits keep the average from sticking below a steady input
+    const size_t length = 16;
+    std::vector<uint8_t> zero( length, 0 );
+    std::vector<uint8_t> current( length, 200 );
+    std::vector<uint16_t> average( length );
+    std::vector<uint8_t> averaged( length );
+
+    FrameAverage::blend( zero.data(), average.data(), averaged.data(), length, 0.1f, true );
+    for( int frame = 0; frame < 200; frame++ )
+    {
+        FrameAverage::blend( current.data(), average.data(), averaged.data(), length, 0.1f, false );
+    }
+    for( size_t i = 0; i < length; i++ )
+    {
+        QCOMPARE( int( averaged[ i ] ), 200 );
+    }
+}
+
+void TestFrameAverage::testNoOverflowAtFullScale()
+{
+    const size_t length = 24;
+    std::vector<uint8_t> current( length, 255 );
+    std::vector<uint16_t> average( length, 255 * FrameAverage::FixedPointScale );
+    std::vector<uint8_t> averaged( length );
+
+    FrameAverage::blend( current.data(), average.data(), averaged.data(), length, 0.5f, false );
+    for( size_t i = 0; i < length; i++ )
+    {
+        QCOMPARE( int( average[ i ] ), 255 * FrameAverage::FixedPointScale );
+        QCOMPARE( int( averaged[ i ] ), 255 );
+    }
+}
+
+void TestFrameAverage::testDelay()
+{
+    QCOMPARE( FrameAverage::delay_frames( 1.0f ), 0.0f );
+    QCOMPARE( FrameAverage::delay_frames( 0.25f ), 3.0f );
+    QVERIFY( std::isinf( FrameAverage::delay_frames( 0.0f ) ) );
+}
+
+QTEST_MAIN(TestFrameAverage)
+#include "main.moc"
@@ -0,0 +1,13 @@
+QT += testlib
+QT -= gui
+TARGET = linedecimationtest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+SOURCES += main.cpp \
+    ../../linedecimation.cpp
+
+INCLUDEPATH += . \
+    ../..
+
+HEADERS += ../../linedecimation.h
@@ -0,0 +1,170 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "linedecimation.h"
+
+/*
+ * LineDecimation: filter weights, output line counts, and the box and max results against
+ * sums done by hand, including the short last group of a revolution that does not divide evenly.
+ */
+class TestLineDecimation : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+void testWeightsSumTo256();
+void testFactorFor();
+void testOutputLinesCoverRevolution();
+void testBoxAveragesGroups();
+void testBoxAveragesShortLastGroup();
+void testMaxKeepsBrightestSample();
+void testGaussianKeepsFlatFrame();
+
+private:
+    static std::vector<uint8_t> rampFrame( size_t numberOfLines, size_t lineLength );
+};
+
+/*
+ * Each line a different level, each sample within it a little brighter
+ */
+std::vector<uint8_t> TestLineDecimation::rampFrame( size_t numberOfLines, size_t lineLength )
+{
+    std::vector<uint8_t> frame( numberOfLines * lineLength );
+    for( size_t line = 0; line < numberOfLines; line++ )
+    {
+        for( size_t sample = 0; sample < lineLength; sample++ )
+        {
+            frame[ line * lineLength + sample ] = uint8_t( ( line * 7 + sample ) % 256 );
+        }
+    }
+    return frame;
+}
+
+void TestLineDecimation::testWeightsSumTo256()
+{
+    const LineDecimation::Mode modes[] = { LineDecimation::Mode::Box, LineDecimation::Mode::Max, LineDecimation::Mode::Gaussian };
+    for( const auto mode : modes )
+    {
+        for( int factor = 1; factor <= LineDecimation::MaxFactor; factor++ )
+        {
+            const auto filter = LineDecimation::makeFilter( mode, factor );
+            QCOMPARE( std::accumulate( filter.weights.begin(), filter.weights.end(), 0 ), 256 );
+            QVERIFY( int( filter.weights.size() ) <= LineDecimation::MaxTaps );
+        }
+    }
+}
+
+void TestLineDecimation::testFactorFor()
+{
+    QCOMPARE( LineDecimation::factorFor( 4096, 1024 ), 4 );
+    QCOMPARE( LineDecimation::factorFor( 1000, 1024 ), 1 );
+    QCOMPARE( LineDecimation::factorFor( 100000, 1024 ), int( LineDecimation::MaxFactor ) );
+    QCOMPARE( LineDecimation::factorFor( 4096, 0 ), 1 );
+}
+
+void TestLineDecimation::testOutputLinesCoverRevolution()
+{
+    QCOMPARE( LineDecimation::outputLines( 4096, 4 ), size_t( 1024 ) );
+    QCOMPARE( LineDecimation::outputLines( 4097, 4 ), size_t( 1025 ) );
+    QCOMPARE( LineDecimation::outputLines( 4099, 4 ), size_t( 1025 ) );
+    QCOMPARE( LineDecimation::outputLines( 1000, 1 ), size_t( 1000 ) );
+}
+
+void TestLineDecimation::testBoxAveragesGroups()
+{
+    // 2 and 4 give exact weights of 128 and 64
+    const size_t lineLength = 37;
+    for( int factor : { 2, 4 } )
+    {
+        const size_t numberOfLines = 16;
+        const auto in = rampFrame( numberOfLines, lineLength );
+        const auto filter = LineDecimation::makeFilter( LineDecimation::Mode::Box, factor );
+        const size_t lines = LineDecimation::outputLines( numberOfLines, factor );
+        std::vector<uint8_t> out( lines * lineLength );
+
+        LineDecimation::decimate( in.data(), numberOfLines, lineLength, out.data(), filter );
+
+        for( size_t line = 0; line < lines; line++ )
+        {
+            for( size_t sample = 0; sample < lineLength; sample++ )
+            {
+                unsigned int sum{0};
+                for( int tap = 0; tap < factor; tap++ )
+                {
+                    sum += in[ ( line * factor + tap ) * lineLength + sample ];
+                }
+                QCOMPARE( int( out[ line * lineLength + sample ] ), int( ( sum + factor / 2 ) / factor ) );
+            }
+        }
+    }
+}
+
+void TestLineDecimation::testBoxAveragesShortLastGroup()
+{
+    // 18 lines in groups of 4: the last group has only lines 16 and 17
+    const size_t numberOfLines = 18;
+    const size_t lineLength = 40;
+    const int factor = 4;
+    const auto in = rampFrame( numberOfLines, lineLength );
+    const auto filter = LineDecimation::makeFilter( LineDecimation::Mode::Box, factor );
+    const size_t lines = LineDecimation::outputLines( numberOfLines, factor );
+    QCOMPARE( lines, size_t( 5 ) );
+    std::vector<uint8_t> out( lines * lineLength );
+
+    LineDecimation::decimate( in.data(), numberOfLines, lineLength, out.data(), filter );
+
+    const size_t last = lines - 1;
+    for( size_t sample = 0; sample < lineLength; sample++ )
+    {
+        const unsigned int sum = in[ 16 * lineLength + sample ] + in[ 17 * lineLength + sample ];
+        QCOMPARE( int( out[ last * lineLength + sample ] ), int( ( sum + 1 ) / 2 ) );
+    }
+}
+
+void TestLineDecimation::testMaxKeepsBrightestSample()
+{
+    const size_t numberOfLines = 11;
+    const size_t lineLength = 33;
+    const int factor = 3;
+    std::vector<uint8_t> in( numberOfLines * lineLength, 10 );
+    // A thin bright reflection on one line of each group, and on the last, short one
+    for( size_t line : { size_t( 1 ), size_t( 5 ), size_t( 10 ) } )
+    {
+        in[ line * lineLength + 20 ] = 250;
+    }
+    const auto filter = LineDecimation::makeFilter( LineDecimation::Mode::Max, factor );
+    const size_t lines = LineDecimation::outputLines( numberOfLines, factor );
+    std::vector<uint8_t> out( lines * lineLength );
+
+    LineDecimation::decimate( in.data(), numberOfLines, lineLength, out.data(), filter );
+
+    QCOMPARE( lines, size_t( 4 ) );
+    QCOMPARE( int( out[ 0 * lineLength + 20 ] ), 250 );
+    QCOMPARE( int( out[ 1 * lineLength + 20 ] ), 250 );
+    QCOMPARE( int( out[ 2 * lineLength + 20 ] ), 10 );
+    QCOMPARE( int( out[ 3 * lineLength + 20 ] ), 250 );
+    QCOMPARE( int( out[ 3 * lineLength + 19 ] ), 10 );
+}
+
+void TestLineDecimation::testGaussianKeepsFlatFrame()
+{
+    // Rescaled weights of a short group must still add up to one
+    const size_t numberOfLines = 23;
+    const size_t lineLength = 48;
+    const std::vector<uint8_t> in( numberOfLines * lineLength, 173 );
+    for( int factor = 2; factor <= 6; factor++ )
+    {
+        const auto filter = LineDecimation::makeFilter( LineDecimation::Mode::Gaussian, factor );
+        const size_t lines = LineDecimation::outputLines( numberOfLines, factor );
+        std::vector<uint8_t> out( lines * lineLength );
+
+        LineDecimation::decimate( in.data(), numberOfLines, lineLength, out.data(), filter );
+        QVERIFY( std::all_of( out.begin(), out.end(), []( uint8_t sample ) { return sample == 173; } ) );
+    }
+}
+
+QTEST_MAIN(TestLineDecimation)
+#include "main.moc"
@@ -0,0 +1,183 @@
+#include <QtTest/QtTest>
+#include <QSettings>
+#include <QTemporaryDir>
+
+#include "defaults.h"
+#include "opencltuning.h"
+
+namespace{
+const QString TestDeviceKey = "OpenClTuningTest";
+}
+
+/*
+ * OpenClTuning: which image formats the kernels can read, the candidates the tuner tries and
+ * the settings it keeps. Settings go to a file of the test's own, never OpenClTuningFile.
+ */
+class TestOpenClTuning : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+void init();
+void cleanup();
+
+void testReadableFormats();
+void testDescribe();
+void testCandidates();
+void testSaveLoad();
+void testUnreadableSavedFormat();
+void testVersionMismatch();
+
+private:
+    QTemporaryDir* m_dir{nullptr};
+    QString m_tuningFile;
+};
+
+void TestOpenClTuning::init()
+{
+    m_dir = new QTemporaryDir();
+    QVERIFY( m_dir->isValid() );
+    m_tuningFile = m_dir->filePath( "openclTuning.ini" );
+}
+
+void TestOpenClTuning::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void TestOpenClTuning::testReadableFormats()
+{
+    QVERIFY( OpenClTuning::isReadableFormat( { CL_R, CL_UNSIGNED_INT8 } ) );
+    QVERIFY( OpenClTuning::isReadableFormat( { CL_R, CL_UNSIGNED_INT16 } ) );
+    QVERIFY( OpenClTuning::isReadableFormat( { CL_RGBA, CL_UNSIGNED_INT32 } ) );
+
+    // read_imageui is undefined for normalized and signed types
+    QVERIFY( !OpenClTuning::isReadableFormat( { CL_INTENSITY, CL_UNORM_INT8 } ) );
+    QVERIFY( !OpenClTuning::isReadableFormat( { CL_R, CL_UNORM_INT8 } ) );
+    QVERIFY( !OpenClTuning::isReadableFormat( { CL_R, CL_SIGNED_INT8 } ) );
+    QVERIFY( !OpenClTuning::isReadableFormat( { CL_R, CL_FLOAT } ) );
+}
+
+void TestOpenClTuning::testDescribe()
+{
+    OpenClTuning::Settings_t settings;
+    QCOMPARE( OpenClTuning::describe( settings ), QString( "R/UINT8, copy host ptr, warp work-group 16x16" ) );
+
+    settings.imageFormat = { CL_RGBA, CL_UNSIGNED_INT16 };
+    settings.uploadMemFlags = CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR;
+    settings.warpLocalSize[ 0 ] = 0;
+    settings.warpLocalSize[ 1 ] = 0;
+    QCOMPARE( OpenClTuning::describe( settings ), QString( "RGBA/UINT16, use host ptr, warp work-group driver" ) );
+}
+
+void TestOpenClTuning::testCandidates()
+{
+    cl_platform_id platform{nullptr};
+    cl_uint numPlatforms{0};
+    if( ( clGetPlatformIDs( 1, &platform, &numPlatforms ) != CL_SUCCESS ) || ( numPlatforms == 0 ) )
+    {
+        QSKIP( "No OpenCL platform" );
+    }
+    cl_device_id device{nullptr};
+    if( clGetDeviceIDs( platform, CL_DEVICE_TYPE_ALL, 1, &device, nullptr ) != CL_SUCCESS )
+    {
+        QSKIP( "No OpenCL device" );
+    }
+    cl_int err{CL_SUCCESS};
+    cl_context context = clCreateContext( nullptr, 1, &device, nullptr, nullptr, &err );
+    QCOMPARE( err, CL_SUCCESS );
+
+    const size_t MaxWorkGroupSize = 128;
+    const auto candidates = OpenClTuning::candidates( context, MaxWorkGroupSize );
+    clReleaseContext( context );
+
+    QVERIFY( !candidates.empty() );
+
+    // The defaults come first so a failed tune still runs as before
+    const OpenClTuning::Settings_t defaults;
+    QCOMPARE( candidates.front().imageFormat.image_channel_order, defaults.imageFormat.image_channel_order );
+    QCOMPARE( candidates.front().imageFormat.image_channel_data_type, defaults.imageFormat.image_channel_data_type );
+    QCOMPARE( candidates.front().uploadMemFlags, defaults.uploadMemFlags );
+    QCOMPARE( candidates.front().warpLocalSize[ 0 ], defaults.warpLocalSize[ 0 ] );
+    QCOMPARE( candidates.front().warpLocalSize[ 1 ], defaults.warpLocalSize[ 1 ] );
+
+    bool hasDriverChoice{false};
+    for( const auto& candidate : candidates )
+    {
+        QVERIFY( OpenClTuning::isReadableFormat( candidate.imageFormat ) );
+
+        const size_t x = candidate.warpLocalSize[ 0 ];
+        const size_t y = candidate.warpLocalSize[ 1 ];
+        if( x == 0 )
+        {
+            hasDriverChoice = true;
+            continue;
+        }
+        QVERIFY( x * y <= MaxWorkGroupSize );
+        QCOMPARE( SectorAlignment_px % int( x ), 0 );
+        QCOMPARE( SectorAlignment_px % int( y ), 0 );
+    }
+    QVERIFY( hasDriverChoice );
+}
+
+void TestOpenClTuning::testSaveLoad()
+{
+    OpenClTuning::Settings_t saved;
+    saved.imageFormat = { CL_R, CL_UNSIGNED_INT8 };
+    saved.uploadMemFlags = CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR;
+    saved.warpLocalSize[ 0 ] = 32;
+    saved.warpLocalSize[ 1 ] = 8;
+    saved.warp_ms = 1.25;
+    saved.sectorSize_px = 1024;
+    OpenClTuning::save( TestDeviceKey, saved, m_tuningFile );
+
+    OpenClTuning::Settings_t loaded;
+    QVERIFY( OpenClTuning::load( TestDeviceKey, loaded, m_tuningFile ) );
+    QCOMPARE( loaded.imageFormat.image_channel_order, saved.imageFormat.image_channel_order );
+    QCOMPARE( loaded.imageFormat.image_channel_data_type, saved.imageFormat.image_channel_data_type );
+    QCOMPARE( loaded.uploadMemFlags, saved.uploadMemFlags );
+    QCOMPARE( loaded.warpLocalSize[ 0 ], saved.warpLocalSize[ 0 ] );
+    QCOMPARE( loaded.warpLocalSize[ 1 ], saved.warpLocalSize[ 1 ] );
+    QCOMPARE( loaded.warp_ms, saved.warp_ms );
+    QCOMPARE( loaded.sectorSize_px, saved.sectorSize_px );
+}
+
+void TestOpenClTuning::testUnreadableSavedFormat()
+{
+    OpenClTuning::Settings_t saved;
+    saved.imageFormat = { CL_INTENSITY, CL_UNORM_INT8 };
+    saved.warpLocalSize[ 0 ] = 8;
+    saved.warpLocalSize[ 1 ] = 8;
+    OpenClTuning::save( TestDeviceKey, saved, m_tuningFile );
+
+    // A rejected file leaves the caller's settings alone
+    OpenClTuning::Settings_t settings;
+    QVERIFY( !OpenClTuning::load( TestDeviceKey, settings, m_tuningFile ) );
+    QCOMPARE( settings.imageFormat.image_channel_order, cl_channel_order( CL_R ) );
+    QCOMPARE( settings.imageFormat.image_channel_data_type, cl_channel_type( CL_UNSIGNED_INT8 ) );
+    QCOMPARE( settings.warpLocalSize[ 0 ], size_t( 16 ) );
+    QCOMPARE( settings.warpLocalSize[ 1 ], size_t( 16 ) );
+}
+
+void TestOpenClTuning::testVersionMismatch()
+{
+    OpenClTuning::save( TestDeviceKey, OpenClTuning::Settings_t(), m_tuningFile );
+    {
+        QSettings tuning( m_tuningFile, QSettings::IniFormat );
+        tuning.beginGroup( TestDeviceKey );
+        tuning.setValue( "version", 1 );
+        tuning.endGroup();
+        tuning.sync();
+    }
+
+    OpenClTuning::Settings_t settings;
+    QVERIFY( !OpenClTuning::load( TestDeviceKey, settings, m_tuningFile ) );
+
+    // Nothing saved for this device
+    QVERIFY( !OpenClTuning::load( "OtherDevice", settings, m_tuningFile ) );
+}
+
+QTEST_MAIN(TestOpenClTuning)
+#include "main.moc"
@@ -0,0 +1,20 @@
+QT += testlib
+QT -= gui
+TARGET = opencltuningtest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+SOURCES += main.cpp \
+    ../../opencltuning.cpp \
+    ../stubs/logger.cpp
+
+INCLUDEPATH += . \
+    ../.. \
+    ../../../../../Common/Include \
+    ../../../../../lib/amd64/Intel/OpenCL_SDK/7.0/include
+
+HEADERS += ../../opencltuning.h \
+    ../../../../../Common/Include/defaults.h \
+    ../../../../../Common/Include/logger.h
+
+LIBS += -L../../../../../lib/amd64/Intel/OpenCL_SDK/7.0/lib/x64/ -lOpenCL
@@ -0,0 +1,147 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include <vector>
+
+#include "specklefilter.h"
+
+/*
+ * Checks the SIMD median networks of SpeckleFilter against a plain sort-based median with the
+ * same edge rules: lines wrap around, samples past either end of a line repeat the end sample.
+ */
+class TestSpeckleFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+void testFastMatchesReference();
+void testQualityMatchesReference();
+void testSse2MatchesReference();
+void testOffCopies();
+void testKeepsEdge();
+
+private:
+    static std::vector<uint8_t> randomFrame( size_t numberOfLines, size_t lineLength, uint32_t seed );
+    static std::vector<uint8_t> reference( const std::vector<uint8_t>& in, size_t numberOfLines, size_t lineLength, int radius );
+};
+
+std::vector<uint8_t> TestSpeckleFilter::randomFrame( size_t numberOfLines, size_t lineLength, uint32_t seed )
+{
+    std::vector<uint8_t> frame( numberOfLines * lineLength );
+    for( auto& sample : frame )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        sample = uint8_t( seed >> 24 );
+    }
+    return frame;
+}
+
+/*
+ * Median across the lines for every sample, then median along the line of those
+ */
+std::vector<uint8_t> TestSpeckleFilter::reference( const std::vector<uint8_t>& in, size_t numberOfLines, size_t lineLength, int radius )
+{
+    std::vector<uint8_t> across( in.size() );
+    std::vector<uint8_t> window;
+    for( size_t line = 0; line < numberOfLines; line++ )
+    {
+        for( size_t sample = 0; sample < lineLength; sample++ )
+        {
+            window.clear();
+            for( int offset = -radius; offset <= radius; offset++ )
+            {
+                const size_t neighbour = ( line + numberOfLines + offset ) % numberOfLines;
+                window.push_back( in[ neighbour * lineLength + sample ] );
+            }
+            std::sort( window.begin(), window.end() );
+            across[ line * lineLength + sample ] = window[ radius ];
+        }
+    }
+
+    std::vector<uint8_t> out( in.size() );
+    for( size_t line = 0; line < numberOfLines; line++ )
+    {
+        for( size_t sample = 0; sample < lineLength; sample++ )
+        {
+            window.clear();
+            for( int offset = -radius; offset <= radius; offset++ )
+            {
+                const long long neighbour = std::max( 0LL, std::min( (long long)( lineLength ) - 1, (long long)( sample ) + offset ) );
+                window.push_back( across[ line * lineLength + size_t( neighbour ) ] );
+            }
+            std::sort( window.begin(), window.end() );
+            out[ line * lineLength + sample ] = window[ radius ];
+        }
+    }
+    return out;
+}
+
+void TestSpeckleFilter::testFastMatchesReference()
+{
+    // A line length that is not a multiple of the vector width exercises the scalar tail
+    const size_t numberOfLines = 37;
+    const size_t lineLength = 101;
+    const auto in = randomFrame( numberOfLines, lineLength, 1 );
+    std::vector<uint8_t> out( in.size() );
+
+    SpeckleFilter::filter( in.data(), numberOfLines, lineLength, out.data(), SpeckleFilter::Mode::Fast );
+    QVERIFY( out == reference( in, numberOfLines, lineLength, 1 ) );
+}
+
+void TestSpeckleFilter::testQualityMatchesReference()
+{
+    const size_t numberOfLines = 64;
+    const size_t lineLength = 133;
+    const auto in = randomFrame( numberOfLines, lineLength, 2 );
+    std::vector<uint8_t> out( in.size() );
+
+    SpeckleFilter::filter( in.data(), numberOfLines, lineLength, out.data(), SpeckleFilter::Mode::Quality );
+    QVERIFY( out == reference( in, numberOfLines, lineLength, 2 ) );
+}
+
+void TestSpeckleFilter::testSse2MatchesReference()
+{
+    const size_t numberOfLines = 5;
+    const size_t lineLength = 70;
+    const auto in = randomFrame( numberOfLines, lineLength, 3 );
+    std::vector<uint8_t> out( in.size() );
+
+    SpeckleFilter::filterSse2( in.data(), numberOfLines, lineLength, out.data(), SpeckleFilter::Mode::Fast );
+    QVERIFY( out == reference( in, numberOfLines, lineLength, 1 ) );
+
+    SpeckleFilter::filterSse2( in.data(), numberOfLines, lineLength, out.data(), SpeckleFilter::Mode::Quality );
+    QVERIFY( out == reference( in, numberOfLines, lineLength, 2 ) );
+}
+
+void TestSpeckleFilter::testOffCopies()
+{
+    const size_t numberOfLines = 8;
+    const size_t lineLength = 40;
+    const auto in = randomFrame( numberOfLines, lineLength, 4 );
+    std::vector<uint8_t> out( in.size() );
+
+    SpeckleFilter::filter( in.data(), numberOfLines, lineLength, out.data(), SpeckleFilter::Mode::Off );
+    QVERIFY( out == in );
+}
+
+void TestSpeckleFilter::testKeepsEdge()
+{
+    // A step along the A-line, e.g. the lumen wall, stays where it is
+    const size_t numberOfLines = 16;
+    const size_t lineLength = 64;
+    std::vector<uint8_t> in( numberOfLines * lineLength );
+    for( size_t line = 0; line < numberOfLines; line++ )
+    {
+        for( size_t sample = 0; sample < lineLength; sample++ )
+        {
+            in[ line * lineLength + sample ] = sample < 30 ? 20 : 200;
+        }
+    }
+    std::vector<uint8_t> out( in.size() );
+
+    SpeckleFilter::filter( in.data(), numberOfLines, lineLength, out.data(), SpeckleFilter::Mode::Quality );
+    QVERIFY( out == in );
+}
+
+QTEST_MAIN(TestSpeckleFilter)
+#include "main.moc"
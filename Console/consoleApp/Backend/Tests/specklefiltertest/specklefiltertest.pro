@@ -0,0 +1,13 @@
+QT += testlib
+QT -= gui
+TARGET = specklefiltertest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+SOURCES += main.cpp \
+    ../../specklefilter.cpp
+
+INCLUDEPATH += . \
+    ../..
+
+HEADERS += ../../specklefilter.h
@@ -0,0 +1,174 @@
+#include <QtTest/QtTest>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSignalSpy>
+#include <QStringList>
+#include <QThread>
+
+#include "startupgraph.h"
+
+/*
+ * StartupGraph: steps run after their dependencies, a failed dependency skips its dependents,
+ * failing steps are retried, and external steps are finished by recordTiming().
+ *
+ * The graph is a singleton, so every test registers its own steps under a prefix and runs
+ * them all to completion before the next test starts. finished() reports on every step so
+ * far; only the first test can expect it to be true.
+ */
+class TestStartupGraph : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+void testDependencyOrder();
+void testFailedDependencySkipped();
+void testRetries();
+void testExternalStep();
+void testUnregisteredStep();
+
+private:
+    void record( const QString& name );
+    QStringList takeRecorded();
+
+    QMutex m_mutex;
+    QStringList m_recorded;
+};
+
+void TestStartupGraph::record( const QString &name )
+{
+    QMutexLocker lock( &m_mutex );
+    m_recorded.append( name );
+}
+
+QStringList TestStartupGraph::takeRecorded()
+{
+    QMutexLocker lock( &m_mutex );
+    QStringList recorded = m_recorded;
+    m_recorded.clear();
+    return recorded;
+}
+
+void TestStartupGraph::testDependencyOrder()
+{
+    StartupGraph* graph = StartupGraph::instance();
+    QSignalSpy finished( graph, SIGNAL(finished(bool)) );
+
+    // A diamond: b and c need a, d needs both
+    graph->addStep( "order.d", { "order.b", "order.c" }, [this]() { record( "order.d" ); return true; } );
+    graph->addStep( "order.b", { "order.a" }, [this]() { QThread::msleep( 20 ); record( "order.b" ); return true; } );
+    graph->addStep( "order.c", { "order.a" }, [this]() { record( "order.c" ); return true; } );
+    graph->addStep( "order.a", {}, [this]() { QThread::msleep( 20 ); record( "order.a" ); return true; } );
+    graph->start();
+
+    QVERIFY( graph->waitFor( "order.d" ) );
+    QVERIFY( graph->waitFor( "order.a" ) );
+
+    const QStringList recorded = takeRecorded();
+    QCOMPARE( recorded.size(), 4 );
+    QCOMPARE( recorded.first(), QString( "order.a" ) );
+    QCOMPARE( recorded.last(), QString( "order.d" ) );
+    QVERIFY( recorded.contains( "order.b" ) );
+    QVERIFY( recorded.contains( "order.c" ) );
+
+    QTRY_COMPARE( finished.count(), 1 );
+    QCOMPARE( finished.first().first().toBool(), true );
+}
+
+void TestStartupGraph::testFailedDependencySkipped()
+{
+    StartupGraph* graph = StartupGraph::instance();
+    QSignalSpy finished( graph, SIGNAL(finished(bool)) );
+
+    graph->addStep( "skip.a", {}, [this]() { record( "skip.a" ); return false; } );
+    graph->addStep( "skip.b", { "skip.a" }, [this]() { record( "skip.b" ); return true; } );
+    graph->addStep( "skip.c", { "skip.b" }, [this]() { record( "skip.c" ); return true; } );
+    graph->addStep( "skip.independent", {}, [this]() { record( "skip.independent" ); return true; } );
+    graph->start();
+
+    QVERIFY( !graph->waitFor( "skip.a" ) );
+    QVERIFY( !graph->waitFor( "skip.b" ) );
+    QVERIFY( !graph->waitFor( "skip.c" ) );
+    QVERIFY( graph->waitFor( "skip.independent" ) );
+
+    // Only the failing step and the unrelated one ran
+    QStringList recorded = takeRecorded();
+    recorded.sort();
+    QCOMPARE( recorded, QStringList( { "skip.a", "skip.independent" } ) );
+
+    QTRY_COMPARE( finished.count(), 1 );
+    QCOMPARE( finished.first().first().toBool(), false );
+    QVERIFY( graph->report().contains( "FAILED" ) );
+}
+
+void TestStartupGraph::testRetries()
+{
+    StartupGraph* graph = StartupGraph::instance();
+    QSignalSpy finished( graph, SIGNAL(finished(bool)) );
+
+    // Succeeds on the third of three tries
+    QAtomicInt flakyAttempts( 0 );
+    graph->addStep( "retry.flaky", {}, [&flakyAttempts]() { return flakyAttempts.fetchAndAddOrdered( 1 ) >= 2; }, 3, 1 );
+
+    // Never succeeds; tried exactly twice
+    QAtomicInt brokenAttempts( 0 );
+    graph->addStep( "retry.broken", {}, [&brokenAttempts]() { brokenAttempts.fetchAndAddOrdered( 1 ); return false; }, 2, 1 );
+    graph->start();
+
+    QVERIFY( graph->waitFor( "retry.flaky" ) );
+    QCOMPARE( flakyAttempts.loadAcquire(), 3 );
+    QVERIFY( !graph->waitFor( "retry.broken" ) );
+    QCOMPARE( brokenAttempts.loadAcquire(), 2 );
+
+    QTRY_COMPARE( finished.count(), 1 );
+}
+
+void TestStartupGraph::testExternalStep()
+{
+    StartupGraph* graph = StartupGraph::instance();
+    QSignalSpy finished( graph, SIGNAL(finished(bool)) );
+    QSignalSpy stepFinished( graph, SIGNAL(stepFinished(QString,bool,qint64)) );
+
+    graph->addStep( "external.before", {}, [this]() { record( "external.before" ); return true; } );
+    graph->addExternalStep( "external.discovery", { "external.before" } );
+    graph->addStep( "external.after", { "external.discovery" }, [this]() { record( "external.after" ); return true; } );
+    graph->start();
+
+    QVERIFY( graph->waitFor( "external.before" ) );
+
+    // Nothing runs the external step; its dependents wait for recordTiming()
+    QCOMPARE( takeRecorded(), QStringList( { "external.before" } ) );
+    QVERIFY( graph->report().contains( "running" ) );
+    QCOMPARE( finished.count(), 0 );
+
+    graph->recordTiming( "external.discovery", 5 );
+    QVERIFY( graph->waitFor( "external.discovery" ) );
+    QVERIFY( graph->waitFor( "external.after" ) );
+    QCOMPARE( takeRecorded(), QStringList( { "external.after" } ) );
+
+    bool isDiscoveryReported{false};
+    for( const auto& arguments : stepFinished )
+    {
+        isDiscoveryReported = isDiscoveryReported || ( arguments.at( 0 ).toString() == "external.discovery" );
+    }
+    QVERIFY( isDiscoveryReported );
+
+    QTRY_COMPARE( finished.count(), 1 );
+}
+
+void TestStartupGraph::testUnregisteredStep()
+{
+    StartupGraph* graph = StartupGraph::instance();
+
+    // Never registered counts as done
+    QVERIFY( graph->waitFor( "unregistered" ) );
+
+    // Timing for an unregistered step only goes into the report
+    graph->recordTiming( "unregistered.timing", 7 );
+    QVERIFY( graph->report().contains( "unregistered.timing" ) );
+    QVERIFY( graph->waitFor( "unregistered.timing" ) );
+}
+
+QTEST_MAIN(TestStartupGraph)
+#include "main.moc"
@@ -0,0 +1,16 @@
+QT += testlib concurrent
+QT -= gui
+TARGET = startupgraphtest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+SOURCES += main.cpp \
+    ../../startupgraph.cpp \
+    ../stubs/logger.cpp
+
+INCLUDEPATH += . \
+    ../.. \
+    ../../../../../Common/Include
+
+HEADERS += ../../startupgraph.h \
+    ../../../../../Common/Include/logger.h
@@ -14,6 +14,19 @@
 #include "logger.h"
 #include "defaults.h"
 
+Logger* Logger::theLogger{nullptr};
+
+/*
+ * Instance
+ */
+Logger & Logger::Instance() {
+    if( !theLogger )
+    {
+        theLogger = new Logger();
+    }
+    return *theLogger;
+}
+
 /*
  * Constructor
  *
@@ -42,7 +55,7 @@ Logger::~Logger()
  * determine what went wrong.  The log is typically created before the
  * rest of the system is initialized so there is no one to send signals to.
  */
-bool Logger::init( void )
+bool Logger::init( QString /*applicationName*/ )
 {
     bool isOk = true;
 
@@ -59,3 +72,27 @@ void Logger::logMessage( QString /*msg*/, const char * /*severity*/, const char
 {
 
 }
+
+/*
+ * close
+ */
+void Logger::close( void )
+{
+
+}
+
+/*
+ * logDebugMessage
+ */
+void Logger::logDebugMessage( const QString & /*msg*/, const char * /*function*/, int /*line*/, Qt::HANDLE /*tId*/ )
+{
+
+}
+
+/*
+ * logButtonMessage
+ */
+void Logger::logButtonMessage( const QString & /*msg*/, const char * /*function*/, int /*line*/, Qt::HANDLE /*tId*/ )
+{
+
+}
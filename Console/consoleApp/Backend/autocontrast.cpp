@@ -0,0 +1,144 @@
+#include "autocontrast.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace{
+// Most of an OCT frame is noise floor; it maps to black and the brightest speckle to white
+const float BlackPointFraction = 0.30f;
+const float WhitePointFraction = 0.995f;
+
+// Narrower ranges would blow up the noise floor into the image
+const float MinimumSpan = 32.0f;
+
+// Weight of the newest frame; at ~16 frames/s the levels settle in about half a second
+const float SmoothingFactor = 0.1f;
+}
+
+/*
+ * accumulateHistogram
+ *
+ * Eight samples are loaded at a time and spread over four sub-histograms, so consecutive
+ * samples of the same value do not serialize on one counter.
+ */
+void AutoContrast::accumulateHistogram( const uint8_t *frame, int numberOfLines, int lineLength,
+                                        int firstSample, int lineStride, uint32_t *histogram )
+{
+    uint32_t subHistogram[ 4 ][ NumberOfBins ];
+    memset( subHistogram, 0, sizeof( subHistogram ) );
+
+    firstSample = std::max( 0, std::min( firstSample, lineLength ) );
+    lineStride  = std::max( 1, lineStride );
+
+    for( int line = 0; line < numberOfLines; line += lineStride )
+    {
+        const uint8_t* sample = frame + size_t( line ) * lineLength + firstSample;
+        const uint8_t* end = frame + size_t( line + 1 ) * lineLength;
+
+        while( end - sample >= 8 )
+        {
+            uint64_t eight;
+            memcpy( &eight, sample, sizeof( eight ) );
+            ++subHistogram[ 0 ][ eight         & 0xff ];
+            ++subHistogram[ 1 ][ (eight >> 8)  & 0xff ];
+            ++subHistogram[ 2 ][ (eight >> 16) & 0xff ];
+            ++subHistogram[ 3 ][ (eight >> 24) & 0xff ];
+            ++subHistogram[ 0 ][ (eight >> 32) & 0xff ];
+            ++subHistogram[ 1 ][ (eight >> 40) & 0xff ];
+            ++subHistogram[ 2 ][ (eight >> 48) & 0xff ];
+            ++subHistogram[ 3 ][ (eight >> 56) & 0xff ];
+            sample += 8;
+        }
+        while( sample < end )
+        {
+            ++subHistogram[ 0 ][ *sample++ ];
+        }
+    }
+
+    for( int bin = 0; bin < NumberOfBins; bin++ )
+    {
+        histogram[ bin ] += subHistogram[ 0 ][ bin ] + subHistogram[ 1 ][ bin ] + subHistogram[ 2 ][ bin ] + subHistogram[ 3 ][ bin ];
+    }
+}
+
+/*
+ * update
+ *
+ * Moves the black and white points toward this frame's percentiles.
+ */
+void AutoContrast::update( const uint32_t *histogram )
+{
+    uint64_t total{0};
+    for( int bin = 0; bin < NumberOfBins; bin++ )
+    {
+        total += histogram[ bin ];
+    }
+    if( total == 0 )
+    {
+        return;
+    }
+
+    const uint64_t blackCount = uint64_t( BlackPointFraction * total );
+    const uint64_t whiteCount = uint64_t( WhitePointFraction * total );
+    int blackBin{-1};
+    int whiteBin{NumberOfBins - 1};
+    uint64_t sum{0};
+    for( int bin = 0; bin < NumberOfBins; bin++ )
+    {
+        sum += histogram[ bin ];
+        if( ( blackBin < 0 ) && ( sum >= blackCount ) )
+        {
+            blackBin = bin;
+        }
+        if( sum >= whiteCount )
+        {
+            whiteBin = bin;
+            break;
+        }
+    }
+
+    float black = float( std::max( blackBin, 0 ) );
+    float white = float( whiteBin );
+    if( white - black < MinimumSpan )
+    {
+        white = std::min( 255.0f, black + MinimumSpan );
+        black = white - MinimumSpan;
+    }
+
+    if( m_isInitialized )
+    {
+        m_blackPoint += SmoothingFactor * ( black - m_blackPoint );
+        m_whitePoint += SmoothingFactor * ( white - m_whitePoint );
+    }
+    else
+    {
+        m_blackPoint = black;
+        m_whitePoint = white;
+        m_isInitialized = true;
+    }
+    updateBrightnessAndContrast();
+}
+
+void AutoContrast::reset()
+{
+    m_isInitialized = false;
+    m_blackPoint = 0.0f;
+    m_whitePoint = 255.0f;
+    updateBrightnessAndContrast();
+}
+
+/*
+ * updateBrightnessAndContrast
+ *
+ * The kernel adds brightness and then applies the contrast correction
+ * f = 259 (C + 255) / (255 (259 - C)) around 128. Solve for the values that map the black
+ * point to 0 and the white point to 255.
+ */
+void AutoContrast::updateBrightnessAndContrast()
+{
+    const float gain = 255.0f / std::max( MinimumSpan, m_whitePoint - m_blackPoint );
+    const float contrast = 259.0f * 255.0f * ( gain - 1.0f ) / ( 259.0f + 255.0f * gain );
+
+    m_contrast = std::max( -255, std::min( 255, int( std::lround( contrast ) ) ) );
+    m_brightness = std::max( -255, std::min( 255, int( std::lround( 128.0f - 128.0f / gain - m_blackPoint ) ) ) );
+}
@@ -0,0 +1,47 @@
+#ifndef AUTOCONTRAST_H
+#define AUTOCONTRAST_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* AutoContrast turns a per-frame intensity histogram into black and white points and then into
+* the brightness and contrast values the warp kernel takes. The points are smoothed over time,
+* so a single bright or dark frame does not make the image flicker. The histogram normally comes
+* from the warp kernel itself; accumulateHistogram() is the CPU path for when it does not.
+*/
+class AutoContrast
+{
+public:
+    static const int NumberOfBins = 256;
+    using Histogram_t = std::array<uint32_t, NumberOfBins>;
+
+    /*
+     * Adds every lineStride-th line of a polar frame to the histogram, skipping the first
+     * firstSample samples (catheter and mask) of each line
+     */
+    static void accumulateHistogram( const uint8_t* frame, int numberOfLines, int lineLength,
+                                     int firstSample, int lineStride, uint32_t* histogram );
+
+    void update( const uint32_t* histogram );
+    void reset();
+
+    // In the units of the warp kernel's brightness and contrast arguments
+    const int* brightness() const { return &m_brightness; }
+    const int* contrast() const { return &m_contrast; }
+
+    float blackPoint() const { return m_blackPoint; }
+    float whitePoint() const { return m_whitePoint; }
+
+private:
+    void updateBrightnessAndContrast();
+
+    bool  m_isInitialized{false};
+    float m_blackPoint{0.0f};
+    float m_whitePoint{255.0f};
+    int   m_brightness{0};
+    int   m_contrast{0};
+};
+
+#endif // AUTOCONTRAST_H
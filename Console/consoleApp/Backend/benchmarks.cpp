@@ -0,0 +1,483 @@
+#include "benchmarks.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cmath>
+#include <vector>
+#include "autocontrast.h"
+#include "frameaverage.h"
+#include "spectralpipeline.h"
+#include "linedecimation.h"
+#include "specklefilter.h"
+#include "pipelinemetrics.h"
+#include "scanconversion.h"
+#include "signalmodel.h"
+#include "Utility/userSettings.h"
+#include "defaults.h"
+#include "logger.h"
+
+namespace{
+// A 1024 line frame of 1024 samples
+const int BenchmarkLines = 1024;
+const int BenchmarkFrames = 200;
+
+// A slow pullback revolution: many more lines than the sector can show
+const int DecimationBenchmarkLines = 10000;
+
+// A fast revolution the speckle filter has to handle
+const int SpeckleBenchmarkLines = 2000;
+
+const double AutoContrastBudget_ms = 0.5;
+const double SpeckleFilterBudget_ms = 2.0;
+const double FrameAverageBudget_ms = 1.0;
+
+// The laser sweep rate the spectral pipeline has to keep up with
+const double ScanRate_ALinesPerSecond = 100000.0 / (LASER_SCAN_DIVIDER + 1);
+
+/*
+ * A frame that looks enough like OCT for the statistics: a dark noise floor with a bright
+ * band that fades with depth.
+ */
+struct BenchmarkFrame_t
+{
+    explicit BenchmarkFrame_t(int lines = BenchmarkLines)
+        : acqData(size_t(FFT_DATA_SIZE) * lines), dispData(size_t(MaxSectorSize_px) * MaxSectorSize_px)
+    {
+        uint32_t seed{12345};
+        for(int line = 0; line < lines; line++){
+            for(int sample = 0; sample < FFT_DATA_SIZE; sample++){
+                seed = seed * 1664525u + 1013904223u;
+                const int noise = int(seed >> 27);
+                const int tissue = (sample > 100 && sample < 600) ? 180 - sample / 4 : 0;
+                acqData[size_t(line) * FFT_DATA_SIZE + sample] = uint8_t(qBound(0, 20 + noise + tissue, 255));
+            }
+        }
+        frame.acqData = acqData.data();
+        frame.dispData = dispData.data();
+        frame.bufferLength = size_t(lines);
+    }
+
+    std::vector<uint8_t> acqData;
+    std::vector<uint8_t> dispData;
+    OCTFile::OctData_t frame;
+};
+
+void report(QTextStream& out, const QString& name, double value_ms)
+{
+    const QString line = QString("%1: %2 ms/frame").arg(name, -48).arg(value_ms, 0, 'f', 3);
+    out << line << endl;
+    LOG( INFO, line )
+}
+
+void setUpSignalModel()
+{
+    auto* sm = SignalModel::instance();
+    sm->setCatheterRadius_um(406.0f);
+    sm->setInternalImagingMask_px(135.0f);
+    sm->setStandardDepth_mm(3.18f);
+    sm->setALineLength_px(512);
+    sm->setFractionOfCanvas(0.5f);
+    sm->setImagingDepth_S(512);
+}
+
+/*
+ * Milliseconds per frame for the full warp, including upload and read back
+ */
+double timeWarp(ScanConversion& scanConversion, BenchmarkFrame_t& input, int frames)
+{
+    // First frames pay for lazy allocations in the driver
+    for(int i = 0; i < 5; i++){
+        scanConversion.warpData(&input.frame, input.frame.bufferLength);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < frames; i++){
+        scanConversion.warpData(&input.frame, input.frame.bufferLength);
+    }
+    return timer.nsecsElapsed() / 1.0e6 / frames;
+}
+
+/*
+ * benchmarkAutoContrast
+ *
+ * Cost of auto contrast per 1024x1024 frame: the CPU histogram path, and the warp with and
+ * without the histogram reduction in the kernel.
+ */
+bool benchmarkAutoContrast(QTextStream& out, ScanConversion* scanConversion, BenchmarkFrame_t& input)
+{
+    bool isWithinBudget{true};
+    AutoContrast autoContrast;
+    AutoContrast::Histogram_t histogram;
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < BenchmarkFrames; i++){
+        histogram.fill(0);
+        AutoContrast::accumulateHistogram(input.acqData.data(), BenchmarkLines, FFT_DATA_SIZE, 135, 4, histogram.data());
+        autoContrast.update(histogram.data());
+    }
+    const double cpu_ms = timer.nsecsElapsed() / 1.0e6 / BenchmarkFrames;
+    report(out, "Auto contrast, CPU histogram (every 4th line)", cpu_ms);
+    isWithinBudget = isWithinBudget && (cpu_ms < AutoContrastBudget_ms);
+
+    if(scanConversion){
+        auto* sm = SignalModel::instance();
+        sm->setIsAutoContrast(false);
+        const double plain_ms = timeWarp(*scanConversion, input, BenchmarkFrames);
+        sm->setIsAutoContrast(true);
+        const double auto_ms = timeWarp(*scanConversion, input, BenchmarkFrames);
+        sm->setIsAutoContrast(false);
+
+        report(out, "Warp", plain_ms);
+        report(out, "Warp with auto contrast histogram", auto_ms);
+        report(out, "Auto contrast, added by the GPU histogram", auto_ms - plain_ms);
+        isWithinBudget = isWithinBudget && (auto_ms - plain_ms < AutoContrastBudget_ms);
+    }
+
+    out << QString("Auto contrast budget %1 ms: %2").arg(AutoContrastBudget_ms).arg(isWithinBudget ? "met" : "EXCEEDED") << endl;
+    return isWithinBudget;
+}
+
+/*
+ * benchmarkFrameAverage
+ *
+ * Cost of temporal averaging per 1024x1024 frame: the CPU fallback, and the warp with and
+ * without the average kernel in front of it.
+ */
+bool benchmarkFrameAverage(QTextStream& out, ScanConversion* scanConversion, BenchmarkFrame_t& input)
+{
+    bool isWithinBudget{true};
+    const size_t length = input.acqData.size();
+    std::vector<uint16_t> average(length);
+    std::vector<uint8_t> averaged(length);
+    const float weight = 0.5f;
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < BenchmarkFrames; i++){
+        FrameAverage::blend(input.acqData.data(), average.data(), averaged.data(), length, weight, i == 0);
+    }
+    const double cpu_ms = timer.nsecsElapsed() / 1.0e6 / BenchmarkFrames;
+    report(out, "Frame average, CPU", cpu_ms);
+    isWithinBudget = isWithinBudget && (cpu_ms < FrameAverageBudget_ms);
+
+    if(scanConversion){
+        auto* sm = SignalModel::instance();
+        sm->setCurrFrameWeight_percent(int(weight * 100));
+        sm->setIsAveragingNoiseReduction(false);
+        const double plain_ms = timeWarp(*scanConversion, input, BenchmarkFrames);
+        sm->setIsAveragingNoiseReduction(true);
+        const double average_ms = timeWarp(*scanConversion, input, BenchmarkFrames);
+        sm->setIsAveragingNoiseReduction(false);
+
+        report(out, "Warp with frame average", average_ms);
+        report(out, "Frame average, added on the GPU", average_ms - plain_ms);
+        isWithinBudget = isWithinBudget && (average_ms - plain_ms < FrameAverageBudget_ms);
+    }
+
+    out << QString("Frame average delay at %1% weight: %2 frames").arg(int(weight * 100)).arg(FrameAverage::delay_frames(weight)) << endl;
+    out << QString("Frame average budget %1 ms: %2").arg(FrameAverageBudget_ms).arg(isWithinBudget ? "met" : "EXCEEDED") << endl;
+    return isWithinBudget;
+}
+
+/*
+ * Raw fringes with three reflectors, a DC level and noise
+ */
+std::vector<uint16_t> makeFringes()
+{
+    std::vector<uint16_t> fringes(size_t(RAW_ALINE_LENGTH) * BenchmarkLines);
+    uint32_t seed{54321};
+    for(int line = 0; line < BenchmarkLines; line++){
+        for(int sample = 0; sample < RAW_ALINE_LENGTH; sample++){
+            seed = seed * 1664525u + 1013904223u;
+            const double value = 32768.0 + 6000.0 * std::cos(0.21 * sample) + 3000.0 * std::cos(0.67 * sample + line)
+                               + 1500.0 * std::cos(1.9 * sample) + double(seed >> 22);
+            fringes[size_t(line) * RAW_ALINE_LENGTH + sample] = uint16_t(value);
+        }
+    }
+    return fringes;
+}
+
+bool reportThroughput(QTextStream& out, const QString& name, double frame_ms)
+{
+    const double aLinesPerSecond = BenchmarkLines / (frame_ms / 1000.0);
+    report(out, name, frame_ms);
+    out << QString("%1: %2 A-lines/s, %3x the scan rate").arg(name, -48).arg(aLinesPerSecond, 0, 'f', 0)
+                                                         .arg(aLinesPerSecond / ScanRate_ALinesPerSecond, 0, 'f', 2) << endl;
+    return aLinesPerSecond >= ScanRate_ALinesPerSecond;
+}
+
+/*
+ * benchmarkSpectral
+ *
+ * Fringes to 8-bit A-lines (resample, window, FFT, log magnitude), on the CPU and in OpenCL.
+ * Each has to keep up with the laser.
+ */
+bool benchmarkSpectral(QTextStream& out, ScanConversion* scanConversion)
+{
+    bool isWithinBudget{true};
+    std::vector<uint16_t> fringes = makeFringes();
+    std::vector<uint8_t> polar(size_t(FFT_DATA_SIZE) * BenchmarkLines);
+    const auto* sm = SignalModel::instance();
+    const int frames = BenchmarkFrames / 4;
+
+    SpectralPipeline pipeline;
+    pipeline.process(fringes.data(), BenchmarkLines, polar.data(), *sm->scaleFactor(), float(*sm->dcNoiseLevel()));
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < frames; i++){
+        pipeline.process(fringes.data(), BenchmarkLines, polar.data(), *sm->scaleFactor(), float(*sm->dcNoiseLevel()));
+    }
+    isWithinBudget = reportThroughput(out, "Spectral pipeline, CPU", timer.nsecsElapsed() / 1.0e6 / frames) && isWithinBudget;
+
+    if(scanConversion && scanConversion->isSpectralOpenCLReady()){
+        OCTFile::OctData_t frame;
+        frame.fringeData = fringes.data();
+        frame.acqData = polar.data();
+        frame.bufferLength = BenchmarkLines;
+
+        const auto backend = scanConversion->spectralBackend();
+        scanConversion->setSpectralBackend(SpectralPipeline::Backend::OpenCL);
+        scanConversion->processFringes(&frame, BenchmarkLines);
+        timer.restart();
+        for(int i = 0; i < frames; i++){
+            scanConversion->processFringes(&frame, BenchmarkLines);
+        }
+        isWithinBudget = reportThroughput(out, "Spectral pipeline, OpenCL", timer.nsecsElapsed() / 1.0e6 / frames) && isWithinBudget;
+        scanConversion->setSpectralBackend(backend);
+    }
+
+    out << QString("Spectral pipeline at %1 A-lines/s: %2").arg(ScanRate_ALinesPerSecond).arg(isWithinBudget ? "met" : "NOT MET") << endl;
+    return isWithinBudget;
+}
+
+/*
+ * benchmarkLineDecimation
+ *
+ * A 10000 line revolution: the CPU decimation on its own, and the warp with decimation off
+ * and in each mode. The warp reads a third of the lines or fewer once decimated.
+ */
+bool benchmarkLineDecimation(QTextStream& out, ScanConversion* scanConversion)
+{
+    BenchmarkFrame_t input(DecimationBenchmarkLines);
+    auto* sm = SignalModel::instance();
+    const int target = *sm->lineDecimationTarget();
+    const int factor = LineDecimation::factorFor(DecimationBenchmarkLines, target);
+    const size_t lines = LineDecimation::outputLines(DecimationBenchmarkLines, factor);
+    std::vector<uint8_t> decimated(FFT_DATA_SIZE * lines);
+    out << QString("Line decimation: %1 lines to %2 (factor %3)").arg(DecimationBenchmarkLines).arg(lines).arg(factor) << endl;
+
+    const LineDecimation::Mode modes[] = { LineDecimation::Mode::Box, LineDecimation::Mode::Max, LineDecimation::Mode::Gaussian };
+    for(const auto mode : modes){
+        const auto filter = LineDecimation::makeFilter(mode, factor);
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < BenchmarkFrames; i++){
+            LineDecimation::decimate(input.acqData.data(), DecimationBenchmarkLines, FFT_DATA_SIZE, decimated.data(), filter);
+        }
+        report(out, "Line decimation, CPU " + LineDecimation::modeName(mode), timer.nsecsElapsed() / 1.0e6 / BenchmarkFrames);
+    }
+
+    if(scanConversion){
+        const int mode0 = *sm->lineDecimationMode();
+        const LineDecimation::Mode allModes[] = { LineDecimation::Mode::Off, LineDecimation::Mode::Box, LineDecimation::Mode::Max, LineDecimation::Mode::Gaussian };
+        for(const auto mode : allModes){
+            sm->setLineDecimationMode(int(mode));
+            report(out, "Warp, line decimation " + LineDecimation::modeName(mode), timeWarp(*scanConversion, input, BenchmarkFrames / 4));
+        }
+        sm->setLineDecimationMode(mode0);
+    }
+    return true;
+}
+
+/*
+ * benchmarkSpeckleFilter
+ *
+ * Both speckle filter qualities on a 2000 line frame: on the CPU with and without AVX2, and
+ * in the warp against the warp alone. Each has to stay within SpeckleFilterBudget_ms.
+ */
+bool benchmarkSpeckleFilter(QTextStream& out, ScanConversion* scanConversion)
+{
+    BenchmarkFrame_t input(SpeckleBenchmarkLines);
+    std::vector<uint8_t> filtered(input.acqData.size());
+    bool isWithinBudget{true};
+
+    const SpeckleFilter::Mode modes[] = { SpeckleFilter::Mode::Fast, SpeckleFilter::Mode::Quality };
+    for(const auto mode : modes){
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < BenchmarkFrames; i++){
+            SpeckleFilter::filterSse2(input.acqData.data(), SpeckleBenchmarkLines, FFT_DATA_SIZE, filtered.data(), mode);
+        }
+        const double sse2_ms = timer.nsecsElapsed() / 1.0e6 / BenchmarkFrames;
+        report(out, "Speckle filter, CPU SSE2 " + SpeckleFilter::modeName(mode), sse2_ms);
+
+        double cpu_ms = sse2_ms;
+        if(SpeckleFilter::isAvx2Supported()){
+            timer.start();
+            for(int i = 0; i < BenchmarkFrames; i++){
+                SpeckleFilter::filter(input.acqData.data(), SpeckleBenchmarkLines, FFT_DATA_SIZE, filtered.data(), mode);
+            }
+            cpu_ms = timer.nsecsElapsed() / 1.0e6 / BenchmarkFrames;
+            report(out, "Speckle filter, CPU AVX2 " + SpeckleFilter::modeName(mode), cpu_ms);
+        }
+        isWithinBudget = isWithinBudget && (cpu_ms < SpeckleFilterBudget_ms);
+    }
+
+    if(scanConversion){
+        auto* sm = SignalModel::instance();
+        const int mode0 = *sm->speckleFilterMode();
+        sm->setSpeckleFilterMode(int(SpeckleFilter::Mode::Off));
+        const double off_ms = timeWarp(*scanConversion, input, BenchmarkFrames / 4);
+        report(out, "Warp, speckle filter off", off_ms);
+        for(const auto mode : modes){
+            sm->setSpeckleFilterMode(int(mode));
+            const double filtered_ms = timeWarp(*scanConversion, input, BenchmarkFrames / 4);
+            report(out, "Warp, speckle filter " + SpeckleFilter::modeName(mode), filtered_ms);
+            isWithinBudget = isWithinBudget && (filtered_ms - off_ms < SpeckleFilterBudget_ms);
+        }
+        sm->setSpeckleFilterMode(mode0);
+    }
+    return isWithinBudget;
+}
+
+/*
+ * benchmarkWarpOutputs
+ *
+ * The display alone against display, video frame and thumbnail from the same launch.
+ */
+bool benchmarkWarpOutputs(QTextStream& out, ScanConversion* scanConversion, BenchmarkFrame_t& input)
+{
+    if(!scanConversion){
+        return true;
+    }
+    const int outputs = scanConversion->warpOutputs();
+    scanConversion->setWarpOutputs(ScanConversion::DisplayOutput);
+    const double display_ms = timeWarp(*scanConversion, input, BenchmarkFrames);
+    scanConversion->setWarpOutputs(ScanConversion::DisplayOutput | ScanConversion::VideoOutput | ScanConversion::ThumbnailOutput);
+    const double all_ms = timeWarp(*scanConversion, input, BenchmarkFrames);
+    scanConversion->setWarpOutputs(outputs);
+
+    report(out, "Warp, display only", display_ms);
+    report(out, "Warp, display + video + thumbnail", all_ms);
+    return true;
+}
+
+/*
+ * benchmarkSectorSizes
+ *
+ * The warp at the scene size, at the control screen's pixels and at the size in use, which
+ * has to fit control/warpBudget_ms.
+ */
+bool benchmarkSectorSizes(QTextStream& out, ScanConversion* scanConversion, BenchmarkFrame_t& input)
+{
+    if(!scanConversion){
+        return true;
+    }
+    auto* sm = SignalModel::instance();
+    const int inUse_px = *sm->getSectorWidth_px();
+    for(int size_px : {SectorWidth_px, SignalModel::nativeSectorSize_px()}){
+        scanConversion->setSectorSize_px(size_px);
+        report(out, QString("Warp, %1 px sector").arg(*sm->getSectorWidth_px()), timeWarp(*scanConversion, input, BenchmarkFrames));
+    }
+    scanConversion->setSectorSize_px(inUse_px);
+    const double inUse_ms = timeWarp(*scanConversion, input, BenchmarkFrames);
+    report(out, QString("Warp, %1 px sector (in use)").arg(inUse_px), inUse_ms);
+    return inUse_ms < userSettings::Instance().getWarpBudget_ms();
+}
+
+/*
+ * benchmarkZoom
+ *
+ * A 10000 line revolution warped whole and with a 4x zoom window. The zoomed warp draws as
+ * many pixels but keeps up to four times the lines.
+ */
+bool benchmarkZoom(QTextStream& out, ScanConversion* scanConversion)
+{
+    if(!scanConversion){
+        return true;
+    }
+    BenchmarkFrame_t input(DecimationBenchmarkLines);
+    const QRectF roi = scanConversion->regionOfInterest();
+    scanConversion->setRegionOfInterest(QRectF(0.0, 0.0, 1.0, 1.0));
+    report(out, "Warp, whole sector", timeWarp(*scanConversion, input, BenchmarkFrames / 4));
+    scanConversion->setRegionOfInterest(QRectF(0.375, 0.375, 0.25, 0.25));
+    report(out, "Warp, 4x zoom window", timeWarp(*scanConversion, input, BenchmarkFrames / 4));
+    scanConversion->setRegionOfInterest(roi);
+    return true;
+}
+
+/*
+ * benchmarkCapture
+ *
+ * A capture re-warped from the last frame at 2048 px, as the capture pool does it. Only the
+ * snapshot is on the warping thread.
+ */
+bool benchmarkCapture(QTextStream& out, ScanConversion* scanConversion, BenchmarkFrame_t& input)
+{
+    if(!scanConversion){
+        return true;
+    }
+    const int CaptureSize_px = 2048;
+    const int Captures = 20;
+    scanConversion->warpData(&input.frame, input.frame.bufferLength);
+
+    QElapsedTimer timer;
+    double snapshot_ms{0.0};
+    double render_ms{0.0};
+    for(int i = 0; i < Captures; i++){
+        timer.start();
+        auto frame = scanConversion->snapshotForCapture();
+        snapshot_ms += timer.nsecsElapsed() / 1.0e6;
+        if(!frame){
+            // Nothing to snapshot when the warp reads the DAQ buffer in place
+            if(i == 0){
+                out << "Capture skipped, the frame is not kept with this tuning" << endl;
+                return true;
+            }
+            return false;
+        }
+        timer.start();
+        if(scanConversion->renderCapture(*frame, CaptureSize_px).isNull()){
+            return false;
+        }
+        render_ms += timer.nsecsElapsed() / 1.0e6;
+    }
+    report(out, "Capture snapshot", snapshot_ms / Captures);
+    report(out, QString("Capture render, %1 px").arg(CaptureSize_px), render_ms / Captures);
+    return true;
+}
+}
+
+int runBenchmarks()
+{
+    QTextStream out(stdout);
+    setUpSignalModel();
+    BenchmarkFrame_t input;
+
+    ScanConversion scanConversion;
+    ScanConversion* gpu = scanConversion.isReady ? &scanConversion : nullptr;
+    if(!gpu){
+        out << "OpenCL is not available, GPU benchmarks skipped" << endl;
+    } else {
+        out << "OpenCL tuning: " << gpu->tuningDescription() << endl;
+    }
+
+    bool isWithinBudget{true};
+    isWithinBudget = benchmarkAutoContrast(out, gpu, input) && isWithinBudget;
+    isWithinBudget = benchmarkFrameAverage(out, gpu, input) && isWithinBudget;
+    isWithinBudget = benchmarkSpectral(out, gpu) && isWithinBudget;
+    isWithinBudget = benchmarkLineDecimation(out, gpu) && isWithinBudget;
+    isWithinBudget = benchmarkSpeckleFilter(out, gpu) && isWithinBudget;
+    isWithinBudget = benchmarkWarpOutputs(out, gpu, input) && isWithinBudget;
+    isWithinBudget = benchmarkSectorSizes(out, gpu, input) && isWithinBudget;
+    isWithinBudget = benchmarkZoom(out, gpu) && isWithinBudget;
+    isWithinBudget = benchmarkCapture(out, gpu, input) && isWithinBudget;
+
+    const auto metrics = PipelineMetrics::instance()->snapshot();
+    if(metrics.isProfiling){
+        out << "OpenCL stage timings (control/openClProfiling):" << endl << metrics.summary() << endl;
+    }
+
+    return isWithinBudget ? 0 : 1;
+}
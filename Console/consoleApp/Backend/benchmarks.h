@@ -0,0 +1,11 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+/*
+* Benchmarks for the imaging pipeline, run with "octConsole --benchmark" on the target
+* hardware. Results go to the console and the log; the return value is non-zero when a
+* stage is over its per-frame budget.
+*/
+int runBenchmarks();
+
+#endif // BENCHMARKS_H
@@ -8,6 +8,7 @@
 #include "signalmodel.h"
 #include "Utility/userSettings.h"
 #include "mainScreen.h"
+#include "spectralpipeline.h"
 
 #include <exception>
 
@@ -24,6 +25,10 @@ extern "C" {
 DAQ::DAQ(MainScreen *ms) : m_mainScreen(ms)
 {
     initLogLevelAndDecimation();
+
+    m_connection = new DaqConnection(NewImageArrived, this);
+    connect(m_connection, &DaqConnection::connected, this, &DAQ::onConnected);
+    connect(m_connection, &DaqConnection::connectionFailed, this, &IDAQ::sendError);
 }
 
 
@@ -31,6 +36,34 @@ void DAQ::initLogLevelAndDecimation()
 {
     userSettings &settings = userSettings::Instance();
     m_daqDecimation = settings.getDaqIndexDecimation();
+    m_isRawFringes = SpectralPipeline::backendFromSetting(settings.getSpectralProcessing()) != SpectralPipeline::Backend::Fpga;
+    LOG1(m_isRawFringes)
+}
+
+/*
+ * setPipelineMode
+ *
+ * Bypass the FPGA processing and send the ADC samples when the console does the FFT.
+ * Subsampling has to be set first or the raw data can saturate the link.
+ */
+void DAQ::setPipelineMode()
+{
+    if(!m_isRawFringes){
+        return;
+    }
+    const uint32_t which_DAQ{0};
+    AxErr success = axSetPipelineMode(AxPipelineMode::RAW_ADC, AxChannelMode::CHAN_1, which_DAQ);
+    LOG1(int(success))
+    if(success != AxErr::NO_AxERROR){
+        logAxErrorVerbose(__LINE__, success);
+    }
+}
+
+void DAQ::swapToLittleEndian(uint16_t *samples, size_t count)
+{
+    for(size_t i = 0; i < count; i++){
+        samples[i] = uint16_t((samples[i] >> 8) | (samples[i] << 8));
+    }
 }
 
 void DAQ::logAxErrorVerbose(int line, AxErr axErrorCode, int count)
@@ -76,44 +109,26 @@ void DAQ::logRegisterValue(int line, int registerNumber)
 
 DAQ::~DAQ()
 {
+    delete m_connection;
 }
 
+/*
+ * initDaq
+ *
+ * Asks for live imaging; the connection starts it (and registers the image callback) as soon
+ * as the DAQ is connected, and again after every reconnect.
+ */
 void DAQ::initDaq()
 {
-    AxErr retval;
-
     int frameBufferCount = userSettings::Instance().getNumberOfDaqBuffers();
     m_bufferNumber = frameBufferCount ? (frameBufferCount - 1) : 0;
 
     imageFrameTimer.start(); // start a timer to provide frame information
 
-    // NewImageArrived - callback_function A user-supplied function to be called.
-    // Pass NULL to un-register a callback function.
-    retval = axRegisterNewImageCallback(session, NewImageArrived, this);
-    if(retval != AxErr::NO_AxERROR){
-        char errorMsg[512];
-        axGetErrorString(retval, errorMsg);
-        LOG2(int(retval), errorMsg)
-    }
-
-//    LOG1(turnLaserOn());
-
-    // number_of_images =0 for Imaging Off (idle), =-1 for Live Imaging (no record), or any positive
-    // value between 1 and 32767 to request the desired number of images in a Burst Record operation.
-    // which_DAQ The numeric index of the desired DAQ.
-    const int16_t number_of_images{-1};
-    const uint32_t which_DAQ{0};
-    retval = axImagingCntrlEthernet(number_of_images, which_DAQ);
-    if(retval != AxErr::NO_AxERROR){
-        char errorMsg[512];
-        axGetErrorString(retval, errorMsg);
-        LOG2(int(retval), errorMsg)
-    }
+    QMetaObject::invokeMethod(m_connection, "setImagingEnabled", Qt::QueuedConnection, Q_ARG(bool, true));
 
     m_callbackTimer.start();
     m_dataTimer.start();
-//    setSubSamplingFactor();
-
 }
 
 IDAQ *DAQ::getSignalSource()
@@ -125,6 +140,7 @@ void DAQ::setSubsamplingAndForcedTrigger(int speed)
 {
     //set sbsampling
     LOG2(speed, m_subsamplingThreshold)
+    m_speed = speed;
     if(speed < m_subsamplingThreshold){
         m_subsamplingFactor = 2;
         setSubSamplingFactor();
@@ -132,7 +148,14 @@ void DAQ::setSubsamplingAndForcedTrigger(int speed)
         m_subsamplingFactor = 1;
         setSubSamplingFactor();
     }
+    setForcedTrigger(speed);
+}
 
+void DAQ::setForcedTrigger(int speed)
+{
+    if(!m_connection->isConnected()){
+        return;
+    }
     //framesUntilForceTrig The number of frames for which the driver will wait for a Image_sync signal
     //before timing out and entering Force Trigger mode.  Defaults to 24 frames at session creation.
     //Values outside the range of [2,100] will be automatically coerced into this range.
@@ -149,121 +172,49 @@ void DAQ::setSubsamplingAndForcedTrigger(int speed)
         framesUntilForceTrig = line->second;
     }
 
-    AxErr success = axSetTrigTimeout(session, framesUntilForceTrig);
+    AxErr success = axSetTrigTimeout(m_connection->session(), framesUntilForceTrig);
     LOG3(int(success), speed, framesUntilForceTrig);
     if(success != AxErr::NO_AxERROR){
         logAxErrorVerbose(__LINE__, success);
     }
-    QThread::msleep(100);
 }
 
 /*
  * startDaq
  *
- * Start the Axsun DAQ based on PCIe or Ethernet mode.
+ * Start connecting to the Axsun DAQ over Ethernet. Returns straight away; discovery,
+ * configuration and reconnects run on the connection's own thread.
  */
 bool DAQ::startDaq()
 {
-    AxErr success = AxErr::NO_AxERROR;
-
-    m_numberOfConnectedDevices = 0;
-
-    //shutdownDaq();
-
-    try {
-
-        success = axOpenAxsunOCTControl(true);
-        if(success != AxErr::NO_AxERROR){
-            logAxErrorVerbose(__LINE__, success);
-        }
-
-        const float capacity_MB{500.0f};
-        success = axStartSession(&session, capacity_MB);    // Start Axsun engine session
-        if(success != AxErr::NO_AxERROR){
-            logAxErrorVerbose(__LINE__, success);
-        }
-
-        //interface_status =1 opens the interface or resets an existing open interface, =0 closes the interface.
-        const uint32_t interface_status{1};
-        success = axNetworkInterfaceOpen(interface_status);
-        if(success != AxErr::NO_AxERROR){
-            char errorMsg[512];
-            axGetErrorString(success, errorMsg);
-            LOG2(int(success), errorMsg)
-        }
-
-        //the two network interfaces 192.168.10.1 and 10.2
-        while(m_numberOfConnectedDevices != 2){
-            m_numberOfConnectedDevices = axCountConnectedDevices();
-            LOG1(m_numberOfConnectedDevices)
-
-            QThread::msleep(500); //TO DO - handle failure max number of retries 60 sec
-        }
-
-        /*
-         * The number of frames for which the driver will wait for a Image_sync signal before timing out and entering Force Trigger mode.
-         * Defaults to 24 frames at session creation.  Values outside the range of [2,100] will be automatically coerced into this range.
-         * 24 gives us 6144 Alines.
-         */
-        QThread::msleep(100);
-
-        success = axSelectInterface(session, AxInterface::GIGABIT_ETHERNET);
-        if(success != AxErr::NO_AxERROR){
-            logAxErrorVerbose(__LINE__, success);
-        }
-        QThread::msleep(100);
-
-        logRegisterValue(__LINE__, 2);
-        logRegisterValue(__LINE__, 5);
-        logRegisterValue(__LINE__, 6);
-
-        // frequency The Image_sync frequency (Hz); this parameter is optional and is ignored when source
-        //is not INTERNAL.
-        const float frequency{16.6};
-        const uint32_t which_DAQ{0};
-        success = axSetImageSyncSource(AxEdgeSource::LVDS, frequency, which_DAQ);
-        if(success != AxErr::NO_AxERROR){
-            logAxErrorVerbose(__LINE__, success);
-        }
-        QThread::msleep(100);
-        logRegisterValue(__LINE__, 2);
-        logRegisterValue(__LINE__, 5);
-        logRegisterValue(__LINE__, 6);
-
-        success = axGetMessage(session, axMessage );
-        if(success != AxErr::NO_AxERROR){
-            logAxErrorVerbose(__LINE__, success);
-        }
-        LOG1(axMessage)
-    }  catch (std::exception& e) {
-       LOG1(e.what())
-    } catch(...){
-        LOG1(__FUNCTION__)
-    }
-
-    return success == AxErr::NO_AxERROR;
+    QMetaObject::invokeMethod(m_connection, "connectToDaq", Qt::QueuedConnection);
+    return true;
 }
 
 bool DAQ::shutdownDaq()
 {
-    AxErr success = AxErr::NO_AxERROR;
-    int errorCount = 0;
+    m_isLaserOnRequested = false;
+    const bool success = m_connection->shutdown();
+    LOG1(success);
 
-    success = axStopSession(session);    // Stop Axsun engine session
-    if(success != AxErr::NO_AxERROR){
-        logAxErrorVerbose(__LINE__, success);
-        ++errorCount;
-    }
-    LOG1(int(success == AxErr::NO_AxERROR));
+    return success;
+}
 
-    success = axCloseAxsunOCTControl();
-    if(success != AxErr::NO_AxERROR){
-        logAxErrorVerbose(__LINE__, success);
-        ++errorCount;
+/*
+ * onConnected
+ *
+ * A fresh session starts with library defaults; put back what was set on the old one.
+ */
+void DAQ::onConnected()
+{
+    LOG2(m_speed, m_isLaserOnRequested)
+    if(m_speed){
+        setSubsamplingAndForcedTrigger(m_speed);
     }
-    LOG1(int(success == AxErr::NO_AxERROR));
-
-    return errorCount == 0;
+    if(m_isLaserOnRequested){
+        setLaserEmissionState(1);
+    }
+    setPipelineMode();
 }
 
 bool DAQ::turnLaserOn()
@@ -272,7 +223,8 @@ bool DAQ::turnLaserOn()
     // emission_state =1 enables laser emission, =0 disables laser emission.
     // which_laser The numeric index of the desired Laser.
 
-    if(m_numberOfConnectedDevices == 2){
+    m_isLaserOnRequested = true;
+    if(m_connection->isConnected()){
         const uint32_t emission_state{1};
         LOG1(emission_state)
         success = setLaserEmissionState(emission_state);
@@ -286,7 +238,8 @@ bool DAQ::turnLaserOff()
     // emission_state =1 enables laser emission, =0 disables laser emission.
     // which_laser The numeric index of the desired Laser.
 
-    if(m_numberOfConnectedDevices == 2){
+    m_isLaserOnRequested = false;
+    if(m_connection->isConnected()){
         const uint32_t emission_state{0};
         LOG1(emission_state)
         success = setLaserEmissionState(emission_state);
@@ -296,7 +249,7 @@ bool DAQ::turnLaserOff()
 
 void DAQ::setSubSamplingFactor()
 {
-    if(m_numberOfConnectedDevices == 2)
+    if(m_connection->isConnected())
     {
         const int subsamplingFactor = m_subsamplingFactor;
         if( subsamplingFactor > 0  && subsamplingFactor <= 4 )
@@ -310,7 +263,7 @@ void DAQ::setSubSamplingFactor()
             if(success != AxErr::NO_AxERROR){
                 logAxErrorVerbose(__LINE__, success);
             }
-            success = axGetMessage( session, axMessage );
+            success = axGetMessage( m_connection->session(), axMessage );
             if(success != AxErr::NO_AxERROR){
                 logAxErrorVerbose(__LINE__, success);
             }
@@ -341,6 +294,7 @@ void DAQ::NewImageArrived(new_image_callback_data_t data, void* user_ptr)
 
     if(daq)
     {
+        daq->m_connection->imageArrived();
         daq->getData(data);
     }
 }
@@ -401,17 +355,24 @@ void DAQ::getData(new_image_callback_data_t data)
 //        LOG1(axsun.acqData)
     }
 
-    const uint32_t bytes_allocated{MAX_ACQ_IMAGE_SIZE};
+    const bool isRawFringes = m_isRawFringes && axsun->fringeData;
+    uint8_t* imageData = isRawFringes ? reinterpret_cast<uint8_t*>(axsun->fringeData) : axsun->acqData;
+    const uint32_t bytes_allocated = isRawFringes ? uint32_t(sizeof(uint16_t) * RAW_ALINE_LENGTH * MAX_LINES_PER_FRAME)
+                                                  : uint32_t(MAX_ACQ_IMAGE_SIZE);
 
     auto info = image_info_t{};
 
     AxErr retval{AxErr::BUFFER_IS_EMPTY};
     if (bytes_allocated >= data.required_buffer_size) {		// insure memory allocation large enough
         auto prefs = request_prefs_t{ .request_mode = AxRequestMode::RETRIEVE_TO_CALLER, .which_window = 1 };
-        retval = axRequestImage(data.session, data.image_number, prefs, bytes_allocated, axsun->acqData, &info);
+        retval = axRequestImage(data.session, data.image_number, prefs, bytes_allocated, imageData, &info);
         axsun->bufferLength = info.width;
         axsun->frameNumber = data.image_number;
+        axsun->isFromRecording = false;
         if (retval == AxErr::NO_AxERROR) {
+            if(isRawFringes && (info.data_type == AxDataType::U16)){
+                swapToLittleEndian(axsun->fringeData, size_t(info.width) * size_t(info.height));
+            }
             qs << "Success: \tWidth: " << info.width;
             if (info.force_trig)
                 qs << "\tForce triggered mode.";
@@ -436,7 +397,8 @@ void DAQ::getData(new_image_callback_data_t data)
             data.image_number &&
             !(last_image - data.image_number) &&
             axsun->bufferLength &&
-            (axsun->bufferLength != 256);
+            (axsun->bufferLength != 256) &&
+            (!isRawFringes || (info.height == RAW_ALINE_LENGTH));
 
     if( thisFrameIsGood){
         ++m_frameGoodCount;
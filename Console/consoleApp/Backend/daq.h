@@ -8,6 +8,7 @@
 #include "octFile.h"
 #include "AxsunOCTCapture.h"
 #include "idaq.h"
+#include "daqconnection.h"
 #include <cstdint>
 #include <map>
 
@@ -33,13 +34,20 @@ public:
     virtual bool turnLaserOff() override;
     bool startDaq() override;
 
+    static void logRegisterValue(int line, int reg);
+    static void logAxErrorVerbose(int line, AxErr e, int count = 0);
+
+private slots:
+    void onConnected();
+
 private:
     void setSubSamplingFactor();
+    void setForcedTrigger(int speed);
     void getData(new_image_callback_data_t data);
     void initLogLevelAndDecimation();
-    void logRegisterValue(int line, int reg);
+    void setPipelineMode();
+    static void swapToLittleEndian(uint16_t* samples, size_t count);
 
-    void logAxErrorVerbose(int line, AxErr e, int count = 0);
     bool setLaserEmissionState(uint32_t emission_state); // emission_state =1 enables laser emission, =0 disables laser emission.
 
     static void NewImageArrived(new_image_callback_data_t data, void* user_ptr);
@@ -55,16 +63,22 @@ private:
     const int m_framesUntilForceTrigDefault{24};
 
     int m_bufferNumber;
-    AOChandle session{nullptr};
+    DaqConnection* m_connection{nullptr};
     QElapsedTimer imageFrameTimer;
     char axMessage[256];
 
     int m_daqDecimation{0};
+
+    // Raw fringes from the DAQ, processed on the console (see SpectralPipeline)
+    bool m_isRawFringes{false};
     int m_callbackCount{0};
 
     const int m_subsamplingThreshold{1000};
     int m_subsamplingFactor{2};
-    int m_numberOfConnectedDevices {0};
+
+    // Restored on the DAQ after a reconnect
+    int m_speed{0};
+    bool m_isLaserOnRequested{false};
 
     uint32_t m_droppedPackets{0};
     uint32_t m_missedImagesCountAccumulated{0};
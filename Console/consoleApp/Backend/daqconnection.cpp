@@ -0,0 +1,444 @@
+#include "daqconnection.h"
+#include "daq.h"
+#include "logger.h"
+#include "startupgraph.h"
+
+#ifdef WIN32
+extern "C" {
+#include "AxsunOCTCapture.h"
+#include "AxsunOCTControl_LW_C.h"
+}
+#endif
+
+namespace{
+// The two network interfaces 192.168.10.1 and 10.2
+const uint32_t ExpectedNumberOfDevices = 2;
+
+// Discovery back-off: 250 ms doubling to 4 s; the first connection gives up after a minute,
+// a reconnect keeps trying for as long as the case runs
+const int InitialRetryDelay_ms = 250;
+const int MaxRetryDelay_ms = 4000;
+const int DiscoveryTimeout_ms = 60000;
+
+// Settle time the DAQ needs between interface selection, sync source and register access
+const int SettleDelay_ms = 100;
+
+// With imaging on, force-triggered images arrive even without a sled; silence means a lost link
+const int WatchdogInterval_ms = 1000;
+const int ImageStallTimeout_ms = 5000;
+}
+
+DaqConnection::DaqConnection(AxNewImageCallbackFunction_t imageCallback, void *callbackUserData)
+    : QObject(nullptr), m_imageCallback(imageCallback), m_callbackUserData(callbackUserData)
+{
+    qRegisterMetaType<DaqConnection::State>();
+
+    m_stepTimer = new QTimer(this);
+    m_stepTimer->setSingleShot(true);
+    connect(m_stepTimer, &QTimer::timeout, this, &DaqConnection::step);
+
+    m_watchdogTimer = new QTimer(this);
+    m_watchdogTimer->setInterval(WatchdogInterval_ms);
+    connect(m_watchdogTimer, &QTimer::timeout, this, &DaqConnection::checkLink);
+
+    m_clock.start();
+    moveToThread(&m_thread);
+    m_thread.start();
+}
+
+DaqConnection::~DaqConnection()
+{
+    shutdown();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void DaqConnection::imageArrived()
+{
+    m_lastImage_ms = m_clock.elapsed();
+
+    if(m_isAwaitingFirstImage.exchange(false)){
+        QMetaObject::invokeMethod(this, "reportImagingResumed", Qt::QueuedConnection);
+    }
+}
+
+bool DaqConnection::shutdown()
+{
+    bool success{true};
+
+    auto doShutdown = [this, &success]() {
+        m_stepTimer->stop();
+        m_watchdogTimer->stop();
+        m_isImagingEnabled = false;
+        success = closeSession();
+        setState(State::Idle);
+    };
+
+    if(QThread::currentThread() == &m_thread){
+        doShutdown();
+    } else if(m_thread.isRunning()){
+        QMetaObject::invokeMethod(this, doShutdown, Qt::BlockingQueuedConnection);
+    }
+    return success;
+}
+
+/*
+ * connectToDaq
+ *
+ * Starts the connection; a connection that is already up or on its way is left alone.
+ */
+void DaqConnection::connectToDaq()
+{
+    if((m_state != State::Idle) && (m_state != State::Failed)){
+        LOG1(int(m_state.load()))
+        return;
+    }
+
+    m_connectTimer.start();
+    m_hasBeenConnected = false;
+    m_retryDelay_ms = InitialRetryDelay_ms;
+    setState(State::OpeningSession);
+    step();
+}
+
+void DaqConnection::setImagingEnabled(bool isEnabled)
+{
+    m_isImagingEnabled = isEnabled;
+    if(isConnected() && isEnabled){
+        armImaging();
+    }
+}
+
+void DaqConnection::setState(DaqConnection::State state)
+{
+    if(m_state != state){
+        m_state = state;
+        LOG1(int(state))
+        emit stateChanged(state);
+    }
+}
+
+/*
+ * step
+ *
+ * Runs the action for the current state; the step timer calls it again when the state
+ * needs another try or the next configuration step.
+ */
+void DaqConnection::step()
+{
+    switch(m_state){
+    case State::OpeningSession:
+        openSession();
+        break;
+    case State::Discovering:
+    case State::Reconnecting:
+        discover();
+        break;
+    case State::Configuring:
+        configure();
+        break;
+    default:
+        break;
+    }
+}
+
+void DaqConnection::openSession()
+{
+    AxErr success = AxErr::NO_AxERROR;
+
+    if(!m_isControlOpen){
+        success = axOpenAxsunOCTControl(true);
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+            retryAfterBackoff();
+            return;
+        }
+        m_isControlOpen = true;
+
+        // Device connect and disconnect events drive discovery and reconnects
+        success = axRegisterConnectCallback(DeviceConnectionChanged, this);
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+        }
+    }
+
+    if(!m_session){
+        AOChandle session{nullptr};
+        const float capacity_MB{500.0f};
+        success = axStartSession(&session, capacity_MB);    // Start Axsun engine session
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+            retryAfterBackoff();
+            return;
+        }
+        m_session = session;
+    }
+
+    //interface_status =1 opens the interface or resets an existing open interface, =0 closes the interface.
+    const uint32_t interface_status{1};
+    success = axNetworkInterfaceOpen(interface_status);
+    if(success != AxErr::NO_AxERROR){
+        DAQ::logAxErrorVerbose(__LINE__, success);
+    }
+
+    m_retryDelay_ms = InitialRetryDelay_ms;
+    setState(State::Discovering);
+    step();
+}
+
+/*
+ * discover
+ *
+ * Waits for both network devices. Connect events from the library cut the back-off short.
+ */
+void DaqConnection::discover()
+{
+    const uint32_t numberOfConnectedDevices = axCountConnectedDevices();
+    LOG1(numberOfConnectedDevices)
+
+    if(numberOfConnectedDevices == ExpectedNumberOfDevices){
+        m_configureStep = 0;
+        setState(State::Configuring);
+        m_stepTimer->start(SettleDelay_ms);
+        return;
+    }
+
+    if((m_state == State::Discovering) && (m_connectTimer.elapsed() > DiscoveryTimeout_ms)){
+        const qint64 elapsed_ms = m_connectTimer.elapsed();
+        LOG2(numberOfConnectedDevices, elapsed_ms)
+        StartupGraph::instance()->recordTiming("axsunDiscovery", elapsed_ms, false);
+        setState(State::Failed);
+        emit connectionFailed(QString("DAQ not found after %1 s").arg(elapsed_ms / 1000));
+        return;
+    }
+
+    retryAfterBackoff();
+}
+
+/*
+ * configure
+ *
+ * Interface selection, image sync source, then imaging; one call per step with the settle
+ * time in between.
+ */
+void DaqConnection::configure()
+{
+    AxErr success = AxErr::NO_AxERROR;
+
+    switch(m_configureStep){
+    case 0:
+        success = axSelectInterface(m_session, AxInterface::GIGABIT_ETHERNET);
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+        }
+        break;
+
+    case 1:
+    {
+        DAQ::logRegisterValue(__LINE__, 2);
+        DAQ::logRegisterValue(__LINE__, 5);
+        DAQ::logRegisterValue(__LINE__, 6);
+
+        // frequency The Image_sync frequency (Hz); this parameter is optional and is ignored when source
+        //is not INTERNAL.
+        const float frequency{16.6f};
+        const uint32_t which_DAQ{0};
+        success = axSetImageSyncSource(AxEdgeSource::LVDS, frequency, which_DAQ);
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+        }
+        break;
+    }
+
+    default:
+    {
+        DAQ::logRegisterValue(__LINE__, 2);
+        DAQ::logRegisterValue(__LINE__, 5);
+        DAQ::logRegisterValue(__LINE__, 6);
+
+        char axMessage[256];
+        success = axGetMessage(m_session, axMessage);
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+        }
+        LOG1(axMessage)
+
+        const bool isReconnect = m_hasBeenConnected;
+        if(isReconnect){
+            const qint64 timeToConnect_ms = m_reconnectTimer.elapsed();
+            LOG1(timeToConnect_ms)
+        } else {
+            StartupGraph::instance()->recordTiming("axsunDiscovery", m_connectTimer.elapsed());
+        }
+        m_hasBeenConnected = true;
+        m_lastImage_ms = -1;
+        m_retryDelay_ms = InitialRetryDelay_ms;
+        setState(State::Connected);
+
+        if(m_isImagingEnabled){
+            armImaging();
+        }
+        m_watchdogTimer->start();
+        emit connected();
+        return;
+    }
+    }
+
+    ++m_configureStep;
+    m_stepTimer->start(SettleDelay_ms);
+}
+
+/*
+ * armImaging
+ *
+ * (Re-)registers the image callback and starts live imaging.
+ */
+void DaqConnection::armImaging()
+{
+    // The stall timeout counts from the start of acquisition, so a first image that never
+    // arrives is caught as well
+    m_lastImage_ms = m_clock.elapsed();
+
+    // callback_function A user-supplied function to be called. Pass NULL to un-register a callback function.
+    AxErr success = axRegisterNewImageCallback(m_session, m_imageCallback, m_callbackUserData);
+    if(success != AxErr::NO_AxERROR){
+        DAQ::logAxErrorVerbose(__LINE__, success);
+    }
+
+    // number_of_images =0 for Imaging Off (idle), =-1 for Live Imaging (no record), or any positive
+    // value between 1 and 32767 to request the desired number of images in a Burst Record operation.
+    // which_DAQ The numeric index of the desired DAQ.
+    const int16_t number_of_images{-1};
+    const uint32_t which_DAQ{0};
+    success = axImagingCntrlEthernet(number_of_images, which_DAQ);
+    if(success != AxErr::NO_AxERROR){
+        DAQ::logAxErrorVerbose(__LINE__, success);
+    }
+}
+
+/*
+ * checkLink
+ *
+ * Watchdog while connected: both devices must be present and, with imaging on, images must
+ * keep arriving.
+ */
+void DaqConnection::checkLink()
+{
+    if(m_state != State::Connected){
+        return;
+    }
+
+    const uint32_t numberOfConnectedDevices = axCountConnectedDevices();
+    if(numberOfConnectedDevices != ExpectedNumberOfDevices){
+        loseConnection(QString("%1 of %2 DAQ devices connected").arg(numberOfConnectedDevices).arg(ExpectedNumberOfDevices));
+        return;
+    }
+
+    const qint64 lastImage_ms = m_lastImage_ms;
+    if(m_isImagingEnabled && (lastImage_ms >= 0) && (m_clock.elapsed() - lastImage_ms > ImageStallTimeout_ms)){
+        loseConnection(QString("no image for %1 ms").arg(m_clock.elapsed() - lastImage_ms));
+    }
+}
+
+void DaqConnection::onDeviceConnectionChanged()
+{
+    switch(m_state){
+    case State::Connected:
+        checkLink();
+        break;
+    case State::Discovering:
+    case State::Reconnecting:
+        // Look now instead of waiting out the back-off
+        m_stepTimer->start(0);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * DeviceConnectionChanged
+ *
+ * Called by the control library on its own thread.
+ */
+void DaqConnection::DeviceConnectionChanged(void *userData)
+{
+    auto* connection = static_cast<DaqConnection*>(userData);
+    if(connection){
+        QMetaObject::invokeMethod(connection, "onDeviceConnectionChanged", Qt::QueuedConnection);
+    }
+}
+
+void DaqConnection::loseConnection(const QString &reason)
+{
+    LOG( WARNING, QString( "DAQ connection lost (%1), reconnecting" ).arg( reason ) );
+
+    m_watchdogTimer->stop();
+    m_reconnectTimer.start();
+    m_isAwaitingFirstImage = m_isImagingEnabled;
+
+    // No callbacks into a half-open session while reconnecting
+    AxErr success = axRegisterNewImageCallback(m_session, nullptr, nullptr);
+    if(success != AxErr::NO_AxERROR){
+        DAQ::logAxErrorVerbose(__LINE__, success);
+    }
+
+    //interface_status =1 opens the interface or resets an existing open interface
+    const uint32_t interface_status{1};
+    success = axNetworkInterfaceOpen(interface_status);
+    if(success != AxErr::NO_AxERROR){
+        DAQ::logAxErrorVerbose(__LINE__, success);
+    }
+
+    m_retryDelay_ms = InitialRetryDelay_ms;
+    setState(State::Reconnecting);
+    emit connectionLost();
+    retryAfterBackoff();
+}
+
+void DaqConnection::retryAfterBackoff()
+{
+    LOG2(int(m_state.load()), m_retryDelay_ms)
+    m_stepTimer->start(m_retryDelay_ms);
+    m_retryDelay_ms = qMin(m_retryDelay_ms * 2, MaxRetryDelay_ms);
+}
+
+/*
+ * reportImagingResumed
+ *
+ * Time to reconnect is measured from the detected drop to the first image afterwards.
+ */
+void DaqConnection::reportImagingResumed()
+{
+    const qint64 timeToReconnect_ms = m_reconnectTimer.elapsed();
+    LOG1(timeToReconnect_ms)
+    emit reconnected(timeToReconnect_ms);
+}
+
+bool DaqConnection::closeSession()
+{
+    int errorCount = 0;
+    AxErr success = AxErr::NO_AxERROR;
+
+    if(m_session){
+        success = axStopSession(m_session);    // Stop Axsun engine session
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+            ++errorCount;
+        }
+        LOG1(int(success == AxErr::NO_AxERROR));
+        m_session = nullptr;
+    }
+
+    if(m_isControlOpen){
+        success = axCloseAxsunOCTControl();
+        if(success != AxErr::NO_AxERROR){
+            DAQ::logAxErrorVerbose(__LINE__, success);
+            ++errorCount;
+        }
+        LOG1(int(success == AxErr::NO_AxERROR));
+        m_isControlOpen = false;
+    }
+
+    return errorCount == 0;
+}
@@ -0,0 +1,105 @@
+#ifndef DAQCONNECTION_H
+#define DAQCONNECTION_H
+
+#include <atomic>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include "AxsunOCTCapture.h"
+
+/*
+* DaqConnection brings up the Axsun session and keeps it up. It works as a state machine on
+* its own thread: each step is one short library call, and the waits between steps are
+* timers, so neither the caller nor the connection thread ever sleeps. Discovery retries back
+* off exponentially. Once connected, device disconnect events and stalls in the image stream
+* start a reconnect, which re-arms the image callback and resumes imaging without an
+* application restart.
+*/
+class DaqConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State
+    {
+        Idle,
+        OpeningSession,
+        Discovering,
+        Configuring,
+        Connected,
+        Reconnecting,
+        Failed
+    };
+
+    DaqConnection(AxNewImageCallbackFunction_t imageCallback, void* callbackUserData);
+    ~DaqConnection();
+
+    State state() const { return m_state; }
+    bool isConnected() const { return m_state == State::Connected; }
+    AOChandle session() const { return m_session; }
+
+    /*
+     * Called from the image callback for every image; feeds the stall watchdog and the
+     * reconnect timing
+     */
+    void imageArrived();
+
+    // Stops imaging and closes the session; blocks until done on the connection thread
+    bool shutdown();
+
+public slots:
+    // Non-blocking; progress is reported through stateChanged()
+    void connectToDaq();
+    void setImagingEnabled(bool isEnabled);
+
+signals:
+    void stateChanged(DaqConnection::State state);
+    void connected();
+    void connectionLost();
+    void connectionFailed(QString reason);
+    void reconnected(qint64 timeToReconnect_ms);
+
+private slots:
+    void step();
+    void checkLink();
+    void onDeviceConnectionChanged();
+    void reportImagingResumed();
+
+private:
+    static void DeviceConnectionChanged(void* userData);
+
+    void setState(State state);
+    void openSession();
+    void discover();
+    void configure();
+    void armImaging();
+    void loseConnection(const QString& reason);
+    void retryAfterBackoff();
+    bool closeSession();
+
+    QThread m_thread;
+    QTimer* m_stepTimer{nullptr};
+    QTimer* m_watchdogTimer{nullptr};
+
+    AxNewImageCallbackFunction_t m_imageCallback{nullptr};
+    void* m_callbackUserData{nullptr};
+
+    std::atomic<State> m_state{State::Idle};
+    std::atomic<AOChandle> m_session{nullptr};
+    bool m_isImagingEnabled{false};
+    bool m_isControlOpen{false};
+    bool m_hasBeenConnected{false};
+    int m_configureStep{0};
+    int m_retryDelay_ms{0};
+
+    QElapsedTimer m_clock;
+    QElapsedTimer m_connectTimer;
+    QElapsedTimer m_reconnectTimer;
+    std::atomic<qint64> m_lastImage_ms{-1};
+    std::atomic<bool> m_isAwaitingFirstImage{false};
+};
+
+Q_DECLARE_METATYPE(DaqConnection::State)
+
+#endif // DAQCONNECTION_H
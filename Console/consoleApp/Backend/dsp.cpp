@@ -24,6 +24,7 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QtMath>
 #include "defaults.h"
 #include "dsp.h"
 #include "logger.h"
@@ -62,6 +63,13 @@ DSP::DSP()
  */
 void DSP::init()
 {
+    // Hann window over the resampled A-line
+    window.resize( RAW_ALINE_LENGTH );
+    for( int i = 0; i < RAW_ALINE_LENGTH; i++ )
+    {
+        window[ i ] = float( 0.5 - 0.5 * cos( 2.0 * M_PI * i / ( RAW_ALINE_LENGTH - 1 ) ) );
+    }
+
     loadRescalingData();
 }
 
@@ -78,7 +86,7 @@ void DSP::init()
 void DSP::loadRescalingData( void )
 {
     // Load the configuration file
-    const unsigned int RescalingDataLength{2048};
+    const unsigned int RescalingDataLength{RAW_ALINE_LENGTH};
     const QString StrRescalingData = SystemDir + "/RescalingData.csv";
     LOG1(StrRescalingData)
 
@@ -134,6 +142,11 @@ void DSP::loadRescalingData( void )
     if( findLabel( &in, &currLine, "% DATA" ) )
     {
         // Load the data into the arrays
+        std::vector<float> whole;
+        std::vector<float> fractional;
+        whole.reserve( RescalingDataLength );
+        fractional.reserve( RescalingDataLength );
+
         for( unsigned int i = 0; i < RescalingDataLength; i++ )
         {
             /*
@@ -149,7 +162,37 @@ void DSP::loadRescalingData( void )
             {
                 currLine = in.readLine();
             }
+
+            /*
+             * Each line is the (fractional) raw sample number for one output sample, or its
+             * whole and fractional parts as two fields.
+             */
+            const QStringList fields = currLine.split( ',', QString::SkipEmptyParts );
+            bool isNumber{false};
+            const double position = fields.isEmpty() ? 0.0 : fields.at( 0 ).trimmed().toDouble( &isNumber );
+            if( !isNumber )
+            {
+                LOG( INFO, QString( "Laser configuration file: bad data on line %1 of the DATA section." ).arg( i + 1 ) )
+                break;
+            }
+            if( fields.size() > 1 )
+            {
+                whole.push_back( float( position ) );
+                fractional.push_back( fields.at( 1 ).trimmed().toFloat() );
+            }
+            else
+            {
+                whole.push_back( float( floor( position ) ) );
+                fractional.push_back( float( position - floor( position ) ) );
+            }
+        }
+
+        if( whole.size() == RescalingDataLength )
+        {
+            wholeSamples = whole;
+            fractionalSamples = fractional;
         }
+        LOG1(whole.size())
     }
     else
     {
@@ -180,6 +223,21 @@ bool DSP::findLabel( QTextStream *in, QString *currLine, const QString Label )
     return foundLabel;
 }
 
+const std::vector<float> &DSP::getWholeSamples() const
+{
+    return wholeSamples;
+}
+
+const std::vector<float> &DSP::getFractionalSamples() const
+{
+    return fractionalSamples;
+}
+
+const std::vector<float> &DSP::getWindow() const
+{
+    return window;
+}
+
 unsigned int DSP::getTimeStamp() {
     return timeStamp;
 }
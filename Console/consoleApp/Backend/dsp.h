@@ -14,6 +14,7 @@
 #define DSP_H_
 
 #include <QTime>
+#include <vector>
 #include "octFile.h"
 
 
@@ -31,6 +32,11 @@ public:
     unsigned int getTimeStamp( void );
     int getMilliseconds( void );
 
+    // k-linear resampling points, split the way rescale.cl takes them; empty without a laser file
+    const std::vector<float>& getWholeSamples() const;
+    const std::vector<float>& getFractionalSamples() const;
+    const std::vector<float>& getWindow() const;
+
 private:
     void loadRescalingData( void );
     bool findLabel( QTextStream *in, QString *currLine, const QString Label );
@@ -48,6 +54,10 @@ private:
 
     QDate  serviceDate;
 
+    std::vector<float> wholeSamples;
+    std::vector<float> fractionalSamples;
+    std::vector<float> window;
+
     // Data related to the current A-line
     int milliseconds;
     unsigned int   timeStamp;
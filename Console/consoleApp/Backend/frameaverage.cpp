@@ -0,0 +1,75 @@
+#include "frameaverage.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FRAME_AVERAGE_SSE2 1
+#endif
+
+namespace{
+const int MaxAverage = 255 * FrameAverage::FixedPointScale;
+}
+
+/*
+ * blend
+ *
+ * SSE2 does 8 samples per step in float; the scalar loop handles the tail and other CPUs.
+ */
+void FrameAverage::blend( const uint8_t *current, uint16_t *average, uint8_t *averaged, size_t length,
+                          float currFrameWeight, bool isReset )
+{
+    const float currWeight = isReset ? 1.0f : currFrameWeight;
+    const float prevWeight = isReset ? 0.0f : 1.0f - currFrameWeight;
+    size_t i{0};
+
+#if FRAME_AVERAGE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16( FixedPointScale / 2 );
+    const __m128 currScale = _mm_set1_ps( currWeight * FixedPointScale );
+    const __m128 prevScale = _mm_set1_ps( prevWeight );
+
+    for( ; i + 8 <= length; i += 8 )
+    {
+        const __m128i curr16 = _mm_unpacklo_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( current + i ) ), zero );
+        const __m128i prev16 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( average + i ) );
+
+        const __m128 currLo = _mm_cvtepi32_ps( _mm_unpacklo_epi16( curr16, zero ) );
+        const __m128 currHi = _mm_cvtepi32_ps( _mm_unpackhi_epi16( curr16, zero ) );
+        const __m128 prevLo = _mm_cvtepi32_ps( _mm_unpacklo_epi16( prev16, zero ) );
+        const __m128 prevHi = _mm_cvtepi32_ps( _mm_unpackhi_epi16( prev16, zero ) );
+
+        const __m128i avgLo = _mm_cvtps_epi32( _mm_add_ps( _mm_mul_ps( currLo, currScale ), _mm_mul_ps( prevLo, prevScale ) ) );
+        const __m128i avgHi = _mm_cvtps_epi32( _mm_add_ps( _mm_mul_ps( currHi, currScale ), _mm_mul_ps( prevHi, prevScale ) ) );
+
+        // Values are at most 255 * 128, so the signed pack does not saturate
+        const __m128i avg16 = _mm_packs_epi32( avgLo, avgHi );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( average + i ), avg16 );
+
+        const __m128i out16 = _mm_srli_epi16( _mm_add_epi16( avg16, round ), 7 );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( averaged + i ), _mm_packus_epi16( out16, zero ) );
+    }
+#endif
+
+    for( ; i < length; i++ )
+    {
+        const float value = currWeight * current[ i ] * FixedPointScale + prevWeight * average[ i ];
+        const int fixedPoint = std::min( int( std::lrint( value ) ), MaxAverage );
+        average[ i ] = uint16_t( fixedPoint );
+        averaged[ i ] = uint8_t( ( fixedPoint + FixedPointScale / 2 ) >> 7 );
+    }
+}
+
+/*
+ * delay_frames
+ *
+ * Mean delay of a first order recursive filter: (1 - w) / w frames.
+ */
+float FrameAverage::delay_frames( float currFrameWeight )
+{
+    if( currFrameWeight <= 0.0f )
+    {
+        return INFINITY;
+    }
+    return ( 1.0f - currFrameWeight ) / currFrameWeight;
+}
@@ -0,0 +1,31 @@
+#ifndef FRAMEAVERAGE_H
+#define FRAMEAVERAGE_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+* CPU side of the temporal frame average (frameAverage.cl): avg = curr * w + prev * (1 - w).
+* The running average is kept as 8.7 fixed point (sample * 128), the same as on the GPU.
+*/
+class FrameAverage
+{
+public:
+    static const int FixedPointScale = 128;
+
+    /*
+     * Blends a frame into the running average and writes the averaged 8-bit frame
+     *
+     * @param isReset
+     *      Start over from this frame (new device, depth or frame size)
+     */
+    static void blend( const uint8_t* current, uint16_t* average, uint8_t* averaged, size_t length,
+                       float currFrameWeight, bool isReset );
+
+    /*
+     * How many frames the average lags a change in the image (the mean delay of the filter)
+     */
+    static float delay_frames( float currFrameWeight );
+};
+
+#endif // FRAMEAVERAGE_H
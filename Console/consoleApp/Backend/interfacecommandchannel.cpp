@@ -0,0 +1,271 @@
+#include "interfacecommandchannel.h"
+#include <QElapsedTimer>
+#include "logger.h"
+
+namespace{
+// Longest wait for a response; the board normally answers within a few ms
+const int ResponseTimeout_ms = 500;
+
+// A response without a line terminator is complete once the line has been quiet this long
+const int InterCharacterGap_ms = 10;
+
+// Polling interval when the RX event is not available
+const int QueuePoll_ms = 1;
+
+bool isResponseLine(const QByteArray& line)
+{
+    const QByteArray upper = line.toUpper();
+    return upper.contains("ACK") || upper.contains("NAK");
+}
+}
+
+FtdiTransport::FtdiTransport(FT_HANDLE handle) : m_handle(handle)
+{
+    m_rxEvent = CreateEvent(nullptr, false, false, nullptr);
+    if(m_rxEvent && (FT_SetEventNotification(m_handle, FT_EVENT_RXCHAR, m_rxEvent) != FT_OK)){
+        const QString msg("Could not set FTDI RX event, polling the receive queue");
+        LOG1(msg)
+        CloseHandle(m_rxEvent);
+        m_rxEvent = nullptr;
+    }
+}
+
+FtdiTransport::~FtdiTransport()
+{
+    if(m_rxEvent){
+        CloseHandle(m_rxEvent);
+    }
+    if(FT_Close(m_handle) != FT_OK){
+        const QString msg("Could not close FTDI device");
+        LOG1(msg)
+    }
+}
+
+bool FtdiTransport::write(const QByteArray &bytes)
+{
+    DWORD bytesWritten{0};
+    FT_STATUS ftStatus = FT_Write(m_handle, const_cast<char*>(bytes.data()), DWORD(bytes.size()), &bytesWritten);
+
+    return (ftStatus == FT_OK) && (bytesWritten == DWORD(bytes.size()));
+}
+
+QByteArray FtdiTransport::read()
+{
+    QByteArray data;
+    const DWORD available = queuedBytes();
+
+    if(available > 0){
+        DWORD bytesRead{0};
+        data.resize(int(available));
+        if(FT_Read(m_handle, data.data(), available, &bytesRead) != FT_OK){
+            const QString msg("Serial read failed");
+            LOG1(msg)
+            bytesRead = 0;
+        }
+        data.resize(int(bytesRead));
+    }
+    return data;
+}
+
+bool FtdiTransport::waitForData(int timeout_ms)
+{
+    if(queuedBytes() > 0){
+        return true;
+    }
+
+    if(m_rxEvent){
+        WaitForSingleObject(m_rxEvent, DWORD(timeout_ms));
+        return queuedBytes() > 0;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while(timer.elapsed() < timeout_ms){
+        QThread::msleep(QueuePoll_ms);
+        if(queuedBytes() > 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+void FtdiTransport::purge()
+{
+    if(FT_Purge(m_handle, FT_PURGE_RX) != FT_OK){
+        const QString msg("Input flush failed");
+        LOG1(msg)
+    }
+}
+
+bool FtdiTransport::setBitMode(UCHAR bits)
+{
+    return FT_SetBitMode(m_handle, bits, 0x20) == FT_OK;
+}
+
+bool FtdiTransport::getBitMode(UCHAR &bits)
+{
+    return FT_GetBitMode(m_handle, &bits) == FT_OK;
+}
+
+DWORD FtdiTransport::queuedBytes()
+{
+    DWORD available{0};
+
+    if(FT_GetQueueStatus(m_handle, &available) != FT_OK){
+        available = 0;
+    }
+    return available;
+}
+
+InterfaceCommandChannel::InterfaceCommandChannel(InterfaceTransport *transport) : m_transport(transport)
+{
+    // A single thread keeps commands and their responses in order
+    m_ioContext.moveToThread(&m_ioThread);
+    m_ioThread.start();
+}
+
+InterfaceCommandChannel::~InterfaceCommandChannel()
+{
+    // Queued behind the outstanding requests, so they finish before the transport goes away
+    QMetaObject::invokeMethod(&m_ioContext, [this]() { m_ioThread.quit(); }, Qt::QueuedConnection);
+    m_ioThread.wait();
+}
+
+QFuture<QByteArray> InterfaceCommandChannel::send(const QByteArray &command, bool ignoreNakResponse)
+{
+    return post([this, command, ignoreNakResponse]()
+    {
+        return transact({command}, ignoreNakResponse).first();
+    });
+}
+
+QFuture<QList<QByteArray>> InterfaceCommandChannel::sendPipelined(const QList<QByteArray> &commands)
+{
+    return post([this, commands]()
+    {
+        return transact(commands, false);
+    });
+}
+
+QFuture<bool> InterfaceCommandChannel::setBitMode(UCHAR bits)
+{
+    return post([this, bits]()
+    {
+        return m_transport->setBitMode(bits);
+    });
+}
+
+QFuture<int> InterfaceCommandChannel::bitMode()
+{
+    return post([this]()
+    {
+        UCHAR bits{0};
+        return m_transport->getBitMode(bits) ? int(bits) : -1;
+    });
+}
+
+double InterfaceCommandChannel::measureRoundTrip_ms(const QByteArray &command, int iterations)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < iterations; i++){
+        send(command, true).waitForFinished();
+    }
+    const double roundTrip_ms = iterations > 0 ? double(timer.nsecsElapsed()) / 1.0e6 / iterations : 0.0;
+    LOG2(command.simplified().toStdString().c_str(), roundTrip_ms)
+    return roundTrip_ms;
+}
+
+/*
+ * Runs on the I/O thread. Writes all commands, then collects one response per command.
+ */
+QList<QByteArray> InterfaceCommandChannel::transact(const QList<QByteArray> &commands, bool ignoreNakResponse)
+{
+    QList<QByteArray> responses;
+
+    // Stale bytes from an earlier timed-out command would be taken as this response
+    m_transport->purge();
+    m_rxBuffer.clear();
+
+    QByteArray batch;
+    for(const auto& command : commands){
+        batch.append(command);
+    }
+    if(m_lastBatch != batch){
+        LOG1(batch.toStdString().c_str())
+        m_lastBatch = batch;
+    }
+
+    if(!m_transport->write(batch)){
+        LOG( WARNING, QString( "Interface support: could not write command: %1 ").arg(batch.data()));
+        for(int i = 0; i < commands.size(); i++){
+            responses.append(QByteArray());
+        }
+        return responses;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray response;
+
+    while(responses.size() < commands.size()){
+        if(takeResponse(response)){
+            if(!ignoreNakResponse && response.toUpper().contains("NAK")){
+                LOG( INFO, "Device responded NAK");
+            }
+            responses.append(response);
+            continue;
+        }
+
+        const int remaining_ms = ResponseTimeout_ms - int(timer.elapsed());
+        if(remaining_ms <= 0){
+            LOG( WARNING, QString( "Interface support: no response to %1").arg(commands.at(responses.size()).simplified().data()));
+            responses.append(QByteArray());
+            continue;
+        }
+
+        if(m_transport->waitForData(m_rxBuffer.isEmpty() ? remaining_ms : qMin(remaining_ms, InterCharacterGap_ms))){
+            m_rxBuffer.append(m_transport->read());
+        } else if(!m_rxBuffer.isEmpty() && isResponseLine(m_rxBuffer)){
+            // Quiet line with an ACK/NAK but no terminator
+            responses.append(m_rxBuffer.simplified());
+            m_rxBuffer.clear();
+        }
+    }
+
+    // Repeated polls answer the same; only log what changed
+    const QByteArray lastResponse = responses.isEmpty() ? QByteArray() : responses.last();
+    if(m_lastResponse != lastResponse){
+        LOG1(lastResponse.toStdString().c_str())
+        m_lastResponse = lastResponse;
+    }
+    return responses;
+}
+
+/*
+ * Takes the next complete response from the receive buffer; lines before the ACK/NAK line
+ * (e.g. values on a line of their own) belong to the same response.
+ */
+bool InterfaceCommandChannel::takeResponse(QByteArray &response)
+{
+    int lineStart = 0;
+
+    while(lineStart < m_rxBuffer.size()){
+        int lineEnd = m_rxBuffer.indexOf('\r', lineStart);
+        const int newline = m_rxBuffer.indexOf('\n', lineStart);
+        if(lineEnd < 0 || (newline >= 0 && newline < lineEnd)){
+            lineEnd = newline;
+        }
+        if(lineEnd < 0){
+            return false;
+        }
+
+        if(isResponseLine(m_rxBuffer.mid(lineStart, lineEnd - lineStart))){
+            response = m_rxBuffer.left(lineEnd).simplified();
+            m_rxBuffer.remove(0, lineEnd + 1);
+            return true;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return false;
+}
@@ -0,0 +1,155 @@
+#ifndef INTERFACECOMMANDCHANNEL_H
+#define INTERFACECOMMANDCHANNEL_H
+
+#include "ftd2xx.h"
+
+#include <memory>
+#include <QByteArray>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QList>
+#include <QObject>
+#include <QThread>
+
+/*
+* Byte transport under the interface board command channel; either the FTDI serial port or
+* a software stand-in for the board.
+*/
+class InterfaceTransport
+{
+public:
+    virtual ~InterfaceTransport() = default;
+
+    virtual bool write(const QByteArray& bytes) = 0;
+
+    /*
+     * Returns everything received so far without blocking
+     */
+    virtual QByteArray read() = 0;
+
+    /*
+     * Blocks until received bytes are available or the timeout expires
+     *
+     * @return True if there is something to read
+     */
+    virtual bool waitForData(int timeout_ms) = 0;
+
+    /*
+     * Drops any received bytes that have not been read
+     */
+    virtual void purge() = 0;
+
+    /*
+     * Drives the bit-bang pins (sled power, laser, board reset) with the given values
+     */
+    virtual bool setBitMode(UCHAR bits) = 0;
+
+    /*
+     * Reads the current values of the bit-bang pins
+     */
+    virtual bool getBitMode(UCHAR& bits) = 0;
+};
+
+/*
+* FTDI serial transport. Waits on the driver's RX character event, falling back to polling
+* FT_GetQueueStatus when the event cannot be set up. Owns the handle and closes it.
+*/
+class FtdiTransport : public InterfaceTransport
+{
+public:
+    explicit FtdiTransport(FT_HANDLE handle);
+    ~FtdiTransport() override;
+
+    bool write(const QByteArray& bytes) override;
+    QByteArray read() override;
+    bool waitForData(int timeout_ms) override;
+    void purge() override;
+    bool setBitMode(UCHAR bits) override;
+    bool getBitMode(UCHAR& bits) override;
+
+private:
+    DWORD queuedBytes();
+
+    FT_HANDLE m_handle{nullptr};
+    HANDLE m_rxEvent{nullptr};
+};
+
+/*
+* InterfaceCommandChannel owns a dedicated I/O thread and the transport, and with it every
+* access to the interface board: serial commands and the bit-bang pins. Requests are queued
+* to the thread's event loop and run in order; a command completes as soon as its ACK or NAK
+* line arrives instead of after a fixed delay.
+*
+* The returned futures are fulfilled by the I/O thread. Unlike a thread pool future, waiting
+* on one never runs the request on the waiting thread.
+*/
+class InterfaceCommandChannel
+{
+public:
+    /*
+     * @param transport
+     *      Transport used for all commands; the channel takes ownership.
+     */
+    explicit InterfaceCommandChannel(InterfaceTransport* transport);
+    ~InterfaceCommandChannel();
+
+    /*
+     * Queues a command
+     *
+     * @param ignoreNakResponse
+     *      Do not log a NAK response, e.g. when polling the sled running state.
+     *
+     * @return future holding the simplified response, or an empty array on timeout
+     */
+    QFuture<QByteArray> send(const QByteArray& command, bool ignoreNakResponse = false);
+
+    /*
+     * Queues independent queries that are written back to back; the responses come back
+     * in the order of the commands.
+     */
+    QFuture<QList<QByteArray>> sendPipelined(const QList<QByteArray>& commands);
+
+    /*
+     * Queues a write of the bit-bang pins, after any commands already queued
+     */
+    QFuture<bool> setBitMode(UCHAR bits);
+
+    /*
+     * Queues a read of the bit-bang pins; the future holds -1 if the read failed
+     */
+    QFuture<int> bitMode();
+
+    /*
+     * Average round trip of a command, in milliseconds, for latency comparisons. Blocks;
+     * not to be called on the I/O thread.
+     */
+    double measureRoundTrip_ms(const QByteArray& command, int iterations);
+
+private:
+    template <typename Job>
+    auto post(Job job) -> QFuture<decltype(job())>
+    {
+        QFutureInterface<decltype(job())> promise;
+        promise.reportStarted();
+        QMetaObject::invokeMethod(&m_ioContext, [job, promise]() mutable
+        {
+            const auto result = job();
+            promise.reportFinished(&result);
+        }, Qt::QueuedConnection);
+        return promise.future();
+    }
+
+    QList<QByteArray> transact(const QList<QByteArray>& commands, bool ignoreNakResponse);
+    bool takeResponse(QByteArray& response);
+
+    std::unique_ptr<InterfaceTransport> m_transport;
+    QThread m_ioThread;
+    QObject m_ioContext; // lives on m_ioThread; requests are queued to it
+
+    // Only touched on the I/O thread
+    QByteArray m_rxBuffer;
+    QByteArray m_lastBatch;
+    QByteArray m_lastResponse;
+};
+
+#endif // INTERFACECOMMANDCHANNEL_H
@@ -1,6 +1,9 @@
 #include "interfacesupport.h"
 #include <QDebug>
 #include <QTextStream>
+#include <QMutexLocker>
+#include "simulatedinterfaceboard.h"
+#include "Utility/userSettings.h"
 #include "logger.h"
 
 constexpr auto DEVICE_BIT_POSITION_SLED_5V = 0;
@@ -10,15 +13,37 @@ constexpr auto DEVICE_BIT_POSITION_LASER = 3;
 
 InterfaceSupport* InterfaceSupport::m_instance {nullptr};
 
+namespace{
+QFuture<QByteArray> noResponse()
+{
+    QFutureInterface<QByteArray> promise;
+    const QByteArray empty;
+    promise.reportStarted();
+    promise.reportFinished(&empty);
+    return promise.future();
+}
+}
+
 InterfaceSupport *InterfaceSupport::getInstance(bool resetInterfaceBoard) {
+    // The board is first opened by a start-up step while other threads may already ask for it
+    static QMutex instanceMutex;
+    QMutexLocker lock(&instanceMutex);
+
     if(!m_instance){
         LOG2(m_instance,resetInterfaceBoard)
         m_instance = new InterfaceSupport();
         // Initialize FTDI device
         if (!m_instance->initalizeFTDIDevice()) {
-            LOG(ERROR, "Failed to initialize InterfaceSupport device");
-            delete m_instance;
-            m_instance = nullptr;
+            if (userSettings::Instance().getIsSimulation()) {
+                // No board attached; answer serial commands in software
+                LOG(WARNING, "No interface board found, using the simulated interface board");
+                m_instance->m_channel.reset(new InterfaceCommandChannel(new SimulatedInterfaceBoard()));
+                m_instance->populateInterfaceBoardCommandList();
+            } else {
+                LOG(ERROR, "Failed to initialize InterfaceSupport device");
+                delete m_instance;
+                m_instance = nullptr;
+            }
         } else {
             if (resetInterfaceBoard) {
                 // Now perform one time reset on the interface board to start using interface support
@@ -42,10 +67,16 @@ void InterfaceSupport::releaseInstance() {
 }
 
 InterfaceSupport::~InterfaceSupport() {
-    FT_STATUS ftStatus = FT_Close(ftHandle);
-    if( ftStatus != FT_OK ) {
-        const QString msg( "Could not close FTDI device");
-        LOG1(msg);
+    // Finishes queued commands, then the transport closes the handle
+    m_channel.reset();
+
+    // Only still ours if the device was opened but could not be set up
+    if (ftHandle) {
+        FT_STATUS ftStatus = FT_Close(ftHandle);
+        if( ftStatus != FT_OK ) {
+            const QString msg( "Could not close FTDI device");
+            LOG1(msg);
+        }
     }
 
     if (ftdiDeviceInfo) {
@@ -137,6 +168,10 @@ bool InterfaceSupport::initalizeFTDIDevice() {
 
         prepDevice();
 
+        // From here on the handle belongs to the transport and is only used on the I/O thread
+        m_channel.reset(new InterfaceCommandChannel(new FtdiTransport(ftHandle)));
+        ftHandle = nullptr;
+
         currentBitSetVal = currentVal;
         populateInterfaceBoardCommandList();
 
@@ -155,9 +190,9 @@ bool InterfaceSupport::resetInterfaceBoard() {
     QString msg = "Reset interface board - pull reset line low";
     QTextStream qts(&msg);
 
-    FT_STATUS ftStatus = FT_SetBitMode( ftHandle, currentBitSetVal.to_ulong(), 0x20 );
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    bool isWritten = writeBitMode();
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         qts << "Could not perform reset on interface board" << msg;
         LOG1(msg)
         return false;
@@ -166,9 +201,9 @@ bool InterfaceSupport::resetInterfaceBoard() {
     currentBitSetVal.set(DEVICE_BIT_POSITION_INTERFACE_BOARD_RESET, 0);
 
     msg = "Reset interface board - pull reset line high";
-    ftStatus = ftStatus = FT_SetBitMode( ftHandle, currentBitSetVal.to_ulong(), 0x20 );
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    isWritten = writeBitMode();
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         qts << "Could not perform reset on interface board" << msg;
         LOG1(msg)
         return false;
@@ -198,9 +233,9 @@ bool InterfaceSupport::turnOnOffSled5V(bool isOn) {
         msg = "turn off Sled 5V";
     }
 
-    FT_STATUS ftStatus = FT_SetBitMode( ftHandle, currentBitSetVal.to_ulong(), 0x20 );  // Reset interface board
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    const bool isWritten = writeBitMode();
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         qts << "Could not complete operation for Sled 5V" << msg;
         LOG1(msg)
         return false;
@@ -224,9 +259,9 @@ bool InterfaceSupport::turnOnOffSled24V(bool isOn) {
         msg = "turn off Sled 24V";
     }
 
-    FT_STATUS ftStatus = FT_SetBitMode( ftHandle, currentBitSetVal.to_ulong(), 0x20 );  // Reset interface board
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    const bool isWritten = writeBitMode();
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         qts << "Could not complete operation for Sled 24V" << msg;
         LOG1(msg)
         return false;
@@ -262,9 +297,9 @@ bool InterfaceSupport::turnOnOffLaser(bool isOn) {
         msg = "turn off Laser";
     }
 
-    FT_STATUS ftStatus = FT_SetBitMode( ftHandle, currentBitSetVal.to_ulong(), 0x20 );  // Reset interface board
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    const bool isWritten = writeBitMode();
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         qts << "Could not complete operation for Laser" << msg;
         LOG1(msg)
         return false;
@@ -278,9 +313,9 @@ bool InterfaceSupport::performResetLow() {
 
     QString msg = "perform reset low";
 
-    FT_STATUS ftStatus = FT_SetBitMode( ftHandle, currentBitSetVal.to_ulong(), 0x20 );  // Reset interface board
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    const bool isWritten = writeBitMode();
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         return false;
     }
 
@@ -292,9 +327,9 @@ bool InterfaceSupport::performResetHigh() {
 
     QString msg = "perform reset high";
 
-    FT_STATUS ftStatus = FT_SetBitMode( ftHandle, currentBitSetVal.to_ulong(), 0x20 );  // Reset interface board
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    const bool isWritten = writeBitMode();
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         return false;
     }
 
@@ -303,9 +338,8 @@ bool InterfaceSupport::performResetHigh() {
 
 bool InterfaceSupport::reportCurrentDeviceStatus() {
 
-    UCHAR currentVal;
-    FT_STATUS ftStatus = FT_GetBitMode(ftHandle, &currentVal);
-    if( ftStatus != FT_OK ) {
+    const int currentVal = m_channel ? m_channel->bitMode().result() : -1;
+    if( currentVal < 0 ) {
         const QString msg( "Could not read current FTDI mode");
         LOG1(msg)
         return false;
@@ -313,14 +347,27 @@ bool InterfaceSupport::reportCurrentDeviceStatus() {
 
     std::bitset<8> currBitSetVal = currentVal;
 
-    float hardwareVersion = getHardwareVersion();
+    // The version and settings queries are independent; send them in one burst
+    QList<QByteArray> responses;
+    if (m_channel) {
+        responses = m_channel->sendPipelined({ interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_HARDWARE_VERSION],
+                                               interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_FIRMWARE_VERSION],
+                                               interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SLED_FIRMWARE_VERSION],
+                                               interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_VOA_SETTINGS],
+                                               interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SUPPLY_VOLTAGE] }).result();
+    }
+    while (responses.size() < 5) {
+        responses.append(QByteArray());
+    }
+
+    float hardwareVersion = parseHardwareVersion(responses.at(0));
     LOG1(hardwareVersion);
-    float firmwareVersion = getFirmwareVersion();
+    float firmwareVersion = parseFirmwareVersion(responses.at(1));
     LOG1(firmwareVersion);
-    float sledVersion = getSledFirmwareVersion();
+    float sledVersion = parseSledFirmwareVersion(responses.at(2));
     LOG1(sledVersion);
 
-    LOG1(getVOASettings());
+    LOG1(parseVOASettings(responses.at(3)));
 
     LOG1(currBitSetVal.test(DEVICE_BIT_POSITION_INTERFACE_BOARD_RESET));
 
@@ -331,7 +378,7 @@ bool InterfaceSupport::reportCurrentDeviceStatus() {
     LOG1(currBitSetVal.test(DEVICE_BIT_POSITION_LASER));
 
     float minimumACVoltage = (float) 122 * 0.9f;
-    float detectedACVoltage = getSupplyVoltage();
+    float detectedACVoltage = parseSupplyVoltage(responses.at(4));
 
     LOG2(minimumACVoltage, detectedACVoltage);
 
@@ -364,68 +411,36 @@ bool InterfaceSupport::reportCurrentDeviceStatus() {
     return true;
 }
 
-QByteArray InterfaceSupport::readDataFromDevice(bool ignoreNakResponse) {
-    QByteArray data;
-    static QByteArray data0;
-    if(ftHandle != nullptr) {
-        DWORD bytesToRead = 256;
-        DWORD bytesRead;
-        char buffer[256]= {};
-
-        Sleep(100);
-        FT_STATUS ftStatus = FT_Read( ftHandle, buffer, bytesToRead, &bytesRead );
-        if( ftStatus != FT_OK ) {
-            const QString msg("Serial read failed");
-            LOG1(msg)
-        } else {
-            buffer[bytesRead] = '\0';
-            data = buffer;
-            data = data.simplified();
-        }
-
-        if(!ignoreNakResponse && data.toUpper().contains( "NAK" )){
-            LOG( INFO, "Device responded NAK");
-        }
-    }
-    if(data0 != data){
-        LOG1(data.toStdString().c_str())
-        data0 = data;
+QByteArray InterfaceSupport::commandResponse(const QByteArray& command, bool ignoreNakResponse) {
+    if (!m_channel) {
+        const QString msg( "Serial port not open for write");
+        LOG1(msg)
+        return QByteArray();
     }
-    return data;
-}
-
-bool InterfaceSupport::writeDataToDevice(QByteArray command) {
 
-    static QByteArray command0;
+    // Blocks only for the round trip; the board usually answers within a few ms. The command
+    // runs on the I/O thread, never on this one.
+    return m_channel->send(command, ignoreNakResponse).result();
+}
 
-    bool retVal = true;
+bool InterfaceSupport::writeBitMode() {
+    return m_channel && m_channel->setBitMode(UCHAR(currentBitSetVal.to_ulong())).result();
+}
 
-    if(command0 != command){
-        LOG1(command.toStdString().c_str())
-        command0 = command;
+QFuture<QByteArray> InterfaceSupport::sendCommand(const QByteArray& command, bool ignoreNakResponse) {
+    if (!m_channel) {
+        return noResponse();
     }
-    if( ftHandle != NULL ) {
-        DWORD bytesWritten;
-
-        FT_STATUS ftStatus = FT_Purge( ftHandle, FT_PURGE_RX );   // flush input buffer
-        if( ftStatus != FT_OK) {
-            const QString msg( "Input flush failed");
-            LOG1(msg)
-        }
+    return m_channel->send(command, ignoreNakResponse);
+}
 
-        Sleep(100);
-        ftStatus = FT_Write( ftHandle, command.data(), command.size(), &bytesWritten);
-        if( ftStatus != FT_OK ) {
-            LOG( WARNING, QString( "Interface support: writeDataToDevice could not write command: %1 ").arg(command.data()));
-            retVal = false;
-        }
-    } else {
-        const QString msg( "Serial port not open for write");
-        LOG1(msg)
-        retVal = false;
-    }
+InterfaceCommandChannel *InterfaceSupport::commandChannel() const {
+    return m_channel.get();
+}
 
-    return retVal;
+QByteArray InterfaceSupport::command(OctInterfaceBoardCommandType type) const {
+    auto it = interfaceBoardCommandList.find(type);
+    return it != interfaceBoardCommandList.end() ? it->second : QByteArray();
 }
 
 void InterfaceSupport::updateSledConfig(const device &currentDevice)
@@ -468,8 +483,8 @@ bool InterfaceSupport::setSledClockingEnabled(const device &currentDevice)
 
     setClockingEnabledCmd.append(QByteArray(QString::number(currentClockingEnabled).toStdString().c_str())).append("\r");
 
-    if(writeDataToDevice(setClockingEnabledCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setClockingEnabledCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -487,8 +502,8 @@ bool InterfaceSupport::setSledClockingGain(const device &currentDevice)
     QByteArray currentClockingGain{currentDevice.getClockingGain()};
 
     setClockingGainCmd.append(currentClockingGain).append("\r");
-    if(writeDataToDevice(setClockingGainCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setClockingGainCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -506,8 +521,8 @@ bool InterfaceSupport::setSledClockingOffset(const device &currentDevice)
 
     setClockingOffsetCmd.append(currentClockingOffset).append("\r");
 
-    if(writeDataToDevice(setClockingOffsetCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setClockingOffsetCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -525,8 +540,8 @@ bool InterfaceSupport::setSledSpeed(const device &currentDevice)
 
     setSpeedCmd.append(QByteArray(QString::number(currentSpeed).toStdString().c_str())).append("\r");
 
-    if(writeDataToDevice(setSpeedCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setSpeedCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -543,8 +558,8 @@ bool InterfaceSupport::setSledTorqueLimit(const device &currentDevice)
     QByteArray currentTorqueLimit{currentDevice.getTorqueLimit()};
 
     setTorqueLimitCmd.append(currentTorqueLimit).append("\r");
-    if(writeDataToDevice(setTorqueLimitCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setTorqueLimitCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -561,8 +576,8 @@ bool InterfaceSupport::setSledTorqueTime(const device &currentDevice)
     QByteArray currentTorqueTime{currentDevice.getTorqueTime()};
 
     setTorqueTimeCmd.append(currentTorqueTime).append("\r");
-    if(writeDataToDevice(setTorqueTimeCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setTorqueTimeCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -578,8 +593,8 @@ bool InterfaceSupport::setSledStallBlinking(const device &currentDevice)
     QByteArray currentStallBlinking{currentDevice.getStallBlinking()};
 
     setStallBlinkingCmd.append(currentStallBlinking).append("\r");
-    if(writeDataToDevice(setStallBlinkingCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setStallBlinkingCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -596,8 +611,8 @@ bool InterfaceSupport::setSledButtonMode(const device &currentDevice)
     QByteArray currentButtonMode{currentDevice.getButtonMode()};
 
     setButtonModeCmd.append(currentButtonMode).append("\r");
-    if(writeDataToDevice(setButtonModeCmd)){
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setButtonModeCmd);
+    if(!response.isEmpty()){
         if(response.toUpper().contains("ACK")){
             success = true;
         }
@@ -642,11 +657,13 @@ void InterfaceSupport::populateInterfaceBoardCommandList() {
 }
 
 float InterfaceSupport::getHardwareVersion() {
+    return parseHardwareVersion(commandResponse(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_HARDWARE_VERSION]));
+}
+
+float InterfaceSupport::parseHardwareVersion(const QByteArray& response) {
     float hardwareVersionNum = 0.0;
 
-    if (writeDataToDevice(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_HARDWARE_VERSION])) {
-        QThread::msleep(250);
-        QByteArray response = readDataFromDevice();
+    if (!response.isEmpty()) {
         LOG1(response.toStdString().c_str());
         if(response.toUpper().contains("ACK")){
             auto parts = QString(response).split(QLatin1Char(' '));
@@ -665,11 +682,13 @@ float InterfaceSupport::getHardwareVersion() {
 }
 
 float InterfaceSupport::getFirmwareVersion() {
+    return parseFirmwareVersion(commandResponse(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_FIRMWARE_VERSION]));
+}
+
+float InterfaceSupport::parseFirmwareVersion(const QByteArray& response) {
     float firmwareVersionNum = 0.0;
 
-    if (writeDataToDevice(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_FIRMWARE_VERSION])) {
-        QThread::msleep(250);
-        QByteArray response = readDataFromDevice();
+    if (!response.isEmpty()) {
         LOG1(response.toStdString().c_str());
         if(response.toUpper().contains("ACK")){
             auto parts = QString(response).split(QLatin1Char(' '));
@@ -688,10 +707,13 @@ float InterfaceSupport::getFirmwareVersion() {
 }
 
 float InterfaceSupport::getSupplyVoltage() {
+    return parseSupplyVoltage(commandResponse(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SUPPLY_VOLTAGE]));
+}
+
+float InterfaceSupport::parseSupplyVoltage(const QByteArray& response) {
     float supplyVoltageVal = 0.0;
 
-    if (writeDataToDevice(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SUPPLY_VOLTAGE])) {
-        QByteArray response = readDataFromDevice();
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             auto parts = QString(response).split(QLatin1Char(' '));
             auto version = parts[0].split(QLatin1Char('='));
@@ -707,9 +729,9 @@ bool InterfaceSupport::turnOnSledAndLaser() {
     bool result = true;
 
     QString msg = "Turn on Sled and Laser";
-    FT_STATUS ftStatus = FT_SetBitMode( ftHandle, 0xFB, 0x20 );  // Turn on Sled and laser
-    LOG3(ftStatus, FT_OK, msg);
-    if( ftStatus != FT_OK ) {
+    const bool isWritten = m_channel && m_channel->setBitMode(0xFB).result();  // Turn on Sled and laser
+    LOG2(isWritten, msg);
+    if( !isWritten ) {
         return false;
     }
 
@@ -717,10 +739,13 @@ bool InterfaceSupport::turnOnSledAndLaser() {
 }
 
 float InterfaceSupport::getSledFirmwareVersion() {
+    return parseSledFirmwareVersion(commandResponse(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SLED_FIRMWARE_VERSION]));
+}
+
+float InterfaceSupport::parseSledFirmwareVersion(const QByteArray& response) {
     float sledFirmwareVersion = 0.0;
 
-    if (writeDataToDevice(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SLED_FIRMWARE_VERSION])) {
-        QByteArray response = readDataFromDevice();
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             auto parts = QString(response).split(QLatin1Char(' '));
             auto combinedVersion = parts[0].split(QLatin1Char('='));
@@ -753,8 +778,8 @@ bool InterfaceSupport::turnOnOffACPowerToOCT(bool isOn) {
 
     bool operationResult = false;
 
-    if (writeDataToDevice(command)) {
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(command);
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             operationResult = true;
 
@@ -776,10 +801,13 @@ bool InterfaceSupport::turnOnOffACPowerToOCT(bool isOn) {
 }
 
 int InterfaceSupport::getVOASettings() {
+    return parseVOASettings(commandResponse(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_VOA_SETTINGS]));
+}
+
+int InterfaceSupport::parseVOASettings(const QByteArray& response) {
     int voaValue = -1;
 
-    if (writeDataToDevice(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_VOA_SETTINGS])) {
-        QByteArray response = readDataFromDevice();
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             auto parts = QString(response).split(QLatin1Char(' '));
             for (auto part : parts) {
@@ -809,8 +837,8 @@ bool InterfaceSupport::setVOAMode(bool transparentMode) {
 
     bool operationResult = false;
 
-    if (writeDataToDevice(command)) {
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(command);
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             operationResult = true;
 
@@ -841,8 +869,8 @@ bool InterfaceSupport::setSledSpeed(int speed) {
 
     bool operationResult = false;
 
-    if (writeDataToDevice(setSpeedSerialCmd)) {
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(setSpeedSerialCmd);
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             operationResult = true;
             LOG( INFO, QString( "Successfully set speed to Sled: %1 ").arg(speed));
@@ -866,8 +894,8 @@ bool InterfaceSupport::enableDisableBidirectional(bool bidirectionalState) {
 
     bool operationResult = false;
 
-    if (writeDataToDevice(command)) {
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(command);
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             operationResult = true;
 
@@ -890,21 +918,9 @@ bool InterfaceSupport::enableDisableBidirectional(bool bidirectionalState) {
 
 int InterfaceSupport::getRunningState() {
     static int lastRunningState0;
-    if (writeDataToDevice(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SLED_RUNNING_STATE])) {
-        bool ignoreNakResponse = true;
-        QByteArray response = readDataFromDevice(ignoreNakResponse);
-        if(response.toUpper().contains("ACK")){
-            auto parts = QString(response).split(QLatin1Char(' '));
-            for (auto part : parts) {
-                if (part.contains("gr")) {
-                    auto version = part.split(QLatin1Char('='));
-                    m_lastRunningState = version[1].toInt();
-//                    LOG( INFO, QString( "Interface support: getRunningState response: %1 ").arg(runState));
-                    break;
-                }
-            }
-        }
-    }
+    bool ignoreNakResponse = true;
+    const QByteArray response = commandResponse(interfaceBoardCommandList[OctInterfaceBoardCommandType::GET_SLED_RUNNING_STATE], ignoreNakResponse);
+    m_lastRunningState = parseRunningState(response, m_lastRunningState);
     if(lastRunningState0 != m_lastRunningState){
         LOG1(m_lastRunningState)
         lastRunningState0 = m_lastRunningState;
@@ -912,6 +928,23 @@ int InterfaceSupport::getRunningState() {
     return m_lastRunningState;
 }
 
+int InterfaceSupport::parseRunningState(const QByteArray& response, int lastRunningState) {
+    int runningState = lastRunningState;
+
+    if(response.toUpper().contains("ACK")){
+        auto parts = QString(response).split(QLatin1Char(' '));
+        for (auto part : parts) {
+            if (part.contains("gr")) {
+                auto version = part.split(QLatin1Char('='));
+                runningState = version[1].toInt();
+//                LOG( INFO, QString( "Interface support: getRunningState response: %1 ").arg(runState));
+                break;
+            }
+        }
+    }
+    return runningState;
+}
+
 bool InterfaceSupport::setSledRunState(bool runState) {
     QByteArray command;
 
@@ -924,8 +957,8 @@ bool InterfaceSupport::setSledRunState(bool runState) {
 
     bool operationResult = false;
 
-    if (writeDataToDevice(command)) {
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(command);
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             operationResult = true;
 
@@ -960,8 +993,8 @@ bool InterfaceSupport::setSledDirection(bool direction) {
 
     bool operationResult = false;
 
-    if (writeDataToDevice(command)) {
-        QByteArray response = readDataFromDevice();
+    const QByteArray response = commandResponse(command);
+    if (!response.isEmpty()) {
         if(response.toUpper().contains("ACK")){
             operationResult = true;
 
@@ -3,9 +3,12 @@
 
 #include "ftd2xx.h"
 #include "deviceSettings.h"
+#include "interfacecommandchannel.h"
 
 #include <bitset>
+#include <memory>
 #include <QByteArray>
+#include <QFuture>
 #include <map>
 
 /*
@@ -247,6 +250,34 @@ public:
 
     int getLastRunningState() const;
 
+    /*
+     * Queues a raw serial command without waiting for the response
+     *
+     * @returns future holding the response, empty if the board did not answer
+     */
+    QFuture<QByteArray> sendCommand(const QByteArray& command, bool ignoreNakResponse = false);
+
+    /*
+     * Serial command channel, e.g. to measure round-trip latency; null if the board is not open
+     */
+    InterfaceCommandChannel* commandChannel() const;
+
+    /*
+     * Serial command string for a query or command without parameters
+     */
+    QByteArray command(OctInterfaceBoardCommandType type) const;
+
+    /*
+     * Response parsers, shared by the blocking queries, the pipelined status report and the
+     * telemetry poller
+     */
+    static float parseHardwareVersion(const QByteArray& response);
+    static float parseFirmwareVersion(const QByteArray& response);
+    static float parseSupplyVoltage(const QByteArray& response);
+    static float parseSledFirmwareVersion(const QByteArray& response);
+    static int parseVOASettings(const QByteArray& response);
+    static int parseRunningState(const QByteArray& response, int lastRunningState);
+
     void updateSledConfig(const device& currentDevice);
 
     bool setSledClockingEnabled(const device& currentDevice);
@@ -296,29 +327,24 @@ private:
     void populateInterfaceBoardCommandList();
 
     /*
-     * Reads command response from the interface board
+     * Sends a command through the command channel and waits for its response
      *
      * @param ignoreNakResponse
      *      If the flag is set to true, do not log any message if we get NAK response from the
      *      interface board. Usually, we may need to ignore NAK response when we query the
      *      running state of sled.
      *
-     * @returns supply voltage in float value
+     * @returns simplified response; empty if the command could not be written or timed out
      */
-    QByteArray readDataFromDevice(bool ignoreNakResponse = false);
+    QByteArray commandResponse(const QByteArray& command, bool ignoreNakResponse = false);
 
     /*
-     * Queries supply voltage to determine if AC power is available to the interface board
-     *
-     * @param command
-     *      command string in byte array to be written to the serial port to get the response.
-     *
-     * @returns True if write is successful
+     * Writes currentBitSetVal to the bit-bang pins on the I/O thread and waits for it
      */
-    bool writeDataToDevice(QByteArray command);
+    bool writeBitMode();
 
     FT_DEVICE_LIST_INFO_NODE *ftdiDeviceInfo = nullptr; // FTDI device information
-    FT_HANDLE ftHandle = nullptr; // FTDI handle to be used to read/write bits
+    FT_HANDLE ftHandle = nullptr; // FTDI handle until it is handed to the command channel
     std::bitset<8> currentBitSetVal; // Bitset used to control device functionality
 
     static InterfaceSupport* m_instance; // Pointer to singleton instance to InterfaceSupport class
@@ -326,6 +352,8 @@ private:
     InterfaceBoardCommandList interfaceBoardCommandList; // List of commands to be used to query interface board
 
     int m_lastRunningState{0};
+
+    std::unique_ptr<InterfaceCommandChannel> m_channel; // All board I/O runs on its I/O thread
 };
 
 #endif // INTERFACESUPPORT_H
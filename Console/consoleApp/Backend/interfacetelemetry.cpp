@@ -0,0 +1,223 @@
+#include "interfacetelemetry.h"
+#include "interfacesupport.h"
+#include <QDateTime>
+#include <QFutureWatcher>
+#include "logger.h"
+
+namespace{
+// The running state drives the laser/VOA interlock, so it is polled often
+const int RunningStatePeriod_ms = 250;
+const int StatusPeriod_ms = 2000;
+// A sled can be swapped during a session
+const int VersionPeriod_ms = 30000;
+
+/*
+ * Runs onDone on the GUI thread when the future finishes
+ */
+template <typename T, typename F>
+void whenFinished(QObject* context, const QFuture<T>& future, F onDone)
+{
+    auto* watcher = new QFutureWatcher<T>(context);
+    QObject::connect(watcher, &QFutureWatcher<T>::finished, context, [watcher, onDone]()
+    {
+        onDone(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
+}
+
+InterfaceTelemetry* InterfaceTelemetry::m_instance{nullptr};
+
+bool InterfaceTelemetry_t::isStatusFresh(int maxAge_ms) const
+{
+    return (statusUpdated_ms >= 0) && (QDateTime::currentMSecsSinceEpoch() - statusUpdated_ms <= maxAge_ms);
+}
+
+InterfaceTelemetry *InterfaceTelemetry::instance()
+{
+    if(!m_instance){
+        m_instance = new InterfaceTelemetry();
+    }
+    return m_instance;
+}
+
+InterfaceTelemetry::InterfaceTelemetry(QObject *parent) : QObject(parent)
+{
+    m_runningStateTimer.setInterval(RunningStatePeriod_ms);
+    m_statusTimer.setInterval(StatusPeriod_ms);
+    m_versionTimer.setInterval(VersionPeriod_ms);
+
+    connect(&m_runningStateTimer, &QTimer::timeout, this, &InterfaceTelemetry::pollRunningState);
+    connect(&m_statusTimer, &QTimer::timeout, this, &InterfaceTelemetry::pollStatus);
+    connect(&m_versionTimer, &QTimer::timeout, this, &InterfaceTelemetry::pollVersions);
+}
+
+InterfaceTelemetry_t InterfaceTelemetry::snapshot() const
+{
+    QReadLocker lock(&m_lock);
+    return m_snapshot;
+}
+
+void InterfaceTelemetry::start()
+{
+    LOG1(RunningStatePeriod_ms)
+    pollVersions();
+    pollStatus();
+    pollRunningState();
+
+    m_runningStateTimer.start();
+    m_statusTimer.start();
+    m_versionTimer.start();
+}
+
+void InterfaceTelemetry::stop()
+{
+    m_runningStateTimer.stop();
+    m_statusTimer.stop();
+    m_versionTimer.stop();
+}
+
+void InterfaceTelemetry::refreshStatus()
+{
+    m_isStatusLogRequested = true;
+    if(m_statusPending){
+        m_isStatusRefreshQueued = true;
+        return;
+    }
+    pollStatus();
+}
+
+/*
+ * Each poll queues its queries on the command channel and returns; a poll is skipped while
+ * the previous one of the same kind is still waiting for the board.
+ */
+void InterfaceTelemetry::pollRunningState()
+{
+    auto interfaceSupport = InterfaceSupport::getInstance();
+    if(!interfaceSupport || m_runningStatePending){
+        return;
+    }
+    m_runningStatePending = true;
+
+    // The sled answers NAK while it is powered off
+    const bool ignoreNakResponse{true};
+    whenFinished(this, interfaceSupport->sendCommand(interfaceSupport->command(OctInterfaceBoardCommandType::GET_SLED_RUNNING_STATE), ignoreNakResponse),
+                 [this](const QByteArray& response)
+    {
+        m_runningStatePending = false;
+        if(!response.isEmpty()){
+            InterfaceTelemetry_t updated = snapshot();
+            updated.runningState = InterfaceSupport::parseRunningState(response, updated.runningState);
+            updated.runningStateUpdated_ms = QDateTime::currentMSecsSinceEpoch();
+            publish(updated);
+        }
+    });
+}
+
+void InterfaceTelemetry::pollStatus()
+{
+    auto interfaceSupport = InterfaceSupport::getInstance();
+    if(!interfaceSupport || !interfaceSupport->commandChannel() || m_statusPending){
+        return;
+    }
+    m_statusPending = true;
+
+    const QList<QByteArray> commands{ interfaceSupport->command(OctInterfaceBoardCommandType::GET_SUPPLY_VOLTAGE),
+                                      interfaceSupport->command(OctInterfaceBoardCommandType::GET_VOA_SETTINGS) };
+    whenFinished(this, interfaceSupport->commandChannel()->sendPipelined(commands), [this](const QList<QByteArray>& responses)
+    {
+        m_statusPending = false;
+        if(m_isStatusRefreshQueued){
+            m_isStatusRefreshQueued = false;
+            pollStatus();
+            return;
+        }
+        if(responses.size() == 2 && !responses.at(0).isEmpty() && !responses.at(1).isEmpty()){
+            InterfaceTelemetry_t updated = snapshot();
+            updated.supplyVoltage = InterfaceSupport::parseSupplyVoltage(responses.at(0));
+            updated.voaSettings = InterfaceSupport::parseVOASettings(responses.at(1));
+            updated.statusUpdated_ms = QDateTime::currentMSecsSinceEpoch();
+            if(m_isStatusLogRequested){
+                m_isStatusLogRequested = false;
+                LOG2(updated.supplyVoltage, updated.voaSettings)
+            }
+            publish(updated);
+        }
+    });
+}
+
+void InterfaceTelemetry::pollVersions()
+{
+    auto interfaceSupport = InterfaceSupport::getInstance();
+    if(!interfaceSupport || !interfaceSupport->commandChannel() || m_versionsPending){
+        return;
+    }
+    m_versionsPending = true;
+
+    const QList<QByteArray> commands{ interfaceSupport->command(OctInterfaceBoardCommandType::GET_HARDWARE_VERSION),
+                                      interfaceSupport->command(OctInterfaceBoardCommandType::GET_FIRMWARE_VERSION),
+                                      interfaceSupport->command(OctInterfaceBoardCommandType::GET_SLED_FIRMWARE_VERSION) };
+    whenFinished(this, interfaceSupport->commandChannel()->sendPipelined(commands), [this](const QList<QByteArray>& responses)
+    {
+        m_versionsPending = false;
+        if(responses.size() == 3){
+            InterfaceTelemetry_t updated = snapshot();
+            updated.hardwareVersion = InterfaceSupport::parseHardwareVersion(responses.at(0));
+            updated.firmwareVersion = InterfaceSupport::parseFirmwareVersion(responses.at(1));
+            updated.sledFirmwareVersion = InterfaceSupport::parseSledFirmwareVersion(responses.at(2));
+            publish(updated);
+        }
+    });
+}
+
+/*
+ * Stores the new values; the version only moves, and signals only fire, on real changes.
+ * The timestamps alone do not count as a change.
+ */
+void InterfaceTelemetry::publish(const InterfaceTelemetry_t &updated)
+{
+    InterfaceTelemetry_t previous;
+    InterfaceTelemetry_t current;
+    {
+        QWriteLocker lock(&m_lock);
+        previous = m_snapshot;
+        m_snapshot = updated;
+        m_snapshot.version = previous.version;
+
+        const bool isChanged = (updated.runningState != previous.runningState) ||
+                               !qFuzzyCompare(1.0f + updated.supplyVoltage, 1.0f + previous.supplyVoltage) ||
+                               (updated.voaSettings != previous.voaSettings) ||
+                               !qFuzzyCompare(1.0f + updated.hardwareVersion, 1.0f + previous.hardwareVersion) ||
+                               !qFuzzyCompare(1.0f + updated.firmwareVersion, 1.0f + previous.firmwareVersion) ||
+                               !qFuzzyCompare(1.0f + updated.sledFirmwareVersion, 1.0f + previous.sledFirmwareVersion);
+        if(isChanged){
+            m_snapshot.version++;
+        }
+        current = m_snapshot;
+    }
+
+    if(current.version == previous.version){
+        return;
+    }
+
+    if(current.runningState != previous.runningState){
+        LOG1(current.runningState)
+        emit runningStateChanged(current.runningState);
+    }
+    if(!qFuzzyCompare(1.0f + current.supplyVoltage, 1.0f + previous.supplyVoltage)){
+        LOG1(current.supplyVoltage)
+        emit supplyVoltageChanged(current.supplyVoltage);
+    }
+    if(current.voaSettings != previous.voaSettings){
+        LOG1(current.voaSettings)
+        emit voaSettingsChanged(current.voaSettings);
+    }
+    if(!qFuzzyCompare(1.0f + current.hardwareVersion, 1.0f + previous.hardwareVersion) ||
+       !qFuzzyCompare(1.0f + current.firmwareVersion, 1.0f + previous.firmwareVersion) ||
+       !qFuzzyCompare(1.0f + current.sledFirmwareVersion, 1.0f + previous.sledFirmwareVersion)){
+        LOG3(current.hardwareVersion, current.firmwareVersion, current.sledFirmwareVersion)
+        emit versionsChanged();
+    }
+    emit telemetryChanged(current.version);
+}
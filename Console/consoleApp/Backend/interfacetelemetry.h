@@ -0,0 +1,87 @@
+#ifndef INTERFACETELEMETRY_H
+#define INTERFACETELEMETRY_H
+
+#include <QObject>
+#include <QReadWriteLock>
+#include <QTimer>
+
+/*
+* Latest values read from the interface board and sled. The version increments whenever a
+* value changes, so readers can tell cheaply whether anything is new.
+*/
+struct InterfaceTelemetry_t
+{
+    quint64 version{0};
+
+    int   runningState{0};
+    float supplyVoltage{0.0f};
+    int   voaSettings{-1};
+    float hardwareVersion{0.0f};
+    float firmwareVersion{0.0f};
+    float sledFirmwareVersion{0.0f};
+
+    qint64 runningStateUpdated_ms{-1}; // msecs since epoch of the last answered query
+    qint64 statusUpdated_ms{-1};       // supply voltage and VOA
+
+    /*
+     * True if the supply voltage and VOA were read within the last maxAge_ms
+     */
+    bool isStatusFresh(int maxAge_ms) const;
+};
+
+/*
+* InterfaceTelemetry polls the sled running state, supply voltage, VOA and firmware versions on
+* its own cadence through the interface board command channel. UI code reads snapshot() without
+* touching the serial port, and the change signals fire only when a value actually changes.
+*/
+class InterfaceTelemetry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static InterfaceTelemetry* instance();
+
+    InterfaceTelemetry_t snapshot() const;
+
+    void start();
+    void stop();
+
+    /*
+     * Poll the supply voltage and VOA now, e.g. after switching AC power or the VOA mode, and
+     * log the values read. A poll already on its way is followed by a fresh one, since its
+     * values may predate the switch.
+     */
+    void refreshStatus();
+
+signals:
+    void telemetryChanged(quint64 version);
+    void runningStateChanged(int runningState);
+    void supplyVoltageChanged(float supplyVoltage);
+    void voaSettingsChanged(int voaSettings);
+    void versionsChanged();
+
+private:
+    explicit InterfaceTelemetry(QObject *parent = nullptr);
+
+    void pollRunningState();
+    void pollStatus();
+    void pollVersions();
+    void publish(const InterfaceTelemetry_t& updated);
+
+    static InterfaceTelemetry* m_instance;
+
+    mutable QReadWriteLock m_lock;
+    InterfaceTelemetry_t m_snapshot;
+
+    QTimer m_runningStateTimer;
+    QTimer m_statusTimer;
+    QTimer m_versionTimer;
+
+    bool m_runningStatePending{false};
+    bool m_statusPending{false};
+    bool m_isStatusRefreshQueued{false};   // poll again once the pending one is back
+    bool m_isStatusLogRequested{false};    // log the values of the next status poll
+    bool m_versionsPending{false};
+};
+
+#endif // INTERFACETELEMETRY_H
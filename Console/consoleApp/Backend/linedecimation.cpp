@@ -0,0 +1,247 @@
+#include "linedecimation.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LINE_DECIMATION_SSE2 1
+#endif
+
+namespace{
+const int WeightSum = 256;
+
+inline size_t wrapLine( long long line, size_t numberOfLines )
+{
+    const long long count = (long long)( numberOfLines );
+    return size_t( ( ( line % count ) + count ) % count );
+}
+
+/*
+ * Rounds the weights to integers that add up to WeightSum, largest remainders first
+ */
+std::vector<uint16_t> quantize( const std::vector<double>& weights )
+{
+    double total{0.0};
+    for( double weight : weights )
+    {
+        total += weight;
+    }
+
+    std::vector<uint16_t> quantized( weights.size() );
+    std::vector<std::pair<double, size_t>> remainders;
+    int sum{0};
+    for( size_t i = 0; i < weights.size(); i++ )
+    {
+        const double exact = weights[ i ] * WeightSum / total;
+        quantized[ i ] = uint16_t( std::floor( exact ) );
+        sum += quantized[ i ];
+        remainders.emplace_back( exact - quantized[ i ], i );
+    }
+    std::sort( remainders.begin(), remainders.end(), []( const std::pair<double, size_t>& a, const std::pair<double, size_t>& b )
+    {
+        return a.first > b.first;
+    } );
+    for( size_t i = 0; ( sum < WeightSum ) && ( i < remainders.size() ); i++, sum++ )
+    {
+        ++quantized[ remainders[ i ].second ];
+    }
+    return quantized;
+}
+}
+
+LineDecimation::Mode LineDecimation::modeFromSetting( const QString &setting )
+{
+    const QString name = setting.trimmed().toLower();
+    if( name == "box" )
+    {
+        return Mode::Box;
+    }
+    if( name == "max" )
+    {
+        return Mode::Max;
+    }
+    if( name == "gaussian" )
+    {
+        return Mode::Gaussian;
+    }
+    return Mode::Off;
+}
+
+QString LineDecimation::modeName( Mode mode )
+{
+    switch( mode )
+    {
+    case Mode::Box:
+        return "box";
+    case Mode::Max:
+        return "max";
+    case Mode::Gaussian:
+        return "gaussian";
+    default:
+        return "off";
+    }
+}
+
+int LineDecimation::defaultTargetLines( int sectorSize_px )
+{
+    return int( M_PI * sectorSize_px );
+}
+
+/*
+ * factorFor
+ *
+ * The nearest whole factor, so the result stays within a third of the target either way.
+ */
+int LineDecimation::factorFor( size_t numberOfLines, int targetLines )
+{
+    if( targetLines <= 0 )
+    {
+        return 1;
+    }
+    const int factor = int( std::lround( double( numberOfLines ) / targetLines ) );
+    return std::max( 1, std::min( factor, int( MaxFactor ) ) );
+}
+
+size_t LineDecimation::outputLines( size_t numberOfLines, int factor )
+{
+    return factor > 1 ? ( numberOfLines + size_t( factor ) - 1 ) / size_t( factor ) : numberOfLines;
+}
+
+LineDecimation::Filter_t LineDecimation::makeFilter( Mode mode, int factor )
+{
+    Filter_t filter;
+    filter.mode = mode;
+    filter.factor = std::max( 1, std::min( factor, int( MaxFactor ) ) );
+
+    std::vector<double> weights;
+    switch( mode )
+    {
+    case Mode::Box:
+    case Mode::Max:
+        weights.assign( size_t( filter.factor ), 1.0 );
+        break;
+    case Mode::Gaussian:
+    {
+        // Sigma of half a group; taps reach half a group beyond it on either side
+        const double sigma = 0.5 * filter.factor;
+        const double centre = 0.5 * ( filter.factor - 1 );
+        filter.firstOffset = -( filter.factor / 2 );
+        for( int tap = 0; tap < 2 * filter.factor; tap++ )
+        {
+            const double distance = filter.firstOffset + tap - centre;
+            weights.push_back( std::exp( -distance * distance / ( 2.0 * sigma * sigma ) ) );
+        }
+        break;
+    }
+    default:
+        weights.assign( 1, 1.0 );
+        break;
+    }
+    filter.weights = quantize( weights );
+    return filter;
+}
+
+/*
+ * decimate
+ *
+ * 16 samples at a time: weighted sums in 16 bits (at most 255 * 256) or a running byte max.
+ * The taps index a revolution padded to a whole number of groups; the padding lines do not
+ * exist, so a group that touches them is summed one sample at a time with its own weight sum.
+ */
+void LineDecimation::decimate( const uint8_t *in, size_t numberOfLines, size_t lineLength, uint8_t *out, const Filter_t &filter )
+{
+    const size_t lines = outputLines( numberOfLines, filter.factor );
+    const size_t paddedLines = filter.factor > 1 ? lines * size_t( filter.factor ) : numberOfLines;
+    const int allTaps = int( filter.weights.size() );
+    const uint8_t* tapLine[ MaxTaps ];
+    unsigned int tapWeight[ MaxTaps ];
+
+    for( size_t line = 0; line < lines; line++ )
+    {
+        const long long first = (long long)( line ) * filter.factor + filter.firstOffset;
+        int taps{0};
+        unsigned int weightSum{0};
+        for( int tap = 0; tap < allTaps; tap++ )
+        {
+            const size_t tapIndex = wrapLine( first + tap, paddedLines );
+            if( tapIndex >= numberOfLines )
+            {
+                continue;
+            }
+            tapLine[ taps ] = in + tapIndex * lineLength;
+            tapWeight[ taps ] = filter.weights[ tap ];
+            weightSum += tapWeight[ taps ];
+            taps++;
+        }
+        uint8_t* outLine = out + line * lineLength;
+        size_t sample{0};
+
+        if( filter.mode == Mode::Max )
+        {
+#if LINE_DECIMATION_SSE2
+            for( ; sample + 16 <= lineLength; sample += 16 )
+            {
+                __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( tapLine[ 0 ] + sample ) );
+                for( int tap = 1; tap < taps; tap++ )
+                {
+                    value = _mm_max_epu8( value, _mm_loadu_si128( reinterpret_cast<const __m128i*>( tapLine[ tap ] + sample ) ) );
+                }
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( outLine + sample ), value );
+            }
+#endif
+            for( ; sample < lineLength; sample++ )
+            {
+                uint8_t value = tapLine[ 0 ][ sample ];
+                for( int tap = 1; tap < taps; tap++ )
+                {
+                    value = std::max( value, tapLine[ tap ][ sample ] );
+                }
+                outLine[ sample ] = value;
+            }
+            continue;
+        }
+
+        if( weightSum != WeightSum )
+        {
+            for( ; sample < lineLength; sample++ )
+            {
+                unsigned int sum = weightSum / 2;
+                for( int tap = 0; tap < taps; tap++ )
+                {
+                    sum += tapWeight[ tap ] * tapLine[ tap ][ sample ];
+                }
+                outLine[ sample ] = uint8_t( sum / weightSum );
+            }
+            continue;
+        }
+
+#if LINE_DECIMATION_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16( WeightSum / 2 );
+        for( ; sample + 16 <= lineLength; sample += 16 )
+        {
+            __m128i sumLo = round;
+            __m128i sumHi = round;
+            for( int tap = 0; tap < taps; tap++ )
+            {
+                const __m128i weight = _mm_set1_epi16( short( tapWeight[ tap ] ) );
+                const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( tapLine[ tap ] + sample ) );
+                sumLo = _mm_add_epi16( sumLo, _mm_mullo_epi16( _mm_unpacklo_epi8( value, zero ), weight ) );
+                sumHi = _mm_add_epi16( sumHi, _mm_mullo_epi16( _mm_unpackhi_epi8( value, zero ), weight ) );
+            }
+            const __m128i result = _mm_packus_epi16( _mm_srli_epi16( sumLo, 8 ), _mm_srli_epi16( sumHi, 8 ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( outLine + sample ), result );
+        }
+#endif
+        for( ; sample < lineLength; sample++ )
+        {
+            unsigned int sum = WeightSum / 2;
+            for( int tap = 0; tap < taps; tap++ )
+            {
+                sum += tapWeight[ tap ] * tapLine[ tap ][ sample ];
+            }
+            outLine[ sample ] = uint8_t( sum >> 8 );
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef LINEDECIMATION_H
+#define LINEDECIMATION_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Combines groups of A-lines when a revolution has more lines than the sector can show.
+*
+* The factor follows from the lines in the frame (one revolution) and a target line count,
+* so faster and slower pullbacks both end up near the target. Weighted modes use 8-bit
+* fixed point weights that sum to 256; lineDecimation.cl does exactly the same arithmetic.
+*/
+class LineDecimation
+{
+public:
+    enum class Mode
+    {
+        Off,
+        Box,        // mean of the lines in the group
+        Max,        // brightest sample of the group; keeps thin bright structures
+        Gaussian    // smooth roll-off over two groups, less aliasing than box
+    };
+    static Mode modeFromSetting( const QString& setting );
+    static QString modeName( Mode mode );
+
+    // Largest factor that is supported (and fits the 8-bit weights)
+    static const int MaxFactor = 16;
+    static const int MaxTaps = 2 * MaxFactor;
+
+    /*
+     * Default target: the outer circumference of the sector in pixels, the most lines
+     * that can be told apart on screen
+     */
+    static int defaultTargetLines( int sectorSize_px );
+
+    struct Filter_t
+    {
+        Mode mode{Mode::Off};
+        int factor{1};
+        int firstOffset{0};             // first tap relative to the first line of the group
+        std::vector<uint16_t> weights;  // one per tap; unused for Max
+    };
+
+    static int factorFor( size_t numberOfLines, int targetLines );
+
+    /*
+     * Rounds up, so the frame still covers the whole revolution: when the lines do not divide
+     * evenly, the last group combines only the lines that are left
+     */
+    static size_t outputLines( size_t numberOfLines, int factor );
+    static Filter_t makeFilter( Mode mode, int factor );
+
+    /*
+     * Writes outputLines( numberOfLines, filter.factor ) lines of lineLength samples to out.
+     * Lines wrap around; a frame is one revolution. Taps that fall on the missing lines of a
+     * short last group are left out and the remaining weights are rescaled.
+     */
+    static void decimate( const uint8_t* in, size_t numberOfLines, size_t lineLength, uint8_t* out, const Filter_t& filter );
+};
+
+#endif // LINEDECIMATION_H
@@ -1,5 +1,6 @@
 #include "octsystemdiagnostics.h"
 #include "logger.h"
+#include "interfacetelemetry.h"
 
 OctSystemDiagnostics::OctSystemDiagnostics(QObject *parent) : QObject(parent) {
 }
@@ -61,7 +62,13 @@ int OctSystemDiagnostics::performACPowerCheck() {
         auto interfaceSupport = InterfaceSupport::getInstance();
         float detectedACVoltage = 0.0;
 
-        if (interfaceSupport) {
+        // The telemetry poller's value is used unless it is stale
+        const int MaxSupplyVoltageAge_ms = 5000;
+        const auto telemetry = InterfaceTelemetry::instance()->snapshot();
+
+        if (interfaceSupport && telemetry.isStatusFresh(MaxSupplyVoltageAge_ms)) {
+            detectedACVoltage = telemetry.supplyVoltage;
+        } else if (interfaceSupport) {
             detectedACVoltage = interfaceSupport->getSupplyVoltage();
         } else {
             // InterfaceSupport cannot be instatiated possibly due to FTDI error.
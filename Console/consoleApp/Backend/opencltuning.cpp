@@ -0,0 +1,204 @@
+#include "opencltuning.h"
+#include "defaults.h"
+#include "logger.h"
+#include <QDateTime>
+#include <QSettings>
+
+namespace{
+// Bump when the candidates change so every console tunes again
+const int TuningVersion = 2;
+
+// Only formats the kernels can read (see isReadableFormat) are tried
+const cl_image_format ImageFormats[] = {
+    { CL_R, CL_UNSIGNED_INT8 }
+};
+
+const cl_mem_flags UploadMemFlags[] = {
+    CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+    CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR  // zero copy on integrated GPUs
+};
+
+const size_t WarpLocalSizes[][ 2 ] = {
+    { 16, 16 }, { 8, 8 }, { 16, 8 }, { 32, 8 }, { 32, 4 }, { 64, 4 }, { 32, 16 }, { 0, 0 }
+};
+
+QString deviceString( cl_device_id device, cl_device_info info )
+{
+    char value[ 1024 ] = { 0 };
+    clGetDeviceInfo( device, info, sizeof( value ), value, nullptr );
+    return QString( value ).trimmed();
+}
+
+QString channelOrderName( cl_channel_order order )
+{
+    switch( order )
+    {
+    case CL_R:         return "R";
+    case CL_A:         return "A";
+    case CL_RG:        return "RG";
+    case CL_RA:        return "RA";
+    case CL_RGB:       return "RGB";
+    case CL_RGBA:      return "RGBA";
+    case CL_BGRA:      return "BGRA";
+    case CL_ARGB:      return "ARGB";
+    case CL_INTENSITY: return "INTENSITY";
+    case CL_LUMINANCE: return "LUMINANCE";
+    default:           return QString( "order 0x%1" ).arg( uint( order ), 0, 16 );
+    }
+}
+
+QString channelTypeName( cl_channel_type type )
+{
+    switch( type )
+    {
+    case CL_SNORM_INT8:       return "SNORM8";
+    case CL_SNORM_INT16:      return "SNORM16";
+    case CL_UNORM_INT8:       return "UNORM8";
+    case CL_UNORM_INT16:      return "UNORM16";
+    case CL_SIGNED_INT8:      return "INT8";
+    case CL_SIGNED_INT16:     return "INT16";
+    case CL_SIGNED_INT32:     return "INT32";
+    case CL_UNSIGNED_INT8:    return "UINT8";
+    case CL_UNSIGNED_INT16:   return "UINT16";
+    case CL_UNSIGNED_INT32:   return "UINT32";
+    case CL_HALF_FLOAT:       return "HALF";
+    case CL_FLOAT:            return "FLOAT";
+    default:                  return QString( "type 0x%1" ).arg( uint( type ), 0, 16 );
+    }
+}
+
+bool isFormatSupported( cl_context context, const cl_image_format& format )
+{
+    cl_uint count{0};
+    if( clGetSupportedImageFormats( context, CL_MEM_READ_WRITE, CL_MEM_OBJECT_IMAGE2D, 0, nullptr, &count ) != CL_SUCCESS )
+    {
+        return false;
+    }
+    std::vector<cl_image_format> formats( count );
+    clGetSupportedImageFormats( context, CL_MEM_READ_WRITE, CL_MEM_OBJECT_IMAGE2D, count, formats.data(), nullptr );
+    for( const auto& supported : formats )
+    {
+        if( ( supported.image_channel_order == format.image_channel_order ) &&
+            ( supported.image_channel_data_type == format.image_channel_data_type ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+QString OpenClTuning::deviceKey( cl_device_id device )
+{
+    const QString key = deviceString( device, CL_DEVICE_VENDOR ) + " " +
+                        deviceString( device, CL_DEVICE_NAME ) + " " +
+                        deviceString( device, CL_DRIVER_VERSION );
+
+    // QSettings groups can't hold slashes
+    QString group;
+    for( const QChar c : key )
+    {
+        group += c.isLetterOrNumber() || ( c == '.' ) ? c : QChar( '_' );
+    }
+    return group;
+}
+
+std::vector<OpenClTuning::Settings_t> OpenClTuning::candidates( cl_context context, size_t maxWorkGroupSize )
+{
+    std::vector<Settings_t> settings;
+    for( const auto& format : ImageFormats )
+    {
+        if( !isReadableFormat( format ) || !isFormatSupported( context, format ) )
+        {
+            LOG2(format.image_channel_order, format.image_channel_data_type)
+            continue;
+        }
+        for( const auto flags : UploadMemFlags )
+        {
+            for( const auto& localSize : WarpLocalSizes )
+            {
+                // Every sector size has to split into whole work-groups
+                const bool isDriverChoice = localSize[ 0 ] == 0;
+                if( !isDriverChoice &&
+                    ( ( localSize[ 0 ] * localSize[ 1 ] > maxWorkGroupSize ) ||
+                      ( SectorAlignment_px % localSize[ 0 ] != 0 ) || ( SectorAlignment_px % localSize[ 1 ] != 0 ) ) )
+                {
+                    continue;
+                }
+                Settings_t candidate;
+                candidate.imageFormat = format;
+                candidate.uploadMemFlags = flags;
+                candidate.warpLocalSize[ 0 ] = localSize[ 0 ];
+                candidate.warpLocalSize[ 1 ] = localSize[ 1 ];
+                settings.push_back( candidate );
+            }
+        }
+    }
+    return settings;
+}
+
+bool OpenClTuning::isReadableFormat( const cl_image_format &format )
+{
+    return ( format.image_channel_data_type == CL_UNSIGNED_INT8 ) ||
+           ( format.image_channel_data_type == CL_UNSIGNED_INT16 ) ||
+           ( format.image_channel_data_type == CL_UNSIGNED_INT32 );
+}
+
+bool OpenClTuning::load( const QString &deviceKey, Settings_t &settings, const QString &settingsFile )
+{
+    QSettings tuning( settingsFile, QSettings::IniFormat );
+    tuning.beginGroup( deviceKey );
+    if( tuning.value( "version", 0 ).toInt() != TuningVersion )
+    {
+        return false;
+    }
+
+    Settings_t loaded;
+    loaded.imageFormat.image_channel_order = cl_channel_order( tuning.value( "imageChannelOrder" ).toUInt() );
+    loaded.imageFormat.image_channel_data_type = cl_channel_type( tuning.value( "imageChannelDataType" ).toUInt() );
+    loaded.uploadMemFlags = cl_mem_flags( tuning.value( "uploadMemFlags" ).toULongLong() );
+    loaded.warpLocalSize[ 0 ] = size_t( tuning.value( "warpLocalSizeX" ).toUInt() );
+    loaded.warpLocalSize[ 1 ] = size_t( tuning.value( "warpLocalSizeY" ).toUInt() );
+    loaded.warp_ms = tuning.value( "warp_ms" ).toDouble();
+    loaded.sectorSize_px = tuning.value( "sectorSize_px", 0 ).toInt();
+
+    // A hand-edited file could name a format the kernels can't read; tune again instead
+    if( !isReadableFormat( loaded.imageFormat ) )
+    {
+        return false;
+    }
+    settings = loaded;
+    return true;
+}
+
+void OpenClTuning::save( const QString &deviceKey, const Settings_t &settings, const QString &settingsFile )
+{
+    QSettings tuning( settingsFile, QSettings::IniFormat );
+    tuning.beginGroup( deviceKey );
+    tuning.setValue( "version", TuningVersion );
+    tuning.setValue( "imageChannelOrder", uint( settings.imageFormat.image_channel_order ) );
+    tuning.setValue( "imageChannelDataType", uint( settings.imageFormat.image_channel_data_type ) );
+    tuning.setValue( "uploadMemFlags", qulonglong( settings.uploadMemFlags ) );
+    tuning.setValue( "warpLocalSizeX", uint( settings.warpLocalSize[ 0 ] ) );
+    tuning.setValue( "warpLocalSizeY", uint( settings.warpLocalSize[ 1 ] ) );
+    tuning.setValue( "warp_ms", settings.warp_ms );
+    tuning.setValue( "sectorSize_px", settings.sectorSize_px );
+    tuning.setValue( "tuned", QDateTime::currentDateTime().toString( Qt::ISODate ) );
+    tuning.endGroup();
+    tuning.sync();
+
+    if( tuning.status() != QSettings::NoError )
+    {
+        LOG( WARNING, QString( "Failed to write OpenCL tuning %1" ).arg( settingsFile ) );
+    }
+}
+
+QString OpenClTuning::describe( const Settings_t &settings )
+{
+    const QString format = channelOrderName( settings.imageFormat.image_channel_order ) + "/" +
+                           channelTypeName( settings.imageFormat.image_channel_data_type );
+    const QString upload = ( settings.uploadMemFlags & CL_MEM_USE_HOST_PTR ) ? "use host ptr" : "copy host ptr";
+    const QString local = settings.warpLocalSize[ 0 ] ? QString( "%1x%2" ).arg( settings.warpLocalSize[ 0 ] ).arg( settings.warpLocalSize[ 1 ] )
+                                                      : QString( "driver" );
+    return QString( "%1, %2, warp work-group %3" ).arg( format, upload, local );
+}
@@ -0,0 +1,56 @@
+#ifndef OPENCLTUNING_H
+#define OPENCLTUNING_H
+
+#include <CL/opencl.h>
+#include <QString>
+#include "defaults.h"
+#include <vector>
+
+/*
+* Launch settings for the OpenCL device: image format, how frames are uploaded and the
+* work-group size of the warp.
+*
+* ScanConversion tries every candidate once per device and driver (see autoTuneOpenCL) and
+* the winner is kept in OpenClTuningFile, so later launches only read it back.
+*/
+class OpenClTuning
+{
+public:
+    struct Settings_t
+    {
+        cl_image_format imageFormat{CL_R, CL_UNSIGNED_INT8};
+        cl_mem_flags    uploadMemFlags{CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR};
+        size_t          warpLocalSize[ 2 ]{16, 16};     // { 0, 0 } leaves it to the driver
+        double          warp_ms{0.0};                   // as measured by the tuner
+        int             sectorSize_px{0};               // the sector size warp_ms was measured at
+    };
+
+    /*
+     * Vendor, device and driver version; a driver update tunes again
+     */
+    static QString deviceKey( cl_device_id device );
+
+    /*
+     * Supported combinations, the defaults first
+     *
+     * @param maxWorkGroupSize
+     *      the smaller of the device and warp kernel limits
+     */
+    static std::vector<Settings_t> candidates( cl_context context, size_t maxWorkGroupSize );
+
+    /*
+     * The kernels read and write with read_imageui and write_imageui, which are only defined
+     * for unsigned integer channel types
+     */
+    static bool isReadableFormat( const cl_image_format& format );
+
+    /*
+     * @param settingsFile
+     *      Only tests keep their tuning anywhere else
+     */
+    static bool load( const QString& deviceKey, Settings_t& settings, const QString& settingsFile = OpenClTuningFile );
+    static void save( const QString& deviceKey, const Settings_t& settings, const QString& settingsFile = OpenClTuningFile );
+    static QString describe( const Settings_t& settings );
+};
+
+#endif // OPENCLTUNING_H
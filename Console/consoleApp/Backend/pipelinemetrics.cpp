@@ -0,0 +1,199 @@
+#include "pipelinemetrics.h"
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace{
+const int BinsPerOctave = 4;
+}
+
+PipelineMetrics* PipelineMetrics::m_instance{nullptr};
+
+int StageHistogram::binFor( double value_us )
+{
+    if( value_us <= 1.0 )
+    {
+        return 0;
+    }
+    const int bin = int( std::ceil( std::log2( value_us ) * BinsPerOctave ) );
+    return std::min( bin, NumberOfBins - 1 );
+}
+
+double StageHistogram::binUpperEdge_us( int bin )
+{
+    return std::exp2( double( bin ) / BinsPerOctave );
+}
+
+void StageHistogram::add( double value_us )
+{
+    if( m_count == WindowSize )
+    {
+        // The oldest sample leaves the window
+        const double oldest = m_window[ m_next ];
+        --m_bins[ binFor( oldest ) ];
+        m_sum_us -= oldest;
+    }
+    else
+    {
+        ++m_count;
+    }
+    m_window[ m_next ] = value_us;
+    ++m_bins[ binFor( value_us ) ];
+    m_sum_us += value_us;
+    m_next = ( m_next + 1 ) % WindowSize;
+}
+
+void StageHistogram::clear()
+{
+    *this = StageHistogram();
+}
+
+double StageHistogram::mean_us() const
+{
+    return m_count ? m_sum_us / m_count : 0.0;
+}
+
+double StageHistogram::max_us() const
+{
+    double maximum{0.0};
+    for( int i = 0; i < m_count; i++ )
+    {
+        maximum = std::max( maximum, m_window[ i ] );
+    }
+    return maximum;
+}
+
+double StageHistogram::percentile_us( double fraction ) const
+{
+    if( !m_count )
+    {
+        return 0.0;
+    }
+    const int rank = std::max( 1, int( std::ceil( fraction * m_count ) ) );
+    int seen{0};
+    for( int bin = 0; bin < NumberOfBins; bin++ )
+    {
+        seen += m_bins[ bin ];
+        if( seen >= rank )
+        {
+            return binUpperEdge_us( bin );
+        }
+    }
+    return binUpperEdge_us( NumberOfBins - 1 );
+}
+
+QString PipelineMetrics_t::summary() const
+{
+    QString text;
+    QTextStream out( &text );
+    out << QString( "%1 %2 %3 %4 %5" ).arg( "stage", -17 ).arg( "p50", 8 ).arg( "p95", 8 ).arg( "max", 8 ).arg( "wait", 8 ) << "\n";
+    for( const auto& stage : stages )
+    {
+        if( !stage.execution.count() )
+        {
+            continue;
+        }
+        const auto ms = []( double value_us ){ return QString::number( value_us / 1000.0, 'f', 2 ); };
+        out << QString( "%1 %2 %3 %4 %5" ).arg( stage.name, -17 )
+                                          .arg( ms( stage.execution.percentile_us( 0.5 ) ), 8 )
+                                          .arg( ms( stage.execution.percentile_us( 0.95 ) ), 8 )
+                                          .arg( ms( stage.execution.max_us() ), 8 )
+                                          .arg( ms( stage.wait.mean_us() ), 8 ) << "\n";
+    }
+    out << "ms, over the last " << StageHistogram::WindowSize << " frames";
+    return text;
+}
+
+QString PipelineMetrics::stageName( Stage stage )
+{
+    switch( stage )
+    {
+    case Stage::FringeUpload:     return "fringe upload";
+    case Stage::Rescale:          return "rescale";
+    case Stage::Fft:              return "fft";
+    case Stage::PostFft:          return "postfft";
+    case Stage::SpectralReadback: return "a-line readback";
+    case Stage::Upload:           return "upload (host)";
+    case Stage::Decimation:       return "decimation";
+    case Stage::SpeckleFilter:    return "speckle filter";
+    case Stage::Average:          return "frame average";
+    case Stage::HistogramClear:   return "histogram clear";
+    case Stage::Warp:             return "warp";
+    case Stage::HistogramRead:    return "histogram read";
+    case Stage::Readback:         return "readback";
+    case Stage::Frame:            return "frame (host)";
+    case Stage::Render:           return "render (host)";
+    default:                      return "unknown";
+    }
+}
+
+PipelineMetrics *PipelineMetrics::instance()
+{
+    if( !m_instance )
+    {
+        m_instance = new PipelineMetrics();
+    }
+    return m_instance;
+}
+
+PipelineMetrics::PipelineMetrics( QObject *parent ) : QObject( parent )
+{
+    for( int i = 0; i < int( Stage::NumberOfStages ); i++ )
+    {
+        StageMetrics_t stage;
+        stage.name = stageName( Stage( i ) );
+        m_metrics.stages.push_back( stage );
+    }
+}
+
+PipelineMetrics_t PipelineMetrics::snapshot() const
+{
+    QReadLocker lock( &m_lock );
+    return m_metrics;
+}
+
+void PipelineMetrics::setProfiling( bool isProfiling )
+{
+    QWriteLocker lock( &m_lock );
+    m_metrics.isProfiling = isProfiling;
+}
+
+void PipelineMetrics::record( Stage stage, quint64 queued_ns, quint64 submit_ns, quint64 start_ns, quint64 end_ns )
+{
+    QWriteLocker lock( &m_lock );
+    auto& metrics = m_metrics.stages[ int( stage ) ];
+    metrics.wait.add( start_ns > queued_ns ? ( start_ns - queued_ns ) / 1000.0 : 0.0 );
+    metrics.execution.add( end_ns > start_ns ? ( end_ns - start_ns ) / 1000.0 : 0.0 );
+    metrics.lastQueuedToSubmit_us = submit_ns > queued_ns ? ( submit_ns - queued_ns ) / 1000.0 : 0.0;
+}
+
+void PipelineMetrics::recordHost( Stage stage, double elapsed_us )
+{
+    QWriteLocker lock( &m_lock );
+    m_metrics.stages[ int( stage ) ].execution.add( elapsed_us );
+}
+
+void PipelineMetrics::frameDone()
+{
+    quint64 version{0};
+    {
+        QWriteLocker lock( &m_lock );
+        version = ++m_metrics.version;
+    }
+    if( version % NotifyInterval == 0 )
+    {
+        emit metricsChanged( version );
+    }
+}
+
+void PipelineMetrics::reset()
+{
+    QWriteLocker lock( &m_lock );
+    for( auto& stage : m_metrics.stages )
+    {
+        stage.wait.clear();
+        stage.execution.clear();
+        stage.lastQueuedToSubmit_us = 0.0;
+    }
+    ++m_metrics.version;
+}
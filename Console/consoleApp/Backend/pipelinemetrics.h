@@ -0,0 +1,132 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+#include <array>
+
+/*
+* Rolling timing statistics of one pipeline stage over the last WindowSize samples, kept as a
+* log-spaced histogram (four bins per octave from 1 us) so percentiles are cheap to read.
+*/
+class StageHistogram
+{
+public:
+    static const int NumberOfBins = 68;     // 1 us to about 130 ms; slower lands in the last bin
+    static const int WindowSize = 256;
+
+    void add( double value_us );
+    void clear();
+
+    int count() const { return m_count; }
+    double mean_us() const;
+    double max_us() const;
+
+    /*
+     * Upper edge of the bin holding the given fraction of the samples
+     */
+    double percentile_us( double fraction ) const;
+
+    static double binUpperEdge_us( int bin );
+    const std::array<int, NumberOfBins>& bins() const { return m_bins; }
+
+private:
+    static int binFor( double value_us );
+
+    std::array<int, NumberOfBins> m_bins{};
+    std::array<double, WindowSize> m_window{};
+    int m_next{0};
+    int m_count{0};
+    double m_sum_us{0.0};
+};
+
+struct StageMetrics_t
+{
+    QString name;
+    StageHistogram wait;        // queued to start: time spent behind earlier work
+    StageHistogram execution;   // start to end on the device
+    double lastQueuedToSubmit_us{0.0};
+};
+
+struct PipelineMetrics_t
+{
+    quint64 version{0};
+    bool isProfiling{false};
+    QVector<StageMetrics_t> stages;     // indexed by PipelineMetrics::Stage
+
+    /*
+     * One line per stage with samples: p50, p95 and max execution and mean wait
+     */
+    QString summary() const;
+};
+
+/*
+* Per-stage OpenCL timings of the warp pipeline, from the profiling info of the events that
+* ScanConversion passes to every enqueue when profiling is enabled (control/openClProfiling).
+* Readers take a snapshot(); the debug overlay on the main screen shows its summary().
+*/
+class PipelineMetrics : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Stage
+    {
+        FringeUpload,
+        Rescale,
+        Fft,
+        PostFft,
+        SpectralReadback,
+        Upload,             // clCreateImage copying the frame; timed on the host
+        Decimation,
+        SpeckleFilter,      // on the host when it runs on the CPU
+        Average,
+        HistogramClear,
+        Warp,
+        HistogramRead,
+        Readback,
+        Frame,              // all of warpData, on the host
+        Render,             // MainScreen putting the frame on screen, on the host
+        NumberOfStages
+    };
+    static QString stageName( Stage stage );
+
+    static PipelineMetrics* instance();
+
+    PipelineMetrics_t snapshot() const;
+
+    void setProfiling( bool isProfiling );
+
+    /*
+     * Device timestamps in ns as returned by clGetEventProfilingInfo
+     */
+    void record( Stage stage, quint64 queued_ns, quint64 submit_ns, quint64 start_ns, quint64 end_ns );
+
+    /*
+     * A stage timed on the host
+     */
+    void recordHost( Stage stage, double elapsed_us );
+
+    /*
+     * Marks the end of a frame; readers are told at most every NotifyInterval frames
+     */
+    void frameDone();
+
+    void reset();
+
+signals:
+    void metricsChanged( quint64 version );
+
+private:
+    explicit PipelineMetrics( QObject *parent = nullptr );
+
+    static const int NotifyInterval = 16;
+    static PipelineMetrics* m_instance;
+
+    mutable QReadWriteLock m_lock;
+    PipelineMetrics_t m_metrics;
+};
+
+#endif // PIPELINEMETRICS_H
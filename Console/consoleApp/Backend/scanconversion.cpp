@@ -4,12 +4,42 @@
 #include "daq.h"
 #include "logger.h"
 #include "signalmodel.h"
+#include "frameaverage.h"
+#include "dsp.h"
+#include "Utility/userSettings.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
 
 int gCounter = 1;
 
-#define DEFAULT_LOCAL_UNITS  ( 16 ) // size of number of buffers
 size_t global_unit_dim[] = { FFT_DATA_SIZE, FFT_DATA_SIZE };
-size_t local_unit_dim[]  = { DEFAULT_LOCAL_UNITS,  DEFAULT_LOCAL_UNITS  };
+const size_t SpectralFftGroupSize{256}; // FFT_GROUP_SIZE in fft.cl
+const size_t SpeckleGroupSize[ 2 ]{64, 4}; // GROUP_WIDTH and GROUP_HEIGHT in speckleFilter.cl
+
+// Auto-tuning: a frame of this many lines, warped this often per candidate
+const size_t TuningLines{1024};
+const int TuningFrames{20};
+// ... with a typical catheter, as the benchmarks use; no device is selected at start-up
+const cl_float TuningCatheterRadius_um{406.0f};
+const cl_float TuningInternalImagingMask_px{135.0f};
+const cl_float TuningStandardDepth_mm{3.18f};
+const cl_int TuningALineLength_px{512};
+const cl_float TuningFractionOfCanvas{0.5f};
+const cl_int TuningImagingDepth_S{512};
+
+namespace{
+/*
+ * The display angle as the warp takes it: an offset into the rows of the polar frame, as a
+ * fraction of a revolution against the drawing direction
+ */
+float polarRowOffset( float displayAngle_deg, int reverseDirection )
+{
+    const float offset = displayAngle_deg / 360.0f;
+    return reverseDirection ? offset : -offset;
+}
+}
 
 ScanConversion::ScanConversion()
 {
@@ -18,6 +48,15 @@ ScanConversion::ScanConversion()
     displayAngle_deg = 0.0f;
     reverseDirection = 0;
 
+    m_spectralBackend = SpectralPipeline::backendFromSetting( userSettings::Instance().getSpectralProcessing() );
+    LOG1(SpectralPipeline::backendName( m_spectralBackend ))
+    if( m_spectralBackend != SpectralPipeline::Backend::Fpga )
+    {
+        DSP dsp;
+        dsp.init();
+        m_spectralPipeline.setRescaling( dsp.getWholeSamples(), dsp.getFractionalSamples(), dsp.getWindow() );
+    }
+
     if( initOpenCL() )
     {
         isReady = true;
@@ -27,6 +66,25 @@ ScanConversion::ScanConversion()
     }
 }
 
+ScanConversion* ScanConversion::m_prepared{nullptr};
+
+bool ScanConversion::prepare()
+{
+    auto scanConversion = new ScanConversion();
+
+    // Built on a start-up thread; the GUI thread owns it from now on
+    scanConversion->moveToThread( QCoreApplication::instance()->thread() );
+    m_prepared = scanConversion;
+    return scanConversion->isReady;
+}
+
+ScanConversion *ScanConversion::takePrepared()
+{
+    auto scanConversion = m_prepared;
+    m_prepared = nullptr;
+    return scanConversion;
+}
+
 bool ScanConversion::initOpenCL()
 {
     qDebug() << "initOpenCL start";
@@ -150,41 +208,12 @@ bool ScanConversion::initOpenCL()
     qDebug() << "DSP: Found OpenCL Device " <<  QString( (char *)vendor_name ) + " " + QString( (char *)device_name );
     LOG3("DSP: Found OpenCL Device ", QString( (char *)vendor_name ), QString( (char *)device_name ))
 
-    if( QString( (char *)device_name ) == "Intel(R) HD Graphics 4600" )
-    {
-        qDebug() << "using image format for Gen 4 Intel";
-        deviceSpecificImageFormat.image_channel_order = CL_R;
-        deviceSpecificImageFormat.image_channel_data_type = CL_UNSIGNED_INT8;
-        deviceSpecificMemFlags = CL_MEM_COPY_HOST_PTR;
-    }
-    else if( QString( (char *)device_name ).contains( "Intel(R) Core(TM) i7" ) )
-    {
-        qDebug() << "using image format for Arbor Computer";
-        deviceSpecificImageFormat.image_channel_order = CL_INTENSITY;
-        deviceSpecificImageFormat.image_channel_data_type = CL_UNORM_INT8;
-        deviceSpecificMemFlags = CL_MEM_READ_WRITE;
-    }
-    else if( QString( (char *)device_name ).contains( "Intel(R) HD Graphics 505" ) )
-    {
-        qDebug() << "using image format for Gen 7 Intel";
-        deviceSpecificImageFormat.image_channel_order = CL_R;
-        deviceSpecificImageFormat.image_channel_data_type = CL_UNSIGNED_INT8;
-        deviceSpecificMemFlags =  CL_MEM_COPY_HOST_PTR;
-    }
-    else if( QString( (char *)device_name ).contains( "Intel(R) Pentium(R) CPU J4205" ) )
-    {
-        qDebug() << "using image format for Intel Apollo Lake";
-        deviceSpecificImageFormat.image_channel_order = CL_R;
-        deviceSpecificImageFormat.image_channel_data_type = CL_UNSIGNED_INT8;
-        deviceSpecificMemFlags =  CL_MEM_COPY_HOST_PTR;
-    }
-    else
-    {
-        qDebug() << "unable to match device name. using default image format" << QString( (char *)device_name ) ;
-        deviceSpecificImageFormat.image_channel_order = CL_R;
-        deviceSpecificImageFormat.image_channel_data_type = CL_UNSIGNED_INT8;
-        deviceSpecificMemFlags = CL_MEM_COPY_HOST_PTR;
-    }
+    // Image format, upload flags and work-group size come from the tuning file, or are tuned below
+    const QString tuningKey = OpenClTuning::deviceKey( cl_ComputeDeviceId );
+    OpenClTuning::Settings_t tuning;
+    const bool isTuned = OpenClTuning::load( tuningKey, tuning );
+    applyTuning( tuning );
+    LOG3(tuningKey, isTuned, OpenClTuning::describe( tuning ))
 
     cl_Context = clCreateContext( 0, 1, &cl_ComputeDeviceId, NULL, NULL, &err );
     if( !cl_Context )
@@ -194,7 +223,12 @@ bool ScanConversion::initOpenCL()
         return false;
     }
 
-    cl_Commands = clCreateCommandQueueWithProperties( cl_Context, cl_ComputeDeviceId, 0, &err );
+    // Profiling costs a little per enqueue, so it is only on when asked for
+    m_isProfiling = userSettings::Instance().getOpenClProfiling();
+    PipelineMetrics::instance()->setProfiling( m_isProfiling );
+    const cl_queue_properties profilingProperties[] = { CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0 };
+    cl_Commands = clCreateCommandQueueWithProperties( cl_Context, cl_ComputeDeviceId, m_isProfiling ? profilingProperties : NULL, &err );
+    LOG1(m_isProfiling)
 
     if( !cl_Commands )
     {
@@ -209,17 +243,54 @@ bool ScanConversion::initOpenCL()
         return false;
     }
 
-    char lineavgkernelname[] = "line_avg_kernel";
-    if( !buildOpenCLKernel( QString( ":/kernel/line_avg"), lineavgkernelname, &cl_LineAvgProgram, &cl_LineAvgKernel ) )
+    char averagekernelname[] = "frame_average_kernel";
+    if( !buildOpenCLKernel( QString( ":/kernel/frameAverage" ), averagekernelname, &cl_AverageProgram, &cl_AverageKernel ) )
     {
-        qDebug() << "Unable to build line_avg.cl";
-        return false;
+        // Temporal averaging runs on the CPU instead
+        LOG1("Unable to build frameAverage.cl")
+        cl_AverageKernel = nullptr;
+    }
+
+    // Without these the spectral pipeline runs on the CPU
+    char rescalekernelname[] = "rescale_kernel";
+    char fftkernelname[] = "fft_kernel";
+    char postfftkernelname[] = "postfft_kernel";
+    if( !buildOpenCLKernel( QString( ":/kernel/rescale" ), rescalekernelname, &cl_RescaleProgram, &cl_RescaleKernel ) ||
+        !buildOpenCLKernel( QString( ":/kernel/fft" ), fftkernelname, &cl_FftProgram, &cl_FftKernel ) ||
+        !buildOpenCLKernel( QString( ":/kernel/postfft" ), postfftkernelname, &cl_PostFftProgram, &cl_PostFftKernel ) ||
+        ( cl_max_workgroup_size < SpectralFftGroupSize ) )
+    {
+        LOG2("Spectral kernels not available", cl_max_workgroup_size)
+        cl_FftKernel = nullptr;
+    }
+
+    char decimationkernelname[] = "line_decimation_kernel";
+    if( !buildOpenCLKernel( QString( ":/kernel/lineDecimation"), decimationkernelname, &cl_DecimationProgram, &cl_DecimationKernel ) )
+    {
+        // Decimation runs on the CPU instead
+        LOG1("Unable to build lineDecimation.cl")
+        cl_DecimationKernel = nullptr;
+    }
+
+    char specklekernelname[] = "speckle_filter_kernel";
+    if( !buildOpenCLKernel( QString( ":/kernel/speckleFilter" ), specklekernelname, &cl_SpeckleProgram, &cl_SpeckleKernel ) ||
+        ( cl_max_workgroup_size < SpeckleGroupSize[ 0 ] * SpeckleGroupSize[ 1 ] ) )
+    {
+        // The speckle filter runs on the CPU instead
+        LOG2("Unable to build speckleFilter.cl", cl_max_workgroup_size)
+        cl_SpeckleKernel = nullptr;
     }
     qDebug() << "*****we got here " << __LINE__;
 
     createCLMemObjects( cl_Context );
     qDebug() << "*****we got here " << __LINE__;
 
+    if( !isTuned )
+    {
+        autoTuneOpenCL( tuningKey );
+    }
+    budgetSectorSize();
+
     global_unit_dim[ 0 ] = FFT_DATA_SIZE;
     global_unit_dim[ 1 ] = MAX_LINES_PER_FRAME;
 
@@ -336,16 +407,17 @@ bool ScanConversion::createCLMemObjects( cl_context context )
     const cl_uint numMipLevels{0};
     const cl_uint numSamples{0};
 
+    if( !createOutputImages( context ) )
+    {
+        return false;
+    }
 
-#if LINE_AVERAGING
-    lineAvgInputMemObj     = clCreateBuffer( context, deviceSpecificMemFlags, FFT_DATA_SIZE * MAX_LINES_PER_FRAME, NULL, &err );
-#endif
     {
-        const size_t imageWidth{SECTOR_HEIGHT_PX}; //input_image_width
-        const size_t imageHeight{SECTOR_HEIGHT_PX}; //input_image_height
+        const size_t imageWidth{FFT_DATA_SIZE}; //input_image_width
+        const size_t imageHeight{MAX_LINES_PER_FRAME}; //input_image_height
         cl_mem buffer{nullptr};
 
-        const cl_image_desc outputImageDescriptor{
+        const cl_image_desc m_warpInputImageDescriptor{
             imageType,
             imageWidth,
             imageHeight,
@@ -357,218 +429,908 @@ bool ScanConversion::createCLMemObjects( cl_context context )
             numSamples,
             {buffer}
         };
-        outputImageMemObj = clCreateImage( context, CL_MEM_WRITE_ONLY, &deviceSpecificImageFormat, &outputImageDescriptor, nullptr, &err );
+        qDebug() << __LINE__ <<": deviceSpecificMemFlags=" << deviceSpecificMemFlags;
+        warpInputImageMemObj = clCreateImage( context, CL_MEM_READ_ONLY, &deviceSpecificImageFormat, &m_warpInputImageDescriptor, nullptr, &err );
     }
     if( err != CL_SUCCESS )
     {
-        qDebug() << "Failed to create GPU image outputImageMemObj, reason: " << err;
+        qDebug() << "Failed to create GPU image warpInputImageMemObj, reason: " << err;
         return false;
     }
 
-    {        const size_t imageWidth{SECTOR_HEIGHT_PX}; //input_image_width
-        const size_t imageHeight{SECTOR_HEIGHT_PX}; //input_image_height
-        cl_mem buffer{nullptr};
+    histogramMemObj = clCreateBuffer( context, CL_MEM_READ_WRITE, sizeof( cl_uint ) * AutoContrast::NumberOfBins, nullptr, &err );
+    if( err != CL_SUCCESS )
+    {
+        // Auto contrast falls back to the CPU histogram
+        LOG1(err)
+        histogramMemObj = nullptr;
+    }
 
-        const cl_image_desc outputVideoImageDescriptor{
-            imageType,
-            imageWidth,
-            imageHeight,
-            imageDepth,
-            imageArraySize,
-            imageRowPitch,
-            imageSlicePitch,
-            numMipLevels,
-            numSamples,
-            {buffer}
-        };
+    return true;
+}
 
-        outputVideoImageMemObj = clCreateImage( context, CL_MEM_WRITE_ONLY, &deviceSpecificImageFormat, &outputVideoImageDescriptor, nullptr, &err );
+/*
+ * createOutputImages
+ *
+ * The display, video and thumbnail frames; these follow the tuned image format and the
+ * display frame the sector size.
+ */
+bool ScanConversion::createOutputImages( cl_context context )
+{
+    cl_int err{-1};
+    SignalModel* smi = SignalModel::instance();
+
+    const cl_image_desc outputImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        size_t( *smi->getSectorWidth_px() ),
+        size_t( *smi->getSectorHeight_px() ),
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    outputImageMemObj = clCreateImage( context, CL_MEM_WRITE_ONLY, &deviceSpecificImageFormat, &outputImageDescriptor, nullptr, &err );
+    if( err != CL_SUCCESS )
+    {
+        qDebug() << "Failed to create GPU image outputImageMemObj, reason: " << err;
+        outputImageMemObj = nullptr;
+        return false;
     }
+
+    const cl_image_desc outputVideoImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        VideoWidth_px,
+        VideoHeight_px,
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    outputVideoImageMemObj = clCreateImage( context, CL_MEM_WRITE_ONLY, &deviceSpecificImageFormat, &outputVideoImageDescriptor, nullptr, &err );
     if( err != CL_SUCCESS )
     {
         qDebug() << "Failed to create GPU image outputVideoImageMemObj, reason: " << err;
+        outputVideoImageMemObj = nullptr;
         return false;
     }
 
+    const cl_image_desc outputThumbnailImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        ThumbnailWidth_px,
+        ThumbnailHeight_px,
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    outputThumbnailImageMemObj = clCreateImage( context, CL_MEM_WRITE_ONLY, &deviceSpecificImageFormat, &outputThumbnailImageDescriptor, nullptr, &err );
+    if( err != CL_SUCCESS )
     {
-        const size_t imageWidth{FFT_DATA_SIZE}; //input_image_width
-        const size_t imageHeight{MAX_LINES_PER_FRAME}; //input_image_height
-        cl_mem buffer{nullptr};
+        qDebug() << "Failed to create GPU image outputThumbnailImageMemObj, reason: " << err;
+        outputThumbnailImageMemObj = nullptr;
+        return false;
+    }
+    return true;
+}
 
-        const cl_image_desc m_warpInputImageDescriptor{
-            imageType,
-            imageWidth,
-            imageHeight,
-            imageDepth,
-            imageArraySize,
-            imageRowPitch,
-            imageSlicePitch,
-            numMipLevels,
-            numSamples,
-            {buffer}
-        };
-        if(deviceSpecificMemFlags == CL_MEM_COPY_HOST_PTR){
-            qDebug() << __LINE__ <<": deviceSpecificMemFlags=CL_MEM_COPY_HOST_PTR";
-        }else {
-            qDebug() << __LINE__ <<": deviceSpecificMemFlags=" << deviceSpecificMemFlags;
+/*
+ * applyTuning
+ *
+ * Takes on new launch settings. Images already made in the old format are dropped; the
+ * lazily allocated ones come back on the next frame.
+ */
+bool ScanConversion::applyTuning( const OpenClTuning::Settings_t &tuning )
+{
+    deviceSpecificImageFormat = tuning.imageFormat;
+    deviceSpecificMemFlags = tuning.uploadMemFlags;
+    m_warpLocalSize[ 0 ] = tuning.warpLocalSize[ 0 ];
+    m_warpLocalSize[ 1 ] = tuning.warpLocalSize[ 1 ];
+    m_tuning = tuning;
+
+    if( !cl_Context )
+    {
+        return true;
+    }
+
+    for( cl_mem* memObj : { &outputImageMemObj, &outputVideoImageMemObj, &outputThumbnailImageMemObj, &averagedImageMemObj, &decimatedImageMemObj,
+                             &speckleImageMemObj } )
+    {
+        if( *memObj )
+        {
+            clReleaseMemObject( *memObj );
+            *memObj = nullptr;
         }
-        warpInputImageMemObj = clCreateImage( context, CL_MEM_READ_ONLY, &deviceSpecificImageFormat, &m_warpInputImageDescriptor, nullptr, &err );
     }
-    if( err != CL_SUCCESS )
+    m_spectralLines = 0;
+    m_averagedLines = 0;
+    m_decimatedLines = 0;
+    m_speckleLines = 0;
+    m_isAveragingActive = false;
+    m_isAutoContrastActive = false;
+
+    return createOutputImages( cl_Context );
+}
+
+/*
+ * autoTuneOpenCL
+ *
+ * Warps a synthetic frame with every candidate and keeps the fastest one whose display
+ * frame matches the first candidate (the defaults) byte for byte. Tuning runs before a device
+ * is selected, so the catheter geometry is set for the run and put back afterwards. Runs once
+ * per device and driver; the result is saved.
+ */
+bool ScanConversion::autoTuneOpenCL( const QString &deviceKey )
+{
+    size_t kernelWorkGroupSize{0};
+    clGetKernelWorkGroupInfo( cl_WarpKernel, cl_ComputeDeviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof( size_t ), &kernelWorkGroupSize, NULL );
+    const size_t maxWorkGroupSize = kernelWorkGroupSize ? std::min( kernelWorkGroupSize, cl_max_workgroup_size ) : cl_max_workgroup_size;
+    auto candidates = OpenClTuning::candidates( cl_Context, maxWorkGroupSize );
+    LOG3(deviceKey, maxWorkGroupSize, candidates.size())
+
+    // Noise with a bright band, so the formats and the interpolation all show up in the output
+    std::vector<uint8_t> polar( FFT_DATA_SIZE * TuningLines );
+    std::vector<uint8_t> display( SignalModel::instance()->getSectorSize_B() );
+    uint32_t seed{12345};
+    for( size_t i = 0; i < polar.size(); i++ )
     {
-        qDebug() << "Failed to create GPU image warpInputImageMemObj, reason: " << err;
+        seed = seed * 1664525u + 1013904223u;
+        const size_t sample = i % FFT_DATA_SIZE;
+        polar[ i ] = uint8_t( ( seed >> 27 ) + ( ( sample > 100 && sample < 600 ) ? 180 - sample / 4 : 0 ) );
+    }
+    OCTFile::OctData_t frame;
+    frame.acqData = polar.data();
+    frame.dispData = display.data();
+    frame.bufferLength = TuningLines;
+
+    // Without a geometry the warp has no depth to draw and every candidate times a blank frame
+    SignalModel* smi = SignalModel::instance();
+    const cl_float catheterRadius_um = *smi->getCatheterRadius_um();
+    const cl_float internalImagingMask_px = *smi->getInternalImagingMask_px();
+    const cl_float standardDepth_mm = *smi->getStandardDepth_mm();
+    const cl_int aLineLength_px = *smi->getALineLength_px();
+    const cl_float fractionOfCanvas = *smi->getFractionOfCanvas();
+    const cl_int imagingDepth_S = *smi->getImagingDepth_S();
+    smi->setCatheterRadius_um( TuningCatheterRadius_um );
+    smi->setInternalImagingMask_px( TuningInternalImagingMask_px );
+    smi->setStandardDepth_mm( TuningStandardDepth_mm );
+    smi->setALineLength_px( TuningALineLength_px );
+    smi->setFractionOfCanvas( TuningFractionOfCanvas );
+    smi->setImagingDepth_S( TuningImagingDepth_S );
+
+    std::vector<uint8_t> reference;
+    OpenClTuning::Settings_t best;
+    bool isBestFound{false};
+    for( auto& candidate : candidates )
+    {
+        m_autoContrast.reset();
+        bool isWorking = applyTuning( candidate );
+
+        // The first frames pay for lazy allocations in the driver
+        for( int i = 0; isWorking && ( i < 3 ); i++ )
+        {
+            isWorking = warpData( &frame, TuningLines );
+        }
+        QElapsedTimer timer;
+        timer.start();
+        for( int i = 0; isWorking && ( i < TuningFrames ); i++ )
+        {
+            isWorking = warpData( &frame, TuningLines );
+        }
+        candidate.warp_ms = timer.nsecsElapsed() / 1.0e6 / TuningFrames;
+        candidate.sectorSize_px = *smi->getSectorWidth_px();
+
+        if( !isWorking )
+        {
+            LOG2("failed", OpenClTuning::describe( candidate ))
+            continue;
+        }
+        if( reference.empty() )
+        {
+            reference = display;
+        }
+        else if( display != reference )
+        {
+            LOG2("wrong output", OpenClTuning::describe( candidate ))
+            continue;
+        }
+        LOG2(OpenClTuning::describe( candidate ), candidate.warp_ms)
+        if( !isBestFound || ( candidate.warp_ms < best.warp_ms ) )
+        {
+            best = candidate;
+            isBestFound = true;
+        }
+    }
+    m_autoContrast.reset();
+
+    smi->setCatheterRadius_um( catheterRadius_um );
+    smi->setInternalImagingMask_px( internalImagingMask_px );
+    smi->setStandardDepth_mm( standardDepth_mm );
+    smi->setALineLength_px( aLineLength_px );
+    smi->setFractionOfCanvas( fractionOfCanvas );
+    smi->setImagingDepth_S( imagingDepth_S );
+
+    if( !isBestFound )
+    {
+        // Nothing worked; stay on the defaults and try again next launch
+        applyTuning( OpenClTuning::Settings_t() );
         return false;
     }
 
+    applyTuning( best );
+    OpenClTuning::save( deviceKey, best );
+    PipelineMetrics::instance()->reset();
+    LOG2(OpenClTuning::describe( best ), best.warp_ms)
     return true;
 }
 
-bool ScanConversion::warpData( OCTFile::OctData_t *dataFrame, size_t pBufferLength )
+/*
+ * budgetSectorSize
+ *
+ * Lowers the sector size until the display image fits the device and the warp, scaled by
+ * pixels from the tuned timing, fits control/warpBudget_ms. It never goes below the scene
+ * size unless the device can't hold that either.
+ */
+int ScanConversion::budgetSectorSize()
 {
-    static int count{0};
-    unsigned char *pDataIn = dataFrame->acqData;
-    unsigned char *pDataOut = dataFrame->dispData;
-    cl_int clStatus{-1};
-    cl_int err{-1};
-
-    const cl_mem_object_type imageType{CL_MEM_OBJECT_IMAGE2D};
-    const size_t imageDepth{1};
-    const size_t imageArraySize{1};
-    const size_t imageRowPitch{0};
-    const size_t imageSlicePitch{0};
-    const cl_uint numMipLevels{0};
-    const cl_uint numSamples{0};
-
-    /* RFR
-     * Remember that buffer input lengths need to be multiples of 16 for some reason.
-     * Line Average will fail if not using multiples of 16 for length.
-     * subsampledBufferLength not required to be multiple of 16.
-     * pBufferLength required to be multiple of 16.
-     */
+    SignalModel* smi = SignalModel::instance();
+    const int requested_px = *smi->getSectorWidth_px();
+
+    size_t maxImageWidth{0};
+    size_t maxImageHeight{0};
+    cl_ulong maxAlloc_B{0};
+    clGetDeviceInfo( cl_ComputeDeviceId, CL_DEVICE_IMAGE2D_MAX_WIDTH, sizeof( size_t ), &maxImageWidth, NULL );
+    clGetDeviceInfo( cl_ComputeDeviceId, CL_DEVICE_IMAGE2D_MAX_HEIGHT, sizeof( size_t ), &maxImageHeight, NULL );
+    clGetDeviceInfo( cl_ComputeDeviceId, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof( cl_ulong ), &maxAlloc_B, NULL );
+
+    const double budget_ms = userSettings::Instance().getWarpBudget_ms();
+    const auto estimate_ms = [ this ]( int size_px )
+    {
+        if( ( m_tuning.warp_ms <= 0.0 ) || ( m_tuning.sectorSize_px <= 0 ) )
+        {
+            return 0.0;
+        }
+        const double ratio = double( size_px ) / m_tuning.sectorSize_px;
+        return m_tuning.warp_ms * ratio * ratio;
+    };
+    const auto fitsDevice = [ & ]( int size_px )
+    {
+        return ( !maxImageWidth || ( size_t( size_px ) <= maxImageWidth ) ) &&
+               ( !maxImageHeight || ( size_t( size_px ) <= maxImageHeight ) ) &&
+               ( !maxAlloc_B || ( cl_ulong( size_px ) * cl_ulong( size_px ) <= maxAlloc_B ) );
+    };
+
+    int size_px = requested_px;
+    while( ( size_px > MinSectorSize_px ) &&
+           ( !fitsDevice( size_px ) || ( ( size_px > SectorWidth_px ) && ( estimate_ms( size_px ) > budget_ms ) ) ) )
+    {
+        size_px -= SectorAlignment_px;
+    }
+    LOG4(requested_px, size_px, estimate_ms( size_px ), budget_ms)
 
-    size_t subsampledBufferLength = pBufferLength;
+    if( size_px != requested_px )
+    {
+        setSectorSize_px( size_px );
+    }
+    LOG2(size_px, smi->getSectorSize_B())
+    return *smi->getSectorWidth_px();
+}
 
-#if LINE_AVERAGING
-    int numLinesToAverage = 3;
-    const int MinNumLines = 1200; // always display at least 1200 lines per frame.
-    if( (pBufferLength / numLinesToAverage) > MinNumLines )
+/*
+ * setSectorSize_px
+ *
+ * Renders the display frame at another size from the next frame on. The caller's display
+ * buffer has to hold SignalModel::getSectorSize_B() bytes.
+ */
+bool ScanConversion::setSectorSize_px( int size_px )
+{
+    SignalModel* smi = SignalModel::instance();
+    const int previous_px = *smi->getSectorWidth_px();
+    if( smi->setSectorSize_px( size_px ) == previous_px )
     {
-        subsampledBufferLength = pBufferLength / numLinesToAverage;
-        qDebug() << "Enough lines to subsample. subsampledBufferLength:" << subsampledBufferLength << "pBufferLength: " << pBufferLength;
+        return true;
     }
-    else
+    if( !cl_Context )
     {
-        numLinesToAverage = 1; // not enough lines to apply averaging.
+        return true;
     }
 
-    lineAvgInputMemObj = clCreateImage2D( cl_Context, deviceSpecificMemFlags, &deviceSpecificImageFormat, FFT_DATA_SIZE, pBufferLength, 0, pDataIn, &err );
-    if( err != CL_SUCCESS )
+    for( cl_mem* memObj : { &outputImageMemObj, &outputVideoImageMemObj, &outputThumbnailImageMemObj } )
     {
-        qDebug() << "warpData: Failed to create lineAvgInputMemObj! Err = " << err;
-        return false;
+        if( *memObj )
+        {
+            clReleaseMemObject( *memObj );
+            *memObj = nullptr;
+        }
     }
-#endif
+    return createOutputImages( cl_Context );
+}
+
+/*
+ * setRegionOfInterest
+ *
+ * The part of the sector the display shows, as fractions of it; clamped so it stays inside.
+ * The whole sector (0, 0, 1, 1) turns the zoom off.
+ */
+void ScanConversion::setRegionOfInterest( const QRectF &roi )
+{
+    const double width = qBound( 1.0 / MaxZoomFactor, roi.width(), 1.0 );
+    const double height = qBound( 1.0 / MaxZoomFactor, roi.height(), 1.0 );
+    m_regionOfInterest = QRectF( qBound( 0.0, roi.x(), 1.0 - width ), qBound( 0.0, roi.y(), 1.0 - height ), width, height );
+    LOG4(m_regionOfInterest.x(), m_regionOfInterest.y(), m_regionOfInterest.width(), m_regionOfInterest.height())
+}
+
+QRectF ScanConversion::regionOfInterest() const
+{
+    return m_regionOfInterest;
+}
+
+void ScanConversion::setWarpOutputs( int outputs )
+{
+    m_warpOutputs = outputs | DisplayOutput;
+    LOG1(m_warpOutputs)
+}
+
+int ScanConversion::warpOutputs() const
+{
+    return m_warpOutputs;
+}
+
+uint8_t *ScanConversion::videoFrame()
+{
+    return m_isVideoFrameValid ? m_videoFrame.data() : nullptr;
+}
+
+QImage ScanConversion::thumbnail() const
+{
+    return m_isThumbnailValid ? m_thumbnail.copy() : QImage();
+}
+
+QString ScanConversion::tuningDescription() const
+{
+    return OpenClTuning::describe( m_tuning );
+}
 
+ScanConversion::CaptureFrame_t::~CaptureFrame_t()
+{
+    if( copied )
     {
-        const size_t imageWidth{FFT_DATA_SIZE};
-        const size_t imageHeight{subsampledBufferLength};
-        cl_mem buffer{nullptr};
+        clReleaseEvent( copied );
+    }
+    if( polarImageMemObj )
+    {
+        clReleaseMemObject( polarImageMemObj );
+    }
+    if( owner )
+    {
+        QMutexLocker lock( &owner->m_capturesInFlightLock );
+        owner->m_capturesInFlight--;
+        owner->m_capturesDone.wakeAll();
+    }
+}
 
-        const cl_image_desc warpInputImageDescriptor{
-            imageType,
-            imageWidth,
-            imageHeight,
-            imageDepth,
-            imageArraySize,
-            imageRowPitch,
-            imageSlicePitch,
-            numMipLevels,
-            numSamples,
-            {buffer}
-        };
-        warpInputImageMemObj = clCreateImage( cl_Context, deviceSpecificMemFlags, &deviceSpecificImageFormat, &warpInputImageDescriptor, pDataIn, &err );
+/*
+ * ~ScanConversion
+ *
+ * The capture pool renders snapshots through this instance; wait until it is done with them.
+ */
+ScanConversion::~ScanConversion()
+{
+    QMutexLocker lock( &m_capturesInFlightLock );
+    while( m_capturesInFlight > 0 )
+    {
+        m_capturesDone.wait( &m_capturesInFlightLock );
     }
+}
 
-    if( err != CL_SUCCESS )
+/*
+ * snapshotForCapture
+ *
+ * Called on the thread that warps, between frames. The copy is queued behind the last warp
+ * and ahead of the next frame, so it is of exactly the frame on screen. Null when the frame
+ * was drawn straight from a DAQ buffer (see warpData); the capture grabs the view instead.
+ */
+std::shared_ptr<ScanConversion::CaptureFrame_t> ScanConversion::snapshotForCapture()
+{
+    if( !m_lastWarpSourceMemObj )
     {
-        qDebug() << "Error: Failed to enqueue new data to GPU! Err = " << err;
-        return false;
+        return nullptr;
     }
 
-#if LINE_AVERAGING
-    clStatus  = clSetKernelArg( cl_LineAvgKernel, 0, sizeof(cl_mem), &lineAvgInputMemObj );
+    // The source may be in the format of an earlier tuning, so the copy takes its own
+    cl_image_format format;
+    size_t width{0};
+    size_t height{0};
+    cl_int clStatus  = clGetImageInfo( m_lastWarpSourceMemObj, CL_IMAGE_FORMAT, sizeof( format ), &format, nullptr );
+    clStatus |= clGetImageInfo( m_lastWarpSourceMemObj, CL_IMAGE_WIDTH, sizeof( width ), &width, nullptr );
+    clStatus |= clGetImageInfo( m_lastWarpSourceMemObj, CL_IMAGE_HEIGHT, sizeof( height ), &height, nullptr );
     if( clStatus != CL_SUCCESS )
     {
-        qDebug() << "DSP: Failed to set LineAverage kernel arguments: arg0:" << clStatus;
-        return false;
+        qDebug() << "DSP: Failed to query the capture source:" << clStatus;
+        return nullptr;
     }
-    clStatus |= clSetKernelArg( cl_LineAvgKernel, 1, sizeof(cl_mem), &warpInputImageMemObj );
+
+    auto frame = std::make_shared<CaptureFrame_t>();
+    const cl_image_desc polarImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        width,
+        height,
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    frame->polarImageMemObj = clCreateImage( cl_Context, CL_MEM_READ_ONLY, &format, &polarImageDescriptor, nullptr, &clStatus );
     if( clStatus != CL_SUCCESS )
     {
-        qDebug() << "DSP: Failed to set LineAverage kernel arguments: arg1:" << clStatus;
-        return false;
+        qDebug() << "DSP: Failed to create the capture image:" << clStatus;
+        frame->polarImageMemObj = nullptr;
+        return nullptr;
     }
-    clStatus |= clSetKernelArg( cl_LineAvgKernel, 2, sizeof(int),    &numLinesToAverage );
+
+    const size_t origin[ 3 ] = { 0, 0, 0 };
+    const size_t region[ 3 ] = { width, height, 1 };
+    clStatus = clEnqueueCopyImage( cl_Commands, m_lastWarpSourceMemObj, frame->polarImageMemObj, origin, origin, region, 0, NULL, &frame->copied );
     if( clStatus != CL_SUCCESS )
     {
-        qDebug() << "DSP: Failed to set LineAverage kernel arguments: arg2:" << clStatus;
-        return false;
+        qDebug() << "DSP: Failed to copy the capture image:" << clStatus;
+        frame->copied = nullptr;
+        return nullptr;
     }
-    global_unit_dim[ 0 ] = FFT_DATA_SIZE;
-    global_unit_dim[ 1 ] = pBufferLength;
 
-    if( numLinesToAverage > 1 )
+    clFlush( cl_Commands );
+
+    SignalModel* smi = SignalModel::instance();
+    frame->catheterRadius_um      = *smi->getCatheterRadius_um();
+    frame->internalImagingMask_px = *smi->getInternalImagingMask_px();
+    frame->standardDepth_mm       = *smi->getStandardDepth_mm();
+    frame->aLineLength_px         = *smi->getALineLength_px();
+    frame->displayAngle           = *smi->getDisplayAngle();
+    frame->isDistalToProximalView = *smi->getIsDistalToProximalView();
+    frame->fractionOfCanvas       = *smi->getFractionOfCanvas();
+    frame->imagingDepth_S         = *smi->getImagingDepth_S();
+    frame->brightness             = m_lastBrightness;
+    frame->contrast               = m_lastContrast;
+    frame->isInvertColors         = *smi->isInvertOctColors();
+    frame->regionOfInterest       = m_regionOfInterest;
+
+    QMutexLocker lock( &m_capturesInFlightLock );
+    m_capturesInFlight++;
+    frame->owner = this;
+    return frame;
+}
+
+/*
+ * renderCapture
+ *
+ * Warps a snapshot to a size_px square (rounded up to SectorAlignment_px) on the calling
+ * thread. Only the display output is written; the histogram is left alone.
+ */
+QImage ScanConversion::renderCapture( const CaptureFrame_t &frame, int size_px )
+{
+    QMutexLocker lock( &m_captureLock );
+    cl_int clStatus{CL_SUCCESS};
+
+    if( !cl_CaptureKernel )
     {
-        clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_LineAvgKernel, 2, NULL, global_unit_dim, NULL, 0, NULL, NULL );
+        cl_CaptureKernel = clCreateKernel( cl_WarpProgram, "warpBc_kernel", &clStatus );
         if( clStatus != CL_SUCCESS )
         {
-            qDebug() << "DSP: Failed to execute LineAverage kernel:" << clStatus << " buffer len, subsampled len:" << pBufferLength << subsampledBufferLength;
-            return false;
+            qDebug() << "DSP: Failed to create the capture kernel:" << clStatus;
+            cl_CaptureKernel = nullptr;
+            return QImage();
         }
-        else
+    }
+    if( !cl_CaptureCommands )
+    {
+        cl_CaptureCommands = clCreateCommandQueueWithProperties( cl_Context, cl_ComputeDeviceId, NULL, &clStatus );
+        if( clStatus != CL_SUCCESS )
         {
-            qDebug() << "                   LINEAVERAGE Execute SUCCESS: buffer len, subsampled len:" << pBufferLength << subsampledBufferLength;
+            qDebug() << "DSP: Failed to create the capture command queue:" << clStatus;
+            cl_CaptureCommands = nullptr;
+            return QImage();
         }
     }
-    else
+
+    const int alignedSize_px = ( qBound( MinSectorSize_px, size_px, MaxSectorSize_px ) + SectorAlignment_px - 1 ) / SectorAlignment_px * SectorAlignment_px;
+    const cl_image_desc captureImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        size_t( alignedSize_px ),
+        size_t( alignedSize_px ),
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    cl_mem captureImageMemObj = clCreateImage( cl_Context, CL_MEM_WRITE_ONLY, &deviceSpecificImageFormat, &captureImageDescriptor, nullptr, &clStatus );
+    if( clStatus != CL_SUCCESS )
     {
-        // don't process, instead read the warp image.
+        qDebug() << "DSP: Failed to create the capture output image:" << clStatus;
+        return QImage();
     }
-#endif
 
-/*
- * Set up Catheter specific parameters
- */
-//    deviceSettings &device = deviceSettings::Instance();
-//    int index = device.getCurrentDevice();
-//    float catheterRadius_um = device.deviceAt(index)->getCatheterRadius_um();
-//    float internalImagingMask_px = device.deviceAt(index)->getInternalImagingMask_px();
-//    float standardDepth_mm = device.deviceAt( index )->getImagingDepth_mm();
-//    const int standardDepth_S = device.deviceAt( index )->getALineLength_px();
-//    int SectorWidth_px = SECTOR_HEIGHT_PX;
-//    int SectorHeight_px = SECTOR_HEIGHT_PX;
+    // The video and thumbnail outputs are off; they are handed the capture image as a placeholder
+    const cl_mem noHistogram{nullptr};
+    const cl_int off{0};
+    const cl_int unused_px{0};
+    const cl_int width_px{alignedSize_px};
+    const cl_float4 roi{ { float( frame.regionOfInterest.x() ), float( frame.regionOfInterest.y() ),
+                           float( frame.regionOfInterest.width() ), float( frame.regionOfInterest.height() ) } };
+    clStatus  = clSetKernelArg( cl_CaptureKernel,  0, sizeof(cl_mem),    &frame.polarImageMemObj );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  1, sizeof(cl_mem),    &captureImageMemObj );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  2, sizeof(cl_mem),    &captureImageMemObj );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  3, sizeof(float),     &frame.catheterRadius_um );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  4, sizeof(float),     &frame.internalImagingMask_px );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  5, sizeof(float),     &frame.standardDepth_mm );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  6, sizeof(int),       &frame.aLineLength_px );
+    const float rotation_norm = polarRowOffset( frame.displayAngle, frame.isDistalToProximalView );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  7, sizeof(float),     &rotation_norm );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  8, sizeof(int),       &frame.isDistalToProximalView );
+    clStatus |= clSetKernelArg( cl_CaptureKernel,  9, sizeof(int),       &width_px );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 10, sizeof(int),       &width_px );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 11, sizeof(float),     &frame.fractionOfCanvas );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 12, sizeof(int),       &frame.imagingDepth_S );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 13, sizeof(int),       &frame.brightness );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 14, sizeof(int),       &frame.contrast );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 15, sizeof(int),       &frame.isInvertColors );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 16, sizeof(cl_mem),    &noHistogram );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 17, sizeof(int),       &off );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 18, sizeof(cl_mem),    &captureImageMemObj );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 19, sizeof(int),       &off );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 20, sizeof(int),       &unused_px );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 21, sizeof(int),       &unused_px );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 22, sizeof(int),       &off );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 23, sizeof(int),       &unused_px );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 24, sizeof(int),       &unused_px );
+    clStatus |= clSetKernelArg( cl_CaptureKernel, 25, sizeof(cl_float4), &roi );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to set capture warp kernel arguments:" << clStatus;
+        clReleaseMemObject( captureImageMemObj );
+        return QImage();
+    }
+
+    const size_t globalDim[ 2 ] = { size_t( alignedSize_px ), size_t( alignedSize_px ) };
+    const size_t* localSize = m_warpLocalSize[ 0 ] ? m_warpLocalSize : NULL;
+    clStatus = clEnqueueNDRangeKernel( cl_CaptureCommands, cl_CaptureKernel, 2, NULL, globalDim, localSize, 1, &frame.copied, NULL );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to execute capture warp kernel:" << clStatus;
+        clReleaseMemObject( captureImageMemObj );
+        return QImage();
+    }
+
+    QImage image( alignedSize_px, alignedSize_px, QImage::Format_Indexed8 );
+    const size_t origin[ 3 ] = { 0, 0, 0 };
+    const size_t region[ 3 ] = { size_t( alignedSize_px ), size_t( alignedSize_px ), 1 };
+    clStatus = clEnqueueReadImage( cl_CaptureCommands, captureImageMemObj, CL_TRUE, origin, region, size_t( image.bytesPerLine() ), 0, image.bits(), 0, NULL, NULL );
+    clReleaseMemObject( captureImageMemObj );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to read back the capture:" << clStatus;
+        return QImage();
+    }
+    return image;
+}
+
+bool ScanConversion::warpData( OCTFile::OctData_t *dataFrame, size_t pBufferLength )
+{
+    static int count{0};
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    m_isVideoFrameValid = false;
+    m_isThumbnailValid = false;
+    processFringes( dataFrame, pBufferLength );
+    unsigned char *pDataIn = dataFrame->acqData;
+    unsigned char *pDataOut = dataFrame->dispData;
+    cl_int clStatus{-1};
+    cl_int err{-1};
+
+    const cl_mem_object_type imageType{CL_MEM_OBJECT_IMAGE2D};
+    const size_t imageDepth{1};
+    const size_t imageArraySize{1};
+    const size_t imageRowPitch{0};
+    const size_t imageSlicePitch{0};
+    const cl_uint numMipLevels{0};
+    const cl_uint numSamples{0};
+
+    /*
+     * Revolutions with more lines than the sector can show are decimated first, on the GPU
+     * after upload or on the CPU before it (the CPU frame average needs the decimated frame).
+     */
+    const auto* smi = SignalModel::instance();
+    const bool isAveraging = *smi->isAveragingNoiseReduction();
+    const auto decimationMode = LineDecimation::Mode( *smi->lineDecimationMode() );
+    // Zoomed in, the display tells apart as many more lines as it magnifies
+    const int decimationTarget = int( std::lround( *smi->lineDecimationTarget() / m_regionOfInterest.width() ) );
+    const int factor = ( decimationMode == LineDecimation::Mode::Off ) ? 1 :
+                       LineDecimation::factorFor( pBufferLength, decimationTarget );
+    if( ( factor != m_decimationFilter.factor ) || ( decimationMode != m_decimationFilter.mode ) )
+    {
+        m_decimationFilter = LineDecimation::makeFilter( decimationMode, factor );
+        m_isDecimationFilterUploaded = false;
+        LOG3(LineDecimation::modeName( decimationMode ), pBufferLength, factor)
+    }
+    const bool isDecimating = factor > 1;
+    const size_t subsampledBufferLength = LineDecimation::outputLines( pBufferLength, factor );
+
+    // The speckle filter follows the decimation; it runs on the CPU ahead of a CPU frame average
+    const auto speckleMode = SpeckleFilter::Mode( *smi->speckleFilterMode() );
+    const bool isSpeckleFiltering = speckleMode != SpeckleFilter::Mode::Off;
+    const bool isSpeckleOnCpu = isSpeckleFiltering && ( !cl_SpeckleKernel || ( isAveraging && !cl_AverageKernel ) );
+
+    const bool isDecimationOnCpu = isDecimating && ( !cl_DecimationKernel || ( isAveraging && !cl_AverageKernel ) || isSpeckleOnCpu );
+    size_t uploadedLines = pBufferLength;
+    if( isDecimationOnCpu )
+    {
+        m_cpuDecimatedFrame.resize( FFT_DATA_SIZE * subsampledBufferLength );
+        LineDecimation::decimate( pDataIn, pBufferLength, FFT_DATA_SIZE, m_cpuDecimatedFrame.data(), m_decimationFilter );
+        pDataIn = m_cpuDecimatedFrame.data();
+        uploadedLines = subsampledBufferLength;
+    }
+    if( isSpeckleOnCpu )
+    {
+        QElapsedTimer speckleTimer;
+        speckleTimer.start();
+        m_cpuSpeckleFrame.resize( FFT_DATA_SIZE * uploadedLines );
+        SpeckleFilter::filter( pDataIn, uploadedLines, FFT_DATA_SIZE, m_cpuSpeckleFrame.data(), speckleMode );
+        pDataIn = m_cpuSpeckleFrame.data();
+        if( m_isProfiling )
+        {
+            PipelineMetrics::instance()->recordHost( PipelineMetrics::Stage::SpeckleFilter, speckleTimer.nsecsElapsed() / 1000.0 );
+        }
+    }
+
+    /*
+     * Temporal averaging restarts when it is switched on and whenever the device, the depth
+     * or the frame size changes, so frames of different geometry are never blended.
+     */
+    AveragingGeometry_t geometry;
+    geometry.numberOfLines = subsampledBufferLength;
+    geometry.aLineLength_px = *smi->getALineLength_px();
+    geometry.imagingDepth_S = *smi->getImagingDepth_S();
+    geometry.internalImagingMask_px = *smi->getInternalImagingMask_px();
+    geometry.catheterRadius_um = *smi->getCatheterRadius_um();
+    geometry.standardDepth_mm = *smi->getStandardDepth_mm();
+    bool isAverageReset = !m_isAveragingActive || !( geometry == m_averagingGeometry );
+    m_isAveragingActive = isAveraging;
+    m_averagingGeometry = geometry;
+
+    const size_t frameLength = FFT_DATA_SIZE * subsampledBufferLength;
+    if( isAveraging && !cl_AverageKernel )
+    {
+        if( m_cpuAverage.size() != frameLength )
+        {
+            m_cpuAverage.resize( frameLength );
+            m_cpuAveragedFrame.resize( frameLength );
+            isAverageReset = true;
+        }
+        FrameAverage::blend( pDataIn, m_cpuAverage.data(), m_cpuAveragedFrame.data(), frameLength,
+                             *smi->currFrameWeight_percent(), isAverageReset );
+        pDataIn = m_cpuAveragedFrame.data();
+    }
+
+    {
+        const size_t imageWidth{FFT_DATA_SIZE};
+        const size_t imageHeight{uploadedLines};
+        cl_mem buffer{nullptr};
+
+        const cl_image_desc warpInputImageDescriptor{
+            imageType,
+            imageWidth,
+            imageHeight,
+            imageDepth,
+            imageArraySize,
+            imageRowPitch,
+            imageSlicePitch,
+            numMipLevels,
+            numSamples,
+            {buffer}
+        };
+        QElapsedTimer uploadTimer;
+        uploadTimer.start();
+        warpInputImageMemObj = clCreateImage( cl_Context, deviceSpecificMemFlags, &deviceSpecificImageFormat, &warpInputImageDescriptor, pDataIn, &err );
+        if( m_isProfiling )
+        {
+            PipelineMetrics::instance()->recordHost( PipelineMetrics::Stage::Upload, uploadTimer.nsecsElapsed() / 1000.0 );
+        }
+    }
+
+    if( err != CL_SUCCESS )
+    {
+        qDebug() << "Error: Failed to enqueue new data to GPU! Err = " << err;
+        return false;
+    }
+
+    cl_mem polarImageMemObj = warpInputImageMemObj;
+    if( isDecimating && !isDecimationOnCpu )
+    {
+        if( !prepareLineDecimation( subsampledBufferLength ) )
+        {
+            return false;
+        }
+
+        const cl_int decimationFactor = m_decimationFilter.factor;
+        const cl_int firstOffset = m_decimationFilter.firstOffset;
+        const cl_int numberOfTaps = cl_int( m_decimationFilter.weights.size() );
+        const cl_int doMax = ( m_decimationFilter.mode == LineDecimation::Mode::Max );
+        clStatus  = clSetKernelArg( cl_DecimationKernel, 0, sizeof(cl_mem), &warpInputImageMemObj );
+        clStatus |= clSetKernelArg( cl_DecimationKernel, 1, sizeof(cl_mem), &decimatedImageMemObj );
+        clStatus |= clSetKernelArg( cl_DecimationKernel, 2, sizeof(cl_mem), &decimationWeightsMemObj );
+        clStatus |= clSetKernelArg( cl_DecimationKernel, 3, sizeof(cl_int), &decimationFactor );
+        clStatus |= clSetKernelArg( cl_DecimationKernel, 4, sizeof(cl_int), &firstOffset );
+        clStatus |= clSetKernelArg( cl_DecimationKernel, 5, sizeof(cl_int), &numberOfTaps );
+        clStatus |= clSetKernelArg( cl_DecimationKernel, 6, sizeof(cl_int), &doMax );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to set line decimation kernel arguments:" << clStatus;
+            return false;
+        }
+
+        const size_t decimationGlobalDim[ 2 ] = { FFT_DATA_SIZE, subsampledBufferLength };
+        clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_DecimationKernel, 2, NULL, decimationGlobalDim, NULL, 0, NULL,
+                                           profilingEvent( PipelineMetrics::Stage::Decimation ) );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to execute line decimation kernel:" << clStatus << " buffer len, subsampled len:" << pBufferLength << subsampledBufferLength;
+            return false;
+        }
+        polarImageMemObj = decimatedImageMemObj;
+    }
+
+    if( isSpeckleFiltering && !isSpeckleOnCpu )
+    {
+        if( !prepareSpeckleFilter( subsampledBufferLength ) )
+        {
+            return false;
+        }
+
+        const cl_int speckleRadius = SpeckleFilter::radius( speckleMode );
+        clStatus  = clSetKernelArg( cl_SpeckleKernel, 0, sizeof(cl_mem), &polarImageMemObj );
+        clStatus |= clSetKernelArg( cl_SpeckleKernel, 1, sizeof(cl_mem), &speckleImageMemObj );
+        clStatus |= clSetKernelArg( cl_SpeckleKernel, 2, sizeof(cl_int), &speckleRadius );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to set speckle filter kernel arguments:" << clStatus;
+            return false;
+        }
+
+        // Whole work-groups; the kernel skips the padding lines
+        const size_t speckleGlobalDim[ 2 ] = { FFT_DATA_SIZE,
+                                               ( subsampledBufferLength + SpeckleGroupSize[ 1 ] - 1 ) / SpeckleGroupSize[ 1 ] * SpeckleGroupSize[ 1 ] };
+        clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_SpeckleKernel, 2, NULL, speckleGlobalDim, SpeckleGroupSize, 0, NULL,
+                                           profilingEvent( PipelineMetrics::Stage::SpeckleFilter ) );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to execute speckle filter kernel:" << clStatus;
+            return false;
+        }
+        polarImageMemObj = speckleImageMemObj;
+    }
+
+/*
+ * Set up Catheter specific parameters
+ */
+//    deviceSettings &device = deviceSettings::Instance();
+//    int index = device.getCurrentDevice();
+//    float catheterRadius_um = device.deviceAt(index)->getCatheterRadius_um();
+//    float internalImagingMask_px = device.deviceAt(index)->getInternalImagingMask_px();
+//    float standardDepth_mm = device.deviceAt( index )->getImagingDepth_mm();
+//    const int standardDepth_S = device.deviceAt( index )->getALineLength_px();
+//    int SectorWidth_px = SECTOR_HEIGHT_PX;
+//    int SectorHeight_px = SECTOR_HEIGHT_PX;
 //    depthSetting &depth = depthSetting::Instance();
 //    float fractionOfCanvas = depth.getFractionOfCanvas();
 
 //    float displayAngle = displayAngle_deg;
-    const auto* smi = SignalModel::instance();
+    cl_mem warpSourceMemObj = polarImageMemObj;
+    if( isAveraging && cl_AverageKernel )
+    {
+        if( !prepareFrameAverage( subsampledBufferLength ) )
+        {
+            return false;
+        }
+        isAverageReset = isAverageReset || ( m_averagedLines != subsampledBufferLength );
+        m_averagedLines = subsampledBufferLength;
+
+        const cl_int doReset = isAverageReset;
+        clStatus  = clSetKernelArg( cl_AverageKernel, 0, sizeof(cl_mem),   &polarImageMemObj );
+        clStatus |= clSetKernelArg( cl_AverageKernel, 1, sizeof(cl_mem),   &averagedImageMemObj );
+        clStatus |= clSetKernelArg( cl_AverageKernel, 2, sizeof(cl_mem),   &previousFrameMemObj );
+        clStatus |= clSetKernelArg( cl_AverageKernel, 3, sizeof(cl_float), smi->currFrameWeight_percent() );
+        clStatus |= clSetKernelArg( cl_AverageKernel, 4, sizeof(cl_float), smi->prevFrameWeight_percent() );
+        clStatus |= clSetKernelArg( cl_AverageKernel, 5, sizeof(cl_int),   &doReset );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to set frame average kernel arguments:" << clStatus;
+            return false;
+        }
 
-    clStatus  = clSetKernelArg( cl_WarpKernel,  0, sizeof(cl_mem), &warpInputImageMemObj );
+        const size_t averageGlobalDim[ 2 ] = { FFT_DATA_SIZE, subsampledBufferLength };
+        clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_AverageKernel, 2, NULL, averageGlobalDim, NULL, 0, NULL,
+                                           profilingEvent( PipelineMetrics::Stage::Average ) );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to execute frame average kernel:" << clStatus;
+            return false;
+        }
+        warpSourceMemObj = averagedImageMemObj;
+    }
+
+    const bool isAutoContrast = *smi->isAutoContrast();
+    if( isAutoContrast && !m_isAutoContrastActive )
+    {
+        m_autoContrast.reset();
+    }
+    m_isAutoContrastActive = isAutoContrast;
+    const cl_int doHistogram = isAutoContrast && histogramMemObj;
+    if( doHistogram )
+    {
+        const cl_uint zero{0};
+        clStatus = clEnqueueFillBuffer( cl_Commands, histogramMemObj, &zero, sizeof( zero ), 0, sizeof( cl_uint ) * AutoContrast::NumberOfBins, 0, NULL,
+                                        profilingEvent( PipelineMetrics::Stage::HistogramClear ) );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to clear the histogram:" << clStatus;
+            return false;
+        }
+    }
+    const cl_int* brightness = isAutoContrast ? m_autoContrast.brightness() : smi->blackLevel();
+    const cl_int* contrast = isAutoContrast ? m_autoContrast.contrast() : smi->whiteLevel();
+
+    clStatus  = clSetKernelArg( cl_WarpKernel,  0, sizeof(cl_mem), &warpSourceMemObj );
     clStatus |= clSetKernelArg( cl_WarpKernel,  1, sizeof(cl_mem), &outputImageMemObj );
     clStatus |= clSetKernelArg( cl_WarpKernel,  2, sizeof(cl_mem), &outputVideoImageMemObj );
     clStatus |= clSetKernelArg( cl_WarpKernel,  3, sizeof(float),  smi->getCatheterRadius_um() );
     clStatus |= clSetKernelArg( cl_WarpKernel,  4, sizeof(float),  smi->getInternalImagingMask_px() );
     clStatus |= clSetKernelArg( cl_WarpKernel,  5, sizeof(float),  smi->getStandardDepth_mm() );
     clStatus |= clSetKernelArg( cl_WarpKernel,  6, sizeof(int),    smi->getALineLength_px() );
-    clStatus |= clSetKernelArg( cl_WarpKernel,  7, sizeof(float),  smi->getDisplayAngle() );
+    const float rotation_norm = polarRowOffset( *smi->getDisplayAngle(), *smi->getIsDistalToProximalView() );
+    clStatus |= clSetKernelArg( cl_WarpKernel,  7, sizeof(float),  &rotation_norm );
     clStatus |= clSetKernelArg( cl_WarpKernel,  8, sizeof(int),    smi->getIsDistalToProximalView() );
     clStatus |= clSetKernelArg( cl_WarpKernel,  9, sizeof(int),    smi->getSectorWidth_px() );
     clStatus |= clSetKernelArg( cl_WarpKernel, 10, sizeof(int),    smi->getSectorHeight_px() );
     clStatus |= clSetKernelArg( cl_WarpKernel, 11, sizeof(float),  smi->getFractionOfCanvas() );
     clStatus |= clSetKernelArg( cl_WarpKernel, 12, sizeof(int),    smi->getImagingDepth_S());
-    clStatus |= clSetKernelArg( cl_WarpKernel, 13, sizeof(int),    smi->blackLevel() );
-    clStatus |= clSetKernelArg( cl_WarpKernel, 14, sizeof(int),    smi->whiteLevel() );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 13, sizeof(int),    brightness );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 14, sizeof(int),    contrast );
     clStatus |= clSetKernelArg( cl_WarpKernel, 15, sizeof(int),    smi->isInvertOctColors() );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 16, sizeof(cl_mem), &histogramMemObj );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 17, sizeof(int),    &doHistogram );
+
+    // The video frame and the thumbnail come out of the same launch when asked for
+    const cl_int doVideo = ( m_warpOutputs & VideoOutput ) != 0;
+    const cl_int doThumbnail = ( m_warpOutputs & ThumbnailOutput ) != 0;
+    const cl_int videoWidth_px{VideoWidth_px};
+    const cl_int videoHeight_px{VideoHeight_px};
+    const cl_int thumbnailWidth_px{ThumbnailWidth_px};
+    const cl_int thumbnailHeight_px{ThumbnailHeight_px};
+    clStatus |= clSetKernelArg( cl_WarpKernel, 18, sizeof(cl_mem), &outputThumbnailImageMemObj );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 19, sizeof(int),    &doVideo );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 20, sizeof(int),    &videoWidth_px );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 21, sizeof(int),    &videoHeight_px );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 22, sizeof(int),    &doThumbnail );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 23, sizeof(int),    &thumbnailWidth_px );
+    clStatus |= clSetKernelArg( cl_WarpKernel, 24, sizeof(int),    &thumbnailHeight_px );
+
+    // The zoom window of the display
+    const cl_float4 roi{ { float( m_regionOfInterest.x() ), float( m_regionOfInterest.y() ),
+                           float( m_regionOfInterest.width() ), float( m_regionOfInterest.height() ) } };
+    clStatus |= clSetKernelArg( cl_WarpKernel, 25, sizeof(cl_float4), &roi );
 
 //    if(count++ % 64 == 0){
 //        LOG4(*(smi->getCatheterRadius_um()), *(smi->getInternalImagingMask_px()), *(smi->getStandardDepth_mm()), *(smi->getImagingDepth_S()))
@@ -585,39 +1347,558 @@ bool ScanConversion::warpData( OCTFile::OctData_t *dataFrame, size_t pBufferLeng
         return false;
     }
 
-    global_unit_dim[ 0 ] = SectorWidth_px;
-    global_unit_dim[ 1 ] = SectorHeight_px;
+    const int sectorWidth_px = *smi->getSectorWidth_px();
+    const int sectorHeight_px = *smi->getSectorHeight_px();
+    global_unit_dim[ 0 ] = size_t( doVideo ? std::max( sectorWidth_px, VideoWidth_px ) : sectorWidth_px );
+    global_unit_dim[ 1 ] = size_t( doVideo ? std::max( sectorHeight_px, VideoHeight_px ) : sectorHeight_px );
 
-    clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_WarpKernel, 2, NULL, global_unit_dim, local_unit_dim, 0, NULL, NULL );
+    const size_t* warpLocalSize = m_warpLocalSize[ 0 ] ? m_warpLocalSize : NULL;
+    clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_WarpKernel, 2, NULL, global_unit_dim, warpLocalSize, 0, NULL,
+                                       profilingEvent( PipelineMetrics::Stage::Warp ) );
     if( clStatus != CL_SUCCESS )
     {
         qDebug() << "DSP: Failed to execute warp kernel:" << clStatus;
         return false;
     }
 
+    if( doHistogram )
+    {
+        // Completes with the warp; no extra host round trip
+        clStatus = clEnqueueReadBuffer( cl_Commands, histogramMemObj, CL_FALSE, 0, sizeof( cl_uint ) * AutoContrast::NumberOfBins, m_histogram.data(), 0, NULL,
+                                        profilingEvent( PipelineMetrics::Stage::HistogramRead ) );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to read the histogram:" << clStatus;
+            return false;
+        }
+    }
+
     // Do all the work that was queued up on the GPU
     clFinish( cl_Commands );
 
+    if( isAutoContrast )
+    {
+        if( !doHistogram )
+        {
+            // Every 4th line is plenty for percentiles and keeps this well under a millisecond
+            m_histogram.fill( 0 );
+            AutoContrast::accumulateHistogram( pDataIn, int( uploadedLines ), FFT_DATA_SIZE,
+                                               int( *smi->getInternalImagingMask_px() ), 4, m_histogram.data() );
+        }
+        // The levels apply from the next frame on
+        m_autoContrast.update( m_histogram.data() );
+    }
+
     size_t origin[ 3 ] = { 0, 0, 0 };
-    size_t region[ 3 ] = { SECTOR_HEIGHT_PX, SECTOR_HEIGHT_PX, 1 };
+    size_t region[ 3 ] = { size_t( sectorWidth_px ), size_t( sectorHeight_px ), 1 };
+
+    /*
+     * read out the video frame and the thumbnail into their persistent buffers; the blocking
+     * read of the display frame after them waits for both
+     */
+    if( doVideo )
+    {
+        const size_t videoRegion[ 3 ] = { VideoWidth_px, VideoHeight_px, 1 };
+        m_videoFrame.resize( size_t( VideoWidth_px ) * VideoHeight_px );
+        clStatus = clEnqueueReadImage( cl_Commands, outputVideoImageMemObj, CL_FALSE, origin, videoRegion, 0, 0, m_videoFrame.data(), 0, NULL, NULL );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to read back the video frame: " << clStatus;
+            return false;
+        }
+    }
+    if( doThumbnail )
+    {
+        const size_t thumbnailRegion[ 3 ] = { ThumbnailWidth_px, ThumbnailHeight_px, 1 };
+        if( m_thumbnail.isNull() )
+        {
+            m_thumbnail = QImage( ThumbnailWidth_px, ThumbnailHeight_px, QImage::Format_Grayscale8 );
+        }
+        clStatus = clEnqueueReadImage( cl_Commands, outputThumbnailImageMemObj, CL_FALSE, origin, thumbnailRegion,
+                                       size_t( m_thumbnail.bytesPerLine() ), 0, m_thumbnail.bits(), 0, NULL, NULL );
+        if( clStatus != CL_SUCCESS )
+        {
+            qDebug() << "DSP: Failed to read back the thumbnail: " << clStatus;
+            return false;
+        }
+    }
 
     /*
      * read out the display frame
      */
-    clStatus = clEnqueueReadImage( cl_Commands, outputImageMemObj, CL_TRUE, origin, region, 0, 0, pDataOut, 0, NULL, NULL );
+    clStatus = clEnqueueReadImage( cl_Commands, outputImageMemObj, CL_TRUE, origin, region, 0, 0, pDataOut, 0, NULL,
+                                   profilingEvent( PipelineMetrics::Stage::Readback ) );
     if( clStatus != CL_SUCCESS )
     {
         qDebug() << "DSP: Failed to read back final image data from warp kernel: " << clStatus;
         return false;
     }
+    m_isVideoFrameValid = doVideo;
+    m_isThumbnailValid = doThumbnail;
+
+    /*
+     * What this frame was drawn from, for snapshotForCapture until the next one. An upload
+     * made with CL_MEM_USE_HOST_PTR is the DAQ's buffer, which is refilled as soon as the
+     * frame goes back; it is not kept past the frame.
+     */
+    if( m_lastWarpSourceMemObj )
+    {
+        clReleaseMemObject( m_lastWarpSourceMemObj );
+        m_lastWarpSourceMemObj = nullptr;
+    }
+    cl_mem_flags sourceFlags{0};
+    clGetMemObjectInfo( warpSourceMemObj, CL_MEM_FLAGS, sizeof( sourceFlags ), &sourceFlags, nullptr );
+    if( !( sourceFlags & CL_MEM_USE_HOST_PTR ) )
+    {
+        clRetainMemObject( warpSourceMemObj );
+        m_lastWarpSourceMemObj = warpSourceMemObj;
+    }
+    m_lastBrightness = *brightness;
+    m_lastContrast = *contrast;
 
     clReleaseMemObject( warpInputImageMemObj );
-#if LINE_AVERAGING
-    clReleaseMemObject( lineAvgInputMemObj );
-#endif
+
+    if( m_isProfiling )
+    {
+        collectProfiling();
+        PipelineMetrics::instance()->recordHost( PipelineMetrics::Stage::Frame, frameTimer.nsecsElapsed() / 1000.0 );
+        PipelineMetrics::instance()->frameDone();
+    }
+    return true;
+}
+
+/*
+ * profilingEvent
+ *
+ * The event to hand to an enqueue for this stage, or NULL when profiling is off. An event
+ * left over from a frame that failed part way is dropped first.
+ */
+cl_event *ScanConversion::profilingEvent( PipelineMetrics::Stage stage )
+{
+    if( !m_isProfiling )
+    {
+        return NULL;
+    }
+    cl_event& event = m_stageEvents[ size_t( stage ) ];
+    if( event )
+    {
+        clReleaseEvent( event );
+        event = nullptr;
+    }
+    return &event;
+}
+
+/*
+ * collectProfiling
+ *
+ * Reads the queued, submit, start and end times of the frame's events (all complete by now)
+ * into PipelineMetrics and releases them.
+ */
+void ScanConversion::collectProfiling()
+{
+    auto* metrics = PipelineMetrics::instance();
+    for( size_t i = 0; i < m_stageEvents.size(); i++ )
+    {
+        cl_event& event = m_stageEvents[ i ];
+        if( !event )
+        {
+            continue;
+        }
+        cl_ulong queued{0};
+        cl_ulong submit{0};
+        cl_ulong start{0};
+        cl_ulong end{0};
+        cl_int err  = clGetEventProfilingInfo( event, CL_PROFILING_COMMAND_QUEUED, sizeof( cl_ulong ), &queued, NULL );
+        err        |= clGetEventProfilingInfo( event, CL_PROFILING_COMMAND_SUBMIT, sizeof( cl_ulong ), &submit, NULL );
+        err        |= clGetEventProfilingInfo( event, CL_PROFILING_COMMAND_START,  sizeof( cl_ulong ), &start,  NULL );
+        err        |= clGetEventProfilingInfo( event, CL_PROFILING_COMMAND_END,    sizeof( cl_ulong ), &end,    NULL );
+        if( err == CL_SUCCESS )
+        {
+            metrics->record( PipelineMetrics::Stage( i ), queued, submit, start, end );
+        }
+        clReleaseEvent( event );
+        event = nullptr;
+    }
+}
+
+SpectralPipeline::Backend ScanConversion::spectralBackend() const
+{
+    return m_spectralBackend;
+}
+
+void ScanConversion::setSpectralBackend( SpectralPipeline::Backend backend )
+{
+    m_spectralBackend = backend;
+}
+
+bool ScanConversion::processFringes( OCTFile::OctData_t *dataFrame, size_t numberOfLines )
+{
+    if( !dataFrame->fringeData || dataFrame->isFromRecording || !dataFrame->acqData ||
+        ( m_spectralBackend == SpectralPipeline::Backend::Fpga ) )
+    {
+        return false;
+    }
+
+    if( ( m_spectralBackend == SpectralPipeline::Backend::OpenCL ) && cl_FftKernel &&
+        processFringesOpenCL( dataFrame->fringeData, numberOfLines, dataFrame->acqData ) )
+    {
+        return true;
+    }
+
+    const auto* smi = SignalModel::instance();
+    m_spectralPipeline.process( dataFrame->fringeData, numberOfLines, dataFrame->acqData,
+                                *smi->scaleFactor(), float( *smi->dcNoiseLevel() ) );
+    return true;
+}
+
+/*
+ * prepareSpectral
+ *
+ * The rescaling tables go up once; the frame buffers grow with the number of lines.
+ */
+bool ScanConversion::prepareSpectral( size_t numberOfLines )
+{
+    cl_int err{CL_SUCCESS};
+
+    if( !wholeSamplesMemObj )
+    {
+        const auto& whole = m_spectralPipeline.wholeSamples();
+        const std::vector<float> wholeSamples( whole.begin(), whole.end() );
+        const size_t tableSize = sizeof( cl_float ) * RAW_ALINE_LENGTH;
+        wholeSamplesMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, tableSize,
+                                             const_cast<float*>( wholeSamples.data() ), &err );
+        fractionalSamplesMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, tableSize,
+                                                  const_cast<float*>( m_spectralPipeline.fractionalSamples().data() ), &err );
+        windowMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, tableSize,
+                                       const_cast<float*>( m_spectralPipeline.window().data() ), &err );
+        if( !wholeSamplesMemObj || !fractionalSamplesMemObj || !windowMemObj )
+        {
+            qDebug() << "Failed to create the rescaling tables, reason: " << err;
+            return false;
+        }
+    }
+
+    if( numberOfLines <= m_spectralLines )
+    {
+        return true;
+    }
+
+    for( cl_mem* memObj : { &fringeMemObj, &resampledMemObj, &fftRealMemObj, &fftImagMemObj, &postFftPreviousMemObj, &spectralImageMemObj } )
+    {
+        if( *memObj )
+        {
+            clReleaseMemObject( *memObj );
+            *memObj = nullptr;
+        }
+    }
+    m_spectralLines = 0;
+
+    fringeMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_ONLY, sizeof( cl_ushort ) * RAW_ALINE_LENGTH * numberOfLines, nullptr, &err );
+    resampledMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_WRITE, sizeof( cl_float ) * RAW_ALINE_LENGTH * numberOfLines, nullptr, &err );
+    fftRealMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_WRITE, sizeof( cl_float ) * FFT_DATA_SIZE * numberOfLines, nullptr, &err );
+    fftImagMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_WRITE, sizeof( cl_float ) * FFT_DATA_SIZE * numberOfLines, nullptr, &err );
+    postFftPreviousMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_WRITE, sizeof( cl_float ) * FFT_DATA_SIZE * numberOfLines, nullptr, &err );
+
+    const cl_image_desc spectralImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        FFT_DATA_SIZE,
+        numberOfLines,
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    spectralImageMemObj = clCreateImage( cl_Context, CL_MEM_WRITE_ONLY, &deviceSpecificImageFormat, &spectralImageDescriptor, nullptr, &err );
+
+    if( !fringeMemObj || !resampledMemObj || !fftRealMemObj || !fftImagMemObj || !postFftPreviousMemObj || !spectralImageMemObj )
+    {
+        qDebug() << "Failed to create the spectral buffers, reason: " << err;
+        return false;
+    }
+
+    m_spectralLines = numberOfLines;
+    LOG1(m_spectralLines)
+    return true;
+}
+
+/*
+ * processFringesOpenCL
+ *
+ * Upload, three kernels and a blocking read of the 8-bit A-lines, which then take the same
+ * path as frames from the FPGA.
+ */
+bool ScanConversion::processFringesOpenCL( const uint16_t *fringes, size_t numberOfLines, uint8_t *polar )
+{
+    if( !prepareSpectral( numberOfLines ) )
+    {
+        return false;
+    }
+
+    cl_int clStatus = clEnqueueWriteBuffer( cl_Commands, fringeMemObj, CL_FALSE, 0, sizeof( cl_ushort ) * RAW_ALINE_LENGTH * numberOfLines,
+                                            fringes, 0, NULL, profilingEvent( PipelineMetrics::Stage::FringeUpload ) );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to upload fringes:" << clStatus;
+        return false;
+    }
+
+    const cl_uint rawLength{RAW_ALINE_LENGTH};
+    clStatus  = clSetKernelArg( cl_RescaleKernel, 0, sizeof(cl_mem),  &fringeMemObj );
+    clStatus |= clSetKernelArg( cl_RescaleKernel, 1, sizeof(cl_mem),  &resampledMemObj );
+    clStatus |= clSetKernelArg( cl_RescaleKernel, 2, sizeof(cl_mem),  &fractionalSamplesMemObj );
+    clStatus |= clSetKernelArg( cl_RescaleKernel, 3, sizeof(cl_mem),  &wholeSamplesMemObj );
+    clStatus |= clSetKernelArg( cl_RescaleKernel, 4, sizeof(cl_mem),  &windowMemObj );
+    clStatus |= clSetKernelArg( cl_RescaleKernel, 5, sizeof(cl_uint), &rawLength );
+    clStatus |= clSetKernelArg( cl_RescaleKernel, 6, sizeof(cl_uint), &rawLength );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to set rescale kernel arguments:" << clStatus;
+        return false;
+    }
+    const size_t rescaleGlobalDim[ 2 ] = { RAW_ALINE_LENGTH, numberOfLines };
+    clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_RescaleKernel, 2, NULL, rescaleGlobalDim, NULL, 0, NULL,
+                                       profilingEvent( PipelineMetrics::Stage::Rescale ) );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to execute rescale kernel:" << clStatus;
+        return false;
+    }
+
+    clStatus  = clSetKernelArg( cl_FftKernel, 0, sizeof(cl_mem), &resampledMemObj );
+    clStatus |= clSetKernelArg( cl_FftKernel, 1, sizeof(cl_mem), &fftRealMemObj );
+    clStatus |= clSetKernelArg( cl_FftKernel, 2, sizeof(cl_mem), &fftImagMemObj );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to set FFT kernel arguments:" << clStatus;
+        return false;
+    }
+    const size_t fftGlobalDim[ 2 ] = { SpectralFftGroupSize, numberOfLines };
+    const size_t fftLocalDim[ 2 ]  = { SpectralFftGroupSize, 1 };
+    clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_FftKernel, 2, NULL, fftGlobalDim, fftLocalDim, 0, NULL,
+                                       profilingEvent( PipelineMetrics::Stage::Fft ) );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to execute FFT kernel:" << clStatus;
+        return false;
+    }
+
+    // Averaging and inversion happen later in the pipeline, on the 8-bit frame
+    const auto* smi = SignalModel::instance();
+    const cl_int doAverage{0};
+    const cl_int doInvert{0};
+    clStatus  = clSetKernelArg( cl_PostFftKernel,  0, sizeof(cl_mem),   &fftRealMemObj );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  1, sizeof(cl_mem),   &fftImagMemObj );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  2, sizeof(cl_mem),   &postFftPreviousMemObj );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  3, sizeof(cl_mem),   &spectralImageMemObj );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  4, sizeof(cl_uint),  smi->getInputLength() );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  5, sizeof(cl_float), smi->scaleFactor() );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  6, sizeof(cl_uint),  smi->dcNoiseLevel() );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  7, sizeof(cl_int),   &doAverage );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  8, sizeof(cl_float), smi->prevFrameWeight_percent() );
+    clStatus |= clSetKernelArg( cl_PostFftKernel,  9, sizeof(cl_float), smi->currFrameWeight_percent() );
+    clStatus |= clSetKernelArg( cl_PostFftKernel, 10, sizeof(cl_int),   &doInvert );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to set postfft kernel arguments:" << clStatus;
+        return false;
+    }
+    const size_t postFftGlobalDim[ 2 ] = { FFT_DATA_SIZE, numberOfLines };
+    clStatus = clEnqueueNDRangeKernel( cl_Commands, cl_PostFftKernel, 2, NULL, postFftGlobalDim, NULL, 0, NULL,
+                                       profilingEvent( PipelineMetrics::Stage::PostFft ) );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to execute postfft kernel:" << clStatus;
+        return false;
+    }
+
+    size_t origin[ 3 ] = { 0, 0, 0 };
+    size_t region[ 3 ] = { FFT_DATA_SIZE, numberOfLines, 1 };
+    clStatus = clEnqueueReadImage( cl_Commands, spectralImageMemObj, CL_TRUE, origin, region, 0, 0, polar, 0, NULL,
+                                   profilingEvent( PipelineMetrics::Stage::SpectralReadback ) );
+    if( clStatus != CL_SUCCESS )
+    {
+        qDebug() << "DSP: Failed to read back the A-lines:" << clStatus;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * prepareSpeckleFilter
+ *
+ * Sizes the filtered frame.
+ */
+bool ScanConversion::prepareSpeckleFilter( size_t numberOfLines )
+{
+    if( speckleImageMemObj && ( m_speckleLines == numberOfLines ) )
+    {
+        return true;
+    }
+    if( speckleImageMemObj )
+    {
+        clReleaseMemObject( speckleImageMemObj );
+        speckleImageMemObj = nullptr;
+    }
+
+    cl_int err{CL_SUCCESS};
+    const cl_image_desc speckleImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        FFT_DATA_SIZE,
+        numberOfLines,
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    speckleImageMemObj = clCreateImage( cl_Context, CL_MEM_READ_WRITE, &deviceSpecificImageFormat, &speckleImageDescriptor, nullptr, &err );
+    if( err != CL_SUCCESS )
+    {
+        qDebug() << "Failed to create GPU image speckleImageMemObj, reason: " << err;
+        speckleImageMemObj = nullptr;
+        return false;
+    }
+    m_speckleLines = numberOfLines;
+    LOG1(m_speckleLines)
     return true;
 }
 
+/*
+ * prepareLineDecimation
+ *
+ * Uploads the filter taps when they change and sizes the decimated frame.
+ */
+bool ScanConversion::prepareLineDecimation( size_t numberOfLines )
+{
+    cl_int err{CL_SUCCESS};
+
+    if( !decimationWeightsMemObj )
+    {
+        decimationWeightsMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_ONLY, sizeof( cl_ushort ) * LineDecimation::MaxTaps, nullptr, &err );
+        if( err != CL_SUCCESS )
+        {
+            qDebug() << "Failed to create GPU buffer decimationWeightsMemObj, reason: " << err;
+            decimationWeightsMemObj = nullptr;
+            return false;
+        }
+    }
+    if( !m_isDecimationFilterUploaded )
+    {
+        err = clEnqueueWriteBuffer( cl_Commands, decimationWeightsMemObj, CL_TRUE, 0, sizeof( cl_ushort ) * m_decimationFilter.weights.size(),
+                                    m_decimationFilter.weights.data(), 0, NULL, NULL );
+        if( err != CL_SUCCESS )
+        {
+            qDebug() << "Failed to upload the line decimation weights, reason: " << err;
+            return false;
+        }
+        m_isDecimationFilterUploaded = true;
+    }
+
+    if( decimatedImageMemObj && ( m_decimatedLines == numberOfLines ) )
+    {
+        return true;
+    }
+    if( decimatedImageMemObj )
+    {
+        clReleaseMemObject( decimatedImageMemObj );
+        decimatedImageMemObj = nullptr;
+    }
+
+    const cl_image_desc decimatedImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        FFT_DATA_SIZE,
+        numberOfLines,
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    decimatedImageMemObj = clCreateImage( cl_Context, CL_MEM_READ_WRITE, &deviceSpecificImageFormat, &decimatedImageDescriptor, nullptr, &err );
+    if( err != CL_SUCCESS )
+    {
+        qDebug() << "Failed to create GPU image decimatedImageMemObj, reason: " << err;
+        decimatedImageMemObj = nullptr;
+        return false;
+    }
+    m_decimatedLines = numberOfLines;
+    LOG1(m_decimatedLines)
+    return true;
+}
+
+/*
+ * prepareFrameAverage
+ *
+ * (Re)allocates the averaged frame and the running average for the current number of lines.
+ */
+bool ScanConversion::prepareFrameAverage( size_t numberOfLines )
+{
+    if( averagedImageMemObj && ( m_averagedLines == numberOfLines ) )
+    {
+        return true;
+    }
+
+    if( averagedImageMemObj )
+    {
+        clReleaseMemObject( averagedImageMemObj );
+        averagedImageMemObj = nullptr;
+    }
+    if( previousFrameMemObj )
+    {
+        clReleaseMemObject( previousFrameMemObj );
+        previousFrameMemObj = nullptr;
+    }
+
+    cl_int err{-1};
+    const cl_image_desc averagedImageDescriptor{
+        CL_MEM_OBJECT_IMAGE2D,
+        FFT_DATA_SIZE,
+        numberOfLines,
+        1,
+        1,
+        0,
+        0,
+        0,
+        0,
+        {nullptr}
+    };
+    averagedImageMemObj = clCreateImage( cl_Context, CL_MEM_READ_WRITE, &deviceSpecificImageFormat, &averagedImageDescriptor, nullptr, &err );
+    if( err != CL_SUCCESS )
+    {
+        qDebug() << "Failed to create GPU image averagedImageMemObj, reason: " << err;
+        averagedImageMemObj = nullptr;
+        return false;
+    }
+
+    previousFrameMemObj = clCreateBuffer( cl_Context, CL_MEM_READ_WRITE, sizeof( cl_ushort ) * FFT_DATA_SIZE * numberOfLines, nullptr, &err );
+    if( err != CL_SUCCESS )
+    {
+        qDebug() << "Failed to create GPU buffer previousFrameMemObj, reason: " << err;
+        previousFrameMemObj = nullptr;
+        return false;
+    }
+
+    LOG1(numberOfLines)
+    return true;
+}
+
+bool ScanConversion::AveragingGeometry_t::operator==( const AveragingGeometry_t &other ) const
+{
+    return ( numberOfLines == other.numberOfLines ) &&
+           ( aLineLength_px == other.aLineLength_px ) &&
+           ( imagingDepth_S == other.imagingDepth_S ) &&
+           ( internalImagingMask_px == other.internalImagingMask_px ) &&
+           ( catheterRadius_um == other.catheterRadius_um ) &&
+           ( standardDepth_mm == other.standardDepth_mm );
+}
+
 void ScanConversion::handleDisplayAngle( float angle, int direction )
 {
     qDebug() << "Change display angle:" << angle << direction;
@@ -7,8 +7,21 @@
 #include "defaults.h"
 #include <CL/opencl.h>
 #include <QDir>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QRectF>
 #include "octFile.h"
 #include <imagedescriptor.h>
+#include "autocontrast.h"
+#include "spectralpipeline.h"
+#include "linedecimation.h"
+#include "specklefilter.h"
+#include "opencltuning.h"
+#include "pipelinemetrics.h"
+#include <array>
+#include <memory>
+#include <vector>
 
 
 class ScanConversion: public QThread
@@ -17,6 +30,16 @@ class ScanConversion: public QThread
 
 public:
     ScanConversion();
+    ~ScanConversion();
+
+    /*
+     * Builds an instance (OpenCL set-up and kernel compile) on the calling thread so start-up
+     * can do it in the background; takePrepared() hands it over, or returns nullptr.
+     *
+     * @return True if OpenCL was set up
+     */
+    static bool prepare();
+    static ScanConversion* takePrepared();
 
     void mapBufferToSector( unsigned char *pDataIn, unsigned char *pDataOut );
     bool isLutGenerated( void ) { return lutGenerated; }
@@ -24,10 +47,87 @@ public:
     bool warpData( OCTFile::OctData_t *dataFrame, size_t pBufferLength );
     bool isReady;
 
+    /*
+     * With the FPGA bypassed, turns the raw fringes of a frame into its 8-bit A-lines (acqData).
+     * Returns false when there is nothing to do.
+     */
+    bool processFringes( OCTFile::OctData_t *dataFrame, size_t numberOfLines );
+    bool isSpectralOpenCLReady( void ) const { return cl_FftKernel != nullptr; }
+    SpectralPipeline::Backend spectralBackend() const;
+    void setSpectralBackend( SpectralPipeline::Backend backend );
+
+    /*
+     * Besides the display frame (dispData), the warp can write an encoder-ready video frame
+     * (VideoWidth_px x VideoHeight_px, 8-bit gray as OctFrameRecorder takes it) and a
+     * ThumbnailWidth_px x ThumbnailHeight_px thumbnail, all in the same launch. The results
+     * stay valid until the next warp; null when the output was not asked for.
+     */
+    enum WarpOutput
+    {
+        DisplayOutput   = 0x1,
+        VideoOutput     = 0x2,
+        ThumbnailOutput = 0x4
+    };
+    void setWarpOutputs( int outputs );
+    int warpOutputs() const;
+    uint8_t* videoFrame();
+    QImage thumbnail() const;
+
+    // The OpenCL launch settings in use, for logs and benchmarks
+    QString tuningDescription() const;
+
+    /*
+     * The display frame is SignalModel::getSectorWidth_px() square. It starts at the size asked
+     * for in the settings, lowered to what the device and control/warpBudget_ms allow.
+     */
+    bool setSectorSize_px( int size_px );
+
+    /*
+     * Zoom: the display frame shows only this part of the sector (fractions of it), warped
+     * straight from the polar frame at the full display size
+     */
+    void setRegionOfInterest( const QRectF& roi );
+    QRectF regionOfInterest() const;
+
+    /*
+     * Image capture without the GUI thread touching pixels: snapshotForCapture() queues a
+     * device copy of the polar frame the last warp drew and takes its warp parameters;
+     * renderCapture() warps that copy at any size, on any thread, with its own kernel and
+     * queue. Null when there is no frame yet, or the frame was drawn straight from a DAQ
+     * buffer uploaded with CL_MEM_USE_HOST_PTR.
+     */
+    struct CaptureFrame_t
+    {
+        cl_mem   polarImageMemObj{nullptr};
+        cl_event copied{nullptr};
+        float    catheterRadius_um{0.0f};
+        float    internalImagingMask_px{0.0f};
+        float    standardDepth_mm{0.0f};
+        int      aLineLength_px{0};
+        float    displayAngle{0.0f};
+        int      isDistalToProximalView{0};
+        float    fractionOfCanvas{0.0f};
+        int      imagingDepth_S{0};
+        int      brightness{0};
+        int      contrast{0};
+        int      isInvertColors{0};
+        QRectF   regionOfInterest;
+        ScanConversion* owner{nullptr};     // waits in its destructor until the frame is gone
+
+        CaptureFrame_t() = default;
+        CaptureFrame_t( const CaptureFrame_t& ) = delete;
+        CaptureFrame_t& operator=( const CaptureFrame_t& ) = delete;
+        ~CaptureFrame_t();
+    };
+    std::shared_ptr<CaptureFrame_t> snapshotForCapture();
+    QImage renderCapture( const CaptureFrame_t& frame, int size_px );
+
 public slots:
     void handleDisplayAngle( float angle, int direction );
 
 private:
+    static ScanConversion* m_prepared;
+
     float **rLUT;
     float **tLUT;
 
@@ -41,21 +141,121 @@ private:
     char *loadCLProgramSourceFromFile( QString );
     bool initOpenCL();
     bool createCLMemObjects( cl_context context );
+    bool createOutputImages( cl_context context );
     cl_mem  warpInputImageMemObj;
-    cl_mem  outputImageMemObj;
-    cl_mem  outputVideoImageMemObj;
+    cl_mem  outputImageMemObj{nullptr};
+    cl_mem  outputVideoImageMemObj{nullptr};
+    cl_mem  outputThumbnailImageMemObj{nullptr};
+    int     m_warpOutputs{DisplayOutput};
+    QRectF  m_regionOfInterest{0.0, 0.0, 1.0, 1.0};
+    cl_mem  m_lastWarpSourceMemObj{nullptr};
+    cl_int  m_lastBrightness{0};
+    cl_int  m_lastContrast{0};
+    std::vector<uint8_t> m_videoFrame;
+    QImage  m_thumbnail;
+    bool    m_isVideoFrameValid{false};
+    bool    m_isThumbnailValid{false};
     cl_kernel cl_WarpKernel;
     cl_device_id cl_ComputeDeviceId;
     size_t cl_max_workgroup_size;
-    cl_context cl_Context;
+    cl_context cl_Context{nullptr};
     cl_command_queue cl_Commands;
     cl_program       cl_WarpProgram;
     cl_image_format deviceSpecificImageFormat;
     cl_mem_flags deviceSpecificMemFlags;
 
-    cl_mem     lineAvgInputMemObj;
-    cl_program cl_LineAvgProgram;
-    cl_kernel  cl_LineAvgKernel;
+    // Image format, upload flags and warp work-group size, tuned per device (see OpenClTuning)
+    bool applyTuning( const OpenClTuning::Settings_t& tuning );
+    bool autoTuneOpenCL( const QString& deviceKey );
+    int budgetSectorSize();
+    OpenClTuning::Settings_t m_tuning;
+    size_t m_warpLocalSize[ 2 ]{16, 16};
+
+    // Capture renders run off the GUI thread, so they don't share the warp kernel or queue
+    QMutex           m_captureLock;
+    cl_kernel        cl_CaptureKernel{nullptr};
+    cl_command_queue cl_CaptureCommands{nullptr};
+
+    // Snapshots still held by the capture pool, which calls back into this instance
+    QMutex           m_capturesInFlightLock;
+    QWaitCondition   m_capturesDone;
+    int              m_capturesInFlight{0};
+
+    // Event profiling of every enqueue, reported through PipelineMetrics
+    cl_event* profilingEvent( PipelineMetrics::Stage stage );
+    void collectProfiling();
+    bool m_isProfiling{false};
+    std::array<cl_event, size_t( PipelineMetrics::Stage::NumberOfStages )> m_stageEvents{};
+
+    // Auto contrast; the histogram is filled by the warp kernel
+    cl_mem     histogramMemObj{nullptr};
+    AutoContrast m_autoContrast;
+    AutoContrast::Histogram_t m_histogram;
+    bool       m_isAutoContrastActive{false};
+
+    // Temporal frame average ahead of the warp; the running average stays on the device
+    struct AveragingGeometry_t
+    {
+        size_t numberOfLines{0};
+        int    aLineLength_px{0};
+        int    imagingDepth_S{0};
+        float  internalImagingMask_px{0.0f};
+        float  catheterRadius_um{0.0f};
+        float  standardDepth_mm{0.0f};
+        bool operator==(const AveragingGeometry_t& other) const;
+    };
+    bool prepareFrameAverage( size_t numberOfLines );
+    cl_program cl_AverageProgram{nullptr};
+    cl_kernel  cl_AverageKernel{nullptr};
+    cl_mem     averagedImageMemObj{nullptr};
+    cl_mem     previousFrameMemObj{nullptr};
+    size_t     m_averagedLines{0};
+    bool       m_isAveragingActive{false};
+    AveragingGeometry_t m_averagingGeometry;
+    std::vector<uint16_t> m_cpuAverage;
+    std::vector<uint8_t>  m_cpuAveragedFrame;
+
+    // Spectral processing of raw fringes: rescale.cl -> fft.cl -> postfft.cl, or the CPU
+    bool prepareSpectral( size_t numberOfLines );
+    bool processFringesOpenCL( const uint16_t* fringes, size_t numberOfLines, uint8_t* polar );
+    SpectralPipeline m_spectralPipeline;
+    SpectralPipeline::Backend m_spectralBackend{SpectralPipeline::Backend::Fpga};
+    cl_program cl_RescaleProgram{nullptr};
+    cl_kernel  cl_RescaleKernel{nullptr};
+    cl_program cl_FftProgram{nullptr};
+    cl_kernel  cl_FftKernel{nullptr};
+    cl_program cl_PostFftProgram{nullptr};
+    cl_kernel  cl_PostFftKernel{nullptr};
+    cl_mem     wholeSamplesMemObj{nullptr};
+    cl_mem     fractionalSamplesMemObj{nullptr};
+    cl_mem     windowMemObj{nullptr};
+    cl_mem     fringeMemObj{nullptr};
+    cl_mem     resampledMemObj{nullptr};
+    cl_mem     fftRealMemObj{nullptr};
+    cl_mem     fftImagMemObj{nullptr};
+    cl_mem     postFftPreviousMemObj{nullptr};
+    cl_mem     spectralImageMemObj{nullptr};
+    size_t     m_spectralLines{0};
+
+    // A-line decimation ahead of the average and the warp
+    bool prepareLineDecimation( size_t numberOfLines );
+    cl_program cl_DecimationProgram{nullptr};
+    cl_kernel  cl_DecimationKernel{nullptr};
+    cl_mem     decimatedImageMemObj{nullptr};
+    cl_mem     decimationWeightsMemObj{nullptr};
+    size_t     m_decimatedLines{0};
+    LineDecimation::Filter_t m_decimationFilter;
+    bool       m_isDecimationFilterUploaded{false};
+    std::vector<uint8_t> m_cpuDecimatedFrame;
+
+    // Speckle filter of the polar frame, after the decimation and ahead of the average
+    bool prepareSpeckleFilter( size_t numberOfLines );
+    cl_program cl_SpeckleProgram{nullptr};
+    cl_kernel  cl_SpeckleKernel{nullptr};
+    cl_mem     speckleImageMemObj{nullptr};
+    size_t     m_speckleLines{0};
+    std::vector<uint8_t> m_cpuSpeckleFrame;
+
     ImageDescriptor m_imageDescriptor;
 
 };
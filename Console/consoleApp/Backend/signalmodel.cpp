@@ -1,9 +1,14 @@
 #include "signalmodel.h"
+#include "frameaverage.h"
+#include "spectralpipeline.h"
+#include "linedecimation.h"
+#include "specklefilter.h"
 #include "logger.h"
 #include "Utility/userSettings.h"
 #include <QFile>
 #include <QElapsedTimer>
 #include <QCoreApplication>
+#include <cmath>
 
 #include "mainScreen.h"
 
@@ -12,9 +17,14 @@ SignalModel* SignalModel::m_instance{nullptr};
 
 SignalModel::SignalModel()
 {
-    allocateOctData();
     const auto& settings = userSettings::Instance();
+    setSectorSize_px(settings.getSectorSize_px() > 0 ? settings.getSectorSize_px() : nativeSectorSize_px());
+    allocateOctData();
     m_simulationFrameCount = settings.getStartFrame();
+
+    setLineDecimationMode(int(LineDecimation::modeFromSetting(settings.getLineDecimation())));
+    setLineDecimationTarget(settings.getLineDecimationTarget());
+    setSpeckleFilterMode(int(SpeckleFilter::modeFromSetting(settings.getSpeckleFilter())));
 }
 
 void SignalModel::allocateOctData()
@@ -22,11 +32,12 @@ void SignalModel::allocateOctData()
 
     const size_t rawDataSize{4096}; //4096
     const size_t fftDataSize{FFTDataSize};
-    const size_t dispDataSize{SectorHeight_px * SectorWidth_px};
+    const size_t dispDataSize{getSectorSize_B()};
 
     LOG3(rawDataSize, fftDataSize, dispDataSize); //8192, 4096, 1024, 1982464
 
     int frameBufferCount = userSettings::Instance().getNumberOfDaqBuffers() + int(userSettings::Instance().getIsSimulation());
+    const bool isRawFringes = SpectralPipeline::backendFromSetting(userSettings::Instance().getSpectralProcessing()) != SpectralPipeline::Backend::Fpga;
 
     for(int i = 0; i < frameBufferCount; ++i){
 
@@ -34,6 +45,9 @@ void SignalModel::allocateOctData()
 
         oct.dispData  = new uint8_t [dispDataSize];
         oct.acqData   = new uint8_t [MAX_ACQ_IMAGE_SIZE];
+        if(isRawFringes){
+            oct.fringeData = new uint16_t [size_t(RAW_ALINE_LENGTH) * MAX_LINES_PER_FRAME];
+        }
 
         m_octData[i] = oct;
     }
@@ -128,6 +142,38 @@ const cl_int* SignalModel::getSectorWidth_px() const
     return &m_sectorWidth_px;
 }
 
+size_t SignalModel::getSectorSize_B() const
+{
+    return size_t(m_sectorWidth_px) * size_t(m_sectorHeight_px);
+}
+
+/*
+ * setSectorSize_px
+ *
+ * The sector is square; the size is kept within bounds and rounded up to whole warp
+ * work-groups. Returns the size taken. Host buffers allocated at start-up can't grow, so
+ * ScanConversion only ever lowers it from there.
+ */
+int SignalModel::setSectorSize_px(int sectorSize_px)
+{
+    const int bounded = qBound(MinSectorSize_px, sectorSize_px, MaxSectorSize_px);
+    const int aligned = ( ( bounded + SectorAlignment_px - 1 ) / SectorAlignment_px ) * SectorAlignment_px;
+    m_sectorWidth_px = aligned;
+    m_sectorHeight_px = aligned;
+    LOG2(sectorSize_px, m_sectorWidth_px)
+    return aligned;
+}
+
+/*
+ * nativeSectorSize_px
+ *
+ * The sector in control screen pixels, so Qt draws it without scaling it up
+ */
+int SignalModel::nativeSectorSize_px()
+{
+    return int(std::ceil(SectorWidth_px * IMAGE_SCALE_FACTOR));
+}
+
 cl_mem SignalModel::getWarpVideoBuffer()
 {
     return m_warpVideoBuffer;
@@ -229,6 +275,16 @@ void SignalModel::setWhiteLevel(int whiteLevel)
     m_whiteLevel = whiteLevel;
 }
 
+const cl_int *SignalModel::isAutoContrast() const
+{
+    return &m_isAutoContrast;
+}
+
+void SignalModel::setIsAutoContrast(bool isAutoContrast)
+{
+    m_isAutoContrast = isAutoContrast;
+}
+
 const cl_int *SignalModel::blackLevel() const
 {
     return &m_blackLevel;
@@ -296,6 +352,9 @@ void SignalModel::setCurrFrameWeight_percent(int currFrameWeight_percent)
 {
     m_currFrameWeight_percent = 0.01f * currFrameWeight_percent;
     m_prevFrameWeight_percent = 0.01f * (100 - currFrameWeight_percent);
+    if(m_isAveragingNoiseReduction){
+        LOG2(currFrameWeight_percent, FrameAverage::delay_frames(m_currFrameWeight_percent))
+    }
 }
 
 const cl_int* SignalModel::isInvertOctColors() const
@@ -316,6 +375,48 @@ const cl_int* SignalModel::isAveragingNoiseReduction() const
 void SignalModel::setIsAveragingNoiseReduction(bool isAveragingNoiseReduction)
 {
     m_isAveragingNoiseReduction = isAveragingNoiseReduction;
+    if(m_isAveragingNoiseReduction){
+        // How far the averaged image trails the live one, in frames
+        LOG2(m_currFrameWeight_percent, FrameAverage::delay_frames(m_currFrameWeight_percent))
+    }
+}
+
+const cl_int *SignalModel::lineDecimationMode() const
+{
+    return &m_lineDecimationMode;
+}
+
+const cl_int *SignalModel::lineDecimationTarget() const
+{
+    return &m_lineDecimationTarget;
+}
+
+void SignalModel::setLineDecimationMode(int lineDecimationMode)
+{
+    m_lineDecimationMode = lineDecimationMode;
+    LOG1(LineDecimation::modeName(LineDecimation::Mode(m_lineDecimationMode)))
+}
+
+/*
+ * setLineDecimationTarget
+ *
+ * 0 or less picks the sector circumference.
+ */
+void SignalModel::setLineDecimationTarget(int lineDecimationTarget)
+{
+    m_lineDecimationTarget = lineDecimationTarget > 0 ? lineDecimationTarget : LineDecimation::defaultTargetLines(m_sectorWidth_px);
+    LOG1(m_lineDecimationTarget)
+}
+
+const cl_int *SignalModel::speckleFilterMode() const
+{
+    return &m_speckleFilterMode;
+}
+
+void SignalModel::setSpeckleFilterMode(int speckleFilterMode)
+{
+    m_speckleFilterMode = speckleFilterMode;
+    LOG1(SpeckleFilter::modeName(SpeckleFilter::Mode(m_speckleFilterMode)))
 }
 
 void SignalModel::pushImageRenderingQueue(OctData *od)
@@ -376,6 +477,8 @@ OctData* SignalModel::handleSimulationSettings(OctData * const od)
             }
             od->frameNumber = m_simulationFrameCount++;
             od->acqData = axsunData->acqData;
+            // Recorded frames are already A-lines
+            od->isFromRecording = true;
 //            LOG1(od.acqData)
             retrieveOct(*od);
         }
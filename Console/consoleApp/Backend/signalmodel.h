@@ -53,6 +53,13 @@ public:
 
     const cl_int *whiteLevel() const;
 
+    const cl_int *isAutoContrast() const;
+
+    const cl_int *lineDecimationMode() const;
+    const cl_int *lineDecimationTarget() const;
+
+    const cl_int *speckleFilterMode() const;
+
 public slots:
     void setIsAveragingNoiseReduction(bool isAveragingNoiseReduction);
     void setCurrFrameWeight_percent(int currFrameWeight_percent);
@@ -60,6 +67,12 @@ public slots:
 
     void setBlackLevel(int blackLevel);
     void setWhiteLevel(int whiteLevel);
+    void setIsAutoContrast(bool isAutoContrast);
+
+    void setLineDecimationMode(int lineDecimationMode);
+    void setLineDecimationTarget(int lineDecimationTarget);
+
+    void setSpeckleFilterMode(int speckleFilterMode);
 
 public: //data
     const size_t m_oclLocalWorkSize[2]{16,16};
@@ -97,6 +110,9 @@ public: //functions
 
     const cl_int* getSectorWidth_px() const;
     const cl_int* getSectorHeight_px() const;
+    size_t getSectorSize_B() const;
+    int setSectorSize_px(int sectorSize_px);
+    static int nativeSectorSize_px();
 
     void setAdvacedViewSourceFrameNumber(int frameNumber);
 
@@ -141,6 +157,14 @@ private: //data
 
     cl_int m_blackLevel{0}; //2 blackLevel
     cl_int m_whiteLevel{0}; //3 whiteLevel
+    cl_int m_isAutoContrast{false}; // levels from the frame histogram instead of black and white level
+
+    //A-line decimation ahead of the warp
+    cl_int m_lineDecimationMode{0}; // LineDecimation::Mode
+    cl_int m_lineDecimationTarget{0}; // lines per revolution to aim for
+
+    //speckle filter of the polar frame ahead of the warp
+    cl_int m_speckleFilterMode{0}; // SpeckleFilter::Mode
 
     //from B and C to warp
     cl_mem m_bAndCimageBuffer{nullptr};
@@ -152,8 +176,8 @@ private: //data
     cl_int m_aLineLength_px{0}; //6 standardDepth_S
     cl_float m_displayAngle{0.0f}; //7 displayAngle_deg
     cl_int m_isDistalToProximalView{0}; //8 reverseDirection
-    const cl_int& m_sectorWidth_px{SectorWidth_px}; //9
-    const cl_int& m_sectorHeight_px{SectorHeight_px}; //10
+    cl_int m_sectorWidth_px{SectorWidth_px}; //9
+    cl_int m_sectorHeight_px{SectorHeight_px}; //10
     cl_float m_fractionOfCanvas{0.0f}; //11 fractionOfCanvas
     cl_int m_imagingDepth_S; //12 imagingDepth_S
 
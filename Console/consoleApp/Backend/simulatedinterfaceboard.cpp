@@ -0,0 +1,134 @@
+#include "simulatedinterfaceboard.h"
+#include <QMutexLocker>
+#include <QThread>
+
+SimulatedInterfaceBoard::SimulatedInterfaceBoard()
+{
+    m_clock.start();
+
+    // Typical responses of a powered board with a sled attached
+    m_script.insert("ghv", "ghv=2.0 ACK");
+    m_script.insert("gfv", "gfv=1.7 ACK");
+    m_script.insert("gsv", "gsv=120.0 ACK");
+    m_script.insert("gvo", "gvo=1 ACK");
+    m_script.insert("gv",  "gv=3.2_sim ACK");
+}
+
+void SimulatedInterfaceBoard::setResponse(const QByteArray &command, const QByteArray &response)
+{
+    QMutexLocker lock(&m_mutex);
+    m_script.insert(command, response);
+}
+
+void SimulatedInterfaceBoard::setLatency_ms(int latency_ms)
+{
+    QMutexLocker lock(&m_mutex);
+    m_latency_ms = latency_ms;
+}
+
+bool SimulatedInterfaceBoard::write(const QByteArray &bytes)
+{
+    QMutexLocker lock(&m_mutex);
+
+    // Commands are answered one after the other, like the board's UART loop
+    qint64 readyAt_ms = m_pending.isEmpty() ? m_clock.elapsed() : m_pending.last().readyAt_ms;
+
+    for(const auto& command : bytes.split('\r')){
+        if(!command.isEmpty()){
+            readyAt_ms += m_latency_ms;
+            m_pending.enqueue(PendingResponse_t{readyAt_ms, respondTo(command) + "\r\n"});
+        }
+    }
+    m_responseQueued.wakeAll();
+    return true;
+}
+
+QByteArray SimulatedInterfaceBoard::read()
+{
+    QMutexLocker lock(&m_mutex);
+    QByteArray data;
+
+    while(!m_pending.isEmpty() && m_pending.head().readyAt_ms <= m_clock.elapsed()){
+        data.append(m_pending.dequeue().bytes);
+    }
+    return data;
+}
+
+bool SimulatedInterfaceBoard::waitForData(int timeout_ms)
+{
+    QMutexLocker lock(&m_mutex);
+    const qint64 deadline_ms = m_clock.elapsed() + timeout_ms;
+
+    while(m_clock.elapsed() < deadline_ms){
+        if(m_pending.isEmpty()){
+            m_responseQueued.wait(&m_mutex, ulong(deadline_ms - m_clock.elapsed()));
+            continue;
+        }
+
+        const qint64 wait_ms = m_pending.head().readyAt_ms - m_clock.elapsed();
+        if(wait_ms <= 0){
+            return true;
+        }
+        lock.unlock();
+        QThread::msleep(ulong(qMin(wait_ms, deadline_ms - m_clock.elapsed())));
+        lock.relock();
+    }
+    return !m_pending.isEmpty() && (m_pending.head().readyAt_ms <= m_clock.elapsed());
+}
+
+void SimulatedInterfaceBoard::purge()
+{
+    QMutexLocker lock(&m_mutex);
+
+    // Only responses already "on the wire" are dropped
+    while(!m_pending.isEmpty() && m_pending.head().readyAt_ms <= m_clock.elapsed()){
+        m_pending.dequeue();
+    }
+}
+
+bool SimulatedInterfaceBoard::setBitMode(UCHAR bits)
+{
+    QMutexLocker lock(&m_mutex);
+    m_bits = bits;
+    return true;
+}
+
+bool SimulatedInterfaceBoard::getBitMode(UCHAR &bits)
+{
+    QMutexLocker lock(&m_mutex);
+    bits = m_bits;
+    return true;
+}
+
+/*
+ * Scripted responses win; otherwise the sled run and direction commands update the state
+ * reported by "gr", and everything else is acknowledged. Called with m_mutex held.
+ */
+QByteArray SimulatedInterfaceBoard::respondTo(const QByteArray &command)
+{
+    QByteArray longestMatch;
+
+    for(auto it = m_script.constBegin(); it != m_script.constEnd(); ++it){
+        if(command.startsWith(it.key()) && (it.key().size() > longestMatch.size()) &&
+           (command == it.key() || !QChar(command.at(it.key().size())).isLetter())){
+            longestMatch = it.key();
+        }
+    }
+    if(!longestMatch.isEmpty()){
+        return m_script.value(longestMatch);
+    }
+
+    if(command == "sr0"){
+        m_runningState = 0;
+    } else if(command == "sr1"){
+        m_runningState = m_isClockwise ? 1 : 3;
+    } else if(command == "sd0" || command == "sd1"){
+        m_isClockwise = (command == "sd1");
+        if(m_runningState != 0){
+            m_runningState = m_isClockwise ? 1 : 3;
+        }
+    } else if(command == "gr"){
+        return QByteArray("gr=") + QByteArray::number(m_runningState) + " ACK";
+    }
+    return "ACK";
+}
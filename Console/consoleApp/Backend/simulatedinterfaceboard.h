@@ -0,0 +1,65 @@
+#ifndef SIMULATEDINTERFACEBOARD_H
+#define SIMULATEDINTERFACEBOARD_H
+
+#include "interfacecommandchannel.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+/*
+* Software stand-in for the L300 interface board and sled. It answers the board's serial
+* commands after a configurable latency so the command channel can be exercised and its
+* latency measured without hardware. Responses can be scripted per command.
+*/
+class SimulatedInterfaceBoard : public InterfaceTransport
+{
+public:
+    SimulatedInterfaceBoard();
+
+    /*
+     * Scripts the response to a command
+     *
+     * @param command
+     *      Command without the trailing carriage return; also matches commands that take a
+     *      value, e.g. "ss" matches "ss1200".
+     * @param response
+     *      Response line without the line terminator.
+     */
+    void setResponse(const QByteArray& command, const QByteArray& response);
+
+    /*
+     * Time between receiving a command and its response becoming readable
+     */
+    void setLatency_ms(int latency_ms);
+
+    bool write(const QByteArray& bytes) override;
+    QByteArray read() override;
+    bool waitForData(int timeout_ms) override;
+    void purge() override;
+    bool setBitMode(UCHAR bits) override;
+    bool getBitMode(UCHAR& bits) override;
+
+private:
+    struct PendingResponse_t
+    {
+        qint64 readyAt_ms;
+        QByteArray bytes;
+    };
+
+    QByteArray respondTo(const QByteArray& command);
+
+    QMutex m_mutex;
+    QWaitCondition m_responseQueued;
+    QElapsedTimer m_clock;
+    QHash<QByteArray, QByteArray> m_script;
+    QQueue<PendingResponse_t> m_pending;
+    int m_latency_ms{20};
+    int m_runningState{0};
+    bool m_isClockwise{true};
+    UCHAR m_bits{0};
+};
+
+#endif // SIMULATEDINTERFACEBOARD_H
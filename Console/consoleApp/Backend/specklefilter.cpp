@@ -0,0 +1,240 @@
+#include "specklefilter.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SPECKLE_FILTER_SSE2 1
+#endif
+
+// MSVC takes AVX2 intrinsics without /arch:AVX2; the CPU is checked before they are used
+#if defined(_M_X64) || defined(__AVX2__)
+#include <immintrin.h>
+#define SPECKLE_FILTER_AVX2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace{
+const int MaxRadius = 2;
+
+inline size_t wrapLine( long long line, size_t numberOfLines )
+{
+    const long long count = (long long)( numberOfLines );
+    return size_t( ( ( line % count ) + count ) % count );
+}
+
+/*
+ * The same median networks for a sample or a vector of them: median of 3 in 4 min/max,
+ * median of 5 in 10
+ */
+struct ScalarOps
+{
+    typedef uint8_t V;
+    static const size_t Width = 1;
+    static V load( const uint8_t* p ) { return *p; }
+    static void store( uint8_t* p, V v ) { *p = v; }
+    static V min( V a, V b ) { return std::min( a, b ); }
+    static V max( V a, V b ) { return std::max( a, b ); }
+};
+
+#if SPECKLE_FILTER_SSE2
+struct Sse2Ops
+{
+    typedef __m128i V;
+    static const size_t Width = 16;
+    static V load( const uint8_t* p ) { return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) ); }
+    static void store( uint8_t* p, V v ) { _mm_storeu_si128( reinterpret_cast<__m128i*>( p ), v ); }
+    static V min( V a, V b ) { return _mm_min_epu8( a, b ); }
+    static V max( V a, V b ) { return _mm_max_epu8( a, b ); }
+};
+#endif
+
+#if SPECKLE_FILTER_AVX2
+struct Avx2Ops
+{
+    typedef __m256i V;
+    static const size_t Width = 32;
+    static V load( const uint8_t* p ) { return _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) ); }
+    static void store( uint8_t* p, V v ) { _mm256_storeu_si256( reinterpret_cast<__m256i*>( p ), v ); }
+    static V min( V a, V b ) { return _mm256_min_epu8( a, b ); }
+    static V max( V a, V b ) { return _mm256_max_epu8( a, b ); }
+};
+#endif
+
+template<class Ops>
+typename Ops::V median3( typename Ops::V a, typename Ops::V b, typename Ops::V c )
+{
+    return Ops::max( Ops::min( a, b ), Ops::min( Ops::max( a, b ), c ) );
+}
+
+template<class Ops>
+typename Ops::V median5( typename Ops::V a, typename Ops::V b, typename Ops::V c, typename Ops::V d, typename Ops::V e )
+{
+    return median3<Ops>( e, Ops::max( Ops::min( a, b ), Ops::min( c, d ) ), Ops::min( Ops::max( a, b ), Ops::max( c, d ) ) );
+}
+
+/*
+ * Medians across the lines in rows, from sample `from` while a whole vector fits before `to`.
+ * Returns the first sample not done.
+ */
+template<class Ops>
+size_t medianAcross( const uint8_t* const* rows, int radius, size_t from, size_t to, uint8_t* dst )
+{
+    size_t sample = from;
+    for( ; sample + Ops::Width <= to; sample += Ops::Width )
+    {
+        const typename Ops::V value = ( radius == 1 ) ?
+            median3<Ops>( Ops::load( rows[ 0 ] + sample ), Ops::load( rows[ 1 ] + sample ), Ops::load( rows[ 2 ] + sample ) ) :
+            median5<Ops>( Ops::load( rows[ 0 ] + sample ), Ops::load( rows[ 1 ] + sample ), Ops::load( rows[ 2 ] + sample ),
+                          Ops::load( rows[ 3 ] + sample ), Ops::load( rows[ 4 ] + sample ) );
+        Ops::store( dst + sample, value );
+    }
+    return sample;
+}
+
+/*
+ * Medians along a line; src[ sample + i ], i in [ -radius, radius ], is the window of a sample
+ */
+template<class Ops>
+size_t medianAlong( const uint8_t* src, int radius, size_t from, size_t to, uint8_t* dst )
+{
+    size_t sample = from;
+    for( ; sample + Ops::Width <= to; sample += Ops::Width )
+    {
+        const uint8_t* window = src + sample - radius;
+        const typename Ops::V value = ( radius == 1 ) ?
+            median3<Ops>( Ops::load( window ), Ops::load( window + 1 ), Ops::load( window + 2 ) ) :
+            median5<Ops>( Ops::load( window ), Ops::load( window + 1 ), Ops::load( window + 2 ),
+                          Ops::load( window + 3 ), Ops::load( window + 4 ) );
+        Ops::store( dst + sample, value );
+    }
+    return sample;
+}
+
+/*
+ * One line at a time: the medians across lines go to a line buffer padded with its end
+ * samples, then the medians along it go straight to the output. Each input line is read
+ * 2 * radius + 1 times while it is still in the cache.
+ */
+template<class Ops>
+void filterLines( const uint8_t* in, size_t numberOfLines, size_t lineLength, uint8_t* out, int radius )
+{
+    std::vector<uint8_t> across( lineLength + 2 * MaxRadius );
+    uint8_t* centre = across.data() + MaxRadius;
+    const uint8_t* rows[ 2 * MaxRadius + 1 ];
+
+    for( size_t line = 0; line < numberOfLines; line++ )
+    {
+        for( int tap = 0; tap <= 2 * radius; tap++ )
+        {
+            rows[ tap ] = in + wrapLine( (long long)( line ) + tap - radius, numberOfLines ) * lineLength;
+        }
+        const size_t done = medianAcross<Ops>( rows, radius, 0, lineLength, centre );
+        medianAcross<ScalarOps>( rows, radius, done, lineLength, centre );
+        for( int pad = 1; pad <= radius; pad++ )
+        {
+            centre[ -pad ] = centre[ 0 ];
+            centre[ lineLength - 1 + pad ] = centre[ lineLength - 1 ];
+        }
+
+        uint8_t* outLine = out + line * lineLength;
+        const size_t alongDone = medianAlong<Ops>( centre, radius, 0, lineLength, outLine );
+        medianAlong<ScalarOps>( centre, radius, alongDone, lineLength, outLine );
+    }
+}
+}
+
+SpeckleFilter::Mode SpeckleFilter::modeFromSetting( const QString &setting )
+{
+    const QString name = setting.trimmed().toLower();
+    if( name == "fast" )
+    {
+        return Mode::Fast;
+    }
+    if( name == "quality" )
+    {
+        return Mode::Quality;
+    }
+    return Mode::Off;
+}
+
+QString SpeckleFilter::modeName( Mode mode )
+{
+    switch( mode )
+    {
+    case Mode::Fast:
+        return "fast";
+    case Mode::Quality:
+        return "quality";
+    default:
+        return "off";
+    }
+}
+
+int SpeckleFilter::radius( Mode mode )
+{
+    switch( mode )
+    {
+    case Mode::Fast:
+        return 1;
+    case Mode::Quality:
+        return MaxRadius;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * isAvx2Supported
+ *
+ * The CPU has AVX2 and the OS saves the YMM registers.
+ */
+bool SpeckleFilter::isAvx2Supported()
+{
+#if SPECKLE_FILTER_AVX2 && defined(_MSC_VER)
+    static const bool isSupported = []()
+    {
+        int info[ 4 ] = { 0 };
+        __cpuid( info, 1 );
+        const bool isOsSavingYmm = ( info[ 2 ] & ( 1 << 27 ) ) && ( ( _xgetbv( 0 ) & 0x6 ) == 0x6 );
+        __cpuidex( info, 7, 0 );
+        return isOsSavingYmm && ( info[ 1 ] & ( 1 << 5 ) );
+    }();
+    return isSupported;
+#elif SPECKLE_FILTER_AVX2
+    return __builtin_cpu_supports( "avx2" );
+#else
+    return false;
+#endif
+}
+
+void SpeckleFilter::filter( const uint8_t *in, size_t numberOfLines, size_t lineLength, uint8_t *out, Mode mode )
+{
+#if SPECKLE_FILTER_AVX2
+    const int filterRadius = radius( mode );
+    if( filterRadius && numberOfLines && isAvx2Supported() )
+    {
+        filterLines<Avx2Ops>( in, numberOfLines, lineLength, out, filterRadius );
+        return;
+    }
+#endif
+    filterSse2( in, numberOfLines, lineLength, out, mode );
+}
+
+void SpeckleFilter::filterSse2( const uint8_t *in, size_t numberOfLines, size_t lineLength, uint8_t *out, Mode mode )
+{
+    const int filterRadius = radius( mode );
+    if( !filterRadius || !numberOfLines )
+    {
+        std::copy( in, in + numberOfLines * lineLength, out );
+        return;
+    }
+#if SPECKLE_FILTER_SSE2
+    filterLines<Sse2Ops>( in, numberOfLines, lineLength, out, filterRadius );
+#else
+    filterLines<ScalarOps>( in, numberOfLines, lineLength, out, filterRadius );
+#endif
+}
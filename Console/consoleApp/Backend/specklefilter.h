@@ -0,0 +1,42 @@
+#ifndef SPECKLEFILTER_H
+#define SPECKLEFILTER_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Edge-preserving speckle reduction of the polar frame, ahead of the frame average and the warp.
+*
+* A separable median: each sample becomes the median, along the A-line, of the medians across
+* neighbouring lines. Lines wrap around (a frame is one revolution); samples past either end
+* of a line repeat the end sample. speckleFilter.cl does exactly the same, so the CPU and
+* OpenCL paths give identical frames.
+*/
+class SpeckleFilter
+{
+public:
+    enum class Mode
+    {
+        Off,
+        Fast,       // 3 x 3
+        Quality     // 5 x 5; smooths more speckle, still keeps plaque edges
+    };
+    static Mode modeFromSetting( const QString& setting );
+    static QString modeName( Mode mode );
+
+    // Samples (and lines) either side of the centre
+    static int radius( Mode mode );
+
+    /*
+     * Filters numberOfLines lines of lineLength samples from in to out, which must not overlap.
+     * Uses AVX2 when the CPU has it, SSE2 otherwise.
+     */
+    static void filter( const uint8_t* in, size_t numberOfLines, size_t lineLength, uint8_t* out, Mode mode );
+
+    // For the benchmark: the same without AVX2
+    static void filterSse2( const uint8_t* in, size_t numberOfLines, size_t lineLength, uint8_t* out, Mode mode );
+    static bool isAvx2Supported();
+};
+
+#endif // SPECKLEFILTER_H
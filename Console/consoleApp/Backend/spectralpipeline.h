@@ -0,0 +1,70 @@
+#ifndef SPECTRALPIPELINE_H
+#define SPECTRALPIPELINE_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Host side spectral processing of raw fringes, for when the Axsun FPGA is bypassed:
+* k-linear resampling, window, real FFT and log magnitude to 8 bits.
+*
+* Each A-line of RAW_ALINE_LENGTH samples becomes FFT_DATA_SIZE polar samples, the same
+* layout the FPGA delivers, so everything downstream (averaging, warp) is unchanged.
+* The OpenCL version of the same steps lives in ScanConversion (rescale.cl, fft.cl, postfft.cl).
+*/
+class SpectralPipeline
+{
+public:
+    enum class Backend
+    {
+        Fpga,   // the DAQ delivers 8-bit A-lines; nothing to do here
+        OpenCL,
+        Cpu
+    };
+    static Backend backendFromSetting( const QString& setting );
+    static QString backendName( Backend backend );
+
+    SpectralPipeline();
+
+    /*
+     * Resampling points from RescalingData.csv (see DSP::loadRescalingData) and the window
+     */
+    void setRescaling( const std::vector<float>& wholeSamples, const std::vector<float>& fractionalSamples,
+                       const std::vector<float>& window );
+
+    /*
+     * Converts a frame of fringes to log magnitude A-lines; spread over the global thread pool
+     *
+     * @param scaleFactor, dcNoiseLevel
+     *      8-bit mapping, log10(|X|^2) * scaleFactor - dcNoiseLevel, as in postfft.cl
+     */
+    void process( const uint16_t* fringes, size_t numberOfLines, uint8_t* polar,
+                  float scaleFactor, float dcNoiseLevel ) const;
+
+    // Tables as used, for the OpenCL path
+    const std::vector<int>& wholeSamples() const;
+    const std::vector<float>& fractionalSamples() const;
+    const std::vector<float>& window() const;
+
+private:
+    // A-lines transformed together, one per SIMD lane
+    static const int LinesPerBatch = 4;
+
+    void processBatch( const uint16_t* fringes, int numberOfLines, uint8_t* polar,
+                       float scaleFactor, float dcNoiseLevel ) const;
+
+    std::vector<int>   m_wholeSamples;
+    std::vector<float> m_fractionalSamples;
+    std::vector<float> m_window;
+
+    // The real FFT of N samples is a complex FFT of N/2 points plus a split step
+    std::vector<uint16_t> m_bitReversed;
+    std::vector<float>    m_fftCos;
+    std::vector<float>    m_fftSin;
+    std::vector<float>    m_splitCos;
+    std::vector<float>    m_splitSin;
+};
+
+#endif // SPECTRALPIPELINE_H
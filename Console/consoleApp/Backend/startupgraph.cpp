@@ -0,0 +1,260 @@
+#include "startupgraph.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+#include "logger.h"
+
+namespace{
+// Start-up steps are mostly I/O or driver bound; a few run side by side
+const int MaxConcurrentSteps = 4;
+}
+
+StartupGraph* StartupGraph::m_instance{nullptr};
+
+StartupGraph *StartupGraph::instance()
+{
+    if(!m_instance){
+        m_instance = new StartupGraph();
+    }
+    return m_instance;
+}
+
+StartupGraph::StartupGraph(QObject *parent) : QObject(parent)
+{
+    // The clock starts with the application, not with the first step
+    m_clock.start();
+    m_pool.setMaxThreadCount(MaxConcurrentSteps);
+}
+
+void StartupGraph::addStep(const QString &name, const QStringList &dependsOn, std::function<bool ()> step, int maxAttempts, int retryDelay_ms)
+{
+    QMutexLocker lock(&m_mutex);
+
+    Step_t newStep;
+    newStep.dependsOn = dependsOn;
+    newStep.run = step;
+    newStep.maxAttempts = qMax(1, maxAttempts);
+    newStep.retryDelay_ms = retryDelay_ms;
+
+    m_steps.insert(name, newStep);
+    m_order.append(name);
+}
+
+void StartupGraph::addExternalStep(const QString &name, const QStringList &dependsOn)
+{
+    QMutexLocker lock(&m_mutex);
+
+    Step_t newStep;
+    newStep.dependsOn = dependsOn;
+    newStep.isExternal = true;
+
+    m_steps.insert(name, newStep);
+    m_order.append(name);
+}
+
+void StartupGraph::start()
+{
+    QMutexLocker lock(&m_mutex);
+
+    LOG1(m_steps.size())
+    m_isStarted = true;
+    launchReadySteps();
+}
+
+bool StartupGraph::waitFor(const QString &name)
+{
+    QMutexLocker lock(&m_mutex);
+
+    if(!m_steps.contains(name)){
+        return true;
+    }
+    while(m_steps[name].state != StepState::Done){
+        m_stepDone.wait(&m_mutex);
+    }
+    return m_steps[name].success;
+}
+
+void StartupGraph::recordTiming(const QString &name, qint64 elapsed_ms, bool success)
+{
+    bool isStepFinished{false};
+    {
+        QMutexLocker lock(&m_mutex);
+
+        const bool isExternal = m_steps.contains(name) && m_steps[name].isExternal;
+        isStepFinished = isExternal && (m_steps[name].state != StepState::Done);
+
+        Step_t step;
+        step.isExternal = isExternal;
+        step.state = StepState::Done;
+        step.success = success;
+        step.attempts = 1;
+        step.started_ms = m_clock.elapsed() - elapsed_ms;
+        step.elapsed_ms = elapsed_ms;
+
+        if(!m_steps.contains(name)){
+            m_order.append(name);
+        } else {
+            step.dependsOn = m_steps[name].dependsOn;
+        }
+        m_steps.insert(name, step);
+        LOG3(name, elapsed_ms, success)
+
+        if(isStepFinished){
+            m_stepDone.wakeAll();
+            launchReadySteps();
+        }
+    }
+    if(isStepFinished){
+        emit stepFinished(name, success, elapsed_ms);
+    }
+}
+
+void StartupGraph::markFirstImage()
+{
+    qint64 firstImage_ms{-1};
+    {
+        QMutexLocker lock(&m_mutex);
+        if(m_firstImage_ms >= 0){
+            return;
+        }
+        m_firstImage_ms = m_clock.elapsed();
+        firstImage_ms = m_firstImage_ms;
+        LOG( INFO, reportLocked() )
+    }
+    emit firstImageDisplayed(firstImage_ms);
+}
+
+QString StartupGraph::report()
+{
+    QMutexLocker lock(&m_mutex);
+    return reportLocked();
+}
+
+/*
+ * One line per step in registration order: start offset, duration, attempts and result.
+ */
+QString StartupGraph::reportLocked() const
+{
+    QString text("Start-up timing report (ms since application start)");
+
+    for(const auto& name : m_order){
+        const Step_t& step = m_steps[name];
+        if(step.state == StepState::Done){
+            text += QString("\n  %1: start %2, took %3, attempts %4, %5")
+                    .arg(name, -22).arg(step.started_ms, 6).arg(step.elapsed_ms, 6).arg(step.attempts)
+                    .arg(step.success ? "ok" : "FAILED");
+        } else {
+            text += QString("\n  %1: %2").arg(name, -22).arg(step.state == StepState::Running ? "running" : "waiting");
+        }
+    }
+    if(m_firstImage_ms >= 0){
+        text += QString("\n  Time to first image: %1").arg(m_firstImage_ms);
+    }
+    return text;
+}
+
+/*
+ * Starts every waiting step whose dependencies are done; a step with a failed dependency is
+ * finished as failed without running. Called with m_mutex held.
+ */
+void StartupGraph::launchReadySteps()
+{
+    if(!m_isStarted){
+        return;
+    }
+
+    bool isChanged{true};
+    while(isChanged){
+        isChanged = false;
+        for(const auto& name : m_order){
+            Step_t& step = m_steps[name];
+            if(step.state != StepState::Waiting){
+                continue;
+            }
+
+            bool isReady{true};
+            bool hasFailedDependency{false};
+            for(const auto& dependency : step.dependsOn){
+                const auto it = m_steps.constFind(dependency);
+                if(it == m_steps.constEnd()){
+                    continue;
+                }
+                if(it->state != StepState::Done){
+                    isReady = false;
+                } else if(!it->success){
+                    hasFailedDependency = true;
+                }
+            }
+
+            if(hasFailedDependency && isReady){
+                step.state = StepState::Done;
+                step.success = false;
+                step.started_ms = m_clock.elapsed();
+                LOG( WARNING, QString( "Start-up step %1 skipped, a dependency failed" ).arg( name ) )
+                m_stepDone.wakeAll();
+                isChanged = true;
+            } else if(isReady){
+                step.state = StepState::Running;
+                step.started_ms = m_clock.elapsed();
+                if(!step.isExternal){
+                    QtConcurrent::run(&m_pool, [this, name]() { runStep(name); });
+                }
+            }
+        }
+    }
+
+    bool isAllDone{true};
+    bool isAllOk{true};
+    for(const auto& step : m_steps){
+        isAllDone = isAllDone && (step.state == StepState::Done);
+        isAllOk = isAllOk && step.success;
+    }
+    if(isAllDone){
+        m_isStarted = false;
+        LOG( INFO, reportLocked() )
+        QMetaObject::invokeMethod(this, [this, isAllOk]() { emit finished(isAllOk); }, Qt::QueuedConnection);
+    }
+}
+
+/*
+ * Runs on the pool; the step function is called without the lock held.
+ */
+void StartupGraph::runStep(const QString &name)
+{
+    std::function<bool()> run;
+    int maxAttempts{1};
+    int retryDelay_ms{0};
+    {
+        QMutexLocker lock(&m_mutex);
+        run = m_steps[name].run;
+        maxAttempts = m_steps[name].maxAttempts;
+        retryDelay_ms = m_steps[name].retryDelay_ms;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool success{false};
+    int attempts{0};
+
+    while(!success && (attempts < maxAttempts)){
+        if(attempts > 0){
+            LOG2(name, attempts)
+            QThread::msleep(ulong(retryDelay_ms));
+        }
+        attempts++;
+        success = run();
+    }
+
+    qint64 elapsed_ms = timer.elapsed();
+    {
+        QMutexLocker lock(&m_mutex);
+        Step_t& step = m_steps[name];
+        step.state = StepState::Done;
+        step.success = success;
+        step.attempts = attempts;
+        step.elapsed_ms = elapsed_ms;
+        m_stepDone.wakeAll();
+        launchReadySteps();
+    }
+    emit stepFinished(name, success, elapsed_ms);
+}
@@ -0,0 +1,104 @@
+#ifndef STARTUPGRAPH_H
+#define STARTUPGRAPH_H
+
+#include <functional>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+/*
+* StartupGraph runs the application's start-up steps as a dependency graph. Steps whose
+* dependencies are met run concurrently on a private pool, failing steps are retried a bounded
+* number of times, and every step's time is logged in a report. Code that needs the result of
+* a step waits for it with waitFor(). The time from start-up to the first displayed image is
+* logged as well, so it can be tracked from release to release.
+*/
+class StartupGraph : public QObject
+{
+    Q_OBJECT
+
+public:
+    static StartupGraph* instance();
+
+    /*
+     * Registers a step; must be called before start()
+     *
+     * @param dependsOn
+     *      Steps that must succeed first. If one fails, this step is not run and fails too.
+     * @param maxAttempts
+     *      Total number of tries before the step is reported as failed.
+     */
+    void addStep(const QString& name, const QStringList& dependsOn, std::function<bool()> step,
+                 int maxAttempts = 1, int retryDelay_ms = 0);
+
+    /*
+     * Registers a step that runs outside the graph (e.g. the DAQ discovery, which starts once a
+     * device is selected). recordTiming() finishes it; other steps may depend on it as usual.
+     */
+    void addExternalStep(const QString& name, const QStringList& dependsOn);
+
+    void start();
+
+    /*
+     * Blocks until the step has finished; steps that were never registered count as done
+     *
+     * @return True if the step succeeded
+     */
+    bool waitFor(const QString& name);
+
+    /*
+     * Finishes an external step, or adds an unregistered one to the report
+     */
+    void recordTiming(const QString& name, qint64 elapsed_ms, bool success = true);
+
+    /*
+     * Called when the first image is displayed; only the first call is recorded
+     */
+    void markFirstImage();
+
+    QString report();
+
+signals:
+    void stepFinished(const QString& name, bool success, qint64 elapsed_ms);
+    void finished(bool success);
+    void firstImageDisplayed(qint64 elapsed_ms);
+
+private:
+    enum class StepState { Waiting, Running, Done };
+
+    struct Step_t
+    {
+        QStringList dependsOn;
+        std::function<bool()> run;
+        int maxAttempts{1};
+        int retryDelay_ms{0};
+        bool isExternal{false};
+        StepState state{StepState::Waiting};
+        bool success{false};
+        int attempts{0};
+        qint64 started_ms{0};
+        qint64 elapsed_ms{0};
+    };
+
+    explicit StartupGraph(QObject *parent = nullptr);
+    void launchReadySteps();
+    void runStep(const QString& name);
+    QString reportLocked() const;
+
+    static StartupGraph* m_instance;
+
+    QMutex m_mutex;
+    QWaitCondition m_stepDone;
+    QMap<QString, Step_t> m_steps;
+    QStringList m_order;
+    QThreadPool m_pool;
+    QElapsedTimer m_clock;
+    qint64 m_firstImage_ms{-1};
+    bool m_isStarted{false};
+};
+
+#endif // STARTUPGRAPH_H
@@ -0,0 +1,178 @@
+/*
+ * sessiondatabasetest.cpp
+ *
+ * Unit test for the session database: rows written on the database thread
+ * are committed by the time their futures finish, and ids are handed out
+ * in order, across bursts of writes and after the database is reopened.
+ *
+ * Every test opens a database in a temporary directory of its own.
+ */
+
+#include "sessiondatabase.h"
+#include "sessiondatabasetest.h"
+#include "userSettings.h"
+#include "util.h"
+
+#include <QDateTime>
+
+// Read back through a connection of our own, as the review and export screens do
+const QString ReaderConnectionName( "sessionDatabaseTestReader" );
+
+void sessionDatabaseTest::initTestCase()
+{
+  if ( !QSqlDatabase::drivers().contains( "QSQLITE" ) ) {
+    QSKIP( "No SQLite driver" );
+  }
+  QVERIFY( idleDir.isValid() );
+  caseDir = nullptr;
+}
+
+void sessionDatabaseTest::init()
+{
+  caseDir = new QTemporaryDir();
+  QVERIFY( caseDir->isValid() );
+  openDir( caseDir->path() );
+}
+
+void sessionDatabaseTest::cleanup()
+{
+  // The writer only lets go of a database when it opens another
+  openDir( idleDir.path() );
+
+  delete caseDir;
+  caseDir = nullptr;
+}
+
+/*
+ * openDir
+ *
+ * Open the session database kept in dir.
+ */
+void sessionDatabaseTest::openDir( const QString &dir )
+{
+  sessionDatabase db;
+  QVERIFY( !db.initSessionDb( dir ).isValid() );
+  currentDbName = dir + "/" + SessionDatabaseFileName;
+}
+
+/*
+ * readValue
+ *
+ * First column of the first row, or an invalid QVariant.
+ */
+QVariant sessionDatabaseTest::readValue( const QString &sql )
+{
+  QVariant value;
+  {
+    QSqlDatabase reader = QSqlDatabase::addDatabase( "QSQLITE", ReaderConnectionName );
+    reader.setDatabaseName( currentDbName );
+    if ( reader.open() ) {
+      QSqlQuery q( reader );
+      if ( q.exec( sql ) && q.next() ) {
+        value = q.value( 0 );
+      }
+    }
+    reader.close();
+  }
+  QSqlDatabase::removeDatabase( ReaderConnectionName );
+  return value;
+}
+
+void sessionDatabaseTest::testCaptures()
+{
+  sessionDatabase db;
+  const uint now = QDateTime::currentDateTime().toTime_t();
+
+  QFuture<int> first  = db.addCapture( "tag1", now, "img-001", "Pantheris", 100 );
+  QFuture<int> second = db.addCapture( "tag2", now, "img-002", "Pantheris", 100 );
+  QCOMPARE( first.result(), 1 );
+  QCOMPARE( second.result(), 2 );
+  QCOMPARE( db.getNumCaptures(), 2 );
+
+  // A finished future means the row is committed and visible to other connections
+  db.updateCaptureTag( 2, "renamed" ).waitForFinished();
+  QCOMPARE( readValue( "SELECT tag FROM captures WHERE id = 2" ).toString(), QString( "renamed" ) );
+  QCOMPARE( readValue( "SELECT COUNT(*) FROM captures" ).toInt(), 2 );
+}
+
+void sessionDatabaseTest::testClips()
+{
+  sessionDatabase db;
+  const uint now = QDateTime::currentDateTime().toTime_t();
+
+  const int clipId = db.addClipCapture( "clip-001", now, "thumbs", "Pantheris" ).result();
+  QCOMPARE( clipId, 1 );
+
+  // The length is only known once recording stops
+  QCOMPARE( readValue( "SELECT length_ms FROM octLoops WHERE id = 1" ).toInt(), 0 );
+  db.updateClipCapture( clipId, 1500 ).waitForFinished();
+  db.updateLoopTag( clipId, "loop tag" ).waitForFinished();
+
+  sessionDatabase::LoopStat stat = db.getLoopsStats();
+  QCOMPARE( stat.numLoops, 1 );
+  QCOMPARE( stat.totLength, 1500 );
+  QCOMPARE( readValue( "SELECT tag FROM octLoops WHERE id = 1" ).toString(), QString( "loop tag" ) );
+}
+
+void sessionDatabaseTest::testSession()
+{
+  sessionDatabase db;
+  caseInfo &info = caseInfo::Instance();
+  info.setDoctor( "Dr. Test" );
+  info.setNotes( "first" );
+
+  db.createSession().waitForFinished();
+  QCOMPARE( readValue( "SELECT doctor FROM session" ).toString(), QString( "Dr. Test" ) );
+  QCOMPARE( readValue( "SELECT cleanExit FROM session" ).toBool(), false );
+  QCOMPARE( readValue( "SELECT COUNT(*) FROM version" ).toInt(), 3 );
+
+  info.setNotes( "second" );
+  db.updateSession().waitForFinished();
+  QCOMPARE( readValue( "SELECT notes FROM session" ).toString(), QString( "second" ) );
+
+  db.markExitAsClean().waitForFinished();
+  QCOMPARE( readValue( "SELECT cleanExit FROM session" ).toBool(), true );
+}
+
+void sessionDatabaseTest::testBurstOfWrites()
+{
+  sessionDatabase db;
+  const uint now = QDateTime::currentDateTime().toTime_t();
+  const int numCaptures( 100 );
+
+  // More than one commit's worth, posted without waiting
+  QList< QFuture<int> > futures;
+  for ( int i = 0; i < numCaptures; i++ ) {
+    futures.append( db.addCapture( QString( "tag%1" ).arg( i ), now, QString( "img-%1" ).arg( i ), "Pantheris", 100 ) );
+  }
+
+  for ( int i = 0; i < numCaptures; i++ ) {
+    QCOMPARE( futures[ i ].result(), i + 1 );
+  }
+  QCOMPARE( readValue( "SELECT COUNT(*) FROM captures" ).toInt(), numCaptures );
+  QCOMPARE( readValue( "SELECT MAX(id) FROM captures" ).toInt(), numCaptures );
+}
+
+void sessionDatabaseTest::testIdsAfterReopen()
+{
+  const uint now = QDateTime::currentDateTime().toTime_t();
+  {
+    sessionDatabase db;
+    QCOMPARE( db.addCapture( "tag", now, "img-001", "Pantheris", 100 ).result(), 1 );
+    QCOMPARE( db.addCapture( "tag", now, "img-002", "Pantheris", 100 ).result(), 2 );
+    QCOMPARE( db.addClipCapture( "clip-001", now, "thumbs", "Pantheris" ).result(), 1 );
+  }
+
+  // Switch away and back: the next ids come from the tables, not from memory
+  QTemporaryDir otherDir;
+  QVERIFY( otherDir.isValid() );
+  openDir( otherDir.path() );
+  openDir( caseDir->path() );
+
+  sessionDatabase db;
+  QCOMPARE( db.addCapture( "tag", now, "img-003", "Pantheris", 100 ).result(), 3 );
+  QCOMPARE( db.addClipCapture( "clip-002", now, "thumbs", "Pantheris" ).result(), 2 );
+  QCOMPARE( db.getNumCaptures(), 3 );
+}
+
+QTEST_MAIN(sessionDatabaseTest)
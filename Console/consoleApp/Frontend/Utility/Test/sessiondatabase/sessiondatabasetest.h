@@ -0,0 +1,32 @@
+/*
+ * sessiondatabasetest.h
+ *
+ * Unit test for the session database.
+ */
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+class sessionDatabaseTest: public QObject
+{
+  Q_OBJECT
+
+    private slots:
+  void initTestCase();
+  void init();
+  void cleanup();
+
+  void testCaptures();
+  void testClips();
+  void testSession();
+  void testBurstOfWrites();
+  void testIdsAfterReopen();
+
+    private:
+  void openDir( const QString &dir );
+  QVariant readValue( const QString &sql );
+
+  QTemporaryDir  idleDir;
+  QTemporaryDir *caseDir;
+  QString        currentDbName;
+};
@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = sessiondatabasetest
+DESTDIR = .
+CONFIG += qtestlib
+QT += sql xml
+INCLUDEPATH += ../../ ../../../../../../Common/Include
+DEPENDPATH += .
+HEADERS += sessiondatabasetest.h ../../sessiondatabase.h ../../../../../../Common/Include/util.h
+SOURCES += sessiondatabasetest.cpp stubs.cpp ../../sessiondatabase.cpp ../../../../Backend/Tests/stubs/logger.cpp
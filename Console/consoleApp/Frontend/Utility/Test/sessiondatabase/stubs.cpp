@@ -0,0 +1,48 @@
+/*
+ * stubs.cpp
+ *
+ * The case information and error handler used by the session database,
+ * without the GUI behind them.
+ */
+
+#include <QDebug>
+#include "userSettings.h"
+#include "util.h"
+
+caseInfo* caseInfo::theInfo{nullptr};
+
+caseInfo &caseInfo::Instance() {
+
+    if(!theInfo){
+        theInfo = new caseInfo();
+    }
+    return *theInfo;
+}
+
+errorHandler* errorHandler::theHandler{nullptr};
+
+errorHandler &errorHandler::Instance() {
+    if(!theHandler){
+        theHandler = new errorHandler();
+    }
+    return *theHandler;
+}
+
+void errorHandler::fail( QString errString, bool fatal ) {
+    qWarning() << "fail:" << errString << fatal;
+    emit failure( errString, fatal );
+}
+
+void errorHandler::warn( QString warnString ) {
+    qWarning() << "warn:" << warnString;
+    emit warning( warnString );
+}
+
+errorHandler::errorHandler() {}
+
+errorHandler::~errorHandler() {}
+
+void displayFailureMessage( QString errString, bool fatal )
+{
+    qWarning() << "failure:" << errString << fatal;
+}
@@ -15,6 +15,7 @@
 #include "styledmessagebox.h"
 #include <QDateTime>
 #include <QDir>
+#include <QFutureWatcher>
 #include "Utility/sessiondatabase.h"
 #include "logger.h"
 
@@ -121,8 +122,11 @@ captureListModel &captureListModel::Instance()
  *
  * Add a new capture to the database, including
  * all associated data and file reference location.
+ * The database write runs on its own thread; the
+ * item is added to the model once its id is known.
+ * Failure warnings are generated by the database.
  */
-int captureListModel::addCapture(QString tag,
+void captureListModel::addCapture(QString tag,
                                   uint timestamp,
                                   QString name,
                                   QString deviceName,
@@ -131,32 +135,38 @@ int captureListModel::addCapture(QString tag,
 {
 
     QDateTime timeVal = QDateTime::fromTime_t(timestamp);
-    // Find next available ID
     sessionDatabase db;
-    db.initSessionDb();
-    int maxID = db.addCapture( tag, timestamp, name, deviceName, pixelsPerMm );
-    if( maxID < 0 )
+
+    auto *watcher = new QFutureWatcher<int>( this );
+    connect( watcher, &QFutureWatcher<int>::finished, this,
+             [this, watcher, timeVal, tag, name, deviceName, pixelsPerMm, zoomFactor]()
     {
-        return -1;
-    }
+        const int maxID = watcher->result();
+        watcher->deleteLater();
+
+        if( maxID < 0 )
+        {
+            return;
+        }
 
-    // Update the model for the list view for the film strip of images
-    QModelIndex root = index(0, 0, QModelIndex() );
-    beginInsertRows( root, rowCount( root ), rowCount( root ) );
-
-    // Add the item to the in memory cache
-    captureItem *cap = new captureItem();
-    cap->setdbKey( maxID );
-    cap->setTag( tag );
-    cap->setTimestamp( timeVal.toString( "yyyy-MM-dd HH:mm:ss" ) ); // use local time in the tool tip
-    cap->setName( name );
-    cap->setIdNumber( maxID );
-    cap->setDeviceName( deviceName );
-    cap->setPixelsPerMm( pixelsPerMm );
-    cap->setZoomFactor( zoomFactor );
-    itemMap.insert( maxID, cap );
-    endInsertRows();
-    return maxID;
+        // Update the model for the list view for the film strip of images
+        QModelIndex root = index(0, 0, QModelIndex() );
+        beginInsertRows( root, rowCount( root ), rowCount( root ) );
+
+        // Add the item to the in memory cache
+        captureItem *cap = new captureItem();
+        cap->setdbKey( maxID );
+        cap->setTag( tag );
+        cap->setTimestamp( timeVal.toString( "yyyy-MM-dd HH:mm:ss" ) ); // use local time in the tool tip
+        cap->setName( name );
+        cap->setIdNumber( maxID );
+        cap->setDeviceName( deviceName );
+        cap->setPixelsPerMm( pixelsPerMm );
+        cap->setZoomFactor( zoomFactor );
+        itemMap.insert( maxID, cap );
+        endInsertRows();
+    } );
+    watcher->setFuture( db.addCapture( tag, timestamp, name, deviceName, pixelsPerMm ) );
 }
 
 int captureListModel::countOfCapuredItems() const
@@ -180,6 +190,28 @@ int captureListModel::getLastCaptureId( void )
 }
 
 
+/*
+ * sectorThumbnailFile()
+ *
+ * Full path of the thumbnail written for this capture.
+ */
+QString captureItem::sectorThumbnailFile( void ) const
+{
+    caseInfo &info = caseInfo::Instance();
+    return( info.getStorageDir() + "/captures/.thumb_" + name + ".png" );
+}
+
+/*
+ * decoratedImageFile()
+ *
+ * Full path of the decorated (annotated) image for this capture.
+ */
+QString captureItem::decoratedImageFile( void ) const
+{
+    caseInfo &info = caseInfo::Instance();
+    return( info.getStorageDir() + "/captures/" + name + ".png" );
+}
+
 /*
  * loadImage()
  *
@@ -102,6 +102,8 @@ public:
     // XXX: do not like wildcarding based on the base name
     QImage loadSector( QString name ) { return( loadImage( name + "*" + ".png" ) ); }
     QImage loadSectorThumbnail( QString name ) { return( loadImage( ".thumb_" + name + "*" + ".png" ) ); }
+    QString sectorThumbnailFile( void ) const;
+    QString decoratedImageFile( void ) const;
     QImage loadDecoratedImage( QString name ) { return( loadImage( name + "*" + ".png" ) ); }
     void replaceDecoratedImage( QImage p ) { saveDecoratedImage( p, name + ".png" ); }
 
@@ -147,12 +149,12 @@ public:
     // singleton
     static captureListModel & Instance(void);
 
-    int addCapture( QString tag,
-                    uint timestamp,
-                    QString name,
-                    QString deviceName,
-                    int pixelsPerMm,
-                    float zoomFactor );
+    void addCapture( QString tag,
+                     uint timestamp,
+                     QString name,
+                     QString deviceName,
+                     int pixelsPerMm,
+                     float zoomFactor );
 
     QList<captureItem *> getItemsByTag(QString tag);
     QList<captureItem *> getItemsByDate(QString date);
@@ -4,7 +4,8 @@
  * The capture machine object handles all file and database
  * operations for image captures. It provides the model
  * and abstraction layer for dealing with the current
- * set of captures.
+ * set of captures. Decoration and encoding run on a small
+ * thread pool so burst captures do not wait on each other.
  *
  * No patient information is written to the capture images.
  *
@@ -16,20 +17,33 @@
 #include "captureListModel.h"
 #include "defaults.h"
 #include "userSettings.h"
+#include "sawFile.h"
+#include <QBuffer>
 #include <QDateTime>
 #include <QDir>
 #include <QPainter>
 #include <QFontMetrics>
+#include <QtConcurrent/QtConcurrent>
 
 #include "logger.h"
 #include "Utility/octFrameRecorder.h"
 
+// PNG "quality" 85 selects zlib level 1 in Qt: much faster than the default
+// level and a fraction of the size of the uncompressed files quality 100 wrote.
+const int CapturePngQuality = 85;
+
+// Captures in flight at once; each also encodes its thumbnail in parallel
+const int MaxCaptureThreads = 4;
+
 /*
  * constructor
  */
 captureMachine::captureMachine()
 {
-    currCaptureNumber = 0;
+    currCaptureNumber   = 0;
+    nextCaptureSequence = 0;
+    nextPublishSequence = 0;
+    captureThreadPool.setMaxThreadCount( qMax( 2, qMin( MaxCaptureThreads, QThread::idealThreadCount() ) ) );
 
     // Connect model signals
     LOG1(currCaptureNumber)
@@ -37,6 +51,16 @@ captureMachine::captureMachine()
     connect( &capList, SIGNAL( warning( QString ) ), this, SIGNAL( warning( QString ) ) );
 }
 
+/*
+ * destructor
+ *
+ * Let captures in flight finish writing their files.
+ */
+captureMachine::~captureMachine()
+{
+    captureThreadPool.waitForDone();
+}
+
 // TBD: merge capture and clipCapture.  eliminate duplicate code!  See #470.
 
 
@@ -58,48 +82,139 @@ void captureMachine::imageCapture( QImage decoratedImage, QImage sector, QString
     c.pixelsPerMm    = pixelsPerMm;
     c.zoomFactor     = zoomFactor;
 
-    mutex.lock();
-    captureQ.enqueue( c );
-    runThreadQ.enqueue( true );
-    mutex.unlock();
+    dispatchImageCapture( c, nullptr );
+}
 
-    if( !isRunning() )
+/*
+ * renderedImageCapture()
+ *
+ * The image is rendered on the capture pool, then decorated and stored as any other.
+ */
+void captureMachine::renderedImageCapture( std::function<QImage()> render, QString tagText, unsigned int timestamp, int pixelsPerMm, float zoomFactor )
+{
+    CaptureItem_t c;
+
+    c.tagText        = tagText;
+    c.timestamp      = timestamp;
+    c.pixelsPerMm    = pixelsPerMm;
+    c.zoomFactor     = zoomFactor;
+
+    dispatchImageCapture( c, render );
+}
+
+/*
+ * dispatchImageCapture
+ *
+ * Name the capture and hand it to the pool, rendering it there first when asked to.
+ */
+void captureMachine::dispatchImageCapture( CaptureItem_t c, std::function<QImage()> render )
+{
+    // Names and time stamps are assigned here, in the order captures are taken
+    c.imageName      = generateImageName();
+    c.timeStampText  = QDateTime::currentDateTime().toUTC().toString( "hh:mm:ss" );
+
+    prepareDecorations();
+
+    const int sequence = nextCaptureSequence++;
+    const Decorations_t decor = decorations;
+
+    QtConcurrent::run( &captureThreadPool, [this, c, render, decor, sequence]() mutable
     {
-        // kick-off the thread
-        start();
-    }
+        if( render )
+        {
+            c.decoratedImage  = render();
+            c.decorationScale = c.decoratedImage.width() / ( SectorWidth_px * IMAGE_SCALE_FACTOR );
+        }
+        if( !c.decoratedImage.isNull() )
+        {
+            processImageCapture( c, decor );
+        }
+
+        // Model and database updates stay on the thread that owns the model
+        QMetaObject::invokeMethod( this, [this, c, sequence]() { captureComplete( sequence, c ); }, Qt::QueuedConnection );
+    } );
 }
 
 /*
  * processCapture
  *
- * Paint session data on the image and store it to disk.
+ * Paint session data on the image and store it to disk. Runs on the
+ * capture thread pool.
  */
-void captureMachine::processImageCapture( CaptureItem_t captureItem )
+void captureMachine::processImageCapture( CaptureItem_t captureItem, Decorations_t decor )
 {
-
-    QString imageName = generateImageName();
+    const QString imageName = captureItem.imageName;
 
     // Paint the decorated image
     QPainter painter;
     QImage decoratedImage( captureItem.decoratedImage.convertToFormat( QImage::Format_RGB32 ) ); // Can't paint on 8-bit
     painter.begin( &decoratedImage );
+    painter.scale( captureItem.decorationScale, captureItem.decorationScale );
 
-    addTimeStamp(painter);
+    addTimeStamp(painter, captureItem.timeStampText);
     addFileName(painter,imageName);
-    addCatheterName(painter);
-    addLogo(painter);
+    addCatheterName(painter, decor);
+    addLogo(painter, decor);
 
     painter.end();
 
-    // Store the capture
+    // Store the capture; the thumbnail is scaled and encoded alongside the full image
+    QFuture<void> thumbnail = QtConcurrent::run( &captureThreadPool, [this, decoratedImage, imageName]()
+    {
+        saveThumbnail(decoratedImage, imageName);
+    } );
     saveImage(decoratedImage, imageName);
-    saveThumbnail(decoratedImage, imageName);
+    thumbnail.waitForFinished();
+}
 
-    // add to the model
-    addCaptureToTheModel(captureItem, imageName);
+/*
+ * captureComplete
+ *
+ * Add finished captures to the model in the order they were taken.
+ */
+void captureMachine::captureComplete( int sequence, CaptureItem_t captureItem )
+{
+    completedCaptures.insert( sequence, captureItem );
+
+    while( completedCaptures.contains( nextPublishSequence ) )
+    {
+        const CaptureItem_t done = completedCaptures.take( nextPublishSequence++ );
+        if( done.decoratedImage.isNull() )
+        {
+            LOG( WARNING, QString( "Capture - %1 could not be rendered" ).arg( done.imageName ) )
+            emit warning( tr( "Image capture failed" ) );
+            continue;
+        }
+
+        addCaptureToTheModel( done, done.imageName );
 
-    LOG( INFO, QString( "Capture - %1" ).arg( imageName ) )
+        LOG( INFO, QString( "Capture - %1" ).arg( done.imageName ) )
+    }
+}
+
+/*
+ * prepareDecorations
+ *
+ * Load and scale the logo once, and split the catheter name whenever the
+ * device changes. Called on the GUI thread before a capture is dispatched.
+ */
+void captureMachine::prepareDecorations()
+{
+    if( decorations.logo.isNull() )
+    {
+        const QImage logoImage( ":/octConsole/captureLogo.png" );
+        const int scale{360};
+
+        decorations.logo     = logoImage.scaledToWidth( scale, Qt::SmoothTransformation );
+        decorations.clipLogo = logoImage.scaledToWidth( int( double(scale) / IMAGE_SCALE_FACTOR ), Qt::SmoothTransformation );
+    }
+
+    auto device = deviceSettings::Instance().current();
+    if( device && ( device->getDeviceName() != decorations.deviceName ) )
+    {
+        decorations.deviceName    = device->getDeviceName();
+        decorations.catheterNames = device->getSplitDeviceName().split( "\n" );
+    }
 }
 
 
@@ -109,7 +224,7 @@ void captureMachine::processImageCapture( CaptureItem_t captureItem )
  * Given the sector image (and procedure data TBD),
  * add the images to the file archive and the database.
  */
-void captureMachine::clipCapture( QImage sector, QString strClipNumber, unsigned int timestamp )
+void captureMachine::clipCapture( QImage sector, QString strClipNumber, unsigned int timestamp, bool isWarpThumbnail )
 {
     // create the item to put on the queue for processing
     ClipItem_t c;
@@ -117,59 +232,77 @@ void captureMachine::clipCapture( QImage sector, QString strClipNumber, unsigned
     c.sectorImage    = sector;
     c.strClipNumber  = strClipNumber;
     c.timestamp      = timestamp;
+    c.timeStampText  = QDateTime::currentDateTime().toUTC().toString( "hh:mm:ss" );
+    c.isWarpThumbnail = isWarpThumbnail;
 
-    LOG2(strClipNumber, timestamp)
+    LOG3(strClipNumber, timestamp, isWarpThumbnail)
 
-    mutex.lock();
-    clipQ.enqueue( c );
-    runThreadQ.enqueue( true );
-    mutex.unlock();
+    // The recorder is told about the clip right away; it is already recording
+    auto* recorder = OctFrameRecorder::instance();
+    recorder->setClipName(c.strClipNumber);
+
+    // Obtain the current timestamp
+    const QDateTime currTime = QDateTime().fromTime_t( c.timestamp );
+    recorder->setTimeStamp(currTime.toString("hh:mm:ss"));
 
-    if( !isRunning() )
+    prepareDecorations();
+
+    const Decorations_t decor = decorations;
+    QtConcurrent::run( &captureThreadPool, [this, c, decor]()
     {
-        // kick-off the thread
-        start();
-    }
+        processLoopRecording( c, decor );
+    } );
 }
 
 /*
  * processClip
  *
- * Paint session data on the image and store it to disk.
+ * Paint session data on the image and store it to disk. Runs on the
+ * capture thread pool.
  */
-void captureMachine::processLoopRecording(ClipItem_t clipItem )
+void captureMachine::processLoopRecording( ClipItem_t clipItem, Decorations_t decor )
 {
     const QString clipFileName = generateClipFileName(clipItem);
 
     const QString clipName{clipItem.strClipNumber};
-    auto* recorder = OctFrameRecorder::instance();
-    recorder->setClipName(clipName);
 
-    // Obtain the current timestamp
-    const QDateTime currTime = QDateTime().fromTime_t( clipItem.timestamp );
-    recorder->setTimeStamp(currTime.toString("hh:mm:ss"));
+    // Build the location directory
+    caseInfo &info = caseInfo::Instance();
+    QString saveDirName = info.getClipsDir();
+    QString saveName =  QString( clipFileName );
+
+    // Store the capture
+    const QString clipThumbNailFileName = saveDirName + "/thumb_" + saveName + ".png";
+    LOG1(clipThumbNailFileName)
+
+    // A thumbnail written by the warp is already gray and the right size
+    if( clipItem.isWarpThumbnail )
+    {
+        if( !saveHashedPng( clipItem.sectorImage, clipThumbNailFileName ) )
+        {
+            LOG( DEBUG, "Loop capture: sector thumbnail capture failed" )
+        }
+        else
+        {
+            emit sendFileToKey( clipThumbNailFileName );
+        }
+        LOG( INFO, "Loop Capture: " + clipFileName )
+        return;
+    }
+
     /*
      * Paint information on the sector image that needs to be visible when reviewed during a case
      */
     QImage secRGB( clipItem.sectorImage.convertToFormat( QImage::Format_RGB32 ) ); // Can't paint on 8-bit
     QPainter painter( &secRGB );
 
-    addLogo(painter, true);
-    addTimeStamp(painter,true);
+    addLogo(painter, decor, true);
+    addTimeStamp(painter, clipItem.timeStampText, true);
     addFileName(painter,clipName, true);
-    addCatheterName(painter,true);
+    addCatheterName(painter, decor, true);
 
     painter.end();
 
-    // Build the location directory
-    caseInfo &info = caseInfo::Instance();
-    QString saveDirName = info.getClipsDir();
-    QString saveName =  QString( clipFileName );
-
-    // Store the capture
-    const QString clipThumbNailFileName = saveDirName + "/thumb_" + saveName + ".png";
-    LOG1(clipThumbNailFileName)
-
     QImage clipThumbNail = secRGB.scaled( ThumbnailHeight_px, ThumbnailWidth_px );
 
     for (int ii = 0; ii < clipThumbNail.width(); ii++) {
@@ -180,7 +313,7 @@ void captureMachine::processLoopRecording(ClipItem_t clipItem )
     }
 
     // save a thumbnail image for the UI to use
-    if( !clipThumbNail.save( clipThumbNailFileName, "PNG", 100 ) )
+    if( !saveHashedPng( clipThumbNail, clipThumbNailFileName ) )
     {
         LOG( DEBUG, "Loop capture: sector thumbnail capture failed" )
     }
@@ -192,16 +325,13 @@ void captureMachine::processLoopRecording(ClipItem_t clipItem )
     LOG( INFO, "Loop Capture: " + clipFileName )
 }
 
-void captureMachine::addTimeStamp(QPainter& painter, bool isClip)
+void captureMachine::addTimeStamp(QPainter& painter, const QString& timeStampTime, bool isClip)
 {
     int nowX{20};
     int firstRow{180};
 
     painter.setPen( QPen( Qt::white ) );
 
-    const auto& now = QDateTime::currentDateTime().toUTC();
-    QString timeStampTime = now.toString("hh:mm:ss");
-
     if(isClip){
         painter.setFont( QFont( "DinPro-regular", 8 ) );
         nowX = 10;
@@ -231,7 +361,7 @@ void captureMachine::addFileName(QPainter &painter, const QString &fn, bool isCl
     LOG2(fnX,fnY)
 }
 
-void captureMachine::addCatheterName(QPainter &painter, bool isClip)
+void captureMachine::addCatheterName(QPainter &painter, const Decorations_t& decor, bool isClip)
 {
     QFont nameFont;
 
@@ -248,10 +378,10 @@ void captureMachine::addCatheterName(QPainter &painter, bool isClip)
     LOG2(nameFont.pointSize(),nameFont.pointSizeF())
     LOG2(qfm.maxWidth(), qfm.height())
 
-    auto device = deviceSettings::Instance().current();
-    auto name = device->getSplitDeviceName();
-
-    QStringList names = name.split("\n");
+    const QStringList& names = decor.catheterNames;
+    if(names.count() < 2){
+        return;
+    }
     QRect rect0 = qfm.tightBoundingRect(names[0]);
     QRect rect1 = qfm.tightBoundingRect(names[1]);
 
@@ -277,23 +407,18 @@ void captureMachine::addCatheterName(QPainter &painter, bool isClip)
     }
 }
 
-void captureMachine::addLogo(QPainter &painter, bool isClip)
+void captureMachine::addLogo(QPainter &painter, const Decorations_t& decor, bool isClip)
 {
     const int logoX0{20};
     const int logoY{20};
-    const QImage logoImage( ":/octConsole/captureLogo.png" );
-    int scale{360};
 
-    if(isClip){
-        scale = double(scale) / IMAGE_SCALE_FACTOR;
-    }
-    const QImage LogoImage = logoImage.scaledToWidth(scale);
-    painter.drawImage( logoX0, logoY, LogoImage );
+    painter.drawImage( logoX0, logoY, isClip ? decor.clipLogo : decor.logo );
 }
 
 QString captureMachine::generateImageName()
 {
-    currCaptureNumber = captureListModel::Instance().countOfCapuredItems();
+    // Captures still in the pool are not in the model yet
+    currCaptureNumber = qMax( currCaptureNumber, captureListModel::Instance().countOfCapuredItems() );
     currCaptureNumber++;
     QString strCaptureNumber = QString( "%1" ).arg( currCaptureNumber);
 
@@ -305,7 +430,7 @@ void captureMachine::saveImage(const QImage&decoratedImage, const QString &image
     caseInfo &info = caseInfo::Instance();
     QString saveDirName = info.getCapturesDir();
     const QString imageFileName = saveDirName + "/"        + imageName + ".png";
-    if( !decoratedImage.save( imageFileName, "PNG", 100 ) )
+    if( !saveHashedPng( decoratedImage, imageFileName ) )
     {
         LOG( DEBUG, "Image Capture: decorated image capture failed" )
     }
@@ -325,7 +450,7 @@ void captureMachine::saveThumbnail(const QImage &decoratedImage, const QString &
     LOG2(thumbNail.width(), thumbNail.height())
     const QString thumbFileName = saveDirName + "/.thumb_" + imageName + ".png";
 
-    if( !thumbNail.save( thumbFileName, "PNG", 100 ) )
+    if( !saveHashedPng( thumbNail, thumbFileName ) )
     {
         LOG( DEBUG, "Image Capture: sector thumbnail capture failed" )
     }
@@ -335,22 +460,38 @@ void captureMachine::saveThumbnail(const QImage &decoratedImage, const QString &
     }
 }
 
+/*
+ * saveHashedPng
+ *
+ * Encode in memory and write through SawFile so the key for the file is
+ * known without reading it back.
+ */
+bool captureMachine::saveHashedPng(const QImage &image, const QString &fileName)
+{
+    QByteArray encoded;
+    QBuffer buffer( &encoded );
+
+    buffer.open( QIODevice::WriteOnly );
+    if( !image.save( &buffer, "PNG", CapturePngQuality ) )
+    {
+        return false;
+    }
+    return SawFile::writeHashed( fileName, encoded );
+}
+
 void captureMachine::addCaptureToTheModel(const captureMachine::CaptureItem_t& captureItem, const QString &imageName)
 {
     const QDateTime currTime = QDateTime::currentDateTime();
     captureListModel &capList = captureListModel::Instance(); // Should have valid caseinfo
     deviceSettings &devSettings = deviceSettings::Instance();
 
-    if( capList.addCapture( captureItem.tagText,
-                            currTime.toTime_t(),
-                            imageName,
-                            devSettings.current()->getDeviceName(),
-                            captureItem.pixelsPerMm,
-                            captureItem.zoomFactor ) < 0 )
-    {
-        LOG1("ERROR")
-        return;   // Failure warnings generated in the call
-    }
+    // Failure warnings are generated by the database
+    capList.addCapture( captureItem.tagText,
+                        currTime.toTime_t(),
+                        imageName,
+                        devSettings.current()->getDeviceName(),
+                        captureItem.pixelsPerMm,
+                        captureItem.zoomFactor );
 }
 
 QString captureMachine::generateClipFileName(const ClipItem_t& clipItem)
@@ -358,45 +499,3 @@ QString captureMachine::generateClipFileName(const ClipItem_t& clipItem)
     return QString ("clip-") + clipItem.strClipNumber;
 }
 
-
-/*
- * run
- *
- * main loop for the thread
- */
-void captureMachine::run( void )
-{
-    /*
-     * Captures and clip captures can occur at almost any time.  The runThread
-     * queue is really an event queue for all capture/clip events so we don't
-     * have to have two threads (one for the clip queue and one for the capture queue).
-     */
-    while( !runThreadQ.empty() )
-    {
-        // process image captures
-        while( !captureQ.empty() )
-        {
-            mutex.lock();
-            CaptureItem_t f = captureQ.dequeue();
-            mutex.unlock();
-
-            processImageCapture( f );
-        }
-
-        // process clip captures
-        while( !clipQ.empty() )
-        {
-            mutex.lock();
-            ClipItem_t clipItem = clipQ.dequeue();
-            LOG1(clipItem.strClipNumber)
-            mutex.unlock();
-
-            processLoopRecording( clipItem );
-        }
-
-        // dequeue and toss the element
-        mutex.lock();
-        runThreadQ.dequeue();
-        mutex.unlock();
-    }
-}
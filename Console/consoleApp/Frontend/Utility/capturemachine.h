@@ -4,7 +4,8 @@
  * The capture machine object handles all file and database
  * operations for image captures. It provides the model
  * and abstraction layer for dealing with the current
- * set of captures.
+ * set of captures. Decoration and encoding run on a small
+ * thread pool so burst captures do not wait on each other.
  *
  * Author: Chris White
  * Copyright (c) 2010-2018 Avinger, Inc.
@@ -13,16 +14,21 @@
 #pragma once
 
 #include <QImage>
-#include <QThread>
-#include <QQueue>
-#include <QMutex>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
 
-class captureMachine : public QThread
+class QPainter;
+
+class captureMachine : public QObject
 {
     Q_OBJECT
 
 public:
     explicit captureMachine();
+    ~captureMachine();
 
 signals:
     void sendFileToKey( QString );
@@ -31,13 +37,19 @@ signals:
 
 public slots:
     void imageCapture( QImage decoratedImage, QImage sector, QString tagText, unsigned int timestamp, int pixelsPerMm, float zoom );
-    void clipCapture( QImage sector, QString strClipNumber, unsigned int timestamp );
+    // isWarpThumbnail: sector is the gray thumbnail the warp wrote and is saved as it is
+    void clipCapture( QImage sector, QString strClipNumber, unsigned int timestamp, bool isWarpThumbnail );
 
-protected:
-    void run();
+public:
+    /*
+     * As imageCapture, but the image is made by render() on the capture pool; the GUI thread
+     * only queues it. Decorations are scaled from the size of a grab of the view to the
+     * width of the rendered image.
+     */
+    void renderedImageCapture( std::function<QImage()> render, QString tagText, unsigned int timestamp, int pixelsPerMm, float zoomFactor );
 
 private:
-    // container for captures to put into a queue
+    // container for captures handed to the worker pool
     struct CaptureItem_t
     {
         QImage decoratedImage;
@@ -46,37 +58,54 @@ private:
         unsigned int timestamp;
         int   pixelsPerMm;
         float zoomFactor;
+        QString imageName;
+        QString timeStampText;
+        double decorationScale{1.0};
     };
 
-    // container for clips to put into a queue
+    // container for clips handed to the worker pool
     struct ClipItem_t
     {
         QImage sectorImage;
         QString strClipNumber;
         unsigned int timestamp;
+        QString timeStampText;
+        bool isWarpThumbnail{false};
     };
 
-    QQueue< CaptureItem_t > captureQ;
-    QQueue< ClipItem_t > clipQ;
+    // Decoration assets, prepared on the GUI thread once per device and
+    // shared read-only by every capture in flight
+    struct Decorations_t
+    {
+        QImage logo;
+        QImage clipLogo;
+        QString deviceName;
+        QStringList catheterNames;
+    };
 
-    // each type enqueues here to keep the thread alive as long as necessary
-    QQueue< bool > runThreadQ;
+    QThreadPool captureThreadPool;
+    Decorations_t decorations;
 
     int currCaptureNumber;
 
-    void processImageCapture(CaptureItem_t captureItem );
-    void processLoopRecording( ClipItem_t clipItem );
-    void addTimeStamp(QPainter& painter, bool isClip = false);
+    // Captures finish in any order but are added to the model in the order taken
+    int nextCaptureSequence;
+    int nextPublishSequence;
+    QMap< int, CaptureItem_t > completedCaptures;
+
+    void dispatchImageCapture( CaptureItem_t captureItem, std::function<QImage()> render );
+    void prepareDecorations();
+    void processImageCapture( CaptureItem_t captureItem, Decorations_t decor );
+    void processLoopRecording( ClipItem_t clipItem, Decorations_t decor );
+    void captureComplete( int sequence, CaptureItem_t captureItem );
+    void addTimeStamp(QPainter& painter, const QString& timeStampText, bool isClip = false);
     void addFileName(QPainter& painter, const QString& fn, bool isClip = false);
-    void addCatheterName(QPainter& painter, bool isClip = false);
-    void addLogo(QPainter& painter, bool isClip = false);
+    void addCatheterName(QPainter& painter, const Decorations_t& decor, bool isClip = false);
+    void addLogo(QPainter& painter, const Decorations_t& decor, bool isClip = false);
     QString generateImageName();
     void saveImage(const QImage &decoratedImage, const QString& imageName);
     void saveThumbnail(const QImage &decoratedImage, const QString& imageName);
+    static bool saveHashedPng(const QImage &image, const QString& fileName);
     void addCaptureToTheModel(const CaptureItem_t &captureItem, const QString& imageName);
     QString generateClipFileName(const ClipItem_t& clipItem);
-
-
-    QMutex mutex;
-
 };
@@ -15,6 +15,7 @@
 #include "styledmessagebox.h"
 #include <QDateTime>
 #include <QDir>
+#include <QFutureWatcher>
 #include "Utility/sessiondatabase.h"
 
 /*
@@ -154,72 +155,104 @@ QVariant clipListModel::data(const QModelIndex &index, int role) const
  *
  * Add a new capture to the database, including
  * all associated data and file reference location.
+ * The database write runs on its own thread; the
+ * item is added to the model once its id is known.
  */
-int clipListModel::addClipCapture(QString name,
+void clipListModel::addClipCapture(QString name,
                                    int timestamp,
                                    QString thumbnailDir,
                                    QString deviceName,
                                    bool /*isHighSpeed*/ )
 {
     QDateTime timeVal = QDateTime::fromTime_t(timestamp);
-
-    // Find next available ID
     sessionDatabase db;
-    db.initSessionDb();
-
-    int maxID = db.addClipCapture( name, timestamp, thumbnailDir, deviceName );
-
-    LOG1(maxID)
-
-    if ( maxID < 0 ) {
-        return -1;
-    }
-
-    lastClipID = maxID;
-
-    // Update the model for the list view for the film strip of images
-    QModelIndex root = index(0, 0, QModelIndex() );
-    beginInsertRows( root, rowCount( root ), rowCount( root ) );
 
-    // Add the item to the in-memory cache
-    clipItem *clip = new clipItem();
-    clip->setdbKey( maxID );
-    clip->setTag( name );
-    clip->setName( name );
-    clip->setTimestamp( timeVal.toString("yyyy-MM-dd HH:mm:ss") ); // use local time in tool tips
-    clip->setLength( 0 ); // length is set after the recording is finished
-    clip->setThumbnailDir( thumbnailDir );
-    clip->setDeviceName( deviceName );
-    itemMap.insert( maxID, clip );
-
-    endInsertRows();
-
-    return maxID;
+    auto *watcher = new QFutureWatcher<int>( this );
+    connect( watcher, &QFutureWatcher<int>::finished, this,
+             [this, watcher, timeVal, name, thumbnailDir, deviceName]()
+    {
+        const int maxID = watcher->result();
+        watcher->deleteLater();
+
+        LOG1(maxID)
+
+        if ( maxID < 0 ) {
+            return;
+        }
+
+        lastClipID = maxID;
+
+        // Update the model for the list view for the film strip of images
+        QModelIndex root = index(0, 0, QModelIndex() );
+        beginInsertRows( root, rowCount( root ), rowCount( root ) );
+
+        // Add the item to the in-memory cache
+        clipItem *clip = new clipItem();
+        clip->setdbKey( maxID );
+        clip->setTag( name );
+        clip->setName( name );
+        clip->setTimestamp( timeVal.toString("yyyy-MM-dd HH:mm:ss") ); // use local time in tool tips
+        clip->setLength( 0 ); // length is set after the recording is finished
+        clip->setThumbnailDir( thumbnailDir );
+        clip->setDeviceName( deviceName );
+        itemMap.insert( maxID, clip );
+
+        endInsertRows();
+    } );
+    lastClipInsert = db.addClipCapture( name, timestamp, thumbnailDir, deviceName );
+    watcher->setFuture( lastClipInsert );
 }
 
 /*
  * updateClipInfo()
  *
  * Update data about the clip that can only be known after
- * the clip is finished recording.
+ * the clip is finished recording. Chained on the insert of
+ * the clip, so it uses the id that insert returned even if
+ * the recording stops before the insert has completed.
  */
 void clipListModel::updateClipInfo( int clipLength_ms )
 {
-    // update the database
-    sessionDatabase db;
-    db.updateClipCapture( lastClipID, clipLength_ms );
-
-    // update the in-memory cache
-    clipItem *clip = new clipItem();
-    clip = itemMap.value( lastClipID );
-    clip->setLength( clipLength_ms );
-
-    // Update the model for the list view for the film strip of images. Inserting
-    // with the same key replaces the item in the list
-    QModelIndex root = index(0, 0, QModelIndex() );
-    beginInsertRows( root, rowCount( root ), rowCount( root ) );
-    itemMap.insert( lastClipID, clip );
-    endInsertRows();
+    if( lastClipInsert.isCanceled() )
+    {
+        // No clip has been added
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<int>( this );
+    connect( watcher, &QFutureWatcher<int>::finished, this,
+             [this, watcher, clipLength_ms]()
+    {
+        const int clipID = watcher->result();
+        watcher->deleteLater();
+
+        if( clipID < 0 )
+        {
+            return;
+        }
+
+        // update the database
+        sessionDatabase db;
+        db.updateClipCapture( clipID, clipLength_ms );
+
+        // The watcher of addClipCapture was connected first, so the clip is in the model by now
+        clipItem *clip = itemMap.value( clipID );
+        if( !clip )
+        {
+            return;
+        }
+
+        // update the in-memory cache
+        clip->setLength( clipLength_ms );
+
+        // Update the model for the list view for the film strip of images. Inserting
+        // with the same key replaces the item in the list
+        QModelIndex root = index(0, 0, QModelIndex() );
+        beginInsertRows( root, rowCount( root ), rowCount( root ) );
+        itemMap.insert( clipID, clip );
+        endInsertRows();
+    } );
+    watcher->setFuture( lastClipInsert );
 }
 
 int clipListModel::countOfClipItems() const
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <QAbstractListModel>
+#include <QFuture>
 #include <QImage>
 #include <QObject>
 
@@ -139,7 +140,7 @@ public:
         return theDB;
     }
 
-    int addClipCapture(QString name,
+    void addClipCapture(QString name,
                         int timestamp,
                         QString thumbnailDir,
                         QString deviceName , bool);
@@ -197,6 +198,7 @@ private:
 
     // used to keep track of the last entry to allow updates when the recording finishes
     int lastClipID;
+    QFuture<int> lastClipInsert;   // the database insert of the last entry; holds its id
 
     // In memory cache of all captures keyed by id.
     // This is so we can do a two-level search for speedup:
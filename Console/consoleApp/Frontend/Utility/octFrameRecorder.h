@@ -49,8 +49,8 @@ private:
     CapUtils::ScreenCapture* m_screenCapture{nullptr};
     QString m_playlistFileName;
     ConcatenateVideo* m_concatenateVideo{nullptr};
-    const int m_width{1024};
-    const int m_height{1024};
+    const int m_width{VideoWidth_px};
+    const int m_height{VideoHeight_px};
 
     QString m_clipName;
     QString m_timeStamp;
@@ -0,0 +1,101 @@
+#include "reviewImageCache.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrent>
+#include "logger.h"
+
+namespace{
+// The selected capture plus its neighbours on either side, with some slack
+const int ReviewCacheEntries = 5;
+const int MaxDecodeThreads = 2;
+}
+
+ReviewImageCache* ReviewImageCache::m_instance{nullptr};
+
+ReviewImageCache *ReviewImageCache::instance()
+{
+    if(!m_instance){
+        m_instance = new ReviewImageCache();
+    }
+    return m_instance;
+}
+
+ReviewImageCache::ReviewImageCache(QObject *parent) : QObject(parent)
+{
+    m_cache.setMaxCost(ReviewCacheEntries);
+    m_decodePool.setMaxThreadCount(MaxDecodeThreads);
+}
+
+/*
+ * image()
+ *
+ * Fill in the cached images and return true, or start decoding and return
+ * false; imageReady() follows once the decode finishes.
+ */
+bool ReviewImageCache::image(const QString &fileName, ReviewImage_t &reviewImage)
+{
+    const QString key = cacheKey(fileName);
+
+    ReviewImage_t* cached = m_cache.object(key);
+    if(cached){
+        reviewImage = *cached;
+        return true;
+    }
+    request(key, fileName);
+    return false;
+}
+
+/*
+ * prefetch()
+ *
+ * Decode a capture that is likely to be selected next.
+ */
+void ReviewImageCache::prefetch(const QString &fileName)
+{
+    const QString key = cacheKey(fileName);
+
+    if(!m_cache.contains(key)){
+        request(key, fileName);
+    }
+}
+
+QString ReviewImageCache::cacheKey(const QString &fileName) const
+{
+    // Decorated images are rewritten in place when a capture is edited
+    const QDateTime modified = QFileInfo(fileName).lastModified();
+
+    return QString("%1|%2").arg(fileName).arg(modified.isValid() ? modified.toMSecsSinceEpoch() : -1);
+}
+
+void ReviewImageCache::request(const QString &key, const QString &fileName)
+{
+    if(m_pending.contains(key)){
+        return;
+    }
+    m_pending.insert(key);
+
+    QtConcurrent::run(&m_decodePool, [this, key, fileName]()
+    {
+        // One decode feeds both resolutions
+        const QImage review = QImage(fileName).scaledToWidth(ReviewWidth_px);
+        const QImage monitor = review.isNull() ? QImage() : review.scaledToWidth(MonitorWidth_px);
+
+        // QPixmap is only created on the GUI thread
+        QMetaObject::invokeMethod(this, [this, key, fileName, review, monitor]() { onDecoded(key, fileName, review, monitor); }, Qt::QueuedConnection);
+    });
+}
+
+void ReviewImageCache::onDecoded(const QString &key, const QString &fileName, const QImage &review, const QImage &monitor)
+{
+    m_pending.remove(key);
+
+    if(review.isNull()){
+        LOG1(fileName)
+        return;
+    }
+
+    ReviewImage_t* reviewImage = new ReviewImage_t{QPixmap::fromImage(review), QPixmap::fromImage(monitor)};
+    m_cache.insert(key, reviewImage, 1);
+
+    emit imageReady(fileName);
+}
@@ -0,0 +1,56 @@
+/*
+ * reviewImageCache.h
+ *
+ * Full-size capture images for the case review screen. Each image is decoded
+ * once on a worker thread and scaled for both the review screen and the
+ * physician monitor; the most recently used images are kept so that paging
+ * back and forth through captures does not reload them.
+ *
+ * Copyright (c) 2018 Avinger, Inc.
+ */
+#ifndef REVIEWIMAGECACHE_H
+#define REVIEWIMAGECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+
+struct ReviewImage_t
+{
+    QPixmap review;     // technician screen
+    QPixmap monitor;    // physician monitor
+};
+
+class ReviewImageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ReviewImageCache* instance();
+
+    static const int ReviewWidth_px  = 1600;
+    static const int MonitorWidth_px = 1000;
+
+    bool image(const QString& fileName, ReviewImage_t& reviewImage);
+    void prefetch(const QString& fileName);
+
+signals:
+    void imageReady(const QString& fileName);
+
+private:
+    explicit ReviewImageCache(QObject *parent = nullptr);
+    QString cacheKey(const QString& fileName) const;
+    void request(const QString& key, const QString& fileName);
+    void onDecoded(const QString& key, const QString& fileName, const QImage& review, const QImage& monitor);
+
+    static ReviewImageCache* m_instance;
+
+    QCache<QString, ReviewImage_t> m_cache;
+    QSet<QString> m_pending;
+    QThreadPool m_decodePool;
+};
+
+#endif // REVIEWIMAGECACHE_H
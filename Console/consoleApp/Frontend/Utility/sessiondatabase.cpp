@@ -12,8 +12,13 @@
 #include "userSettings.h"
 #include "defaults.h"
 #include "util.h"
+#include <QAtomicInt>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QDateTime>
+#include <QFutureInterface>
+#include <QThread>
 #include <logger.h>
 
 // Schema layouts for each table are defined in SDS 0007
@@ -21,71 +26,200 @@
 #define OCT_LOOPS_SCHEMA_VERSION       4
 #define SESSION_SCHEMA_VERSION         3
 
+// Connection owned by the database thread; the default connection is left to other databases
+const QString SessionConnectionName = "sessionWriter";
+
+// Upper bound on the statements grouped into one commit during a burst of writes
+const int MaxStatementsPerCommit = 32;
+
 /*
- * constructor
+ * sessionDatabaseWriter
+ *
+ * Owns the session database connection and the single thread it is used
+ * on. Jobs run in the order they are posted. A transaction is opened by
+ * the first job of a burst and committed once no more jobs are waiting
+ * (or MaxStatementsPerCommit is reached). Row ids are handed out from
+ * memory; the tables are only asked for MAX(id) when the database opens.
+ *
+ * Jobs are queued to the database thread's event loop rather than a thread
+ * pool: waiting on a pool future lets the waiting thread run the job
+ * itself, and the connection must never be used from another thread.
  */
-sessionDatabase::sessionDatabase()
+class sessionDatabaseWriter
 {
-    // Find the database in the patient directory if it
-    // exists, or create a new one.
+public:
+    static sessionDatabaseWriter &Instance()
+    {
+        static sessionDatabaseWriter theWriter;
+        return theWriter;
+    }
 
-    if( !QSqlDatabase::drivers().contains( "QSQLITE" ) )
+    QSqlError open( const QString &name );
+
+    template <typename Job>
+    auto post( Job job ) -> QFuture<decltype( job() )>
     {
-        // TBD:  this should fail earlier.  don't allow app to start up?
-        displayFailureMessage( QObject::tr( "Unable to load database:\nThis application needs the SQLITE driver" ), true );
+        QFutureInterface<decltype( job() )> promise;
+        promise.reportStarted();
+        pendingJobs.ref();
+        QMetaObject::invokeMethod( &context, [this, job, promise]() mutable
+        {
+            run( promise, job );
+        }, Qt::QueuedConnection );
+        return promise.future();
     }
-    initSessionDb();
-}
 
-sessionDatabase::~sessionDatabase()
-{
-}
+    // Only used from jobs, i.e. on the database thread
+    bool isOpen() const { return db.isOpen(); }
+    QSqlQuery &statement( const QString &sql );
+    int nextId( const QString &table ) { return nextIds[ table ]++; }
+
+private:
+    sessionDatabaseWriter()
+    {
+        statementsInTransaction = 0;
+        inTransaction = false;
+        context.moveToThread( &thread );
+        thread.start();
+    }
+    ~sessionDatabaseWriter()
+    {
+        // Queued behind any outstanding jobs, so they all run before the thread stops
+        QMetaObject::invokeMethod( &context, [this]()
+        {
+            close();
+            thread.quit();
+        }, Qt::QueuedConnection );
+        thread.wait();
+    }
+
+    // The transaction is opened before a job runs and committed after the last of a burst;
+    // the result is only reported once the job's statements are committed
+    template <typename Result, typename Job>
+    void run( QFutureInterface<Result> &promise, Job &job )
+    {
+        beginJob();
+        const Result result = job();
+        endJob();
+        promise.reportFinished( &result );
+    }
+    template <typename Job>
+    void run( QFutureInterface<void> &promise, Job &job )
+    {
+        beginJob();
+        job();
+        endJob();
+        promise.reportFinished();
+    }
+
+    QSqlError openOnDatabaseThread( const QString &name );
+    QSqlError createTables( void );
+    int readMaxId( const QString &table );
+    void close( void );
+    void beginJob( void );
+    void endJob( void );
+
+    QThread     thread;
+    QObject     context;    // lives on thread; jobs are queued to it
+    QAtomicInt  pendingJobs;
+
+    // Name of the open database, checked by callers before posting an open
+    QMutex  nameLock;
+    QString openName;
+
+    // Database thread only
+    QSqlDatabase db;
+    QHash<QString, QSqlQuery> statements;
+    QMap<QString, int> nextIds;
+    int  statementsInTransaction;
+    bool inTransaction;
+};
 
 /*
- * initDb()
+ * open
  *
- * Create a new database using the session identifiers
- * specified by the user. Sets up the SQLite file,
- * the schema and tables.
+ * Open (or switch to) the named session database. This waits for the
+ * database thread, but only when the case changes.
  */
-QSqlError sessionDatabase::initSessionDb(void)
+QSqlError sessionDatabaseWriter::open( const QString &name )
 {
-    caseInfo &info = caseInfo::Instance();
-
-    // Not ready yet
-    if( !info.storageValid() )
     {
-        return QSqlError();
+        QMutexLocker locker( &nameLock );
+        if( name == openName )
+        {
+            return QSqlError();
+        }
     }
-    QStringList names = QSqlDatabase::connectionNames();
-    if(!names.isEmpty()){
-        QSqlDatabase::removeDatabase("qt_sql_default_connection");
+
+    QSqlError sqlerr = post( [this, name]() { return openOnDatabaseThread( name ); } ).result();
+    if( !sqlerr.isValid() )
+    {
+        QMutexLocker locker( &nameLock );
+        openName = name;
     }
-    m_dbName = info.getStorageDir().append( "/" ).append( SessionDatabaseFileName );
-    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName( m_dbName );
+    return sqlerr;
+}
 
-    QSqlError sqlerr;
+/*
+ * openOnDatabaseThread
+ */
+QSqlError sessionDatabaseWriter::openOnDatabaseThread( const QString &name )
+{
+    errorHandler &err = errorHandler::Instance();
+
+    close();
+
+    db = QSqlDatabase::addDatabase( "QSQLITE", SessionConnectionName );
+    db.setDatabaseName( name );
 
     if( !db.open() )
     {
-        displayFailureMessage( QObject::tr( "Database error:\nFailed to open capture database for session." ), true );
-        return db.lastError();
+        QSqlError sqlerr = db.lastError();
+        err.fail( QObject::tr( "Database error:\nFailed to open capture database for session." ), true );
+        return sqlerr;
     }
 
-    // Setup the database only in the case
-    // that the tables don't already exist
+    // WAL keeps readers and the writer apart and needs far fewer fsyncs per commit
+    QSqlQuery pragma( db );
+    if( !pragma.exec( QLatin1String( "PRAGMA journal_mode=WAL" ) ) ||
+        !pragma.exec( QLatin1String( "PRAGMA synchronous=NORMAL" ) ) )
+    {
+        LOG( WARNING, QString( "Session database: journal settings failed: %1" ).arg( pragma.lastError().databaseText() ) )
+    }
+
+    QSqlError sqlerr = createTables();
+    if( sqlerr.isValid() )
+    {
+        return sqlerr;
+    }
+
+    nextIds[ "captures" ] = readMaxId( "captures" ) + 1;
+    nextIds[ "octLoops" ] = readMaxId( "octLoops" ) + 1;
+
+    return sqlerr;
+}
+
+/*
+ * createTables
+ *
+ * Sets up the schema and tables, only in the case that the tables don't
+ * already exist.
+ */
+QSqlError sessionDatabaseWriter::createTables( void )
+{
+    errorHandler &err = errorHandler::Instance();
+    QSqlError sqlerr;
     QStringList tables = db.tables();
 
     // Set up the schema version table
     if( !tables.contains( "version", Qt::CaseInsensitive ) )
     {
         // Doesn't exist, create it.
-        QSqlQuery q;
+        QSqlQuery q( db );
         if( !q.exec(QLatin1String("create table version(id integer primary key, tablename varchar, version integer)") ) )
         {
             sqlerr = q.lastError();
-            displayFailureMessage( QObject::tr( "Database Failure:\nFailed to create db schema - version table" ), true );
+            err.fail( QObject::tr( "Database Failure:\nFailed to create db schema - version table" ), true );
             return sqlerr;
         }
     }
@@ -95,11 +229,11 @@ QSqlError sessionDatabase::initSessionDb(void)
     {
 
         // Doesn't exist, create it.
-        QSqlQuery q;
+        QSqlQuery q( db );
         if( !q.exec(QLatin1String("create table captures(id integer primary key, timestamp timestamp, tag varchar, name varchar, deviceName varchar, pixelsPerMm int)") ) )
         {
             sqlerr = q.lastError();
-            displayFailureMessage( QObject::tr( "Database Failure:\nFailed to create db schema - captures table" ), true );
+            err.fail( QObject::tr( "Database Failure:\nFailed to create db schema - captures table" ), true );
             return sqlerr;
         }
     }
@@ -109,11 +243,11 @@ QSqlError sessionDatabase::initSessionDb(void)
     {
 
         // Doesn't exist, create it.
-        QSqlQuery q;
+        QSqlQuery q( db );
         if( !q.exec( QLatin1String( "create table octLoops(id integer primary key, timestamp timestamp, tag varchar, name varchar, length_ms integer, catheterView varchar, deviceName varchar)" ) ) )
         {
             sqlerr = q.lastError();
-            displayFailureMessage( QObject::tr( "Database Failure:\nFailed to create db schema - octLoops table" ), true );
+            err.fail( QObject::tr( "Database Failure:\nFailed to create db schema - octLoops table" ), true );
             return sqlerr;
         }
     }
@@ -123,11 +257,11 @@ QSqlError sessionDatabase::initSessionDb(void)
     {
 
         // Doesn't exist, create it
-        QSqlQuery q;
+        QSqlQuery q( db );
         if( !q.exec(QLatin1String("create table session(caseid varchar primary key, timestamp timestamp, utcOffset integer, patient varchar, doctor varchar, location varchar, notes varchar, cleanExit char)" ) ) )
         {
             sqlerr = q.lastError();
-            displayFailureMessage( QObject::tr( "Database Failure:\nFailed to create db schema - session table" ), true );
+            err.fail( QObject::tr( "Database Failure:\nFailed to create db schema - session table" ), true );
             return sqlerr;
         }
     }
@@ -135,21 +269,171 @@ QSqlError sessionDatabase::initSessionDb(void)
     return sqlerr;
 }
 
+/*
+ * readMaxId
+ *
+ * Largest id in the table, or 0 if it is empty.
+ */
+int sessionDatabaseWriter::readMaxId( const QString &table )
+{
+    QSqlQuery q( db );
+
+    if( !q.exec( QString( "SELECT MAX(id) FROM %1" ).arg( table ) ) || !q.next() )
+    {
+        errorHandler::Instance().warn( QObject::tr( "Database failure:\nFailed to find MAX ID." ) );
+        return 0;
+    }
+    return q.value( 0 ).isNull() ? 0 : q.value( 0 ).toInt();
+}
+
+/*
+ * close
+ */
+void sessionDatabaseWriter::close( void )
+{
+    if( inTransaction )
+    {
+        db.commit();
+        inTransaction = false;
+        statementsInTransaction = 0;
+    }
+
+    // Prepared statements must go before the connection can be removed
+    statements.clear();
+    nextIds.clear();
+
+    if( db.isValid() )
+    {
+        db.close();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase( SessionConnectionName );
+    }
+}
+
+/*
+ * statement
+ *
+ * Prepared statements are kept for the life of the connection.
+ */
+QSqlQuery &sessionDatabaseWriter::statement( const QString &sql )
+{
+    if( !statements.contains( sql ) )
+    {
+        QSqlQuery q( db );
+        if( !q.prepare( sql ) )
+        {
+            LOG( WARNING, QString( "Session database: prepare failed: %1" ).arg( q.lastError().databaseText() ) )
+        }
+        statements.insert( sql, q );
+    }
+    return statements[ sql ];
+}
+
+/*
+ * beginJob
+ */
+void sessionDatabaseWriter::beginJob( void )
+{
+    if( !inTransaction && db.isOpen() )
+    {
+        inTransaction = db.transaction();
+    }
+}
+
+/*
+ * endJob
+ *
+ * Commit once the burst is over, or when the transaction has grown large.
+ */
+void sessionDatabaseWriter::endJob( void )
+{
+    const bool lastPending = !pendingJobs.deref();
+
+    if( inTransaction )
+    {
+        statementsInTransaction++;
+        if( lastPending || ( statementsInTransaction >= MaxStatementsPerCommit ) )
+        {
+            if( !db.commit() )
+            {
+                errorHandler::Instance().warn( QObject::tr( "Database failure:\nFailed to commit session data: " ).append( db.lastError().databaseText() ) );
+            }
+            inTransaction = false;
+            statementsInTransaction = 0;
+        }
+    }
+}
+
+/*
+ * constructor
+ */
+sessionDatabase::sessionDatabase()
+{
+    // Find the database in the patient directory if it
+    // exists, or create a new one.
+
+    if( !QSqlDatabase::drivers().contains( "QSQLITE" ) )
+    {
+        // TBD:  this should fail earlier.  don't allow app to start up?
+        displayFailureMessage( QObject::tr( "Unable to load database:\nThis application needs the SQLITE driver" ), true );
+    }
+    initSessionDb();
+}
+
+sessionDatabase::~sessionDatabase()
+{
+}
+
+/*
+ * initDb()
+ *
+ * Open the database for the current session on the database thread. A new
+ * database is created (SQLite file, schema and tables) the first time a
+ * case directory is used; later calls for the same case return at once.
+ */
+QSqlError sessionDatabase::initSessionDb(void)
+{
+    caseInfo &info = caseInfo::Instance();
+
+    // Not ready yet
+    if( !info.storageValid() )
+    {
+        return QSqlError();
+    }
+    return initSessionDb( info.getStorageDir() );
+}
+
+/*
+ * initSessionDb( storageDir )
+ *
+ * Open the session database kept in storageDir; the case directory unless
+ * a test points it somewhere else.
+ */
+QSqlError sessionDatabase::initSessionDb( const QString &storageDir )
+{
+    m_dbName = QString( storageDir ).append( "/" ).append( SessionDatabaseFileName );
+
+    return sessionDatabaseWriter::Instance().open( m_dbName );
+}
+
 /*
  * populateVersionTable()
  *
  * Populate the version table with the current versions for each table.
+ * Runs on the database thread.
  */
-void sessionDatabase::populateVersionTable( void )
+static void populateVersionTable( sessionDatabaseWriter &writer )
 {
     QMap<QString, int> versionMap;
+    errorHandler &err = errorHandler::Instance();
 
     // map the tables to their current version numbers
     versionMap[ "captures" ] = IMAGE_CAPTURES_SCHEMA_VERSION;
     versionMap[ "octLoops" ] = OCT_LOOPS_SCHEMA_VERSION;
     versionMap[ "session" ]  = SESSION_SCHEMA_VERSION;
 
-    QSqlQuery q;
+    QSqlQuery &q = writer.statement( QString( "INSERT INTO version (tablename, version)"
+                                              "VALUES (?, ?)" ) );
     QSqlError sqlerr;
 
     // Walk the list and add each table to the version table
@@ -158,10 +442,8 @@ void sessionDatabase::populateVersionTable( void )
     {
         i.next();
 
-        q.prepare( QString( "INSERT INTO version (tablename, version)"
-                            "VALUES (?, ?)" ) );
-        q.addBindValue( i.key() );
-        q.addBindValue( i.value() );
+        q.bindValue( 0, i.key() );
+        q.bindValue( 1, i.value() );
 //        LOG2(i.key(), i.value())
 
         q.exec();
@@ -169,7 +451,7 @@ void sessionDatabase::populateVersionTable( void )
         sqlerr = q.lastError();
         if( sqlerr.isValid() )
         {
-            displayFailureMessage( QObject::tr( "Database failure:Failed to INSERT new version data." ), true );
+            err.fail( QObject::tr( "Database failure:Failed to INSERT new version data." ), true );
         }
     }
 }
@@ -180,35 +462,51 @@ void sessionDatabase::populateVersionTable( void )
  * After the database has been set up, insert the session
  * data into the table.
  */
-void sessionDatabase::createSession( void )
+QFuture<void> sessionDatabase::createSession( void )
 {
     caseInfo &info = caseInfo::Instance();
-    QSqlQuery q;
-    QSqlError sqlerr;
-
-    populateVersionTable();
 
     // start time is UTC
-    QString timeStr = QDateTime::currentDateTime().toUTC().toString( "yyyy-MM-dd HH:mm:ss" );
-
-    q.prepare( QString( "INSERT INTO session (caseid, timestamp, utcOffset, patient, doctor, location, notes, cleanExit)"
-                        "VALUES (?, ?, ?, ?, ? ,?, ?, ?)" ) );
-    LOG1(info.getCaseID() )
-    q.addBindValue( info.getCaseID() );
-    q.addBindValue( timeStr );
-    q.addBindValue( info.getUtcOffset() );
-    q.addBindValue( info.getPatientID() );
-    q.addBindValue( info.getDoctor() );
-    q.addBindValue( info.getLocation() );
-    q.addBindValue( info.getNotes() );
-    q.addBindValue( false );
-    q.exec();
-
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
+    const QString timeStr = QDateTime::currentDateTime().toUTC().toString( "yyyy-MM-dd HH:mm:ss" );
+    const QString caseId   = info.getCaseID();
+    const int     utcOffset = info.getUtcOffset();
+    const QString patient  = info.getPatientID();
+    const QString doctor   = info.getDoctor();
+    const QString location = info.getLocation();
+    const QString notes    = info.getNotes();
+
+    LOG1(caseId)
+
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer, timeStr, caseId, utcOffset, patient, doctor, location, notes]()
     {
-        displayFailureMessage( QObject::tr( "Database failure:\nFailed to INSERT new session data." ), true );
-    }
+        errorHandler &err = errorHandler::Instance();
+
+        if( !writer.isOpen() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to INSERT new session data." ) );
+            return;
+        }
+
+        populateVersionTable( writer );
+
+        QSqlQuery &q = writer.statement( QString( "INSERT INTO session (caseid, timestamp, utcOffset, patient, doctor, location, notes, cleanExit)"
+                                                  "VALUES (?, ?, ?, ?, ? ,?, ?, ?)" ) );
+        q.bindValue( 0, caseId );
+        q.bindValue( 1, timeStr );
+        q.bindValue( 2, utcOffset );
+        q.bindValue( 3, patient );
+        q.bindValue( 4, doctor );
+        q.bindValue( 5, location );
+        q.bindValue( 6, notes );
+        q.bindValue( 7, false );
+        q.exec();
+
+        if( q.lastError().isValid() )
+        {
+            err.fail( QObject::tr( "Database failure:\nFailed to INSERT new session data." ), true );
+        }
+    } );
 }
 
 /*
@@ -217,26 +515,33 @@ void sessionDatabase::createSession( void )
  * Anytime the session data has changed, update the
  * session table to reflect the new data.
  */
-void sessionDatabase::updateSession( void )
+QFuture<void> sessionDatabase::updateSession( void )
 {
     caseInfo &info = caseInfo::Instance();
-    errorHandler & err = errorHandler::Instance();
-    QSqlQuery q;
-    QSqlError sqlerr;
+    const QString notes    = info.getNotes();
+    const QString doctor   = info.getDoctor();
+    const QString location = info.getLocation();
+    const QString patient  = info.getPatientID();
 
-    // Note that there is no WHERE clause: all rows in session get updated.
-    q.prepare( "UPDATE session SET notes = :notes, doctor = :doctor, location = :location, patient = :patient" );
-    q.bindValue( ":notes",    info.getNotes() );
-    q.bindValue( ":doctor",   info.getDoctor() );
-    q.bindValue( ":location", info.getLocation() );
-    q.bindValue( ":patient",  info.getPatientID() );
-    q.exec();
-
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer, notes, doctor, location, patient]()
     {
-        err.warn( QObject::tr( "Database failure:\nFailed to UPDATE session data: " ).append( sqlerr.databaseText() ) );
-    }
+        errorHandler & err = errorHandler::Instance();
+
+        // Note that there is no WHERE clause: all rows in session get updated.
+        QSqlQuery &q = writer.statement( "UPDATE session SET notes = :notes, doctor = :doctor, location = :location, patient = :patient" );
+        q.bindValue( ":notes",    notes );
+        q.bindValue( ":doctor",   doctor );
+        q.bindValue( ":location", location );
+        q.bindValue( ":patient",  patient );
+        q.exec();
+
+        QSqlError sqlerr = q.lastError();
+        if( sqlerr.isValid() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to UPDATE session data: " ).append( sqlerr.databaseText() ) );
+        }
+    } );
 }
 
 /*
@@ -246,139 +551,117 @@ void sessionDatabase::updateSession( void )
  * cleanly. Used in homescreen to determine if movie integrity
  * might be compromised.
  */
-void sessionDatabase::markExitAsClean( void )
+QFuture<void> sessionDatabase::markExitAsClean( void )
 {
-    QSqlQuery q;
-    QSqlError sqlerr;
-    errorHandler & err = errorHandler::Instance();
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer]()
+    {
+        errorHandler & err = errorHandler::Instance();
 
-    q.prepare( "UPDATE session SET cleanExit = :value" );
-    q.bindValue( ":value", true );
-    q.exec();
+        QSqlQuery &q = writer.statement( "UPDATE session SET cleanExit = :value" );
+        q.bindValue( ":value", true );
+        q.exec();
 
-    sqlerr = q.lastError();
-    if ( sqlerr.isValid() )
-    {
-        err.warn( QObject::tr("Database failure:\nFailed to UPDATE clean exit flag." ) );
-    }
+        if ( q.lastError().isValid() )
+        {
+            err.warn( QObject::tr("Database failure:\nFailed to UPDATE clean exit flag." ) );
+        }
+    } );
 }
 
 /*
  * addCapture
  */
-int sessionDatabase::addCapture( QString tag,
-                                 uint    timestamp,
-                                 QString name,
-                                 QString deviceName,
-                                 int     pixelsPerMm )
+QFuture<int> sessionDatabase::addCapture( QString tag,
+                                          uint    timestamp,
+                                          QString name,
+                                          QString deviceName,
+                                          int     pixelsPerMm )
 {
-    QSqlQuery q;
-    QSqlError sqlerr;
-    errorHandler & err = errorHandler::Instance();
     QDateTime timeVal = QDateTime::fromTime_t(timestamp);
-    QString timeStr = timeVal.toUTC().toString( "yyyy-MM-dd HH:mm:ss" );
-
-    // Find next available ID
-    int maxID = 0;
-    q.prepare( "SELECT MAX(id) FROM captures" );
+    const QString timeStr = timeVal.toUTC().toString( "yyyy-MM-dd HH:mm:ss" );
 
-    q.exec();
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer, timeStr, tag, name, deviceName, pixelsPerMm]()
     {
-        err.warn( QObject::tr( "Database failure:\nFailed to find MAX ID." ) );
-        return -1;
-    }
-    q.next();
-    QSqlRecord result = q.record();
-    if( result.isNull("MAX(id)") )
-    {
-        maxID = 1;
-    }
-    else
-    {
-        int idCol = result.indexOf( "MAX(id)" );
-        maxID = result.value( idCol ).toInt() + 1;
-    }
+        errorHandler & err = errorHandler::Instance();
 
-    q.prepare( QString("INSERT INTO captures (id, timestamp, tag, name, deviceName, pixelsPerMm)"
-               "VALUES (?, ?, ?, ?, ?, ?)") );
-    LOG2(maxID, timeStr)
-    LOG2(tag, name)
-    LOG2(deviceName,pixelsPerMm)
-    q.addBindValue( maxID );
-    q.addBindValue( timeStr );
-    q.addBindValue( tag) ;
-    q.addBindValue( name );
-    q.addBindValue( deviceName );
-    q.addBindValue( pixelsPerMm );
-    q.exec();
-
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
-    {
-        err.warn( QObject::tr( "Database failure:\nFailed to INSERT new capture." ) );
-        return -1;
-    }
+        if( !writer.isOpen() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to INSERT new capture." ) );
+            return -1;
+        }
+
+        // Next available ID, without asking the table
+        const int maxID = writer.nextId( "captures" );
+
+        QSqlQuery &q = writer.statement( QString("INSERT INTO captures (id, timestamp, tag, name, deviceName, pixelsPerMm)"
+                                                 "VALUES (?, ?, ?, ?, ?, ?)") );
+        LOG2(maxID, timeStr)
+        LOG2(tag, name)
+        LOG2(deviceName,pixelsPerMm)
+        q.bindValue( 0, maxID );
+        q.bindValue( 1, timeStr );
+        q.bindValue( 2, tag) ;
+        q.bindValue( 3, name );
+        q.bindValue( 4, deviceName );
+        q.bindValue( 5, pixelsPerMm );
+        q.exec();
 
-    return maxID;
+        if( q.lastError().isValid() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to INSERT new capture." ) );
+            return -1;
+        }
+
+        return maxID;
+    } );
 }
 
 /*
  * addClipCapture
  */
-int sessionDatabase::addClipCapture(QString name,
-                                     uint    timestamp,
-                                     QString thumbnailDir,
-                                     QString deviceName)
+QFuture<int> sessionDatabase::addClipCapture(QString name,
+                                             uint    timestamp,
+                                             QString thumbnailDir,
+                                             QString deviceName)
 {
-    QSqlQuery q;
-    errorHandler & err = errorHandler::Instance();
-    QSqlError sqlerr;
     QDateTime timeVal = QDateTime::fromTime_t(timestamp);
-    QString timeStr = timeVal.toUTC().toString("yyyy-MM-dd HH:mm:ss");
+    const QString timeStr = timeVal.toUTC().toString("yyyy-MM-dd HH:mm:ss");
 
-    // Find next available ID
-    int maxID = 0;
-    q.prepare( "SELECT MAX(id) FROM octLoops" );
-    q.exec();
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer, timeStr, name, thumbnailDir, deviceName]()
     {
-        err.warn( QObject::tr( "Database failure:\nFailed to find MAX ID." ) );
-        return -1;
-    }
-    q.next();
-    QSqlRecord result = q.record();
-    if( result.isNull( "MAX(id)" ) )
-    {
-        maxID = 1;
-    }
-    else
-    {
-        int idCol = result.indexOf( "MAX(id)" );
-        maxID = result.value( idCol ).toInt() + 1;
-    }
+        errorHandler & err = errorHandler::Instance();
 
-    q.prepare( "INSERT INTO octLoops (id, timestamp, tag, name, length_ms, catheterView, deviceName)"
-               "VALUES (?, ?, ?, ?, ? ,?, ?)" );
-    q.addBindValue( maxID );
-    q.addBindValue( timeStr );
-    q.addBindValue( name );         // Duplicate the name in the tag column by default
-    q.addBindValue( name );         // file name without extension
-    q.addBindValue( 0 );            // placeholder until the loop recording stops
-    q.addBindValue( thumbnailDir );
-    q.addBindValue( deviceName );
-    q.exec();
-
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
-    {
-        err.warn( QObject::tr( "Database failure:\nFailed to INSERT new clip capture." ) );
-        return -1;
-    }
+        if( !writer.isOpen() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to INSERT new clip capture." ) );
+            return -1;
+        }
+
+        // Next available ID, without asking the table
+        const int maxID = writer.nextId( "octLoops" );
+
+        QSqlQuery &q = writer.statement( "INSERT INTO octLoops (id, timestamp, tag, name, length_ms, catheterView, deviceName)"
+                                         "VALUES (?, ?, ?, ?, ? ,?, ?)" );
+        q.bindValue( 0, maxID );
+        q.bindValue( 1, timeStr );
+        q.bindValue( 2, name );         // Duplicate the name in the tag column by default
+        q.bindValue( 3, name );         // file name without extension
+        q.bindValue( 4, 0 );            // placeholder until the loop recording stops
+        q.bindValue( 5, thumbnailDir );
+        q.bindValue( 6, deviceName );
+        q.exec();
+
+        if( q.lastError().isValid() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to INSERT new clip capture." ) );
+            return -1;
+        }
 
-    return maxID;
+        return maxID;
+    } );
 }
 
 /*
@@ -386,23 +669,24 @@ int sessionDatabase::addClipCapture(QString name,
  *
  * Update the recording length of the OCT Loop after recording is finished.
  */
-void sessionDatabase::updateClipCapture( int lastClipID, int clipLength_ms )
+QFuture<void> sessionDatabase::updateClipCapture( int lastClipID, int clipLength_ms )
 {
-    QSqlQuery q;
-    QSqlError sqlerr;
-    errorHandler &err = errorHandler::Instance();
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer, lastClipID, clipLength_ms]()
+    {
+        errorHandler &err = errorHandler::Instance();
 
-    q.prepare( "UPDATE octLoops SET id = :id, length_ms = :value WHERE id = :idToUpdate" );
-    q.bindValue( ":id", lastClipID );
-    q.bindValue( ":value", clipLength_ms );
-    q.bindValue( ":idToUpdate", lastClipID );
-    q.exec();
+        QSqlQuery &q = writer.statement( "UPDATE octLoops SET id = :id, length_ms = :value WHERE id = :idToUpdate" );
+        q.bindValue( ":id", lastClipID );
+        q.bindValue( ":value", clipLength_ms );
+        q.bindValue( ":idToUpdate", lastClipID );
+        q.exec();
 
-    sqlerr = q.lastError();
-    if ( sqlerr.isValid() )
-    {
-        err.warn( QObject::tr("Database failure:\nFailed to UPDATE clip length." ) );
-    }
+        if ( q.lastError().isValid() )
+        {
+            err.warn( QObject::tr("Database failure:\nFailed to UPDATE clip length." ) );
+        }
+    } );
 }
 
 /*
@@ -410,23 +694,24 @@ void sessionDatabase::updateClipCapture( int lastClipID, int clipLength_ms )
  * 
  * Updates the stored tag for a given capture in the session database.
  */
-void sessionDatabase::updateCaptureTag( int key, QString newTag )
+QFuture<void> sessionDatabase::updateCaptureTag( int key, QString newTag )
 {
-    QSqlQuery q;
-    QSqlError sqlerr;
-    errorHandler &err = errorHandler::Instance();
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer, key, newTag]()
+    {
+        errorHandler &err = errorHandler::Instance();
 
-    q.prepare( "UPDATE captures SET id = :id, tag = :value WHERE id = :idToUpdate" );
-    q.bindValue( ":id", key );
-    q.bindValue( ":value", newTag );
-    q.bindValue( ":idToUpdate", key );
-    q.exec();
+        QSqlQuery &q = writer.statement( "UPDATE captures SET id = :id, tag = :value WHERE id = :idToUpdate" );
+        q.bindValue( ":id", key );
+        q.bindValue( ":value", newTag );
+        q.bindValue( ":idToUpdate", key );
+        q.exec();
 
-    sqlerr = q.lastError();
-    if ( sqlerr.isValid() )
-    {
-        err.warn( QObject::tr( "Database failure:\nFailed to UPDATE capture tag." ) );
-    }
+        if ( q.lastError().isValid() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to UPDATE capture tag." ) );
+        }
+    } );
 }
 
 
@@ -435,53 +720,51 @@ void sessionDatabase::updateCaptureTag( int key, QString newTag )
  *
  * Updates the stored tag for a given capture in the session database.
  */
-void sessionDatabase::updateLoopTag( int key, QString newTag )
+QFuture<void> sessionDatabase::updateLoopTag( int key, QString newTag )
 {
-    QSqlQuery q;
-    QSqlError sqlerr;
-    errorHandler &err = errorHandler::Instance();
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    return writer.post( [&writer, key, newTag]()
+    {
+        errorHandler &err = errorHandler::Instance();
 
-    q.prepare( "UPDATE octLoops SET id = :id, tag = :value WHERE id = :idToUpdate" );
-    q.bindValue( ":id", key );
-    q.bindValue( ":value", newTag );
-    q.bindValue( ":idToUpdate", key );
-    q.exec();
+        QSqlQuery &q = writer.statement( "UPDATE octLoops SET id = :id, tag = :value WHERE id = :idToUpdate" );
+        q.bindValue( ":id", key );
+        q.bindValue( ":value", newTag );
+        q.bindValue( ":idToUpdate", key );
+        q.exec();
 
-    sqlerr = q.lastError();
-    if ( sqlerr.isValid() )
-    {
-        err.warn( QObject::tr( "Database failure:\nFailed to UPDATE loop tag." ) );
-    }
+        if ( q.lastError().isValid() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to UPDATE loop tag." ) );
+        }
+    } );
 }
 
 /*
  * getNumCaptures
  *
- * Query captures table in the session database.
+ * Query captures table in the session database. Waits for any queued writes.
  */
 int sessionDatabase::getNumCaptures()
 {
-    QSqlQuery q;
-    QSqlError sqlerr;
-    errorHandler &err = errorHandler::Instance();
-
-    q.prepare( "SELECT * from CAPTURES" );
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    const int numCaptures = writer.post( [&writer]()
+    {
+        errorHandler &err = errorHandler::Instance();
 
-   // Select count (*) is more straightforward, but QT does not seem to have the API to get the result.
-   // q.prepare( "SELECT COUNT (*) from CAPTURES" );
-    q.exec();
+        QSqlQuery &q = writer.statement( "SELECT COUNT(*) FROM captures" );
+        q.exec();
 
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
-    {
-        err.warn( QObject::tr( "Database failure:\nFailed to query captures." ) );
-    }
+        if( q.lastError().isValid() || !q.next() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to query captures." ) );
+            return 0;
+        }
+        const int count = q.value( 0 ).toInt();
+        q.finish();
+        return count;
+    } ).result();
 
-    int numCaptures = 0;
-    while( q.next() )
-    {
-        numCaptures++;
-    }
     qDebug() << "Total number of captures: " << numCaptures;
 
     return numCaptures;
@@ -490,36 +773,32 @@ int sessionDatabase::getNumCaptures()
 /*
  * GetLoopsStats
  *
- * Query octloops table to get statistics in the session database.
+ * Query octloops table to get statistics in the session database. Waits
+ * for any queued writes.
  */
 sessionDatabase::LoopStat sessionDatabase::getLoopsStats()
 {
-    QSqlQuery q;
-    QSqlError sqlerr;
-    errorHandler &err = errorHandler::Instance();
-
-    q.prepare( "SELECT * from OCTLOOPS" );
-    q.exec();
-
-    sqlerr = q.lastError();
-    if( sqlerr.isValid() )
+    sessionDatabaseWriter &writer = sessionDatabaseWriter::Instance();
+    LoopStat loopStat = writer.post( [&writer]()
     {
-        err.warn( QObject::tr( "Database failure:\nFailed to query OCTLoops." ) );
-    }
+        errorHandler &err = errorHandler::Instance();
+        LoopStat stat;
+        stat.numLoops = 0;
+        stat.totLength = 0;
 
-    QSqlRecord rec;
-    rec = q.record();
-
-    LoopStat loopStat;
-    loopStat.numLoops = 0;
-    loopStat.totLength = 0;
+        QSqlQuery &q = writer.statement( "SELECT COUNT(*), TOTAL(length_ms) FROM octLoops" );
+        q.exec();
 
-    int nameCol = rec.indexOf( "length_ms" );
-    while( q.next() )
-    {
-         loopStat.numLoops++;
-         loopStat.totLength += q.value( nameCol ).toInt();
-    }
+        if( q.lastError().isValid() || !q.next() )
+        {
+            err.warn( QObject::tr( "Database failure:\nFailed to query OCTLoops." ) );
+            return stat;
+        }
+        stat.numLoops  = q.value( 0 ).toInt();
+        stat.totLength = q.value( 1 ).toInt();
+        q.finish();
+        return stat;
+    } ).result();
 
     qDebug() << "Total number of loops: " << loopStat.numLoops;
     qDebug() << "Total loop time (ms): " << loopStat.totLength;
@@ -4,6 +4,11 @@
  * Handles all database operations for image captures.  This is a singleton object
  * so it can be used throughout the codebase.
  *
+ * All statements run on a single database thread that owns its own SQLite
+ * connection (WAL journal). Writes return a QFuture so that the GUI and
+ * capture threads never wait on the disk; writes that arrive together are
+ * committed as one transaction.
+ *
  * Author: Dennis W. Jackson
  *
  * Copyright (c) 2011-2018 Avinger, Inc.
@@ -13,6 +18,7 @@
 #define SESSIONDATABASE_H
 
 #include <QtSql>
+#include <QFuture>
 
 class sessionDatabase
 {
@@ -22,25 +28,27 @@ public:
     ~sessionDatabase();
 
     QSqlError initSessionDb(void);
+    QSqlError initSessionDb( const QString &storageDir );
 
-    void createSession(void);
-    void updateSession(void);
-    void markExitAsClean(void);
+    QFuture<void> createSession(void);
+    QFuture<void> updateSession(void);
+    QFuture<void> markExitAsClean(void);
 
-    int addCapture(QString tag,
-                    uint timestamp,
-                    QString name,
-                    QString deviceName,
-                    int pixelsPerMm );
+    // The future holds the id of the new row, or -1 on failure
+    QFuture<int> addCapture(QString tag,
+                            uint timestamp,
+                            QString name,
+                            QString deviceName,
+                            int pixelsPerMm );
 
-    int addClipCapture(QString name,
-                        uint timestamp,
-                        QString thumbnailDir,
-                        QString deviceName);
+    QFuture<int> addClipCapture(QString name,
+                                uint timestamp,
+                                QString thumbnailDir,
+                                QString deviceName);
 
-    void updateClipCapture( int lastClipID, int clipLength_ms );
-    void updateCaptureTag( int key, QString newTag );
-    void updateLoopTag( int key, QString newTag );
+    QFuture<void> updateClipCapture( int lastClipID, int clipLength_ms );
+    QFuture<void> updateCaptureTag( int key, QString newTag );
+    QFuture<void> updateLoopTag( int key, QString newTag );
 
     int getNumCaptures(void);
     struct LoopStat
@@ -49,7 +57,6 @@ public:
         int totLength;
     };
     LoopStat getLoopsStats();
-    void populateVersionTable( void );
 
 private:
 
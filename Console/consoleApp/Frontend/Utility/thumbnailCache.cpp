@@ -0,0 +1,136 @@
+#include "thumbnailCache.h"
+#include <QImage>
+#include <QtConcurrent/QtConcurrent>
+#include "logger.h"
+
+namespace{
+// Roughly 200 thumbnails at 160x160x4 bytes
+const int ThumbnailCacheSize_KB = 20 * 1024;
+const int MaxDecodeThreads = 2;
+const int UnreadableRetry_ms = 1000;
+const QRgb DimmedColor = qRgb(150, 150, 150);
+}
+
+ThumbnailCache* ThumbnailCache::m_instance{nullptr};
+
+ThumbnailCache *ThumbnailCache::instance()
+{
+    if(!m_instance){
+        m_instance = new ThumbnailCache();
+    }
+    return m_instance;
+}
+
+ThumbnailCache::ThumbnailCache(QObject *parent) : QObject(parent)
+{
+    m_cache.setMaxCost(ThumbnailCacheSize_KB);
+    m_decodePool.setMaxThreadCount(MaxDecodeThreads);
+    m_clock.start();
+}
+
+/*
+ * thumbnail()
+ *
+ * Return the cached thumbnail, or a null pixmap and start decoding it.
+ */
+QPixmap ThumbnailCache::thumbnail(const QString &fileName, bool dimmed)
+{
+    const QString key = cacheKey(fileName, dimmed);
+
+    const Entry_t* cached = m_cache.object(key);
+    if(cached && !cached->pixmap.isNull()){
+        return cached->pixmap;
+    }
+    request(key, fileName, dimmed);
+    return QPixmap();
+}
+
+/*
+ * prefetch()
+ *
+ * Start decoding a thumbnail that is likely to be painted soon.
+ */
+void ThumbnailCache::prefetch(const QString &fileName, bool dimmed)
+{
+    request(cacheKey(fileName, dimmed), fileName, dimmed);
+}
+
+QString ThumbnailCache::cacheKey(const QString &fileName, bool dimmed)
+{
+    return dimmed ? fileName + QStringLiteral("|dimmed") : fileName;
+}
+
+/*
+ * request()
+ *
+ * Start a decode unless one is running, the thumbnail is cached, or the
+ * file could not be read a moment ago.
+ */
+void ThumbnailCache::request(const QString &key, const QString &fileName, bool dimmed)
+{
+    if(m_pending.contains(key)){
+        return;
+    }
+    const Entry_t* cached = m_cache.object(key);
+    if(cached && (!cached->pixmap.isNull() || (m_clock.elapsed() - cached->failed_ms < UnreadableRetry_ms))){
+        return;
+    }
+    m_pending.insert(key);
+
+    QtConcurrent::run(&m_decodePool, [this, key, fileName, dimmed]()
+    {
+        const QImage image = decode(fileName, dimmed);
+
+        // QPixmap is only created on the GUI thread
+        QMetaObject::invokeMethod(this, [this, key, fileName, image]() { onDecoded(key, fileName, image); }, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailCache::onDecoded(const QString &key, const QString &fileName, const QImage &image)
+{
+    m_pending.remove(key);
+
+    Entry_t* entry = new Entry_t;
+    if(image.isNull()){
+        // Usually a file that is still being written; tried again after UnreadableRetry_ms
+        entry->failed_ms = m_clock.elapsed();
+        m_cache.insert(key, entry, 1);
+        return;
+    }
+
+    entry->pixmap = QPixmap::fromImage(image);
+    const int cost_KB = qMax(1, entry->pixmap.width() * entry->pixmap.height() * entry->pixmap.depth() / 8 / 1024);
+    m_cache.insert(key, entry, cost_KB);
+
+    emit thumbnailReady(fileName);
+}
+
+/*
+ * decode()
+ *
+ * Load and scale a thumbnail; runs on the decode pool. Dimmed thumbnails
+ * (shown while recording) have their white pixels grayed out.
+ */
+QImage ThumbnailCache::decode(const QString &fileName, bool dimmed)
+{
+    QImage image(fileName);
+
+    if(image.isNull()){
+        LOG1(fileName)
+        return image;
+    }
+
+    image = image.scaled(ThumbnailDisplay_px, ThumbnailDisplay_px).convertToFormat(QImage::Format_RGB32);
+
+    if(dimmed){
+        for(int jj = 0; jj < image.height(); jj++){
+            QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(jj));
+            for(int ii = 0; ii < image.width(); ii++){
+                if(qGray(line[ii]) == 255){
+                    line[ii] = DimmedColor;
+                }
+            }
+        }
+    }
+    return image;
+}
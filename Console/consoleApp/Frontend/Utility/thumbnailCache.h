@@ -0,0 +1,62 @@
+/*
+ * thumbnailCache.h
+ *
+ * Pre-scaled thumbnails for the capture and clip lists. Thumbnail files are
+ * decoded and scaled on a background pool; the delegates paint a placeholder
+ * until thumbnailReady() is emitted and the list repaints. Entries are keyed
+ * by file name alone, so painting never touches the file system; thumbnail
+ * files are written once, under a new name for every capture. A file that
+ * could not be read (usually one that is still being written) is kept in the
+ * same LRU and tried again after a short delay.
+ *
+ * Copyright (c) 2018 Avinger, Inc.
+ */
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ThumbnailCache* instance();
+
+    // Edge length of the thumbnails as drawn in the lists
+    static const int ThumbnailDisplay_px = 160;
+
+    QPixmap thumbnail(const QString& fileName, bool dimmed = false);
+    void prefetch(const QString& fileName, bool dimmed = false);
+
+signals:
+    void thumbnailReady(const QString& fileName);
+
+private:
+    // A null pixmap marks a file that could not be read at failed_ms
+    struct Entry_t
+    {
+        QPixmap pixmap;
+        qint64 failed_ms{-1};
+    };
+
+    explicit ThumbnailCache(QObject *parent = nullptr);
+    static QString cacheKey(const QString& fileName, bool dimmed);
+    void request(const QString& key, const QString& fileName, bool dimmed);
+    void onDecoded(const QString& key, const QString& fileName, const QImage& image);
+    static QImage decode(const QString& fileName, bool dimmed);
+
+    static ThumbnailCache* m_instance;
+
+    QCache<QString, Entry_t> m_cache;
+    QSet<QString> m_pending;
+    QElapsedTimer m_clock;
+    QThreadPool m_decodePool;
+};
+
+#endif // THUMBNAILCACHE_H
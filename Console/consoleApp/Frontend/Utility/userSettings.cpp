@@ -45,6 +45,7 @@ void userSettings::saveSettings()
 //    LOG3(brightnessVal,contrastVal,reticleBrightnessVal)
 
     varSettings->setValue( "displayOptions/depthIndex", m_imageDepthIndex );
+    varSettings->setValue( "displayOptions/autoContrast", m_isAutoContrast );
 
     if(m_isGray){
         varSettings->setValue( "displayOptions/color", QString("gray" ));
@@ -62,6 +63,7 @@ void userSettings::loadVarSettings()
     contrastVal          = varSettings->value( "displayOptions/contrast",          0 ).toInt();
     reticleBrightnessVal = varSettings->value( "displayOptions/reticleBrightness", 127 ).toInt();
     m_imageDepthIndex = varSettings->value( "displayOptions/depthIndex", 0 ).toInt();
+    m_isAutoContrast = varSettings->value( "displayOptions/autoContrast", false ).toBool();
 
     QString color =  varSettings->value( "displayOptions/color", "" ).toString();
     if(color == "gray"){
@@ -120,6 +122,24 @@ void userSettings::loadProfileSettings()
     simDir = profileSettings->value( "control/simDir", "sim11").toString();
     LOG1(simDir);
 
+    spectralProcessing = profileSettings->value( "control/spectralProcessing", "fpga").toString();
+    LOG1(spectralProcessing);
+
+    lineDecimation = profileSettings->value( "control/lineDecimation", "box").toString();
+    lineDecimationTarget = profileSettings->value( "control/lineDecimationTarget", 0).toInt();
+    LOG2(lineDecimation, lineDecimationTarget);
+    speckleFilter = profileSettings->value( "control/speckleFilter", "off").toString();
+    LOG1(speckleFilter);
+
+    openClProfiling = profileSettings->value( "control/openClProfiling", 0).toInt();
+    LOG1(openClProfiling);
+
+    sectorSize_px = profileSettings->value( "control/sectorSize_px", 0).toInt();
+    warpBudget_ms = profileSettings->value( "control/warpBudget_ms", 8.0).toDouble();
+    LOG2(sectorSize_px, warpBudget_ms);
+    captureSize_px = profileSettings->value( "control/captureSize_px", 0).toInt();
+    LOG1(captureSize_px);
+
     recordingDurationMin = profileSettings->value( "recording/durationMinimum_ms", 3000).toInt();
     LOG1(recordingDurationMin)
 
@@ -142,6 +162,46 @@ QString userSettings::getSimDir() const
     return simDir;
 }
 
+QString userSettings::getSpectralProcessing() const
+{
+    return spectralProcessing;
+}
+
+QString userSettings::getLineDecimation() const
+{
+    return lineDecimation;
+}
+
+QString userSettings::getSpeckleFilter() const
+{
+    return speckleFilter;
+}
+
+int userSettings::getLineDecimationTarget() const
+{
+    return lineDecimationTarget;
+}
+
+int userSettings::getOpenClProfiling() const
+{
+    return openClProfiling;
+}
+
+int userSettings::getSectorSize_px() const
+{
+    return sectorSize_px;
+}
+
+double userSettings::getWarpBudget_ms() const
+{
+    return warpBudget_ms;
+}
+
+int userSettings::getCaptureSize_px() const
+{
+    return captureSize_px;
+}
+
 int userSettings::getMeasurementPrecision() const
 {
     return measurementPrecision;
@@ -292,6 +352,17 @@ void userSettings::setIsGray(bool isGray)
     saveSettings();
 }
 
+bool userSettings::getIsAutoContrast() const
+{
+    return m_isAutoContrast;
+}
+
+void userSettings::setIsAutoContrast(bool isAutoContrast)
+{
+    m_isAutoContrast = isAutoContrast;
+    saveSettings();
+}
+
 int userSettings::getImageIndexDecimation() const
 {
     return imageIndexDecimation;
@@ -159,6 +159,9 @@ public:
     bool getIsGray() const;
     void setIsGray(bool isGray);
 
+    bool getIsAutoContrast() const;
+    void setIsAutoContrast(bool isAutoContrast);
+
     int getImageDepthIndex() const;
     void setImageDepthIndex(int imageDepthIndex);
 
@@ -214,6 +217,21 @@ public:
 
     QString getSimDir() const;
 
+    QString getSpectralProcessing() const;
+
+    QString getLineDecimation() const;
+    int getLineDecimationTarget() const;
+
+    QString getSpeckleFilter() const;
+
+    int getOpenClProfiling() const;
+
+    int getSectorSize_px() const;
+
+    double getWarpBudget_ms() const;
+
+    int getCaptureSize_px() const;
+
 private:
     void saveSettings();
     void loadVarSettings();
@@ -239,6 +257,14 @@ private:
     int  numberOfDaqBuffers;
     int  measurementPrecision;
     QString simDir;
+    QString spectralProcessing;       // "fpga", or "opencl"/"cpu" to process raw fringes on the console
+    QString lineDecimation;           // "off", "box", "max" or "gaussian"
+    int  lineDecimationTarget;        // lines per revolution after decimation; 0 for the sector circumference
+    QString speckleFilter;            // "off", "fast" (3x3) or "quality" (5x5) median of the polar frame
+    int  openClProfiling;             // 1 to time every OpenCL stage and show the timings over the image
+    int  sectorSize_px;               // pixels the warp renders the sector at; 0 for the control screen's
+    double warpBudget_ms;             // the sector size is lowered until the warp fits in this
+    int  captureSize_px;              // pixels captures are warped at; 0 for the size they are shown at
 
     int  recordingDurationMin;
     QDate m_serviceDate;
@@ -247,6 +273,7 @@ private:
     QString catheterViewStr;          // view orientation of the catheter to coordinate with the fluoro view
     CatheterView_t catheterViewMode{DistalToProximal};  //
     bool m_isGray{true};
+    bool m_isAutoContrast{false};
     int  m_imageDepthIndex{1};
 
     float m_imagingDepth_mm{0.0f};
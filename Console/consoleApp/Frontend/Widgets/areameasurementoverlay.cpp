@@ -321,10 +321,21 @@ QPolygon AreaMeasurementOverlay::polygonToPoints( QPolygon *list )
  */
 void AreaMeasurementOverlay::setCalibrationScale( const int /*CalValMm*/ )
 {
-    currPxPerMm = depthSetting::Instance().getPixelsPerMm();
+    currPxPerMm = depthSetting::Instance().getPixelsPerMm() * zoomFactor;
     LOG1(currPxPerMm)
 }
 
+/*
+ * setZoomFactor
+ *
+ * The live sector is magnified by zoom, and so is a millimetre on screen
+ */
+void AreaMeasurementOverlay::setZoomFactor( float zoom )
+{
+    zoomFactor = zoom;
+    setCalibrationScale( 0 );
+}
+
 /*
  * addControlPoint
  *
@@ -22,6 +22,7 @@ public:
     void setColor( QColor color ) { currentColor = color; }
     void drawMinMax( bool state ) { enableDrawMinMax = state; }
     void setCalibrationScale( const int CalValMm );
+    void setZoomFactor( float zoom );
 
 signals:
 
@@ -43,6 +44,7 @@ private:
     bool     enableDrawMinMax;
     int      replacementPointIndex;
     float    currPxPerMm;
+    float    zoomFactor{1.0f};     // of the live sector under the overlay
     int computeArea( void );
     int computeLength( QPoint *p1, QPoint *p2 );
     int pointsOverlap( QPoint *p1, QPolygon *list, int tolerance );
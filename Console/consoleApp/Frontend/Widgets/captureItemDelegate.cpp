@@ -1,5 +1,6 @@
 #include "captureItemDelegate.h"
 #include "Utility/captureListModel.h"
+#include "Utility/thumbnailCache.h"
 #include "defaults.h"
 #include "logger.h"
 
@@ -8,6 +9,8 @@ const QSize  ThumbSize( ThumbnailHeight_px + 10, ThumbnailHeight_px + 10 );
 const QColor SelectedItemColor( 245, 196, 0 );
 const QColor SelectedTextColor( 143, 185, 224 );
 const int    MinOffsetForNumberLabel_px = 10;
+const QColor PlaceholderColor( 40, 40, 40 );
+const int    PrefetchRows = 4;
 }
 
 CaptureItemDelegate::CaptureItemDelegate(bool rotate, QObject *parent)
@@ -72,8 +75,27 @@ void CaptureItemDelegate::paint( QPainter *painter,
    QFontMetrics fm = painter->fontMetrics();
    const QString NumberLabel = QString( "%1" ).arg( item->getdbKey() );
    const int Offset_px = MinOffsetForNumberLabel_px + fm.width( NumberLabel );
-   QImage tmi = item->loadSectorThumbnail( item->getName());
-   painter->drawImage( 5, 5, tmi.scaled(160,160));
+
+   // Thumbnails are decoded in the background; draw a placeholder until ready
+   ThumbnailCache* thumbnails = ThumbnailCache::instance();
+   const QPixmap thumbnail = thumbnails->thumbnail( item->sectorThumbnailFile() );
+   if( thumbnail.isNull() )
+   {
+       painter->fillRect( 5, 5, ThumbnailCache::ThumbnailDisplay_px, ThumbnailCache::ThumbnailDisplay_px, PlaceholderColor );
+   }
+   else
+   {
+       painter->drawPixmap( 5, 5, thumbnail );
+   }
+
+   // Warm the rows on either side so scrolling does not show placeholders
+   for( int i = qMax( 0, rowNum - PrefetchRows ); i <= qMin( itemList.size() - 1, rowNum + PrefetchRows ); i++ )
+   {
+       if( i != rowNum && itemList.at( i ) )
+       {
+           thumbnails->prefetch( itemList.at( i )->sectorThumbnailFile() );
+       }
+   }
    painter->setPen( QPen( SelectedTextColor, 6 ) );
 
    painter->drawText( option.rect.width() - Offset_px, option.rect.height() - 4, NumberLabel );
@@ -9,6 +9,7 @@
 #include "clipItemDelegate.h"
 #include "Utility/clipListModel.h"
 #include "Utility/octFrameRecorder.h"
+#include "Utility/thumbnailCache.h"
 #include "displayManager.h"
 
 #include <QGraphicsPixmapItem>
@@ -133,11 +134,16 @@ void CaseReviewScreen::initCapture()
 
     connect(crDelegate, &CaptureItemDelegate::updateLabel, this, &CaseReviewScreen::updateCaptureLabel);
 
+    // Repaint once a thumbnail finishes decoding
+    connect(ThumbnailCache::instance(), &ThumbnailCache::thumbnailReady, ui->captureView->viewport(), QOverload<>::of(&QWidget::update));
+
     // Auto-scroll the list when items are added
     connect( &capList, &captureListModel::rowsInserted, ui->captureView, &captureListView::updateView );
 
     //scroll
     connect(this, &CaseReviewScreen::displayOffsetChanged, crDelegate, &CaptureItemDelegate::handleDisplayOffset);
+
+    connect(ReviewImageCache::instance(), &ReviewImageCache::imageReady, this, &CaseReviewScreen::reviewImageReady);
 }
 
 void CaseReviewScreen::initClips()
@@ -152,6 +158,7 @@ void CaseReviewScreen::initClips()
     connect( ui->clipsView, &clipListView::clicked, this, &CaseReviewScreen::clipSelected );
 
     connect(clipItemDelegate, &ClipItemDelegate::updateLabel, this, &CaseReviewScreen::updateClipLabel);
+    connect(ThumbnailCache::instance(), &ThumbnailCache::thumbnailReady, ui->clipsView->viewport(), QOverload<>::of(&QWidget::update));
 
     // Auto-scroll the list when items are added
     connect( &clipList, &clipListModel::rowsInserted, ui->clipsView, &clipListView::updateView );
@@ -342,23 +349,50 @@ void CaseReviewScreen::captureSelected( QModelIndex index )
 
         const auto& imageName{m_selectedCaptureItem->getName()};
         LOG1(imageName)
-        QImage image = m_selectedCaptureItem->loadDecoratedImage(imageName).scaledToWidth(1600);
-        QImage imagePm = image.scaledToWidth(1000);
+        m_selectedCaptureFile = m_selectedCaptureItem->decoratedImageFile();
+
+        // Shown now if cached, otherwise from reviewImageReady()
+        ReviewImageCache* reviewImages = ReviewImageCache::instance();
+        ReviewImage_t reviewImage;
+        if(reviewImages->image(m_selectedCaptureFile, reviewImage)){
+            showCaptureImage(reviewImage);
+        }
+
+        // Paging moves one capture at a time, so decode the neighbours now
+        for(int neighbour : {rowNum + 1, rowNum - 1}){
+            if(neighbour >= 0 && neighbour < itemList.size() && itemList.at(neighbour)){
+                reviewImages->prefetch(itemList.at(neighbour)->decoratedImageFile());
+            }
+        }
+    }
+}
 
-        LOG2(image.size().width(), image.size().height())
+/*
+ * reviewImageReady()
+ *
+ * A capture image finished decoding; show it if it is still the selection.
+ */
+void CaseReviewScreen::reviewImageReady(const QString &fileName)
+{
+    ReviewImage_t reviewImage;
+    if(m_selectedCaptureItem && fileName == m_selectedCaptureFile &&
+       ReviewImageCache::instance()->image(fileName, reviewImage)){
+        showCaptureImage(reviewImage);
+    }
+}
 
-        QGraphicsScene *scene = new QGraphicsScene(this);
-        QGraphicsScene *scenePm = new QGraphicsScene(this);
+void CaseReviewScreen::showCaptureImage(const ReviewImage_t &reviewImage)
+{
+    LOG2(reviewImage.review.width(), reviewImage.review.height())
 
-        QGraphicsPixmapItem* item = new QGraphicsPixmapItem(QPixmap::fromImage(image));
-        QGraphicsPixmapItem* itemPm = new QGraphicsPixmapItem(QPixmap::fromImage(imagePm));
+    QGraphicsScene *scene = new QGraphicsScene(this);
+    QGraphicsScene *scenePm = new QGraphicsScene(this);
 
-        scene->addItem(item);
-        scenePm->addItem(itemPm);
+    scene->addItem(new QGraphicsPixmapItem(reviewImage.review));
+    scenePm->addItem(new QGraphicsPixmapItem(reviewImage.monitor));
 
-        ui->captureScene->setScene(scene);
-        DisplayManager::instance()->setScene(scenePm);
-    }
+    ui->captureScene->setScene(scene);
+    DisplayManager::instance()->setScene(scenePm);
 }
 
 void CaseReviewScreen::clipSelected(QModelIndex index)
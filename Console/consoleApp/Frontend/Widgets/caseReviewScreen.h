@@ -7,6 +7,7 @@
 #include "Utility/captureListModel.h"
 #include "Utility/clipListModel.h"
 #include "capturelistview.h"
+#include "Utility/reviewImageCache.h"
 
 
 namespace Ui {
@@ -60,6 +61,8 @@ private:
     void hideUnimplementedButtons();
     void updateCaptureLabel();
     void updateClipLabel();
+    void showCaptureImage( const ReviewImage_t& reviewImage );
+    void reviewImageReady( const QString& fileName );
 
 private:
     Ui::CaseReviewScreen *ui;
@@ -73,6 +76,7 @@ private:
     bool m_isImageReviewInProgress{false};
 
     captureItem *m_selectedCaptureItem{nullptr};
+    QString m_selectedCaptureFile;
     clipItem *m_selectedClipItem{nullptr};
 
 };
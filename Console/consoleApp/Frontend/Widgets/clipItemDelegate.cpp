@@ -3,17 +3,21 @@
 #include "defaults.h"
 #include "logger.h"
 #include "Utility/octFrameRecorder.h"
+#include "Utility/thumbnailCache.h"
 
 namespace{
 const QSize  ThumbSize( ThumbnailHeight_px + 10, ThumbnailHeight_px + 10 );
 const QColor SelectedItemColor( 245, 196, 0 );
 const QColor SelectedTextColor( 143, 185, 224 );
 const int    MinOffsetForNumberLabel_px = 10;
+const QColor PlaceholderColor( 40, 40, 40 );
+const int    PrefetchRows = 4;
 }
 
 ClipItemDelegate::ClipItemDelegate(bool rotated, QObject *parent)
+    :QAbstractItemDelegate( parent )
 {
-
+   doRotate = rotated;
 }
 
 /*
@@ -90,17 +94,22 @@ void ClipItemDelegate::paint( QPainter *painter,
 //       LOG1(item->getCatheterView())
        const QString thumbNailFile(item->clipThumbnailFile(item->getThumbnailDir(), item->getName()));
 //       LOG1(thumbNailFile)
-       QImage image(thumbNailFile);
-       if(recorderIsOn){
-           for (int ii = 0; ii < image.width(); ii++) {
-               for (int jj = 0; jj < image.height(); jj++) {
-                   int gray = qGray(image.pixel(ii, jj));
-                   if(gray == 255)
-                        image.setPixel(ii, jj, QColor(150, 150, 150).rgb());
-               }
+
+       // The grayed-out variant shown while recording is cached separately
+       ThumbnailCache* thumbnails = ThumbnailCache::instance();
+       const QPixmap thumbnail = thumbnails->thumbnail(thumbNailFile, recorderIsOn);
+       if(thumbnail.isNull()){
+           painter->fillRect( 5, 5, ThumbnailCache::ThumbnailDisplay_px, ThumbnailCache::ThumbnailDisplay_px, PlaceholderColor );
+       } else {
+           painter->drawPixmap( 5, 5, thumbnail );
+       }
+
+       for(int i = qMax(0, rowNum - PrefetchRows); i <= qMin(itemList.size() - 1, rowNum + PrefetchRows); i++){
+           const clipItem* neighbour = itemList.at(i);
+           if(i != rowNum && neighbour){
+               thumbnails->prefetch(neighbour->clipThumbnailFile(neighbour->getThumbnailDir(), neighbour->getName()), recorderIsOn);
            }
        }
-       painter->drawImage( 5, 5, image.scaled(160,160));
        painter->setPen( QPen( indexColor, 6 ) );
 
        painter->drawText( option.rect.width() - Offset_px, option.rect.height() - 4, NumberLabel );
@@ -13,6 +13,7 @@
 #include "defaults.h"
 
 #include <daqfactory.h>
+#include <Backend/startupgraph.h>
 #include <QImage>
 #include <QIcon>
 #include <QStringListModel>
@@ -87,6 +88,8 @@ void DeviceSelectDialog::populateList()
 {
     deviceSettings &devices = deviceSettings::Instance();
 
+    // The catalogue is parsed by a start-up step; wait for it rather than parse it twice
+    StartupGraph::instance()->waitFor("deviceCatalogue");
 
     // Only create the list if devices don't exist.
     if( devices.list().isEmpty() )
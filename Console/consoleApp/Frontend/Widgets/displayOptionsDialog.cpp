@@ -78,6 +78,7 @@ void DisplayOptionsDialog::on_pushButtonBack_clicked()
     userSettings &settings = userSettings::Instance();
     settings.setBrightness( m_model0.imageBrightness() );
     settings.setContrast(m_model0.imageContrast());
+    ui->pushButtonAutoContrast->setChecked(m_isAutoContrast0);
 
     //imaging depth
     setImagingDepth(m_model0.depthIndex());
@@ -256,6 +257,11 @@ void DisplayOptionsDialog::initBrightnessAndContrast()
 {
     connect(ui->horizontalSliderImageBrightness, &QSlider::valueChanged, this, &DisplayOptionsDialog::handleImageBrightness);
     connect(ui->horizontalSliderImageContrast, &QSlider::valueChanged, this, &DisplayOptionsDialog::handleImageContrast);
+    connect(ui->pushButtonAutoContrast, &QPushButton::toggled, this, &DisplayOptionsDialog::handleAutoContrast);
+
+    m_isAutoContrast0 = userSettings::Instance().getIsAutoContrast();
+    ui->pushButtonAutoContrast->setChecked(m_isAutoContrast0);
+    handleAutoContrast(m_isAutoContrast0);
 
     if(m_model){
         const auto& brightness = m_model->imageBrightness();
@@ -321,6 +327,17 @@ void DisplayOptionsDialog::handleImageContrast(int contrast)
 
 }
 
+void DisplayOptionsDialog::handleAutoContrast(bool isAuto)
+{
+    LOG1(isAuto)
+    SignalModel::instance()->setIsAutoContrast(isAuto);
+    userSettings::Instance().setIsAutoContrast(isAuto);
+
+    // The manual levels are kept for when auto is turned off again
+    ui->horizontalSliderImageBrightness->setEnabled(!isAuto);
+    ui->horizontalSliderImageContrast->setEnabled(!isAuto);
+}
+
 void DisplayOptionsDialog::handleImageBrightness(int brightness)
 {
     LOGUA;
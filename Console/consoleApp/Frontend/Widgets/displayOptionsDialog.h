@@ -54,6 +54,7 @@ private slots:
     void updateGraySepiaSetting();
     void handleImageBrightness(int value);
     void handleImageContrast(int value);
+    void handleAutoContrast(bool isAuto);
 
 
 private:
@@ -78,6 +79,7 @@ private:
 
     DisplayOptionsModel* m_model{nullptr};
     DisplayOptionsModel  m_model0;
+    bool m_isAutoContrast0{false};
 
 };
 
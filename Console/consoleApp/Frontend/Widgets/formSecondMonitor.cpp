@@ -11,6 +11,8 @@ LiveSceneView::LiveSceneView(QWidget *parent) :
 
     ui->graphicsView->setHorizontalScrollBarPolicy( Qt::ScrollBarAlwaysOff );
     ui->graphicsView->setVerticalScrollBarPolicy( Qt::ScrollBarAlwaysOff );
+    // The sector is rendered for the control screen; this view shows the scene 1:1 and scales it down
+    ui->graphicsView->setRenderHint( QPainter::SmoothPixmapTransform );
     ui->labelSpeed->hide();
     ui->pushButtonSpeed->hide();
 
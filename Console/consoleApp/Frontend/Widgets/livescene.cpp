@@ -22,8 +22,11 @@
 #include <QPainter>
 #include "logger.h"
 #include <QApplication>
+#include <QGraphicsSceneWheelEvent>
+#include <cmath>
 #include "Utility/userSettings.h"
 #include <Backend/interfacesupport.h>
+#include <Backend/interfacetelemetry.h>
 #include "rotationIndicatorFactory.h"
 
 
@@ -76,6 +79,7 @@ liveScene::liveScene( QObject *parent )
 
     reviewing              = false;
     zoomFactor             = 1.0;
+    zoomWindow             = sceneRect();
     mouseRotationEnabled   = true;
     isAnnotateMode         = false;
     isMeasureMode          = false;
@@ -84,7 +88,7 @@ liveScene::liveScene( QObject *parent )
     reviewSector    = nullptr;
 
     connect( this, SIGNAL(captureAll(QImage,QImage,QString,unsigned int,int,float)), &capturer, SLOT(imageCapture(QImage,QImage,QString,uint,int,float)) );
-    connect( this, SIGNAL(clipCapture(QImage,QString,unsigned int)), &capturer, SLOT(clipCapture(QImage,QString,unsigned int)) );
+    connect( this, SIGNAL(clipCapture(QImage,QString,unsigned int,bool)), &capturer, SLOT(clipCapture(QImage,QString,unsigned int,bool)) );
 
     connect( &capturer, SIGNAL(warning( QString ) ),     this, SIGNAL(sendWarning( QString ) ) );
     connect( &capturer, SIGNAL(sendFileToKey(QString)),  this, SIGNAL(sendFileToKey(QString)));
@@ -287,6 +291,8 @@ void liveScene::showReview( const QImage & sec )
     // turn off overlays during review
     overlays->setVisible( false );
 
+    // reviews show the capture as it was taken
+    resetZoom();
     reviewing = true;
 
     reviewSector    = new QGraphicsPixmapItem( QPixmap::fromImage( sec ) );
@@ -335,6 +341,62 @@ void liveScene::captureDecoratedImage( QImage decoratedImage, QString tagText )
 //        secImage = sector->freeze();
 //    }
 
+    const int pixelsPerMm = capturePixelsPerMm();
+
+    /*
+     * Perform the capture. Allow the capture text to be translated.
+     */
+    {
+        emit captureAll( decoratedImage, secImage, tr( tagText.toLocal8Bit().constData() ), sector->getFrozenTimestamp(), pixelsPerMm, zoomFactor );
+    }
+}
+
+/*
+ * captureRenderedImage
+ *
+ * Capture a sector rendered by renderSector() on the capture pool. Only the colour map, the
+ * reticle and the zoom are read here; the reticle is drawn over the rendered sector, as
+ * vectors at its resolution, by the pool.
+ */
+void liveScene::captureRenderedImage( std::function<QImage()> renderSector, QString tagText )
+{
+    const QVector<QRgb> colorTable = sector->getSectorImage()->colorTable();
+    const bool isReticleVisible = overlays->isVisible();
+    const overlayItem::Reticle_t reticle = overlayItem::reticle( sector->getReticleBrightness() );
+    const QTransform zoom = QTransform().scale( zoomFactor, zoomFactor ).translate( -zoomWindow.x(), -zoomWindow.y() );
+
+    auto render = [renderSector, colorTable, isReticleVisible, reticle, zoom]()
+    {
+        QImage sectorImage = renderSector();
+        if( sectorImage.isNull() )
+        {
+            return QImage();
+        }
+        sectorImage.setColorTable( colorTable );
+        QImage image( sectorImage.convertToFormat( QImage::Format_RGB32 ) );
+
+        if( isReticleVisible )
+        {
+            // The reticle is laid out in scene units
+            const double scale = double( image.width() ) / SectorWidth_px;
+            QPainter painter( &image );
+            painter.setRenderHint( QPainter::Antialiasing );
+            painter.setTransform( zoom * QTransform::fromScale( scale, scale ) );
+            overlayItem::paintReticle( painter, reticle );
+        }
+        return image;
+    };
+
+    capturer.renderedImageCapture( render, tr( tagText.toLocal8Bit().constData() ), sector->getFrozenTimestamp(), capturePixelsPerMm(), zoomFactor );
+}
+
+/*
+ * capturePixelsPerMm
+ *
+ * The calibration stored with a capture, or -1 when the device can't be measured on.
+ */
+int liveScene::capturePixelsPerMm() const
+{
     depthSetting &ds = depthSetting::Instance();
     int pixelsPerMm = ds.getPixelsPerMm();
     qDebug() << __FUNCTION__ << "." <<  __LINE__ << ": pixelsPerMm=" << pixelsPerMm;
@@ -344,13 +406,7 @@ void liveScene::captureDecoratedImage( QImage decoratedImage, QString tagText )
     {
         pixelsPerMm = -1; // assign to -1 meaning the feature is disabled.
     }
-
-    /*
-     * Perform the capture. Allow the capture text to be translated.
-     */
-    {
-        emit captureAll( decoratedImage, secImage, tr( tagText.toLocal8Bit().constData() ), sector->getFrozenTimestamp(), pixelsPerMm, zoomFactor );
-    }
+    return pixelsPerMm;
 }
 
 /*
@@ -482,9 +538,10 @@ void liveScene::rewindPlayback()
  */
 void liveScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
-    if( zoomFactor != 1.0f ) // no zoom
+    if( ( zoomFactor != 1.0f ) && !isMeasureMode && !isAnnotateMode )
     {
-        // capture the event; allows image review to pan and zoom
+        // capture the event; drags pan the zoomed sector
+        lastPanPoint = event->scenePos();
     }
     else if( reviewing && !isMeasureMode )
     {
@@ -517,7 +574,7 @@ void liveScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
              qApp->setOverrideCursor( Qt::ArrowCursor );
              if(RotationIndicatorFactory::getRotationIndicator()->isVisible()){
                  auto interfaceSupport = InterfaceSupport::getInstance();
-                 int runState = interfaceSupport->getLastRunningState();
+                 int runState = InterfaceTelemetry::instance()->snapshot().runningState;
 
                  if (runState == 1) {
                      interfaceSupport->enableDisableBidirectional(true); // Clockwise
@@ -540,7 +597,17 @@ void liveScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
  */
 void liveScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 {
-    if( isMeasureMode )
+    if( ( zoomFactor != 1.0f ) && !isMeasureMode && !isAnnotateMode )
+    {
+        if( event->buttons() & Qt::LeftButton )
+        {
+            // Keep the sector point that was under the mouse under it
+            const QPointF sectorPoint = zoomWindow.topLeft() + lastPanPoint / double( zoomFactor );
+            setZoom( zoomFactor, sectorPoint, event->scenePos() );
+            lastPanPoint = event->scenePos();
+        }
+    }
+    else if( isMeasureMode )
     {
         qApp->setOverrideCursor( Qt::CrossCursor );
 
@@ -585,13 +652,83 @@ void liveScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
     update();
 }
 
+/*
+ * wheelEvent()
+ *
+ * Zooms the live sector about the mouse. Not while reviewing, measuring or annotating, as
+ * those work on what is already on screen.
+ */
+void liveScene::wheelEvent(QGraphicsSceneWheelEvent *event)
+{
+    if( reviewing || isMeasureMode || isAnnotateMode )
+    {
+        QGraphicsScene::wheelEvent( event );
+        return;
+    }
+
+    const QPointF sectorPoint = zoomWindow.topLeft() + event->scenePos() / double( zoomFactor );
+    const float factor = zoomFactor * float( std::pow( 1.25, event->delta() / 120.0 ) );
+    setZoom( factor, sectorPoint, event->scenePos() );
+    event->accept();
+}
+
+/*
+ * setZoom
+ *
+ * Magnifies the sector by factor so that sectorPoint (unzoomed scene units) lands on
+ * scenePoint. The warp renders the window at full display resolution from the polar frame
+ * (see zoomChanged); the reticle is scaled to match.
+ */
+void liveScene::setZoom( float factor, QPointF sectorPoint, QPointF scenePoint )
+{
+    zoomFactor = qBound( 1.0f, factor, float( MaxZoomFactor ) );
+
+    const QRectF scene = sceneRect();
+    const QSizeF size = scene.size() / double( zoomFactor );
+    const QPointF topLeft = sectorPoint - scenePoint / double( zoomFactor );
+    zoomWindow = QRectF( QPointF( qBound( scene.left(), topLeft.x(), scene.right() - size.width() ),
+                                  qBound( scene.top(), topLeft.y(), scene.bottom() - size.height() ) ),
+                         size );
+
+    overlays->setTransform( QTransform().scale( zoomFactor, zoomFactor ).translate( -zoomWindow.x(), -zoomWindow.y() ) );
+    if( areaOverlayItem )
+    {
+        areaOverlayItem->setZoomFactor( zoomFactor );
+    }
+    emit zoomChanged( regionOfInterest() );
+}
+
+void liveScene::resetZoom()
+{
+    setZoom( 1.0f, QPointF(), QPointF() );
+}
+
+/*
+ * regionOfInterest
+ *
+ * The zoom window as fractions of the sector, as the warp takes it
+ */
+QRectF liveScene::regionOfInterest() const
+{
+    const QRectF scene = sceneRect();
+    return QRectF( ( zoomWindow.x() - scene.x() ) / scene.width(), ( zoomWindow.y() - scene.y() ) / scene.height(),
+                   zoomWindow.width() / scene.width(), zoomWindow.height() / scene.height() );
+}
+
 /*
  * captureClip
  *
- * Save the sector from the start of the clip
+ * Save the sector from the start of the clip. A thumbnail from the warp is used as it is;
+ * otherwise the sector is frozen and scaled down by the capturer.
  */
-void liveScene::captureClip( QString strIter )
+void liveScene::captureClip( QString strIter, QImage thumbnail )
 {
+    if( !thumbnail.isNull() )
+    {
+        emit clipCapture( thumbnail, strIter, QDateTime::currentDateTime().toUTC().toTime_t(), true );
+        return;
+    }
+
     /*
      * Render the sector images,
      * then pass of to the capturer to write to
@@ -600,7 +737,7 @@ void liveScene::captureClip( QString strIter )
     QImage secImage = sector->freeze();
 
     // Perform the capture. Allow the capture text to be translated.
-    emit clipCapture( secImage, strIter, sector->getFrozenTimestamp() );
+    emit clipCapture( secImage, strIter, sector->getFrozenTimestamp(), false );
 }
 
 /*
@@ -828,6 +965,7 @@ void liveScene::setMeasureModeArea( bool state, QColor color )
         areaOverlayItem->setZValue( 6.0 );
         areaOverlayItem->setColor( color );
         areaOverlayItem->setCalibrationScale( cachedCalibrationScale );
+        areaOverlayItem->setZoomFactor( zoomFactor );
     }
     else
     {
@@ -22,6 +22,7 @@
 #include <QThread>
 #include <QTimer>
 #include <QMutex>
+#include <functional>
 #include "sectoritem.h"
 #include "Utility/capturemachine.h"
 #include "annotateoverlay.h"
@@ -40,6 +41,11 @@ public:
     liveScene( QObject *parent = nullptr );
     ~liveScene();
     void setZoomFactor( float factor ) { zoomFactor = factor; }
+    void setZoom( float factor, QPointF sectorPoint, QPointF scenePoint );
+    void resetZoom();
+    QRectF regionOfInterest() const;
+    // The view shows more than the sector and its reticle, so a capture has to grab it
+    bool needsViewGrab() const { return reviewing || isMeasurementEnabled || isAnnotateModeEnabled; }
     void setMeasureModeArea( bool state, QColor color );
     void setAnnotateMode( bool state, QColor color );
     void applyClipInfoToBuffer( char *buffer );
@@ -66,7 +72,8 @@ public:
 
 public slots:
     void captureDecoratedImage( QImage decoratedImage, QString tagText );
-    void captureClip( QString strIter );
+    void captureRenderedImage( std::function<QImage()> renderSector, QString tagText );
+    void captureClip( QString strIter, QImage thumbnail = QImage() );
     void generateClipInfo();
     void resetRotationCounter();
     void setWindOffset( bool enabled ) {
@@ -131,7 +138,7 @@ signals:
     void sendFileToKey( QString );
     void sendStatusText( QString );
     void captureAll( QImage, QImage, QString, unsigned int, int, float );
-    void clipCapture( QImage , QString, unsigned int );
+    void clipCapture( QImage , QString, unsigned int, bool );
     void sendWarning( QString );
     void sendError( QString );
     void endOfFile( );
@@ -143,6 +150,9 @@ signals:
     void measurementArea( int );
     void measurementLength( int );
 
+    // The part of the sector to warp, as fractions of it
+    void zoomChanged( QRectF );
+
 private slots:
     void refresh();
 
@@ -157,6 +167,8 @@ private:
     sectorItem *sector;
     overlayItem *overlays;
     float zoomFactor;
+    QRectF zoomWindow;      // the part of the sector on screen, in scene units
+    QPointF lastPanPoint;
     bool reviewing;
     bool mouseRotationEnabled;
     bool isAnnotateMode;
@@ -195,9 +207,11 @@ private:
     IRotationIndicator* rotationIndicatorOverlayItem{nullptr};
     bool isRotationIndicatorOverlayItemEnabled{false};
     bool isTheMouseInTheCenter(QGraphicsSceneMouseEvent *event) const;
+    int capturePixelsPerMm() const;
 
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *event);
     void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
+    void wheelEvent(QGraphicsSceneWheelEvent *event);
 };
@@ -22,6 +22,9 @@
 #include "displayManager.h"
 #include "defaults.h"
 #include <Backend/interfacesupport.h>
+#include <Backend/interfacetelemetry.h>
+#include <Backend/startupgraph.h>
+#include <Backend/pipelinemetrics.h>
 #include "endCaseDialog.h"
 #include "Utility/displayThread.h"
 
@@ -33,6 +36,7 @@
 #include <QTextStream>
 #include <QGraphicsView>
 #include <QBitmap>
+#include <QLabel>
 #include <memory>
 
 MainScreen::MainScreen(QWidget *parent)
@@ -86,15 +90,60 @@ MainScreen::MainScreen(QWidget *parent)
     m_imageDecimation = userSettings::Instance().getImageIndexDecimation();
     m_disableRendering = userSettings::Instance().getDisableRendering();
 
+   if(!m_scanWorker){
+       // OpenCL is normally compiled by a start-up step while the user selects a device
+       StartupGraph::instance()->waitFor("openCL");
+       m_scanWorker = ScanConversion::takePrepared();
+   }
    if(!m_scanWorker){
        m_scanWorker = new ScanConversion();
    }
+   // The device may have lowered the sector size below what the settings asked for
+   m_scene->sectorHandle()->setSectorSize_px(*SignalModel::instance()->getSectorWidth_px());
+   // Zoom renders only the window on screen, at full resolution
+   connect(m_scene, &liveScene::zoomChanged, this, [this](QRectF roi){ m_scanWorker->setRegionOfInterest(roi); });
+   // A thumbnail every frame is cheap and ready whenever a loop recording starts
+   m_scanWorker->setWarpOutputs(ScanConversion::DisplayOutput | ScanConversion::ThumbnailOutput);
 
 //   if(!m_displayThread){
 //       m_displayThread = new DisplayThread(this);
 //   }
 
    SignalModel::instance()->setMainScreen(this);
+   initProfilingOverlay();
+}
+
+/*
+ * initProfilingOverlay
+ *
+ * A read-only text box over the top left of the image with the per-stage OpenCL timings.
+ * Refreshed as PipelineMetrics reports, which is every few frames.
+ */
+void MainScreen::initProfilingOverlay()
+{
+    if(!userSettings::Instance().getOpenClProfiling()){
+        return;
+    }
+
+    m_profilingOverlay = new QLabel(m_graphicsView);
+    m_profilingOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    m_profilingOverlay->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160); color: rgb(0, 255, 0);"
+                                      " font-family: monospace; font-size: 11px; padding: 4px; border: none; }");
+    m_profilingOverlay->move(8, 8);
+    m_profilingOverlay->setText("OpenCL profiling: waiting for frames");
+    m_profilingOverlay->adjustSize();
+    m_profilingOverlay->show();
+
+    connect(PipelineMetrics::instance(), &PipelineMetrics::metricsChanged, this, &MainScreen::updateProfilingOverlay);
+}
+
+void MainScreen::updateProfilingOverlay()
+{
+    if(!m_profilingOverlay || !m_profilingOverlay->isVisible()){
+        return;
+    }
+    m_profilingOverlay->setText(PipelineMetrics::instance()->snapshot().summary());
+    m_profilingOverlay->adjustSize();
 }
 
 void MainScreen::hookupEndCaseDiagnostics() {
@@ -351,11 +400,16 @@ void MainScreen::updateMainScreenLabels(const OCTFile::OctData_t &frameData)
     const QString catheterName{names[0]};
     const QString cathalogName{names[1]};
 
-    emit updateRecorder(frameData.dispData,
-                        catheterName.toLatin1(),cathalogName.toLatin1(),
-                        activePassiveValue.toLatin1(),
-                        timeLabel.toLatin1(),
-                        1024,1024);
+    // The warp writes the recorder's frame while recording; dispData is sector sized, so a
+    // frame without a video frame is not recorded
+    uint8_t* videoFrame = m_scanWorker->videoFrame();
+    if(videoFrame){
+        emit updateRecorder(videoFrame,
+                            catheterName.toLatin1(),cathalogName.toLatin1(),
+                            activePassiveValue.toLatin1(),
+                            timeLabel.toLatin1(),
+                            VideoWidth_px,VideoHeight_px);
+    }
 
     if( userSettings::Instance().getIsRecording()){
          ui->labelSim->setText(QString("recording ") + QString::number(frameData.frameNumber));
@@ -423,6 +477,9 @@ bool MainScreen::renderImage(const QImage *disk) const
         const QPixmap& tmpPixmap = QPixmap::fromImage( *disk, Qt::MonoOnly);
         pixmap->setPixmap(tmpPixmap);
         success = true;
+        if(m_profilingOverlay){
+            PipelineMetrics::instance()->recordHost(PipelineMetrics::Stage::Render, time.nsecsElapsed() / 1000.0);
+        }
         LOG2(m_disableRendering, time.elapsed());
     }
     return success;
@@ -525,7 +582,7 @@ void MainScreen::showEvent(QShowEvent *se)
 
     LOG1(image)
     if(image){
-        memset(image->bits(), 0, 1024*1024);
+        image->fill(0);
         QGraphicsPixmapItem* pixmap = m_scene->sectorHandle();
 
         if(pixmap){
@@ -591,8 +648,7 @@ void MainScreen::updateDeviceSettings()
     const bool isBidir = selectedDevice->isBiDirectional();
     const int numberOfSpeeds = selectedDevice->getNumberOfSpeeds();
 
-    auto interfaceSupport = InterfaceSupport::getInstance();
-    int currentSledRunningStateVal{interfaceSupport->getLastRunningState()};
+    int currentSledRunningStateVal{InterfaceTelemetry::instance()->snapshot().runningState};
 
     emit sledRunningStateChanged(currentSledRunningStateVal);
 
@@ -799,8 +855,8 @@ void MainScreen::on_pushButtonMeasure_clicked(bool checked)
 
 void MainScreen::updateSledRunningState()
 {
-    auto interfaceSupport = InterfaceSupport::getInstance();
-    int currentSledRunningStateVal{interfaceSupport->getRunningState()};
+    // Polled in the background; no serial round trip on the GUI thread
+    int currentSledRunningStateVal{InterfaceTelemetry::instance()->snapshot().runningState};
 
      if(m_sledRunningStateVal != currentSledRunningStateVal)
      {
@@ -923,6 +979,9 @@ void MainScreen::on_pushButtonRecord_clicked(bool checked)
             initRecording();
         }
 
+        const int outputs = m_scanWorker->warpOutputs();
+        m_scanWorker->setWarpOutputs(m_recordingIsOn ? (outputs | ScanConversion::VideoOutput) : (outputs & ~ScanConversion::VideoOutput));
+
         auto* recorder = OctFrameRecorder::instance();
         recorder->onRecordSector(m_recordingIsOn);
         if(m_recordingIsOn){
@@ -930,7 +989,7 @@ void MainScreen::on_pushButtonRecord_clicked(bool checked)
             const QString playListThumbnail(clipListModel::Instance().getPlaylistThumbnail());
             LOG1(playListThumbnail)
             QTimer::singleShot(delay, this, &MainScreen::enableRecordButton);
-            m_scene->captureClip(playListThumbnail);
+            m_scene->captureClip(playListThumbnail, m_scanWorker->thumbnail());
 
             // record the start time
             auto clipTimestamp = QDateTime::currentDateTime().toUTC();
@@ -954,6 +1013,24 @@ void MainScreen::onCaptureImage()
     // tag the images as "IMG1, IMG2, ..."
     currentImageNumber++;
     QString fileName = QString( "%1%2" ).arg( ImagePrefix ).arg( currentImageNumber);
+
+    /*
+     * The sector is warped again from the polar frame on screen, at the capture size, by the
+     * capture pool. Measurements, annotations and review images are only drawn in the view,
+     * so those captures grab it.
+     */
+    std::shared_ptr<ScanConversion::CaptureFrame_t> frame;
+    if(!m_scene->needsViewGrab()){
+        frame = m_scanWorker->snapshotForCapture();
+    }
+    if(frame){
+        const int captureSize_px = userSettings::Instance().getCaptureSize_px();
+        const int size_px = captureSize_px > 0 ? captureSize_px : SignalModel::nativeSectorSize_px();
+        ScanConversion* worker = m_scanWorker;
+        m_scene->captureRenderedImage([worker, frame, size_px](){ return worker->renderCapture(*frame, size_px); }, fileName);
+        return;
+    }
+
     grabImage();
     m_scene->captureDecoratedImage(m_sectorImage, fileName);
 }
@@ -1063,6 +1140,7 @@ void MainScreen::presentData( const OCTFile::OctData_t* pointerToFrame){
         {
             updateMainScreenLabels(frame);
             renderImage(diskImage);
+            StartupGraph::instance()->markFirstImage();
         }
         //QCoreApplication::processEvents();
     }
@@ -1073,7 +1151,7 @@ void MainScreen::presentData( const OCTFile::OctData_t* pointerToFrame){
 void MainScreen::on_pushButton_clicked()
 {
     auto interfaceSupport = InterfaceSupport::getInstance();
-    int currentSledRunningStateVal{interfaceSupport->getLastRunningState()};
+    int currentSledRunningStateVal{InterfaceTelemetry::instance()->snapshot().runningState};
 
     if (currentSledRunningStateVal == 0) {
         interfaceSupport->setSledRunState(true);
@@ -18,6 +18,7 @@ class QPushButton;
 class QGraphicsView;
 class ScanConversion;
 class DisplayThread;
+class QLabel;
 
 
 QT_BEGIN_NAMESPACE
@@ -114,6 +115,8 @@ private:
     void computeStatistics(const OCTFile::OctData_t& frameData) const;
     const QImage *polarTransform(const OCTFile::OctData_t& frameData);
     bool renderImage(const QImage* disk) const;
+    void initProfilingOverlay();
+    void updateProfilingOverlay();
 
 private:
     Ui::MainScreen *ui;
@@ -151,5 +154,6 @@ private:
 
     OctSystemDiagnostics* diagnostics = nullptr;
     DisplayThread* m_displayThread{nullptr};
+    QLabel* m_profilingOverlay{nullptr};    // OpenCL stage timings, when control/openClProfiling is on
 };
 #endif // MAINSCREEN_H
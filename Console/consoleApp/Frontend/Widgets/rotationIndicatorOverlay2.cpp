@@ -7,6 +7,7 @@
 #include "logger.h"
 #include "depthsetting.h"
 #include <Backend/interfacesupport.h>
+#include <Backend/interfacetelemetry.h>
 
 RotationIndicatorOverlay2* RotationIndicatorOverlay2::m_instance{nullptr};
 
@@ -118,8 +119,7 @@ void RotationIndicatorOverlay2::paint(QPainter* painter, const QStyleOptionGraph
 //        font.setBold(true);
         painter->setFont(font);
 
-        auto interfaceSupport = InterfaceSupport::getInstance();
-        int lastRunningState{interfaceSupport->getLastRunningState()};
+        int lastRunningState{InterfaceTelemetry::instance()->snapshot().runningState};
 
         if(lastRunningState == 3)
         {
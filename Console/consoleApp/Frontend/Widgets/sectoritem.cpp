@@ -18,6 +18,8 @@
 #include <QPainter>
 #include <QString>
 #include <math.h>
+#include <algorithm>
+#include <cmath>
 #include "defaults.h"
 #include "sectoritem.h"
 #include "livescene.h"
@@ -28,6 +30,7 @@
 #include <QTime>
 #include "depthsetting.h"
 #include <Backend/interfacesupport.h>
+#include <Backend/interfacetelemetry.h>
 #include "rotationIndicatorFactory.h"
 #include "signalmodel.h"
 
@@ -112,6 +115,8 @@ sectorItem::sectorItem( QGraphicsItem *parent )
     sectorDecoratedImage = sectorImage->copy();
 
     isVideoOnly = false;
+
+    setSectorSize_px( *SignalModel::instance()->getSectorWidth_px() );
 }
 
 /*
@@ -145,6 +150,9 @@ void sectorItem::mousePressEvent( QGraphicsSceneMouseEvent *event )
     if( !rotating && ( event->button() == Qt::LeftButton ) )
     {
         rotating = true;
+
+        // The drag turns the warp from wherever it is now
+        displayRotationAngle_deg = *SignalModel::instance()->getDisplayAngle();
     }
 }
 
@@ -188,8 +196,6 @@ void sectorItem::deviceChanged(void)
 
     // clean up the display for the new device
     clearImage();
-    displayRotationAngle_deg = 0.0;
-    rotateSector( displayRotationAngle_deg );
 }
 
 void sectorItem::setReticleBrightness(int value)
@@ -234,21 +240,16 @@ void sectorItem::mouseMoveEvent( QGraphicsSceneMouseEvent *event )
         newRotation_deg = displayRotationAngle_deg + oldAngle_deg - newAngle_deg;
 
         /*
-         * Clamp the rotation to the unit circle.  Losing the fractional
-         * part of the rotation is acceptable. Keeping the angle on the unit
-         * circle is required for the GPU processing of the video frame.
+         * Keep the rotation on the unit circle, fraction and all, so the drag stays smooth
+         * across 0 degrees. The warp turns it into a row offset in the polar frame from the
+         * next frame on; nothing is redrawn here.
          */
+        newRotation_deg = std::fmod( newRotation_deg, 360.0 );
         if( newRotation_deg < 0 )
         {
             newRotation_deg += 360.0;
         }
-        if( newRotation_deg > 360.0 )
-        {
-            newRotation_deg = int(newRotation_deg) % 360;
-        }
-//        LOG1(newRotation_deg);
         SignalModel::instance()->setDisplayAngle(float(newRotation_deg));
-//        rotateSector( newRotation_deg );
     }
 }
 
@@ -268,49 +269,43 @@ void sectorItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * )
     }
 }
 
+QImage *sectorItem::getSectorImage() const
+{
+    return sectorImage;
+}
+
+void sectorItem::setSectorImage(QImage *value)
+{
+    sectorImage = value;
+}
+
 /*
- * rotateSector
+ * setSectorSize_px
  *
- * Do the common operations necessary to rotate the display of the
- * sector.
+ * The warp renders the sector at size_px while the scene stays in SectorWidth_px units;
+ * the item is scaled down by the same ratio the view scales it up, so the control screen
+ * shows the pixels 1:1.
  */
-void sectorItem::rotateSector( double angle_deg )
+void sectorItem::setSectorSize_px( int size_px )
 {
-//	qDebug() << ">>>>>> 8";
-    QTransform matrix;
-
-    // Locate the center of the image
-    QPointF center = boundingRect().center();
-
-    // These offsets depend on the anti-aliasing mode in use
-    double yTranslation = center.y() + 0.5;
-    double xTranslation = center.x() + 0.5;
-
-    // Clamp between 0 and 360 degrees
-    if( angle_deg < 0.0 )
+    if( sectorImage && ( sectorImage->width() == size_px ) && ( sectorImage->height() == size_px ) )
     {
-        angle_deg += 360.0;
-    }
-    if( angle_deg > 360.0 )
-    {
-        angle_deg -= 360.0;
+        return;
     }
 
-    // rotate and scale around the center of the item
-    matrix.translate( xTranslation, yTranslation );
-    matrix.rotate( angle_deg );
-    matrix.translate( -xTranslation, -yTranslation );
-    setTransform( matrix, false );
-}
+    QImage *resized = new QImage( size_px, size_px, QImage::Format_Indexed8 );
+    resized->setColorTable( sectorImage->colorTable() );
+    resized->fill( 0x00 );
+    delete sectorImage;
+    sectorImage = resized;
 
-QImage *sectorItem::getSectorImage() const
-{
-    return sectorImage;
-}
+    centerX  = sectorImage->width()  / 2;
+    centerY  = sectorImage->height() / 2;
+    secWidth = sectorImage->width();
+    sectorDecoratedImage = sectorImage->copy();
 
-void sectorItem::setSectorImage(QImage *value)
-{
-    sectorImage = value;
+    setScale( double( SectorWidth_px ) / size_px );
+    setPixmap( QPixmap::fromImage( *sectorImage, Qt::MonoOnly ) );
 }
 
 /*
@@ -322,7 +317,8 @@ void sectorItem::setSectorImage(QImage *value)
 void sectorItem::addFrame( QSharedPointer<scanframe> &data )
 {
     // Copy the image into the display buffer
-    memcpy( sectorImage->bits(), data->m_dispData->data(), SectorWidth_px * SectorHeight_px );
+    const size_t sectorSize_B = size_t( sectorImage->bytesPerLine() ) * size_t( sectorImage->height() );
+    memcpy( sectorImage->bits(), data->m_dispData->data(), std::min( sectorSize_B, size_t( data->m_dispData->size() ) ) );
     sectorShouldPaint = true;
 }
 
@@ -461,37 +457,8 @@ QImage sectorItem::freeze ( void )
 //	qDebug() << ">>>>>> 13";
     timestamp = QDateTime::currentDateTime().toUTC().toTime_t();
 
-    // Copy the sector image to a local image that can be manipulated
-    QImage tmp = sectorImage->copy();
-
-    // Rotate about the center of the image; use +0.5 for rounding
-    float yTranslation = ( float( tmp.height() ) / 2.0f ) + 0.5f;
-    float xTranslation = ( float( tmp.width() )  / 2.0f ) + 0.5f;
-
-    // Compute the bounding rectangle of the new circle, to crop
-    // off the corners that will be rotated around.  Even though the image
-    // looks round, it's really a rectangle!
-    double clipPixels = sqrt( double( tmp.height() * tmp.height() ) +
-                              double( tmp.width()  * tmp.width()  ) );
-    clipPixels = ( clipPixels - tmp.width() ) / 2.0;
-
-    QRect clipRect;
-    clipRect.setX( int(clipPixels * fabs( sin( displayRotationAngle_deg * degToRad * 2.0 ) ) ) );
-    clipRect.setY( clipRect.x() );
-    clipRect.setWidth( tmp.width() );
-    clipRect.setHeight( tmp.height() );
-
-    // Rotate about the center of the image
-    QTransform transform;
-    transform.translate( double(xTranslation), double(yTranslation) );
-    transform.rotate( displayRotationAngle_deg );
-    transform.translate( double(-xTranslation), double(-yTranslation) );
-
-    // rotate the image
-    tmp = tmp.transformed( transform, Qt::SmoothTransformation );
-
-    // return just the area that is defined by the clipping rectangle
-    return( tmp.copy( clipRect ) );
+    // The warp has already turned the sector to the display angle
+    return sectorImage->copy();
 }
 
 /*
@@ -579,49 +546,72 @@ void overlayItem::render( void )
 
     if(dev->isBiDirectional()){
         auto rotationIndicatorOverlayItem = RotationIndicatorFactory::getRotationIndicator();
-        auto interfaceSupport = InterfaceSupport::getInstance();
-        int runningState{interfaceSupport->getLastRunningState()};
+        int runningState{InterfaceTelemetry::instance()->snapshot().runningState};
 
         if(runningState != 0){
             rotationIndicatorOverlayItem->show();
         }
     }
 
-    depthSetting &depth = depthSetting::Instance();
-    int numReticles = depth.getNumReticles();
-    int pixelsPerMm = depth.getPixelsPerMm();
-    int catheterEdgePosition = depth.getCatheterEdgePosition();
-
     // Create the target image
     QPixmap tmpPixmap = QPixmap::fromImage( *overlayImage );
     overlayPainter->begin( &tmpPixmap );
+    paintReticle( *overlayPainter, reticle( parentSector->getReticleBrightness() ) );
 
+    setPixmap( tmpPixmap );
+    overlayPainter->end();
+}
+
+/*
+ * reticle()
+ *
+ * The depth reticle of the current device and depth, at the given brightness.
+ */
+overlayItem::Reticle_t overlayItem::reticle( int brightness )
+{
+    depthSetting &depth = depthSetting::Instance();
+    Reticle_t current;
+    current.numReticles          = depth.getNumReticles();
+    current.pixelsPerMm          = depth.getPixelsPerMm();
+    current.catheterEdgePosition = depth.getCatheterEdgePosition();
+    current.brightness           = brightness;
+    return current;
+}
+
+/*
+ * paintReticle()
+ *
+ * Draws the depth rings and the clock ticks in sector units (SectorWidth_px square). The
+ * overlay and captures share it; a capture scales the painter to its own size.
+ */
+void overlayItem::paintReticle( QPainter &painter, const Reticle_t &reticle )
+{
     // Draw reticle indicating depths
-    QColor reticleColor( 50, 50, 255, parentSector->getReticleBrightness() );
+    QColor reticleColor( 50, 50, 255, reticle.brightness );
     QPen  reticlePen( QPen( reticleColor, 3, Qt::SolidLine, Qt::RoundCap) );
 
-    overlayPainter->setPen( reticlePen );
-    overlayPainter->setBrush( ReticleBrush );
+    painter.setPen( reticlePen );
+    painter.setBrush( Qt::NoBrush );
 
     int x1 = SectorWidth_px  / 2;
     int y1 = SectorHeight_px / 2;
 
     // Draw reticles
-    int offset = catheterEdgePosition;
+    int offset = reticle.catheterEdgePosition;
 
-    for ( int i = 0; i < numReticles; i++ )
+    for ( int i = 0; i < reticle.numReticles; i++ )
     {
-        offset += pixelsPerMm;
-        overlayPainter->drawEllipse( QRect( QPoint( x1 - offset, y1 - offset ),
-                                     QPoint( x1 + offset, y1 + offset ) ) );
+        offset += reticle.pixelsPerMm;
+        painter.drawEllipse( QRect( QPoint( x1 - offset, y1 - offset ),
+                             QPoint( x1 + offset, y1 + offset ) ) );
     }
 
     // draw tick marks at major cardinal positions
     {
-        overlayPainter->save();
+        painter.save();
 
         // set the painter coordinates to the center
-        overlayPainter->translate( x1, y1 );
+        painter.translate( x1, y1 );
 
         /*
          * Offset from the edge of the overlayImage where to begin drawing the tick marks.
@@ -636,29 +626,25 @@ void overlayItem::render( void )
         const int OtherLineWidth_px    = CardinalLineWidth_px / 2;
 
         // 3, 6, 9, 12 o'clock markers
-        overlayPainter->setPen( QPen( reticleColor.lighter( 125 ), CardinalLineWidth_px, Qt::SolidLine, Qt::FlatCap ) );
+        painter.setPen( QPen( reticleColor.lighter( 125 ), CardinalLineWidth_px, Qt::SolidLine, Qt::FlatCap ) );
         for( int kr = 0; kr < 4; kr++ )
         {
-            overlayPainter->drawLine( TickMark );
-            overlayPainter->rotate( 90.0 );
+            painter.drawLine( TickMark );
+            painter.rotate( 90.0 );
         }
 
         // the other hour markers are smaller
-        overlayPainter->setPen( QPen( reticleColor.lighter( 125 ), OtherLineWidth_px, Qt::SolidLine, Qt::FlatCap ) );
+        painter.setPen( QPen( reticleColor.lighter( 125 ), OtherLineWidth_px, Qt::SolidLine, Qt::FlatCap ) );
         for( int kr = 0; kr < 12; kr++ )
         {
             // only draw non-cardinal lines
             if( ( kr % 3 ) != 0 )
             {
-                overlayPainter->drawLine( TickMark );
+                painter.drawLine( TickMark );
             }
-            overlayPainter->rotate( 30.0 );
+            painter.rotate( 30.0 );
         }
 
-        overlayPainter->restore();
+        painter.restore();
     }
-
-    setPixmap( tmpPixmap );
-    overlayPainter->end();
 }
-
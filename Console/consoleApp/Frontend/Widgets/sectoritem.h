@@ -161,6 +161,7 @@ public:
     void setVideoOnly() { isVideoOnly = true; }
     QImage *getSectorImage() const;
     void setSectorImage(QImage *value);
+    void setSectorSize_px( int size_px );
 
 private:
     int status;
@@ -168,7 +169,6 @@ private:
 
     double computeAngleForPosition(QPointF position);
     double distanceToPoint(QPointF point);
-    void rotateSector(double angle_deg);
 
     QImage *sectorImage;
     QImage sectorDecoratedImage;
@@ -259,6 +259,16 @@ public:
     void render( void );
     void clearOverlay();
 
+    struct Reticle_t
+    {
+        int numReticles{0};
+        int pixelsPerMm{0};
+        int catheterEdgePosition{0};
+        int brightness{0};
+    };
+    static Reticle_t reticle( int brightness );
+    static void paintReticle( QPainter& painter, const Reticle_t& reticle );
+
 private:
     bool overlaysShouldPaint;
     QPainter   *overlayPainter;
@@ -267,6 +277,4 @@ private:
     int reticleBrightness;
 
     const QSize sectorSize {SectorHeight_px, SectorWidth_px };
-    // Reticle and indicator colors/pens/brushes
-    const QBrush ReticleBrush {Qt::NoBrush};
 };
@@ -13,6 +13,7 @@
 #include "preferencesDialog.h"
 #include "shutdownConfirmationDialog.h"
 #include "Utility/screenFactory.h"
+#include "interfacetelemetry.h"
 
 #include <QDebug>
 #include <QTimer>
@@ -156,7 +157,7 @@ void StartScreen::showEvent(QShowEvent *se)
         ifs->turnOnOffSled5V(false); // 3, OFF "sled 5v"
         ifs->turnOnOffSled24V(false); //3. OFF "sled 24v"
 
-        LOG2(ifs->getSupplyVoltage(), ifs->getVOASettings());
+        InterfaceTelemetry::instance()->refreshStatus(); // reads back and logs the supply voltage and VOA
     }
 }
 
@@ -184,7 +185,7 @@ void StartScreen::on_pushButtonStart_released()
         ifs->turnOnOffSled5V(true); // 3, ON "sled 5v"
         ifs->turnOnOffSled24V(true); //3. ON "sled 24v"
         ifs->setVOAMode(false);//2. svb
-        LOG2(ifs->getSupplyVoltage(), ifs->getVOASettings());
+        InterfaceTelemetry::instance()->refreshStatus(); // reads back and logs the supply voltage and VOA
 
         ScreenFactory sf;
         sf.unRegisterScreens();
@@ -52,6 +52,8 @@ public:
         int index{0};
         uint8_t *acqData{nullptr};
         uint8_t *dispData{nullptr};        // used for display
+        uint16_t *fringeData{nullptr};     // raw fringes, only when the FPGA processing is bypassed
+        bool isFromRecording{false};       // acqData was read back from a recording; fringeData is stale
         size_t bufferLength{0};
     };
 
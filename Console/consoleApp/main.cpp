@@ -11,10 +11,27 @@
 #include "screenNavigator.h"
 #include <QApplication>
 #include <Backend/powerUpDiagnostics.h>
+#include <Backend/interfacetelemetry.h>
+#include <Backend/interfacesupport.h>
+#include <Backend/scanconversion.h>
+#include <Backend/startupgraph.h>
+#include <Backend/benchmarks.h>
+#include <Backend/signalmodel.h>
+#include <Backend/pipelinemetrics.h>
+#include "Utility/userSettings.h"
+#include "deviceSettings.h"
+#include "trigLookupTable.h"
+#include <QSqlDatabase>
 #include "logger.h"
 #include <styledmessagebox.h>
 
-void hookupPowerUpDiagnostics() {
+/*
+ * hookupPowerUpDiagnostics
+ *
+ * Builds the diagnostics and their message box on the GUI thread; the checks themselves talk
+ * to the board and run as a start-up step.
+ */
+PowerUpDiagnostics* hookupPowerUpDiagnostics() {
     auto diagnostics = new PowerUpDiagnostics();
     auto messageBox = styledMessageBox::instance(); //new PowerUpMessageBox();
     LOG(INFO, "Initializing power up diagnostics");
@@ -26,8 +43,66 @@ void hookupPowerUpDiagnostics() {
 
     QObject::connect(messageBox, &styledMessageBox::userAcknowledged,
                      diagnostics, &OctSystemDiagnostics::onUserAcknowledged);
-    const bool success = diagnostics->performDiagnostics(true);
-    LOG1(success);
+    return diagnostics;
+}
+
+/*
+ * registerStartupSteps
+ *
+ * Start-up work that does not need the GUI thread. Steps without dependencies between them
+ * run at the same time; the timing report is written to the log when they are all done.
+ */
+void registerStartupSteps() {
+    auto graph = StartupGraph::instance();
+
+    // Steps share these; building them here means no two steps race to create one, and the
+    // QObjects among them live on the GUI thread
+    userSettings::Instance();
+    SignalModel::instance();
+    PipelineMetrics::instance();
+    InterfaceTelemetry::instance();
+    auto diagnostics = hookupPowerUpDiagnostics();
+
+    // The board can take a moment to enumerate after power-up
+    graph->addStep("interfaceBoard", {}, []() {
+        return InterfaceSupport::getInstance() != nullptr;
+    }, 3, 1000);
+
+    // Runs even without a board; the board check then reports itself as not run
+    graph->addStep("powerUpDiagnostics", {}, [diagnostics]() {
+        StartupGraph::instance()->waitFor("interfaceBoard");
+        const bool success = diagnostics->performDiagnostics(true);
+        LOG1(success);
+
+        // Sled and board status for the UI, polled off the GUI thread
+        auto telemetry = InterfaceTelemetry::instance();
+        QMetaObject::invokeMethod(telemetry, [telemetry]() { telemetry->start(); }, Qt::QueuedConnection);
+        return success;
+    });
+
+    graph->addStep("deviceCatalogue", {}, []() {
+        deviceSettings::Instance().init();
+        return !deviceSettings::Instance().list().isEmpty();
+    });
+
+    graph->addStep("openCL", {}, []() {
+        return ScanConversion::prepare();
+    });
+
+    graph->addStep("sectorLookupTables", {}, []() {
+        trigLookupTable::Instance();
+        return true;
+    });
+
+    // The case database itself is opened once the case directory is known
+    graph->addStep("databaseDriver", {}, []() {
+        return QSqlDatabase::isDriverAvailable("QSQLITE");
+    });
+
+    // Starts when a device is selected; DaqConnection finishes it
+    graph->addExternalStep("axsunDiscovery", {"deviceCatalogue"});
+
+    graph->start();
 }
 
 /*
@@ -37,9 +112,15 @@ int main(int argc, char *argv[])
 {
     QApplication app( argc, argv );
 
+    if( app.arguments().contains( "--benchmark" ) )
+    {
+        return runBenchmarks();
+    }
+
+    registerStartupSteps();
+
     ScreenNavigator navigator;
     navigator.display();
-    hookupPowerUpDiagnostics();
 
     app.exec();
 
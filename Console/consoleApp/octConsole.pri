@@ -9,11 +9,24 @@ HEADERS += \
     $$PWD/Backend/AxsunOCTControl_LW_C.h \
     $$PWD/Backend/backend.h \
     $$PWD/Backend/daq.h \
+    $$PWD/Backend/daqconnection.h \
+    $$PWD/Backend/autocontrast.h \
+    $$PWD/Backend/frameaverage.h \
+    $$PWD/Backend/linedecimation.h \
+    $$PWD/Backend/specklefilter.h \
+    $$PWD/Backend/opencltuning.h \
+    $$PWD/Backend/pipelinemetrics.h \
+    $$PWD/Backend/spectralpipeline.h \
+    $$PWD/Backend/benchmarks.h \
     $$PWD/Backend/displayManager.h \
     $$PWD/Backend/endcasediagnostics.h \
     $$PWD/Backend/fullCaseRecorder.h \
     $$PWD/Backend/imagedescriptor.h \
     $$PWD/Backend/interfacesupport.h \
+    $$PWD/Backend/interfacecommandchannel.h \
+    $$PWD/Backend/simulatedinterfaceboard.h \
+    $$PWD/Backend/interfacetelemetry.h \
+    $$PWD/Backend/startupgraph.h \
     $$PWD/Backend/octsystemdiagnostics.h \
     $$PWD/Backend/powerUpDiagnostics.h \
     $$PWD/Backend/scanconversion.h \
@@ -77,6 +90,8 @@ HEADERS += \
     Frontend/Widgets/livescene.h \
     Frontend/Widgets/sectoritem.h \
     Frontend/Utility/capturemachine.h \
+    Frontend/Utility/thumbnailCache.h \
+    Frontend/Utility/reviewImageCache.h \
     Include/eventDataLog.h \
     Include/qtsingleapplication.h \
     Frontend/Utility/sessiondatabase.h \
@@ -88,8 +103,10 @@ HEADERS += \
     ../../Common/Include/defaults.h \
     ../../Common/Include/logger.h \
     ../../Common/Include/deviceSettings.h \
+    ../../Common/Include/deviceCatalogueCache.h \
     ../../Common/Include/styledmessagebox.h \
     ../../Common/Include/sawFile.h \
+    ../../Common/Include/fileManifest.h \
     ../../Common/Include/keys.h \
     ../../Common/Include/util.h \
     Backend/dsp.h \
@@ -106,11 +123,24 @@ HEADERS += \
 SOURCES += \
     $$PWD/Backend/backend.cpp \
     $$PWD/Backend/daq.cpp \
+    $$PWD/Backend/daqconnection.cpp \
+    $$PWD/Backend/autocontrast.cpp \
+    $$PWD/Backend/frameaverage.cpp \
+    $$PWD/Backend/linedecimation.cpp \
+    $$PWD/Backend/specklefilter.cpp \
+    $$PWD/Backend/opencltuning.cpp \
+    $$PWD/Backend/pipelinemetrics.cpp \
+    $$PWD/Backend/spectralpipeline.cpp \
+    $$PWD/Backend/benchmarks.cpp \
     $$PWD/Backend/displayManager.cpp \
     $$PWD/Backend/endcasediagnostics.cpp \
     $$PWD/Backend/fullCaseRecorder.cpp \
     $$PWD/Backend/imagedescriptor.cpp \
     $$PWD/Backend/interfacesupport.cpp \
+    $$PWD/Backend/interfacecommandchannel.cpp \
+    $$PWD/Backend/simulatedinterfaceboard.cpp \
+    $$PWD/Backend/interfacetelemetry.cpp \
+    $$PWD/Backend/startupgraph.cpp \
     $$PWD/Backend/octsystemdiagnostics.cpp \
     $$PWD/Backend/powerUpDiagnostics.cpp \
     $$PWD/Backend/scanconversion.cpp \
@@ -170,6 +200,8 @@ SOURCES += \
     Frontend/Widgets/livescene.cpp \
     Frontend/Widgets/sectoritem.cpp \
     Frontend/Utility/capturemachine.cpp \
+    Frontend/Utility/thumbnailCache.cpp \
+    Frontend/Utility/reviewImageCache.cpp \
     Utility/eventDataLog.cpp \
     Utility/qtsingleapplication.cpp \
     Frontend/Utility/sessiondatabase.cpp \
@@ -180,8 +212,10 @@ SOURCES += \
     ../../Common/Utility/unwindMachine.cpp \
     ../../Common/Utility/logger.cpp \
     ../../Common/Utility/deviceSettings.cpp \
+    ../../Common/Utility/deviceCatalogueCache.cpp \
     ../../Common/GUI/styledmessagebox.cpp \
     ../../Common/Utility/sawFile.cpp \
+    ../../Common/Utility/fileManifest.cpp \
     ../../Common/Utility/util.cpp \
     ../../Common/Utility/keys.cpp \
     Backend/dsp.cpp \